@@ -87,6 +87,8 @@ if [[ $TASK == "swig" ]]; then
         objdump -T ./lib_lightgbm.so > ./objdump.log || exit 1
         objdump -T ./lib_lightgbm_swig.so >> ./objdump.log || exit 1
         python ./.ci/check-dynamic-dependencies.py ./objdump.log || exit 1
+        javac -cp ./build/lightgbmlib.jar -d ./build/swig_tests ./swig/tests/*.java || exit 1
+        java -cp ./build/lightgbmlib.jar:./build/swig_tests -Dlightgbm.lib.dir=. PredictDirectTest || exit 1
     fi
     if [[ $PRODUCES_ARTIFACTS == "true" ]]; then
         cp ./build/lightgbmlib.jar $BUILD_ARTIFACTSTAGINGDIRECTORY/lightgbmlib_$OS_NAME.jar
@@ -0,0 +1,104 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ *
+ * Compare the prediction time of rows scored one at a time with rows scored by blocks (predict_block_size),
+ * for the first 100, 1000 and all the trees of a model trained on synthetic data.
+ * Usage: benchmark [num_iterations] [num_leaves] [num_rows]
+ */
+#include <LightGBM/c_api.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int kNumCols = 32;
+
+void Check(int result, const char* call) {
+  if (result != 0) {
+    std::fprintf(stderr, "%s failed: %s\n", call, LGBM_GetLastError());
+    std::exit(1);
+  }
+}
+
+/*! \brief Predict all the rows with the first num_iteration iterations, return the time in seconds */
+double TimePredict(BoosterHandle booster, const std::vector<double>& features, int num_rows, int num_iteration,
+                   const std::string& params, std::vector<double>* out) {
+  out->resize(num_rows);
+  int64_t out_len;
+  const auto start = std::chrono::steady_clock::now();
+  Check(LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64, num_rows, kNumCols, 1,
+                                  C_API_PREDICT_RAW_SCORE, 0, num_iteration, params.c_str(), &out_len, out->data()),
+        "LGBM_BoosterPredictForMat");
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int num_iterations = argc > 1 ? std::atoi(argv[1]) : 5000;
+  const int num_leaves = argc > 2 ? std::atoi(argv[2]) : 31;
+  const int num_rows = argc > 3 ? std::atoi(argv[3]) : 20000;
+
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  std::vector<double> features(static_cast<size_t>(num_rows) * kNumCols);
+  std::vector<float> labels(num_rows);
+  for (int i = 0; i < num_rows; ++i) {
+    double* row = features.data() + static_cast<size_t>(i) * kNumCols;
+    for (int j = 0; j < kNumCols; ++j) {
+      row[j] = uniform(gen);
+    }
+    labels[i] = static_cast<float>(std::sin(3.0 * row[0]) + row[0] * row[1] + (row[2] > 0.3 ? 1.0 : 0.0)
+                                   + 0.1 * uniform(gen));
+  }
+
+  DatasetHandle dataset;
+  Check(LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, num_rows, kNumCols, 1, "verbose=-1", nullptr,
+                                  &dataset), "LGBM_DatasetCreateFromMat");
+  Check(LGBM_DatasetSetField(dataset, "label", labels.data(), num_rows, C_API_DTYPE_FLOAT32), "LGBM_DatasetSetField");
+  BoosterHandle booster;
+  const std::string params = "objective=regression verbose=-1 min_data_in_leaf=5 learning_rate=0.01 num_leaves="
+                             + std::to_string(num_leaves);
+  Check(LGBM_BoosterCreate(dataset, params.c_str(), &booster), "LGBM_BoosterCreate");
+  for (int i = 0; i < num_iterations; ++i) {
+    int is_finished;
+    Check(LGBM_BoosterUpdateOneIter(booster, &is_finished), "LGBM_BoosterUpdateOneIter");
+  }
+
+  // a single thread, so that the cache behaviour is not blurred by the threads sharing it
+  std::printf("%8s %12s", "trees", "row by row");
+  const int block_sizes[] = {16, 64, 256};
+  for (int block_size : block_sizes) {
+    std::printf("   block %-4d speedup", block_size);
+  }
+  std::printf("\n");
+  for (int num_trees : {100, 1000, num_iterations}) {
+    if (num_trees > num_iterations) {
+      continue;
+    }
+    std::vector<double> expected, out;
+    const double row_time = TimePredict(booster, features, num_rows, num_trees, "num_threads=1", &expected);
+    std::printf("%8d %11.3fs", num_trees, row_time);
+    for (int block_size : block_sizes) {
+      const double block_time = TimePredict(booster, features, num_rows, num_trees,
+                                            "num_threads=1 predict_block_size=" + std::to_string(block_size), &out);
+      if (out != expected) {
+        std::fprintf(stderr, "predictions by blocks of %d rows differ\n", block_size);
+        return 1;
+      }
+      std::printf(" %10.3fs %6.2fx", block_time, row_time / block_time);
+    }
+    std::printf("\n");
+  }
+
+  LGBM_BoosterFree(booster);
+  LGBM_DatasetFree(dataset);
+  return 0;
+}
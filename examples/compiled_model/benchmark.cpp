@@ -0,0 +1,103 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ *
+ * Compare the prediction time of a compiled model with the interpreted one, on synthetic data.
+ * Usage: benchmark [num_iterations] [num_leaves] [num_rows] [compiler_flags]
+ */
+#include <LightGBM/c_api.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int kNumCols = 32;
+
+void Check(int result, const char* call) {
+  if (result != 0) {
+    std::fprintf(stderr, "%s failed: %s\n", call, LGBM_GetLastError());
+    std::exit(1);
+  }
+}
+
+/*! \brief Predict all the rows, return the time in seconds */
+double TimePredict(BoosterHandle booster, const std::vector<double>& features, int num_rows, int predict_type,
+                   const char* params, std::vector<double>* out) {
+  out->resize(num_rows);
+  int64_t out_len;
+  const auto start = std::chrono::steady_clock::now();
+  Check(LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64, num_rows, kNumCols, 1, predict_type,
+                                  0, -1, params, &out_len, out->data()), "LGBM_BoosterPredictForMat");
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int num_iterations = argc > 1 ? std::atoi(argv[1]) : 500;
+  const int num_leaves = argc > 2 ? std::atoi(argv[2]) : 63;
+  const int num_rows = argc > 3 ? std::atoi(argv[3]) : 100000;
+  const std::string compiler_flags = argc > 4 ? argv[4] : "-O3 -march=native";
+  const char* filename = "benchmark_model.so";
+
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  std::vector<double> features(static_cast<size_t>(num_rows) * kNumCols);
+  std::vector<float> labels(num_rows);
+  for (int i = 0; i < num_rows; ++i) {
+    double* row = features.data() + static_cast<size_t>(i) * kNumCols;
+    for (int j = 0; j < kNumCols; ++j) {
+      row[j] = gen() % 50 == 0 ? NAN : uniform(gen);
+    }
+    const double x0 = std::isnan(row[0]) ? 0.0 : row[0];
+    const double x1 = std::isnan(row[1]) ? 0.0 : row[1];
+    labels[i] = static_cast<float>(std::sin(3.0 * x0) + x0 * x1 + (row[2] > 0.3 ? 1.0 : 0.0) + 0.1 * uniform(gen));
+  }
+
+  DatasetHandle dataset;
+  Check(LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, num_rows, kNumCols, 1, "verbose=-1", nullptr,
+                                  &dataset), "LGBM_DatasetCreateFromMat");
+  Check(LGBM_DatasetSetField(dataset, "label", labels.data(), num_rows, C_API_DTYPE_FLOAT32), "LGBM_DatasetSetField");
+  BoosterHandle booster;
+  const std::string params = "objective=regression verbose=-1 min_data_in_leaf=5 num_leaves=" + std::to_string(num_leaves);
+  Check(LGBM_BoosterCreate(dataset, params.c_str(), &booster), "LGBM_BoosterCreate");
+  for (int i = 0; i < num_iterations; ++i) {
+    int is_finished;
+    Check(LGBM_BoosterUpdateOneIter(booster, &is_finished), "LGBM_BoosterUpdateOneIter");
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  Check(LGBM_BoosterSaveModelCompiled(booster, -1, 0, nullptr, compiler_flags.c_str(), filename),
+        "LGBM_BoosterSaveModelCompiled");
+  std::printf("compiled %d iterations of %d leaves in %.1f s\n", num_iterations, num_leaves,
+              std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  BoosterHandle compiled;
+  int num_loaded_iterations;
+  Check(LGBM_BoosterLoadCompiled(filename, &num_loaded_iterations, &compiled), "LGBM_BoosterLoadCompiled");
+
+  std::printf("%-28s %12s %12s %8s\n", "prediction", "interpreted", "compiled", "speedup");
+  for (const char* predict_params : {"num_threads=1", "num_threads=1 predict_block_size=64", ""}) {
+    std::vector<double> expected, out;
+    const double interpreted_time = TimePredict(booster, features, num_rows, C_API_PREDICT_RAW_SCORE, predict_params,
+                                                &expected);
+    const double compiled_time = TimePredict(compiled, features, num_rows, C_API_PREDICT_RAW_SCORE, predict_params,
+                                             &out);
+    if (out != expected) {
+      std::fprintf(stderr, "compiled predictions differ with %s\n", predict_params);
+      return 1;
+    }
+    std::printf("%-28s %11.3fs %11.3fs %7.2fx\n", predict_params[0] != '\0' ? predict_params : "all threads",
+                interpreted_time, compiled_time, interpreted_time / compiled_time);
+  }
+
+  LGBM_BoosterFree(compiled);
+  LGBM_BoosterFree(booster);
+  LGBM_DatasetFree(dataset);
+  return 0;
+}
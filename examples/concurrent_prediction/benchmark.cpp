@@ -0,0 +1,126 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ *
+ * Measure the throughput of threads sharing one FastConfigHandle for single-row predictions,
+ * against the same threads serialized by a mutex around each call.
+ * Usage: benchmark [num_iterations] [num_leaves] [rows_per_thread] [max_threads]
+ */
+#include <LightGBM/c_api.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int kNumCols = 50;
+const int kNumRows = 10000;
+
+void Check(int result, const char* call) {
+  if (result != 0) {
+    std::fprintf(stderr, "%s failed: %s\n", call, LGBM_GetLastError());
+    std::exit(1);
+  }
+}
+
+/*!
+ * \brief Let num_threads threads predict rows_per_thread rows each through fast_config
+ * \param call_mutex When not nullptr, held around each prediction
+ * \return Rows predicted per second
+ */
+double Throughput(FastConfigHandle fast_config, const std::vector<double>& features, int num_threads,
+                  int rows_per_thread, std::mutex* call_mutex) {
+  std::atomic<int> num_ready(0);
+  std::atomic<bool> go(false);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      double out;
+      int64_t out_len;
+      ++num_ready;
+      while (!go.load()) {
+        std::this_thread::yield();
+      }
+      for (int i = 0; i < rows_per_thread; ++i) {
+        const double* row = features.data() + static_cast<size_t>((t * 7919 + i) % kNumRows) * kNumCols;
+        if (call_mutex != nullptr) {
+          std::lock_guard<std::mutex> lock(*call_mutex);
+          Check(LGBM_BoosterPredictForMatSingleRowFast(fast_config, row, &out_len, &out),
+                "LGBM_BoosterPredictForMatSingleRowFast");
+        } else {
+          Check(LGBM_BoosterPredictForMatSingleRowFast(fast_config, row, &out_len, &out),
+                "LGBM_BoosterPredictForMatSingleRowFast");
+        }
+      }
+    });
+  }
+  while (num_ready.load() < num_threads) {
+    std::this_thread::yield();
+  }
+  const auto start = std::chrono::steady_clock::now();
+  go = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return static_cast<double>(num_threads) * rows_per_thread / seconds;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int num_iterations = argc > 1 ? std::atoi(argv[1]) : 20;
+  const int num_leaves = argc > 2 ? std::atoi(argv[2]) : 31;
+  const int rows_per_thread = argc > 3 ? std::atoi(argv[3]) : 100000;
+  const int max_threads = argc > 4 ? std::atoi(argv[4]) : 64;
+
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  std::vector<double> features(static_cast<size_t>(kNumRows) * kNumCols);
+  std::vector<float> labels(kNumRows);
+  for (int i = 0; i < kNumRows; ++i) {
+    double* row = features.data() + static_cast<size_t>(i) * kNumCols;
+    for (int j = 0; j < kNumCols; ++j) {
+      row[j] = uniform(gen);
+    }
+    labels[i] = static_cast<float>(std::sin(3.0 * row[0]) + row[0] * row[1] + 0.1 * uniform(gen));
+  }
+
+  DatasetHandle dataset;
+  Check(LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, kNumRows, kNumCols, 1, "verbose=-1", nullptr,
+                                  &dataset), "LGBM_DatasetCreateFromMat");
+  Check(LGBM_DatasetSetField(dataset, "label", labels.data(), kNumRows, C_API_DTYPE_FLOAT32), "LGBM_DatasetSetField");
+  BoosterHandle booster;
+  const std::string params = "objective=regression verbose=-1 num_leaves=" + std::to_string(num_leaves);
+  Check(LGBM_BoosterCreate(dataset, params.c_str(), &booster), "LGBM_BoosterCreate");
+  for (int i = 0; i < num_iterations; ++i) {
+    int is_finished;
+    Check(LGBM_BoosterUpdateOneIter(booster, &is_finished), "LGBM_BoosterUpdateOneIter");
+  }
+  FastConfigHandle fast_config;
+  Check(LGBM_BoosterPredictForMatSingleRowFastInit(booster, C_API_PREDICT_NORMAL, 0, -1, C_API_DTYPE_FLOAT64,
+                                                   kNumCols, "num_threads=1", &fast_config),
+        "LGBM_BoosterPredictForMatSingleRowFastInit");
+
+  std::printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+  std::printf("%8s %16s %16s\n", "threads", "shared rows/s", "mutex rows/s");
+  std::mutex call_mutex;
+  for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+    const double shared = Throughput(fast_config, features, num_threads, rows_per_thread, nullptr);
+    const double serialized = Throughput(fast_config, features, num_threads, rows_per_thread, &call_mutex);
+    std::printf("%8d %16.0f %16.0f\n", num_threads, shared, serialized);
+  }
+
+  LGBM_FastConfigFree(fast_config);
+  LGBM_BoosterFree(booster);
+  LGBM_DatasetFree(dataset);
+  return 0;
+}
@@ -58,6 +58,9 @@ class Application {
   /*! \brief Main Convert model logic */
   void ConvertModel();
 
+  /*! \brief Main Compile model logic */
+  void CompileModel();
+
   /*! \brief All configs */
   Config config_;
   /*! \brief Training data */
@@ -81,6 +84,8 @@ inline void Application::Run() {
     Predict();
   } else if (config_.task == TaskType::kConvertModel) {
     ConvertModel();
+  } else if (config_.task == TaskType::kCompileModel) {
+    CompileModel();
   } else {
     InitTrain();
     Train();
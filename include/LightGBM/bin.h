@@ -419,6 +419,37 @@ class Bin {
   virtual void ConstructHistogramInt32(data_size_t start, data_size_t end,
                                        const score_t* ordered_gradients, hist_t* out) const = 0;
 
+  /*!
+  * \brief Construct histograms of several leaves in one pass over this feature,
+  *        the data_indices[i]-th data is accumulated into the histogram out[leaf_slots[i]]
+  * \param data_indices Used data indices of all the leaves, in increasing order
+  * \param start start index in data_indices
+  * \param end end index in data_indices
+  * \param leaf_slots Histogram slot of each data, aligned with data_indices
+  * \param ordered_gradients Pointer to gradients, the data_indices[i]-th data's gradient is ordered_gradients[i]
+  * \param ordered_hessians Pointer to hessians, the data_indices[i]-th data's hessian is ordered_hessians[i],
+  *        nullptr to count the data instead (constant hessians)
+  * \param out Histograms of the slots
+  */
+  virtual void ConstructHistogramMultiLeaf(const data_size_t* data_indices, data_size_t start, data_size_t end,
+                                           const int* leaf_slots, const score_t* ordered_gradients,
+                                           const score_t* ordered_hessians, hist_t* const* out) const = 0;
+
+  /*!
+  * \brief Construct the histograms of several outputs (e.g. the classes of multiclass) in one pass over this feature,
+  *        the histograms are interleaved: out[(bin * num_outputs + k) * 2] is the sum of gradients of the k-th output in bin
+  * \param data_indices Used data indices, nullptr to use the data in [start, end)
+  * \param start start index
+  * \param end end index
+  * \param num_outputs Number of outputs
+  * \param ordered_gradients_and_hessians Interleaved gradients and hessians, the ones of the k-th output of
+  *        the i-th data are at ((i - start) * num_outputs + k) * 2 and ((i - start) * num_outputs + k) * 2 + 1
+  * \param out Interleaved histograms
+  */
+  virtual void ConstructHistogramMultiOutput(const data_size_t* data_indices, data_size_t start, data_size_t end,
+                                             int num_outputs, const score_t* ordered_gradients_and_hessians,
+                                             hist_t* out) const = 0;
+
   virtual data_size_t Split(uint32_t min_bin, uint32_t max_bin,
                             uint32_t default_bin, uint32_t most_freq_bin,
                             MissingType missing_type, bool default_left,
@@ -583,10 +614,31 @@ class MultiValBin {
                                              const score_t* ordered_hessians,
                                              hist_t* out) const = 0;
 
+  /*!
+  * \brief Construct the interleaved histograms of several outputs in one pass over the rows,
+  *        with the same layout as Bin::ConstructHistogramMultiOutput
+  */
+  virtual void ConstructHistogramMultiOutput(const data_size_t* data_indices,
+                                             data_size_t start, data_size_t end,
+                                             int num_outputs,
+                                             const score_t* ordered_gradients_and_hessians,
+                                             hist_t* out) const = 0;
+
   virtual void FinishLoad() = 0;
 
   virtual bool IsSparse() = 0;
 
+  /*! \brief Size of the bins in bytes */
+  virtual size_t SizesInByte() const = 0;
+
+  /*!
+  * \brief Copy the rows in [start, start + num_data) of other_bin to the same rows, with a stable partition:
+  *        the rows with is_left set go first
+  * \param is_left Whether each row goes first, is_left[i] is for the (start + i)-th row
+  */
+  virtual void CopyPartitionedRows(const MultiValBin* other_bin, data_size_t start, data_size_t num_data,
+                                   const uint8_t* is_left) = 0;
+
   static MultiValBin* CreateMultiValBin(data_size_t num_data, int num_bin,
                                         int num_feature, double sparse_rate, const std::vector<uint32_t>& offsets);
 
@@ -7,10 +7,15 @@
 
 #include <LightGBM/config.h>
 #include <LightGBM/meta.h>
+#include <LightGBM/prediction_early_stop.h>
+#include <LightGBM/utils/sparse_row.h>
 
 #include <string>
+#include <functional>
 #include <map>
+#include <memory>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace LightGBM {
@@ -19,7 +24,26 @@ namespace LightGBM {
 class Dataset;
 class ObjectiveFunction;
 class Metric;
-struct PredictionEarlyStopInstance;
+
+/*!
+* \brief Settings of a prediction resolved against a model by Boosting::CreatePredictionPlan.
+*        A plan is immutable and holds everything a prediction needs besides the model itself,
+*        so that predictions with different plans can run at the same time on one model.
+*/
+struct PredictionPlan {
+  virtual ~PredictionPlan() {}
+  /*! \brief Start index of the predicted iterations */
+  int start_iteration = 0;
+  /*! \brief Number of predicted iterations */
+  int num_iteration = 0;
+  /*! \brief Early stopping of the score predictions */
+  PredictionEarlyStopInstance early_stop;
+  /*!
+  * \brief Raw features of the compact records, compact feature i holds the value of raw feature compact_features[i].
+  *        Only the features used by some split are kept, in increasing order. Only set with use_compact_features
+  */
+  std::vector<int> compact_features;
+};
 
 /*!
 * \brief The interface for Boosting
@@ -76,6 +100,14 @@ class LIGHTGBM_EXPORT Boosting {
   */
   virtual void RefitTree(const int* tree_leaf_prediction, const size_t nrow, const size_t ncol) = 0;
 
+  /*!
+  * \brief Update the tree output by new training data, computing the leaves of the records from their features
+  *        for a block of iterations at a time, so that the leaf indices of all the trees are never stored together
+  * \param nrow Number of records, must be the number of training data
+  * \param get_row_fun Writes the features of a record to a buffer of MaxFeatureIdx() + 1 zeros
+  */
+  virtual void RefitTree(size_t nrow, const std::function<void(data_size_t row_idx, double* features)>& get_row_fun) = 0;
+
   /*!
   * \brief Training logic
   * \param gradients nullptr for using default objective, otherwise use self-defined boosting
@@ -123,32 +155,112 @@ class LIGHTGBM_EXPORT Boosting {
   */
   virtual void GetPredictAt(int data_idx, double* result, int64_t* out_len) = 0;
 
+  /*!
+  * \brief Prediction for all the records of a constructed dataset, walking the trees on its bins
+  * \param data Dataset with the bins of the training data (or compatible ones), its raw values are not needed
+  * \param start_iteration Start index of the iteration to predict
+  * \param num_iteration Number of iterations to predict, <= 0 means no limit
+  * \param is_raw_score True to output the raw scores
+  * \param output Prediction result, num_data * NumModelPerIteration() values in row-major order
+  */
+  virtual void PredictForDataset(const Dataset* data, int start_iteration, int num_iteration,
+                                 bool is_raw_score, double* output) const = 0;
+
   virtual int NumPredictOneRow(int start_iteration, int num_iteration, bool is_pred_leaf, bool is_pred_contrib) const = 0;
 
   /*!
   * \brief Prediction for one record, not sigmoid transform
+  * \param plan Prediction plan created by CreatePredictionPlan, its early stopping is applied
   * \param feature_values Feature value on this record
   * \param output Prediction result for this record
-  * \param early_stop Early stopping instance. If nullptr, no early stopping is applied and all models are evaluated.
   */
-  virtual void PredictRaw(const double* features, double* output,
-                          const PredictionEarlyStopInstance* early_stop) const = 0;
+  virtual void PredictRaw(const PredictionPlan& plan, const double* features, double* output) const = 0;
 
-  virtual void PredictRawByMap(const std::unordered_map<int, double>& features, double* output,
-                               const PredictionEarlyStopInstance* early_stop) const = 0;
+  /*!
+  * \brief Prediction for one sparse record, not sigmoid transform
+  * \param features Feature values of this record, absent features are zero
+  */
+  virtual void PredictRawSparse(const PredictionPlan& plan, const SparseRow& features, double* output) const = 0;
 
 
   /*!
   * \brief Prediction for one record, sigmoid transformation will be used if needed
+  * \param plan Prediction plan created by CreatePredictionPlan, its early stopping is applied
   * \param feature_values Feature value on this record
   * \param output Prediction result for this record
-  * \param early_stop Early stopping instance. If nullptr, no early stopping is applied and all models are evaluated.
   */
-  virtual void Predict(const double* features, double* output,
-                       const PredictionEarlyStopInstance* early_stop) const = 0;
+  virtual void Predict(const PredictionPlan& plan, const double* features, double* output) const = 0;
+
+  virtual void PredictSparse(const PredictionPlan& plan, const SparseRow& features, double* output) const = 0;
+
+  /*!
+  * \brief Prediction for a block of records, not sigmoid transform, without early stopping.
+  *        Each tree is evaluated on all records of the block before moving on to the next tree.
+  * \param features Feature values of the records, row-major with MaxFeatureIdx() + 1 values per record
+  * \param num_rows Number of records in the block
+  * \param output Prediction result, NumModelPerIteration() values per record
+  */
+  virtual void PredictRawBlock(const PredictionPlan& plan, const double* features, int num_rows, double* output) const = 0;
+
+  /*!
+  * \brief Prediction for a block of records, sigmoid transformation will be used if needed
+  * \param features Feature values of the records, row-major with MaxFeatureIdx() + 1 values per record
+  * \param num_rows Number of records in the block
+  * \param output Prediction result, NumModelPerIteration() values per record
+  */
+  virtual void PredictBlock(const PredictionPlan& plan, const double* features, int num_rows, double* output) const = 0;
+
+  /*!
+  * \brief Convert the raw score of one record into its prediction, sigmoid transformation will be used if needed
+  * \param raw_score Raw score of all the iterations up to the end of the predicted range, i.e. the sum of
+  *                  the raw score of iterations [0, start_iteration) and of the predicted iterations
+  * \param output Prediction result for this record, can be the same buffer as raw_score
+  */
+  virtual void ConvertRawScore(const PredictionPlan& plan, const double* raw_score, double* output) const = 0;
+
+  /*!
+  * \brief Prediction for one record with single precision thresholds and leaf values, not sigmoid transform.
+  *        Only available with a plan created with use_float32
+  * \param features Feature values of this record, MaxFeatureIdx() + 1 values
+  * \param output Prediction result for this record
+  */
+  virtual void PredictRawFloat32(const PredictionPlan& plan, const float* features, double* output) const = 0;
+
+  /*!
+  * \brief Prediction for one record with single precision thresholds and leaf values,
+  *        sigmoid transformation will be used if needed. Only available with a plan created with use_float32
+  */
+  virtual void PredictFloat32(const PredictionPlan& plan, const float* features, double* output) const = 0;
+
+  /*!
+  * \brief Deviation of the single precision prediction from the double one
+  * \param start_iteration Start index of the iteration to predict
+  * \param num_iteration Number of used iterations, <= 0 means no limit
+  * \param out_num_inexact_thresholds Number of numerical thresholds which are not representable as float,
+  *                                   and are rounded down in single precision
+  * \return Upper bound of the absolute difference of the raw scores for inputs representable as float, caused by
+  *         the rounding of the leaf values, 0 when the predictions are identical. Other float64 inputs are rounded
+  *         to float first and may be routed differently at any threshold, they have no bound
+  */
+  virtual double GetFloat32Deviation(int start_iteration, int num_iteration, int* out_num_inexact_thresholds) const = 0;
+
+  /*!
+  * \brief Prediction for one compact record, not sigmoid transform. Only available with a plan created with use_compact_features
+  * \param features Feature values of this record, plan.compact_features.size() values
+  * \param output Prediction result for this record
+  */
+  virtual void PredictRawCompact(const PredictionPlan& plan, const double* features, double* output) const = 0;
 
-  virtual void PredictByMap(const std::unordered_map<int, double>& features, double* output,
-                            const PredictionEarlyStopInstance* early_stop) const = 0;
+  /*!
+  * \brief Prediction for one compact record, sigmoid transformation will be used if needed.
+  *        Only available with a plan created with use_compact_features
+  */
+  virtual void PredictCompact(const PredictionPlan& plan, const double* features, double* output) const = 0;
+
+  /*!
+  * \brief Prediction for one compact record with leaf index. Only available with a plan created with use_compact_features
+  */
+  virtual void PredictLeafIndexCompact(const PredictionPlan& plan, const double* features, double* output) const = 0;
 
 
   /*!
@@ -156,21 +268,35 @@ class LIGHTGBM_EXPORT Boosting {
   * \param feature_values Feature value on this record
   * \param output Prediction result for this record
   */
-  virtual void PredictLeafIndex(
-    const double* features, double* output) const = 0;
+  virtual void PredictLeafIndex(const PredictionPlan& plan, const double* features, double* output) const = 0;
 
-  virtual void PredictLeafIndexByMap(
-    const std::unordered_map<int, double>& features, double* output) const = 0;
+  virtual void PredictLeafIndexSparse(const PredictionPlan& plan, const SparseRow& features, double* output) const = 0;
 
   /*!
-  * \brief Feature contributions for the model's prediction of one record
+  * \brief Feature contributions for the model's prediction of one record, the plan must be created with is_pred_contrib
   * \param feature_values Feature value on this record
   * \param output Prediction result for this record
   */
-  virtual void PredictContrib(const double* features, double* output) const = 0;
+  virtual void PredictContrib(const PredictionPlan& plan, const double* features, double* output) const = 0;
 
-  virtual void PredictContribByMap(const std::unordered_map<int, double>& features,
-                                   std::vector<std::unordered_map<int, double>>* output) const = 0;
+  /*!
+  * \brief Feature contributions for a block of records, same as PredictContrib on each of them.
+  *        Each tree explains all records of the block at once.
+  * \param features Feature values of the records, row-major with MaxFeatureIdx() + 1 values per record
+  * \param num_rows Number of records in the block
+  * \param output Prediction result, NumPredictOneRow() values per record
+  */
+  virtual void PredictContribBlock(const PredictionPlan& plan, const double* features, int num_rows,
+                                   double* output) const = 0;
+
+  /*!
+  * \brief Feature contributions for one sparse record
+  * \param features Feature values of this record, absent features are zero
+  * \param output For each tree of an iteration, the (feature index, contribution) pairs sorted by index of the
+  *               features used by its trees, followed by the expected value at index MaxFeatureIdx() + 1
+  */
+  virtual void PredictContribSparse(const PredictionPlan& plan, const SparseRow& features,
+                                    std::vector<std::vector<std::pair<int, double>>>* output) const = 0;
 
   /*!
   * \brief Dump model to json format string
@@ -223,6 +349,61 @@ class LIGHTGBM_EXPORT Boosting {
   */
   virtual bool LoadModelFromString(const char* buffer, size_t len) = 0;
 
+  /*!
+  * \brief Save model to a binary file, whose arrays can be used in place once the file is mapped into memory
+  * \param start_iteration The model will be saved start from
+  * \param num_iterations Number of model that want to save, -1 means save all
+  * \param feature_importance_type Type of feature importance, 0: split, 1: gain
+  * \param filename Filename that want to save to
+  * \return true if succeeded
+  */
+  virtual bool SaveModelToBinaryFile(int start_iteration, int num_iterations, int feature_importance_type, const char* filename) const = 0;
+
+  /*!
+  * \brief Restore from a model written by SaveModelToBinaryFile
+  * \param buffer The content of model, must be aligned on 8 bytes
+  * \param len The length of buffer
+  * \param owner Keeps buffer alive, the prediction arrays are then used in place, the trees are copied anyway;
+  *        when nullptr everything is copied
+  * \return true if succeeded
+  */
+  virtual bool LoadModelFromBinary(const char* buffer, size_t len, std::shared_ptr<const void> owner) = 0;
+
+  /*!
+  * \brief Generate self-contained C code of the model and build it into a shared library
+  * \param num_iteration Number of iterations that want to compile, -1 means compile all
+  * \param use_float32 Whether to also build the entry point predicting float32 records
+  * \param compiler Command of the C compiler
+  * \param compiler_flags Flags of the compiler, the library flags are added
+  * \param filename Filename of the shared library, the C source is written next to it
+  * \return true if succeeded
+  */
+  virtual bool SaveModelToCompiled(int num_iteration, bool use_float32, const std::string& compiler,
+                                   const std::string& compiler_flags, const char* filename) const = 0;
+
+  /*!
+  * \brief Restore from a shared library built by SaveModelToCompiled, predictions then go through it
+  * \param filename Filename of the shared library
+  * \return true if succeeded
+  */
+  virtual bool LoadModelFromCompiled(const char* filename) = 0;
+
+  /*!
+  * \brief Create a prediction-only boosting object sharing the trees of some iterations, without copying them.
+  *        A shared tree is copied by the first object modifying it in place.
+  * \param start_iteration Start index of the iterations of the view
+  * \param num_iteration Number of iterations of the view, <= 0 means up to the last one
+  * \return The view, whose iteration 0 is start_iteration of this object
+  */
+  virtual Boosting* CreateView(int start_iteration, int num_iteration) = 0;
+
+  /*!
+  * \brief Get the memory used by the trees and the flattened forest
+  * \param own_bytes Output, bytes used by this object only
+  * \param shared_bytes Output, bytes shared with other objects (see CreateView), reported by each of them
+  */
+  virtual void GetMemoryUsage(int64_t* own_bytes, int64_t* shared_bytes) const = 0;
+
   /*!
   * \brief Calculate feature importances
   * \param num_iteration Number of model that want to use for feature importance, -1 means use all
@@ -283,12 +464,22 @@ class LIGHTGBM_EXPORT Boosting {
   virtual bool NeedAccuratePrediction() const = 0;
 
   /*!
-  * \brief Initial work for the prediction
+  * \brief Resolve the settings of a prediction against the current model, without modifying it.
+  *        The plan keeps predicting the same trees after the model is modified, and may be used by several threads
   * \param start_iteration Start index of the iteration to predict
-  * \param num_iteration number of used iteration
-  * \param is_pred_contrib
-  */
-  virtual void InitPredict(int start_iteration, int num_iteration, bool is_pred_contrib) = 0;
+  * \param num_iteration number of used iteration, <= 0 means no limit
+  * \param is_pred_contrib True to prepare the feature contributions
+  * \param use_quick_scorer True to score the eligible trees with the QuickScorer bitvector algorithm
+  * \param use_float32 True to prepare the single precision forest used by PredictRawFloat32, must not be used with linear trees
+  * \param use_binned True to score records quantized into the positions of their values in the thresholds of the model
+  * \param use_compact_features True to prepare the forest used by the *Compact methods, must not be used with linear trees
+  * \param early_stop Early stopping of the score predictions
+  * \return The plan, owned by the caller
+  */
+  virtual PredictionPlan* CreatePredictionPlan(int start_iteration, int num_iteration, bool is_pred_contrib,
+                                               bool use_quick_scorer, bool use_float32, bool use_binned,
+                                               bool use_compact_features,
+                                               const PredictionEarlyStopInstance& early_stop) const = 0;
 
   /*!
   * \brief Name of submodel
@@ -36,6 +36,7 @@ typedef void* ByteBufferHandle; /*!< \brief Handle of ByteBuffer. */
 #define C_API_DTYPE_FLOAT64 (1)  /*!< \brief float64 (double precision float). */
 #define C_API_DTYPE_INT32   (2)  /*!< \brief int32. */
 #define C_API_DTYPE_INT64   (3)  /*!< \brief int64. */
+#define C_API_DTYPE_INT16   (4)  /*!< \brief int16. */
 
 #define C_API_PREDICT_NORMAL     (0)  /*!< \brief Normal prediction, with transform (if needed). */
 #define C_API_PREDICT_RAW_SCORE  (1)  /*!< \brief Predict raw score. */
@@ -668,6 +669,76 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterCreateFromModelfile(const char* filename,
                                                       int* out_num_iterations,
                                                       BoosterHandle* out);
 
+/*!
+ * \brief Load an existing booster from a binary model written by ``LGBM_BoosterSaveModelBinary``.
+ * \note
+ * A file is mapped into memory and the flattened trees used by prediction are read in place,
+ * so the pages are shared by all the processes loading the same file.
+ * The trees themselves, used by SHAP values, refit, saving and the prediction types the flattened trees
+ * do not cover, are still copied to the heap of every process: about as much memory again as the file.
+ * A buffer is copied, it can be freed once this function returns.
+ * \param filename Filename of binary model, ``NULL`` when loading from ``buffer``
+ * \param buffer Content of binary model, ``NULL`` when loading from ``filename``
+ * \param buffer_len Length of ``buffer`` in bytes
+ * \param[out] out_num_iterations Number of iterations of this booster
+ * \param[out] out Handle of created booster
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterCreateFromModelBinary(const char* filename,
+                                                        const void* buffer,
+                                                        int64_t buffer_len,
+                                                        int* out_num_iterations,
+                                                        BoosterHandle* out);
+
+/*!
+ * \brief Load an existing booster from a shared library built by ``LGBM_BoosterSaveModelCompiled`` or by ``task=compile``.
+ * \note
+ * Scores (raw or transformed) are then predicted by the compiled code, over blocks of rows for matrices;
+ * the other prediction types use the model embedded in the library.
+ * The library stays loaded until the booster is freed, and is no longer used once the model is modified.
+ * \param filename Filename of the shared library
+ * \param[out] out_num_iterations Number of iterations of this booster
+ * \param[out] out Handle of created booster
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterLoadCompiled(const char* filename,
+                                               int* out_num_iterations,
+                                               BoosterHandle* out);
+
+/*!
+ * \brief Create a prediction-only booster sharing the trees of some iterations of an existing booster, without copying them.
+ * \note
+ * A shared tree is copied by the first booster modifying it in place (e.g. ``LGBM_BoosterSetLeafValue``,
+ * ``LGBM_BoosterRollbackOneIter``, dart training); the trees appended by training are not shared.
+ * The view also shares the flattened forest used for prediction, which is built by this call if needed.
+ * Both boosters can be freed in any order.
+ * \param handle Handle of the booster viewed
+ * \param start_iteration Start index of the iterations of the view
+ * \param num_iteration Number of iterations of the view, <= 0 means up to the last one
+ * \param[out] out_num_iterations Number of iterations of the view
+ * \param[out] out Handle of created booster
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterCreateView(BoosterHandle handle,
+                                             int start_iteration,
+                                             int num_iteration,
+                                             int* out_num_iterations,
+                                             BoosterHandle* out);
+
+/*!
+ * \brief Get the memory used by the trees of a booster and by its flattened forest.
+ * \note
+ * Memory shared with other boosters (see ``LGBM_BoosterCreateView``) is reported by each of them,
+ * so the memory of a process is the sum of the own bytes of its boosters plus the shared bytes counted once.
+ * \param handle Handle of booster
+ * \param[out] out_own_bytes Bytes used by this booster only
+ * \param[out] out_shared_bytes Bytes shared with other boosters
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterGetMemoryUsage(BoosterHandle handle,
+                                                 int64_t* out_own_bytes,
+                                                 int64_t* out_shared_bytes);
+
 /*!
  * \brief Load an existing booster from string.
  * \param model_str Model string
@@ -778,6 +849,29 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterRefit(BoosterHandle handle,
                                         int32_t nrow,
                                         int32_t ncol);
 
+/*!
+ * \brief Refit the tree model using the new data (online learning), given as the features of the training data.
+ *        Unlike ``LGBM_BoosterRefit``, the leaf indices of the rows are computed for a block of iterations
+ *        at a time, between the refits of the trees, so that the leaf indices of all the trees are never stored:
+ *        at most ``refit_leaf_buffer_size`` of them (a parameter of the booster) are kept in memory,
+ *        but always at least the ``nrow * num_tree_per_iteration`` leaf indices of one iteration,
+ *        since refitting a tree needs the leaves of all the rows.
+ *        The result is the same as refitting with the leaf indices predicted for ``data``.
+ * \param handle Handle of booster
+ * \param data Pointer to the features of the training data of the booster, in the same order
+ * \param data_type Type of ``data`` pointer, can be ``C_API_DTYPE_FLOAT32`` or ``C_API_DTYPE_FLOAT64``
+ * \param nrow Number of rows, must be the number of training data
+ * \param ncol Number of columns, must be the number of features of the model
+ * \param is_row_major 1 for row-major, 0 for column-major
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterRefitForMat(BoosterHandle handle,
+                                              const void* data,
+                                              int data_type,
+                                              int32_t nrow,
+                                              int32_t ncol,
+                                              int is_row_major);
+
 /*!
  * \brief Update the model by specifying gradient and Hessian directly
  *        (this can be used to support customized loss functions).
@@ -951,7 +1045,8 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterGetPredict(BoosterHandle handle,
  *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iterations for prediction, <= 0 means no limit
- * \param parameter Other parameters for prediction, e.g. early stopping for prediction
+ * \param parameter Other parameters for prediction, e.g. early stopping for prediction,
+ *                  or ``predict_output_format=float32`` to write raw binary values instead of text
  * \param result_filename Filename of result file in which predictions will be written
  * \return 0 when succeed, -1 when failure happens
  */
@@ -964,6 +1059,39 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForFile(BoosterHandle handle,
                                                  const char* parameter,
                                                  const char* result_filename);
 
+/*!
+ * \brief Make prediction for file, starting from the raw scores of previous iterations.
+ *        Only the iterations from ``start_iteration`` on are evaluated, and their raw score is added to
+ *        the raw score of iterations ``[0, start_iteration)``, as predicted before the model grew.
+ * \note
+ * Early stopping for prediction is disabled, a partial raw score says nothing about the final decision.
+ * The number of rows of ``data_filename`` and ``init_score_filename`` are compared before ``result_filename`` is created.
+ * \param handle Handle of booster
+ * \param data_filename Filename of file with data
+ * \param data_has_header Whether file has header or not
+ * \param predict_type What should be predicted
+ *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
+ *   - ``C_API_PREDICT_RAW_SCORE``: raw score
+ * \param init_score_filename Filename of the raw scores of iterations ``[0, start_iteration)``,
+ *                            one line per row of ``data_filename`` with ``num_class`` tab separated values,
+ *                            i.e. the result file of a ``C_API_PREDICT_RAW_SCORE`` prediction.
+ *                            If ``NULL`` or empty, ``data_filename`` + ``".init"`` is used
+ * \param start_iteration Start index of the iteration to predict, i.e. number of iterations of the previous scores
+ * \param num_iteration Number of iterations for prediction, <= 0 means no limit
+ * \param parameter Other parameters for prediction
+ * \param result_filename Filename of result file in which predictions will be written
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForFileFromScore(BoosterHandle handle,
+                                                          const char* data_filename,
+                                                          int data_has_header,
+                                                          int predict_type,
+                                                          const char* init_score_filename,
+                                                          int start_iteration,
+                                                          int num_iteration,
+                                                          const char* parameter,
+                                                          const char* result_filename);
+
 /*!
  * \brief Get number of predictions.
  * \param handle Handle of booster
@@ -985,6 +1113,31 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterCalcNumPredict(BoosterHandle handle,
                                                  int num_iteration,
                                                  int64_t* out_len);
 
+/*!
+ * \brief Get the deviation of predictions made with ``predict_float32=true`` from the double precision ones.
+ * \note
+ * Float32 inputs, and float64 inputs whose values are representable as ``float``, take the same decisions
+ * in both modes, so their raw scores only differ by the rounding of the leaf values to ``float``,
+ * and are identical when ``out_max_deviation`` is ``0``.
+ * Other float64 inputs are rounded to ``float`` first, and may then be routed differently at any numerical
+ * threshold: e.g. ``t + 1e-10`` goes right of a threshold ``t`` in double precision, but is rounded to ``t``
+ * and goes left in single precision, and values above the ``float`` range become infinite.
+ * Their raw scores are not bounded by ``out_max_deviation``.
+ * \param handle Handle of booster
+ * \param start_iteration Start index of the iteration to predict
+ * \param num_iteration Number of iterations for prediction, <= 0 means no limit
+ * \param[out] out_num_inexact_thresholds Number of numerical thresholds which are not representable as ``float``,
+ *                                         and are rounded down in single precision
+ * \param[out] out_max_deviation Upper bound of the absolute difference of the raw scores for inputs
+ *                               representable as ``float``
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterGetFloat32Deviation(BoosterHandle handle,
+                                                      int start_iteration,
+                                                      int num_iteration,
+                                                      int* out_num_inexact_thresholds,
+                                                      double* out_max_deviation);
+
 /*!
  * \brief Release FastConfig object.
  *
@@ -993,6 +1146,20 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterCalcNumPredict(BoosterHandle handle,
  */
 LIGHTGBM_C_EXPORT int LGBM_FastConfigFree(FastConfigHandle fastConfig);
 
+/*!
+ * \brief Get the shape of the rows predicted with a FastConfig object, e.g. to check the size of caller buffers.
+ *
+ * \param fastConfig Handle to the FastConfig object acquired with a ``*FastInit()`` method
+ * \param[out] out_data_type Type of the feature values, ``C_API_DTYPE_FLOAT32`` or ``C_API_DTYPE_FLOAT64``
+ * \param[out] out_ncol Number of columns of a row
+ * \param[out] out_len Number of predictions written for one row
+ * \return 0 when it succeeds, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_FastConfigGetShape(FastConfigHandle fastConfig,
+                                              int* out_data_type,
+                                              int32_t* out_ncol,
+                                              int64_t* out_len);
+
 /*!
  * \brief Make prediction for a new dataset in CSR format.
  * \note
@@ -1037,6 +1204,50 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForCSR(BoosterHandle handle,
                                                 int64_t* out_len,
                                                 double* out_result);
 
+/*!
+ * \brief Make prediction for a new dataset in CSR format, starting from the raw scores of previous iterations.
+ *        Only the iterations from ``start_iteration`` on are evaluated, and their raw score is added to
+ *        the raw score of iterations ``[0, start_iteration)``, as predicted before the model grew.
+ * \note
+ * You should pre-allocate memory for ``out_result``, its length is equal to ``num_class * num_data``.
+ * \param handle Handle of booster
+ * \param indptr Pointer to row headers
+ * \param indptr_type Type of ``indptr``, can be ``C_API_DTYPE_INT32`` or ``C_API_DTYPE_INT64``
+ * \param indices Pointer to column indices
+ * \param data Pointer to the data space
+ * \param data_type Type of ``data`` pointer, can be ``C_API_DTYPE_FLOAT32`` or ``C_API_DTYPE_FLOAT64``
+ * \param nindptr Number of rows in the matrix + 1
+ * \param nelem Number of nonzero elements in the matrix
+ * \param num_col Number of columns
+ * \param predict_type What should be predicted
+ *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
+ *   - ``C_API_PREDICT_RAW_SCORE``: raw score
+ * \param init_score Raw scores of iterations ``[0, start_iteration)``, ``num_class`` values per row,
+ *                   i.e. the output of a ``C_API_PREDICT_RAW_SCORE`` prediction
+ * \param start_iteration Start index of the iteration to predict, i.e. number of iterations of ``init_score``
+ * \param num_iteration Number of iterations for prediction, <= 0 means no limit
+ * \param parameter Other parameters for prediction, early stopping for prediction is disabled
+ * \param[out] out_len Length of output result
+ * \param[out] out_result Pointer to array with predictions
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForCSRFromScore(BoosterHandle handle,
+                                                         const void* indptr,
+                                                         int indptr_type,
+                                                         const int32_t* indices,
+                                                         const void* data,
+                                                         int data_type,
+                                                         int64_t nindptr,
+                                                         int64_t nelem,
+                                                         int64_t num_col,
+                                                         int predict_type,
+                                                         const double* init_score,
+                                                         int start_iteration,
+                                                         int num_iteration,
+                                                         const char* parameter,
+                                                         int64_t* out_len,
+                                                         double* out_result);
+
 /*!
  * \brief Make sparse prediction for a new dataset in CSR or CSC format. Currently only used for feature contributions.
  * \note
@@ -1183,6 +1394,10 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForCSRSingleRowFastInit(BoosterHandle h
  *   or that number of threads will be used for these calls as well.
  *
  * \note
+ *   The same ``FastConfig`` can be used by several threads at the same time, without locking
+ *   as long as the booster is not modified.
+ *
+ * \note
  * You should pre-allocate memory for ``out_result``:
  *   - for normal and raw score, its length is equal to ``num_class * num_data``;
  *   - for leaf index, its length is equal to ``num_class * num_data * num_iteration``;
@@ -1291,6 +1506,106 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForMat(BoosterHandle handle,
                                                 int64_t* out_len,
                                                 double* out_result);
 
+/*!
+ * \brief Predict the leaf index of each row in each tree, as compact integers.
+ *        Same as ``LGBM_BoosterPredictForMat`` with ``C_API_PREDICT_LEAF_INDEX``,
+ *        but with 2 or 4 times less memory than ``double`` leaf indices.
+ * \note
+ * You should pre-allocate memory for ``out_result``, its length is equal to ``num_class * num_iteration * num_data``.
+ * \param handle Handle of booster
+ * \param data Pointer to the data space
+ * \param data_type Type of ``data`` pointer, can be ``C_API_DTYPE_FLOAT32`` or ``C_API_DTYPE_FLOAT64``
+ * \param nrow Number of rows
+ * \param ncol Number of columns
+ * \param is_row_major 1 for row-major, 0 for column-major
+ * \param start_iteration Start index of the iteration to predict
+ * \param num_iteration Number of iteration for prediction, <= 0 means no limit
+ * \param parameter Other parameters for prediction
+ * \param out_type Type of ``out_result``, can be ``C_API_DTYPE_INT32`` or ``C_API_DTYPE_INT16``.
+ *                 Fails with ``C_API_DTYPE_INT16`` when a leaf index is above ``32767``
+ * \param[out] out_len Length of output result
+ * \param[out] out_result Pointer to array with leaf indices
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterPredictLeafIndexForMat(BoosterHandle handle,
+                                                         const void* data,
+                                                         int data_type,
+                                                         int32_t nrow,
+                                                         int32_t ncol,
+                                                         int is_row_major,
+                                                         int start_iteration,
+                                                         int num_iteration,
+                                                         const char* parameter,
+                                                         int out_type,
+                                                         int64_t* out_len,
+                                                         void* out_result);
+
+/*!
+ * \brief Make prediction for a new dataset, starting from the raw scores of previous iterations.
+ *        Only the iterations from ``start_iteration`` on are evaluated, and their raw score is added to
+ *        the raw score of iterations ``[0, start_iteration)``, as predicted before the model grew.
+ * \note
+ * You should pre-allocate memory for ``out_result``, its length is equal to ``num_class * num_data``.
+ * \param handle Handle of booster
+ * \param data Pointer to the data space
+ * \param data_type Type of ``data`` pointer, can be ``C_API_DTYPE_FLOAT32`` or ``C_API_DTYPE_FLOAT64``
+ * \param nrow Number of rows
+ * \param ncol Number of columns
+ * \param is_row_major 1 for row-major, 0 for column-major
+ * \param predict_type What should be predicted
+ *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
+ *   - ``C_API_PREDICT_RAW_SCORE``: raw score
+ * \param init_score Raw scores of iterations ``[0, start_iteration)``, ``num_class`` values per row,
+ *                   i.e. the output of a ``C_API_PREDICT_RAW_SCORE`` prediction
+ * \param start_iteration Start index of the iteration to predict, i.e. number of iterations of ``init_score``
+ * \param num_iteration Number of iteration for prediction, <= 0 means no limit
+ * \param parameter Other parameters for prediction, early stopping for prediction is disabled
+ * \param[out] out_len Length of output result
+ * \param[out] out_result Pointer to array with predictions
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForMatFromScore(BoosterHandle handle,
+                                                         const void* data,
+                                                         int data_type,
+                                                         int32_t nrow,
+                                                         int32_t ncol,
+                                                         int is_row_major,
+                                                         int predict_type,
+                                                         const double* init_score,
+                                                         int start_iteration,
+                                                         int num_iteration,
+                                                         const char* parameter,
+                                                         int64_t* out_len,
+                                                         double* out_result);
+
+/*!
+ * \brief Make prediction for a constructed dataset, walking the trees on its bins.
+ *        The raw values of the dataset are not needed, so it can be built from a file or loaded from a binary file.
+ *        The dataset must have the bins of the training data (e.g. be constructed with it as reference),
+ *        otherwise the thresholds of the trees may not be bin boundaries and the call fails.
+ * \note
+ * You should pre-allocate memory for ``out_result``, its length is equal to ``num_class * num_data``.
+ * \param handle Handle of booster
+ * \param dataset Handle of the dataset
+ * \param predict_type What should be predicted
+ *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
+ *   - ``C_API_PREDICT_RAW_SCORE``: raw score
+ * \param start_iteration Start index of the iteration to predict
+ * \param num_iteration Number of iteration for prediction, <= 0 means no limit
+ * \param parameter Other parameters for prediction
+ * \param[out] out_len Length of output result
+ * \param[out] out_result Pointer to array with predictions
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForDataset(BoosterHandle handle,
+                                                    const DatasetHandle dataset,
+                                                    int predict_type,
+                                                    int start_iteration,
+                                                    int num_iteration,
+                                                    const char* parameter,
+                                                    int64_t* out_len,
+                                                    double* out_result);
+
 /*!
  * \brief Make prediction for a new dataset. This method re-uses the internal predictor structure
  *        from previous calls and is optimized for single row invocation.
@@ -1370,6 +1685,10 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForMatSingleRowFastInit(BoosterHandle h
  *   If you use a different number of threads in other calls, you need to start the setup process over,
  *   or that number of threads will be used for these calls as well.
  *
+ * \note
+ *   The same ``FastConfig`` can be used by several threads at the same time, without locking
+ *   as long as the booster is not modified.
+ *
  * \param fastConfig_handle FastConfig object handle returned by ``LGBM_BoosterPredictForMatSingleRowFastInit``
  * \param data Single-row array data (no other way than row-major form).
  * \param[out] out_len Length of output result
@@ -1466,6 +1785,44 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterSaveModel(BoosterHandle handle,
                                             int feature_importance_type,
                                             const char* filename);
 
+/*!
+ * \brief Save model into a binary file, which can be loaded by ``LGBM_BoosterCreateFromModelBinary``.
+ * \note
+ * The binary format is versioned and only readable on machines with the same byte order.
+ * \param handle Handle of booster
+ * \param start_iteration Start index of the iteration that should be saved
+ * \param num_iteration Index of the iteration that should be saved, <= 0 means save all
+ * \param feature_importance_type Type of feature importance, can be ``C_API_FEATURE_IMPORTANCE_SPLIT`` or ``C_API_FEATURE_IMPORTANCE_GAIN``
+ * \param filename The name of the file
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterSaveModelBinary(BoosterHandle handle,
+                                                  int start_iteration,
+                                                  int num_iteration,
+                                                  int feature_importance_type,
+                                                  const char* filename);
+
+/*!
+ * \brief Generate self-contained C code of the model and build it into a shared library, which can be loaded by ``LGBM_BoosterLoadCompiled``.
+ * \note
+ * The C source is saved next to the library, with the ``.c`` extension.
+ * The compiled code predicts the same scores as the interpreted model, bit for bit.
+ * \param handle Handle of booster
+ * \param num_iteration Number of iterations that should be compiled, <= 0 means compile all
+ * \param use_float32 Whether to also compile the entry point used by ``predict_float32``
+ * \param compiler Command of the C compiler, ``NULL`` means ``cc``
+ * \param compiler_flags Flags of the compiler, ``NULL`` means ``-O3``; the flags building a shared library are added,
+ *                       no shell is involved: the flags are split at whitespace
+ * \param filename Filename of the shared library
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterSaveModelCompiled(BoosterHandle handle,
+                                                    int num_iteration,
+                                                    int use_float32,
+                                                    const char* compiler,
+                                                    const char* compiler_flags,
+                                                    const char* filename);
+
 /*!
  * \brief Save model to string.
  * \param handle Handle of booster
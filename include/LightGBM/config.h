@@ -32,7 +32,7 @@ namespace LightGBM {
 
 /*! \brief Types of tasks */
 enum TaskType {
-  kTrain, kPredict, kConvertModel, KRefitTree, kSaveBinary
+  kTrain, kPredict, kConvertModel, KRefitTree, kSaveBinary, kCompileModel
 };
 const int kDefaultNumLeaves = 31;
 
@@ -117,13 +117,14 @@ struct Config {
   // [no-save]
   // type = enum
   // default = train
-  // options = train, predict, convert_model, refit
+  // options = train, predict, convert_model, refit, save_binary, compile
   // alias = task_type
   // desc = ``train``, for training, aliases: ``training``
   // desc = ``predict``, for prediction, aliases: ``prediction``, ``test``
   // desc = ``convert_model``, for converting model file into if-else format, see more information in `Convert Parameters <#convert-parameters>`__
   // desc = ``refit``, for refitting existing models with new data, aliases: ``refit_tree``
   // desc = ``save_binary``, load train (and validation) data then save dataset to binary file. Typical usage: ``save_binary`` first, then run multiple ``train`` tasks in parallel using the saved binary file
+  // desc = ``compile``, for compiling model file into a shared library loaded by ``LGBM_BoosterLoadCompiled``, aliases: ``compile_model``, see more information in `Compile Parameters <#compile-parameters>`__
   // desc = **Note**: can be used only in CLI version; for language-specific packages you can use the correspondent functions
   TaskType task = TaskType::kTrain;
 
@@ -300,10 +301,45 @@ struct Config {
   // desc = ``< 0`` means no limit
   double histogram_pool_size = -1.0;
 
+  // desc = used only with ``cpu`` device type and row-wise histogram building
+  // desc = set this to ``true`` to keep a copy of the row-wise bins in the order of the leaves, partitioned along with the data at each split
+  // desc = the histograms of a leaf then read its rows as one contiguous block, instead of gathering them from the whole data, which helps when the bins are much larger than the CPU caches
+  // desc = the histograms, and so the models, are the same as without the copy
+  // desc = **Note**: the copy and its partition buffer take up to twice the memory of the row-wise bins, use ``leaf_ordered_bins_max_memory`` to limit it
+  bool leaf_ordered_bins = false;
+
+  // desc = max memory in MB for ``leaf_ordered_bins``, the leaf-ordered copy is not used when it would need more
+  // desc = ``< 0`` means no limit
+  double leaf_ordered_bins_max_memory = -1.0;
+
+  // desc = used only with ``cpu`` device type, ``serial`` tree learner and several trees per iteration, e.g. ``multiclass``
+  // desc = set this to ``true`` to construct the root histograms of the trees of all the classes of an iteration with one pass over the data, instead of one pass per class
+  // desc = the histograms, and so the models, are the same as without it
+  // desc = **Note**: the root histograms of all the classes are kept until their trees are trained. With row-wise histogram building, each thread also needs its own histograms of all the classes
+  // desc = **Note**: not used with ``feature_fraction < 1.0``, with ``use_quantized_grad`` or when the hessians are constant
+  bool multiclass_root_histograms = false;
+
   // desc = limit the max depth for tree model. This is used to deal with over-fitting when ``#data`` is small. Tree still grows leaf-wise
   // desc = ``<= 0`` means no limit
   int max_depth = -1;
 
+  // type = enum
+  // options = leafwise, depthwise
+  // desc = order in which the leaves are split
+  // descl2 = ``leafwise``, split the leaf with the largest gain first
+  // descl2 = ``depthwise``, split all the leaves of a level before going deeper, the leaves of a level are split by decreasing gain until ``num_leaves`` is reached. The histograms of all the leaves of a level are constructed in a single pass over each feature group
+  // desc = **Note**: ``depthwise`` is only supported by the ``serial`` tree learner on ``cpu``, without forced splits and with ``basic`` monotone constraints
+  std::string grow_policy = "leafwise";
+
+  // alias = symmetric_tree
+  // desc = grow oblivious (symmetric) trees, all the nodes of a level split on the same feature and threshold
+  // desc = the split of a level maximizes the sum of the gains over all the leaves of the level, every leaf of the level is split
+  // desc = the trees have ``max_depth`` levels, and at most ``num_leaves`` leaves, so ``floor(log2(num_leaves))`` levels when ``max_depth <= 0``
+  // desc = the leaf of a record is computed from the bits of the level decisions, without walking the nodes, which speeds up prediction
+  // desc = only numerical features are used for splits, missing values go to the side of the most frequent bin
+  // desc = **Note**: works only with ``cpu`` device type and ``serial`` tree learner, without linear trees, forced splits, monotone or interaction constraints
+  bool oblivious_tree = false;
+
   // alias = min_data_per_leaf, min_data, min_child_samples, min_samples_leaf
   // check = >=0
   // desc = minimal number of data in one leaf. Can be used to deal with over-fitting
@@ -548,6 +584,12 @@ struct Config {
   // desc = used only in ``refit`` task in CLI version or as argument in ``refit`` function in language-specific package
   double refit_decay_rate = 0.9;
 
+  // check = >0
+  // desc = used only by ``LGBM_BoosterRefitForMat``, which computes the leaves of the records from their features
+  // desc = maximal number of leaf indices stored at once, but never less than the ``num_data * num_tree_per_iteration`` leaves of one iteration: the leaves of as many iterations as fit are computed with one pass on the features, then these trees are refitted
+  // desc = bounds the memory used by the leaf indices to ``4 * max(refit_leaf_buffer_size, num_data * num_tree_per_iteration)`` bytes
+  int refit_leaf_buffer_size = 33554432;
+
   // check = >=0.0
   // desc = cost-effective gradient boosting multiplier for all penalties
   double cegb_tradeoff = 1.0;
@@ -876,6 +918,64 @@ struct Config {
   // desc = the threshold of margin in early-stopping prediction
   double pred_early_stop_margin = 10.0;
 
+  // [no-save]
+  // desc = used only in ``prediction`` task and if ``pred_early_stop=true``
+  // desc = if ``true``, the prediction of a record only stops when it provably cannot change its decision, ``pred_early_stop_margin`` is not used
+  // desc = the decision is the side of ``pred_early_stop_threshold`` of the raw score for binary models, and the class with the highest raw score for multiclass models
+  // desc = the sums of the highest and of the lowest leaf values of the remaining trees bound the raw score the record would reach, the prediction stops when the decision is the same at both bounds
+  // desc = the check happens every ``pred_early_stop_freq`` iterations, records stopped early output the raw score of the iterations predicted so far
+  // desc = **Note**: it is not used with linear trees
+  bool pred_early_stop_exact = false;
+
+  // [no-save]
+  // desc = used only in ``prediction`` task and if ``pred_early_stop_exact=true``
+  // desc = decision threshold on the raw score of binary models, e.g. ``log(p / (1 - p))`` for a probability threshold ``p`` with the ``binary`` objective
+  double pred_early_stop_threshold = 0.0;
+
+  // [no-save]
+  // check = >=0
+  // desc = used only in ``prediction`` task
+  // desc = number of rows scored together against one tree before moving on to the next tree, so that both the tree and the rows stay in cache
+  // desc = ``0`` means each row is scored against all the trees on its own
+  // desc = **Note**: only applies to normal and raw score prediction without ``pred_early_stop`` or with ``pred_early_stop_exact``, and to ``predict_contrib``
+  // desc = with ``pred_early_stop_exact``, the rows of a block which cannot change their decision are left out of the next iterations
+  // desc = **Note**: ``predict_contrib`` always explains rows by blocks, of ``32`` rows when this is ``0``
+  int predict_block_size = 0;
+
+  // [no-save]
+  // desc = used only in ``prediction`` task
+  // desc = if ``true``, trees with only numerical splits and at most 64 leaves are evaluated with the QuickScorer bitvector algorithm, which scans the sorted thresholds of each feature instead of walking the trees node by node
+  // desc = the other trees (with categorical splits or linear leaves) are predicted the usual way, results are the same in both cases
+  // desc = usually faster for large ensembles of small trees
+  // desc = **Note**: only applies to normal and raw score prediction
+  bool predict_quick_scorer = false;
+
+  // [no-save]
+  // desc = used only in ``prediction`` task
+  // desc = if ``true``, thresholds, leaf values and feature buffers are stored as ``float`` instead of ``double``, which halves the memory read by each prediction
+  // desc = thresholds are rounded down, so float32 inputs take exactly the same decisions as with ``double``, and the raw score only deviates by the rounding of the leaf values (``0`` when they are representable as ``float``)
+  // desc = float64 inputs are rounded to ``float`` first; unless their values are representable as ``float``, they may then be routed differently at any threshold (e.g. ``t + 1e-10`` is rounded to the threshold ``t``), and their predictions are not bounded
+  // desc = the maximal deviation for inputs representable as ``float`` can be queried with ``LGBM_BoosterGetFloat32Deviation``
+  // desc = **Note**: only applies to normal and raw score prediction of models without linear trees, ``predict_quick_scorer`` is ignored
+  bool predict_float32 = false;
+
+  // [no-save]
+  // desc = used only in ``prediction`` task
+  // desc = if ``true``, the thresholds of each feature are gathered from all the trees into a sorted table, each record is converted once into the positions of its values in these tables (stored as ``uint8`` or ``uint16``), and the trees are then walked with integer comparisons
+  // desc = results are the same as without it, usually faster for large ensembles, where each value is compared much more often than it is converted
+  // desc = **Note**: only applies to normal and raw score prediction of models without linear trees, ``predict_quick_scorer`` is ignored, and ``predict_float32`` takes precedence
+  bool predict_binned = false;
+
+  // [no-save]
+  // type = enum
+  // options = text, float32, float64
+  // desc = used only in ``prediction`` task
+  // desc = format of the prediction result file
+  // descl2 = ``text``, one line per record with tab separated values
+  // descl2 = ``float32``, ``float64``, the values of all the records one after the other as raw binary numbers in native byte order, without header nor separator. Records are not formatted as text, which is much faster for large files
+  // desc = **Note**: ``task=refit`` always writes the leaf indices as ``text``
+  std::string predict_output_format = "text";
+
   // [no-save]
   // alias = predict_result, prediction_result, predict_name, prediction_name, pred_name, name_pred
   // desc = used only in ``prediction`` task
@@ -906,6 +1006,39 @@ struct Config {
   #ifndef __NVCC__
   #pragma endregion
 
+  #pragma region Compile Parameters
+  #endif  // __NVCC__
+
+  // [no-save]
+  // alias = compiled_model_file
+  // desc = used only in ``compile`` task
+  // desc = output filename of the shared library, the generated C source is saved next to it with the ``.c`` extension
+  // desc = **Note**: the C API takes it as an argument of ``LGBM_BoosterSaveModelCompiled`` instead
+  std::string compiled_model = "gbdt_prediction.so";
+
+  // [no-save]
+  // desc = used only in ``compile`` task
+  // desc = set this to ``true`` to also compile the entry point used by ``predict_float32``
+  // desc = **Note**: the C API takes it as an argument of ``LGBM_BoosterSaveModelCompiled`` instead
+  bool compile_float32 = false;
+
+  // [no-save]
+  // desc = used only in ``compile`` task
+  // desc = C compiler building the shared library, a program name searched in the ``PATH`` or a path, it must accept the ``gcc`` flags ``-shared -fPIC -o``
+  // desc = **Note**: the C API takes it as an argument of ``LGBM_BoosterSaveModelCompiled`` instead
+  std::string compiler = "cc";
+
+  // [no-save]
+  // desc = used only in ``compile`` task
+  // desc = flags passed to ``compiler``, the flags building a shared library are added
+  // desc = no shell runs ``compiler``, the flags are split at whitespace and quotes are passed unchanged
+  // desc = add ``-march=native`` to use the vector instructions of the machine the library is built on, this needs ``LGBM_BoosterSaveModelCompiled`` as parameter values cannot contain ``=``
+  // desc = **Note**: the C API takes it as an argument of ``LGBM_BoosterSaveModelCompiled`` instead
+  std::string compiler_flags = "-O3";
+
+  #ifndef __NVCC__
+  #pragma endregion
+
   #pragma endregion
 
   #pragma region Objective Parameters
@@ -722,6 +722,21 @@ class Dataset {
                                    TrainingShareStates* share_state,
                                    hist_t* hist_data) const;
 
+  /*!
+   * \brief Construct the histograms of a leaf from the leaf-ordered bins of the row-wise share states
+   * \param leaf_begin Position of the leaf in the leaf-ordered bins
+   */
+  template <bool USE_QUANT_GRAD, int HIST_BITS>
+  void ConstructHistogramsLeafOrdered(const data_size_t* data_indices,
+                                      data_size_t leaf_begin,
+                                      data_size_t num_data,
+                                      const score_t* gradients,
+                                      const score_t* hessians,
+                                      score_t* ordered_gradients,
+                                      score_t* ordered_hessians,
+                                      TrainingShareStates* share_state,
+                                      hist_t* hist_data) const;
+
   template <bool USE_QUANT_GRAD, int HIST_BITS>
   inline void ConstructHistograms(
       const std::vector<int8_t>& is_feature_used,
@@ -756,6 +771,50 @@ class Dataset {
     }
   }
 
+  /*!
+   * \brief Construct the histograms of several leaves, with one pass over each feature group for all the leaves
+   * \param is_feature_used Features whose histograms are needed
+   * \param data_indices Data indices of all the leaves, in increasing order
+   * \param leaf_slots Slot of the leaf of each data, aligned with data_indices
+   * \param num_data Number of data in data_indices
+   * \param leaf_data_indices Data indices of each slot
+   * \param leaf_num_data Number of data of each slot
+   * \param gradients Gradients of all data
+   * \param hessians Hessians of all data
+   * \param ordered_gradients Buffer of num_data gradients
+   * \param ordered_hessians Buffer of num_data hessians
+   * \param share_state Training states
+   * \param hist_data Histograms of each slot
+   */
+  void ConstructHistogramsMultiLeaf(const std::vector<int8_t>& is_feature_used,
+                                    const data_size_t* data_indices, const int* leaf_slots,
+                                    data_size_t num_data,
+                                    const std::vector<const data_size_t*>& leaf_data_indices,
+                                    const std::vector<data_size_t>& leaf_num_data,
+                                    const score_t* gradients, const score_t* hessians,
+                                    score_t* ordered_gradients, score_t* ordered_hessians,
+                                    TrainingShareStates* share_state,
+                                    const std::vector<hist_t*>& hist_data) const;
+
+  /*!
+   * \brief Construct the histograms of several outputs (e.g. the trees of the classes of multiclass) on the same data,
+   *        with one pass over the bins for all the outputs. The histograms are interleaved, like in
+   *        Bin::ConstructHistogramMultiOutput, and each one is the same as with ConstructHistograms
+   * \param is_feature_used Features whose histograms are needed
+   * \param data_indices Used data indices, nullptr to use all the data
+   * \param num_data Number of used data
+   * \param gradients Gradients of all data of each output
+   * \param hessians Hessians of all data of each output
+   * \param share_state Training states
+   * \param hist_data Interleaved histograms, of share_state->num_hist_total_bin() bins
+   */
+  void ConstructHistogramsMultiOutput(const std::vector<int8_t>& is_feature_used,
+                                      const data_size_t* data_indices, data_size_t num_data,
+                                      const std::vector<const score_t*>& gradients,
+                                      const std::vector<const score_t*>& hessians,
+                                      TrainingShareStates* share_state,
+                                      hist_t* hist_data) const;
+
   void FixHistogram(int feature_idx, double sum_gradient, double sum_hessian, hist_t* data) const;
 
   template <typename PACKED_HIST_BIN_T, typename PACKED_HIST_ACC_T, int HIST_BITS_BIN, int HIST_BITS_ACC>
@@ -997,6 +1056,9 @@ class Dataset {
   #endif  // USE_CUDA
 
  private:
+  /*! \brief Collect the used non multi-value groups, return the used multi-value group or -1 */
+  int GetUsedGroups(const std::vector<int8_t>& is_feature_used, std::vector<int>* used_dense_group) const;
+
   void SerializeHeader(BinaryWriter* serializer);
 
   size_t GetSerializedHeaderSize();
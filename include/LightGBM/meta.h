@@ -62,7 +62,7 @@ using PredictFunction =
 std::function<void(const std::vector<std::pair<int, double>>&, double* output)>;
 
 using PredictSparseFunction =
-std::function<void(const std::vector<std::pair<int, double>>&, std::vector<std::unordered_map<int, double>>* output)>;
+std::function<void(const std::vector<std::pair<int, double>>&, std::vector<std::vector<std::pair<int, double>>>* output)>;
 
 typedef void(*ReduceFunction)(const char* input, char* output, int type_size, comm_size_t array_size);
 
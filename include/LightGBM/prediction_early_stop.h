@@ -20,11 +20,17 @@ struct PredictionEarlyStopInstance {
 
   FunctionType callback_function;  // callback function itself
   int          round_period;       // call callback_function every `runPeriod` iterations
+  /// Exact early stopping: instead of calling callback_function, boosters stop a prediction when
+  /// the bounds of the remaining trees prove that it cannot change its decision, i.e. the side of
+  /// `decision_threshold` of a single raw score, or the class with the highest raw score
+  bool         is_exact;
+  double       decision_threshold;
 };
 
 struct PredictionEarlyStopConfig {
   int round_period;
   double margin_threshold;
+  double decision_threshold;  // only used by the exact types
 };
 
 /// Create an early stopping algorithm of type `type`, with given round_period and margin threshold
@@ -16,6 +16,26 @@
 
 namespace LightGBM {
 
+/*!
+* \brief Interleave the gradients and hessians of several outputs for the data in [start, end),
+*        in the layout of Bin::ConstructHistogramMultiOutput
+* \param data_indices Used data indices, nullptr to use the data in [start, end)
+*/
+inline void InterleaveGradientsAndHessians(const data_size_t* data_indices, data_size_t start, data_size_t end,
+                                           const std::vector<const score_t*>& gradients,
+                                           const std::vector<const score_t*>& hessians,
+                                           score_t* out) {
+  const int num_outputs = static_cast<int>(gradients.size());
+  for (data_size_t i = start; i < end; ++i) {
+    const data_size_t idx = data_indices != nullptr ? data_indices[i] : i;
+    score_t* gh = out + static_cast<size_t>(i - start) * num_outputs * 2;
+    for (int k = 0; k < num_outputs; ++k) {
+      gh[k * 2] = gradients[k][idx];
+      gh[k * 2 + 1] = hessians[k][idx];
+    }
+  }
+}
+
 class MultiValBinWrapper {
  public:
   MultiValBinWrapper(MultiValBin* bin, data_size_t num_data,
@@ -54,6 +74,84 @@ class MultiValBinWrapper {
     const auto cur_multi_val_bin = (is_use_subcol_ || is_use_subrow_)
           ? multi_val_bin_subset_.get()
           : multi_val_bin_.get();
+    ConstructHistogramsOfRows<USE_INDICES, ORDERED, USE_QUANT_GRAD, HIST_BITS>(
+      cur_multi_val_bin, data_indices, 0, num_data, gradients, hessians, hist_buf, origin_hist_data);
+  }
+
+  /*!
+  * \brief Use a copy of the bins in the order of the data partition, when its memory is below max_memory_mb
+  * \return Whether the copy is used
+  */
+  bool EnableLeafOrdered(double max_memory_mb);
+
+  /*!
+  * \brief Copy the rows of the data partition to the leaf-ordered bins, at the beginning of a tree
+  * \param partition_indices Data indices of the data partition, they must stay at the same address during the tree
+  * \param num_data Number of data in the data partition
+  */
+  void InitLeafOrdered(const data_size_t* partition_indices, data_size_t num_data);
+
+  /*!
+  * \brief Partition the leaf-ordered bins like the data partition after a split
+  * \param begin Position of the split leaf in the data partition
+  * \param left_cnt Number of data of the left child, which keeps the position of the split leaf
+  * \param right_cnt Number of data of the right child
+  */
+  void SplitLeafOrdered(data_size_t begin, data_size_t left_cnt, data_size_t right_cnt);
+
+  /*!
+  * \brief Position in the leaf-ordered bins of the rows of a leaf
+  * \param data_indices Data indices of the leaf
+  * \return The position, or -1 when data_indices are not a range of the data partition
+  */
+  data_size_t LeafOrderedBegin(const data_size_t* data_indices, data_size_t num_data) const {
+    if (leaf_ordered_bins_[0] == nullptr || partition_indices_ == nullptr || data_indices < partition_indices_ ||
+        data_indices + num_data > partition_indices_ + leaf_ordered_indices_.size()) {
+      return -1;
+    }
+    return static_cast<data_size_t>(data_indices - partition_indices_);
+  }
+
+  /*!
+  * \brief Construct the histograms of the leaf at leaf_begin in the leaf-ordered bins, reading its rows contiguously
+  * \param ordered_gradients Gradients, ordered_gradients[leaf_begin + i] is the gradient of the i-th data of the leaf
+  */
+  template <bool USE_QUANT_GRAD, int HIST_BITS>
+  void ConstructLeafOrderedHistograms(data_size_t leaf_begin,
+      data_size_t num_data,
+      const score_t* ordered_gradients,
+      const score_t* ordered_hessians,
+      std::vector<hist_t, Common::AlignmentAllocator<hist_t, kAlignedSize>>* hist_buf,
+      hist_t* origin_hist_data) {
+    ConstructHistogramsOfRows<false, false, USE_QUANT_GRAD, HIST_BITS>(
+      leaf_ordered_bins_[leaf_ordered_slots_[leaf_begin]].get(), nullptr, leaf_begin, num_data, ordered_gradients, ordered_hessians,
+      hist_buf, origin_hist_data);
+  }
+
+  /*!
+  * \brief Construct the interleaved histograms of several outputs with one pass over the rows,
+  *        see MultiValBin::ConstructHistogramMultiOutput. The rows are split in the same blocks as in
+  *        ConstructHistograms and the blocks are summed in the same order, so each output gets the same histogram
+  * \param data_indices Used data indices, nullptr to use all the data
+  * \param gradients Gradients of all data of each output
+  * \param hessians Hessians of all data of each output
+  * \param out Interleaved histograms of the bins of the multi-value bin
+  */
+  void ConstructMultiOutputHistograms(const data_size_t* data_indices,
+      data_size_t num_data,
+      const std::vector<const score_t*>& gradients,
+      const std::vector<const score_t*>& hessians,
+      hist_t* out);
+
+  template <bool USE_INDICES, bool ORDERED, bool USE_QUANT_GRAD, int HIST_BITS>
+  void ConstructHistogramsOfRows(MultiValBin* cur_multi_val_bin,
+      const data_size_t* data_indices,
+      data_size_t row_start,
+      data_size_t num_data,
+      const score_t* gradients,
+      const score_t* hessians,
+      std::vector<hist_t, Common::AlignmentAllocator<hist_t, kAlignedSize>>* hist_buf,
+      hist_t* origin_hist_data) {
     if (cur_multi_val_bin != nullptr) {
       global_timer.Start("Dataset::sparse_bin_histogram");
       n_data_block_ = 1;
@@ -66,8 +164,8 @@ class MultiValBinWrapper {
       #pragma omp parallel for schedule(static) num_threads(num_threads_)
       for (int block_id = 0; block_id < n_data_block_; ++block_id) {
         OMP_LOOP_EX_BEGIN();
-        data_size_t start = block_id * data_block_size_;
-        data_size_t end = std::min<data_size_t>(start + data_block_size_, num_data);
+        data_size_t start = row_start + block_id * data_block_size_;
+        data_size_t end = std::min<data_size_t>(start + data_block_size_, row_start + num_data);
         if (inner_hist_bits == 8) {
           ConstructHistogramsForBlock<USE_INDICES, ORDERED, USE_QUANT_GRAD, 8>(
             cur_multi_val_bin, start, end, data_indices, gradients, hessians,
@@ -242,6 +340,20 @@ class MultiValBinWrapper {
   bool is_subrow_copied_ = false;
   std::unique_ptr<MultiValBin> multi_val_bin_;
   std::unique_ptr<MultiValBin> multi_val_bin_subset_;
+  bool is_leaf_ordered_ = false;
+  /*!
+  * \brief Copies of the used bins, with the rows in the order of the data partition, the rows of a split leaf are
+  *        partitioned from one copy to the other
+  */
+  std::unique_ptr<MultiValBin> leaf_ordered_bins_[2];
+  /*! \brief Copy with the rows of each leaf, set at the position of the leaf */
+  std::vector<uint8_t> leaf_ordered_slots_;
+  /*! \brief Data indices of the leaf-ordered rows */
+  std::vector<data_size_t> leaf_ordered_indices_;
+  std::vector<uint8_t> leaf_ordered_is_left_;
+  const data_size_t* partition_indices_ = nullptr;
+  /*! \brief Interleaved histograms of the blocks of rows after the first one, for ConstructMultiOutputHistograms */
+  std::vector<hist_t, Common::AlignmentAllocator<hist_t, kAlignedSize>> multi_output_hist_buf_;
   std::vector<uint32_t> hist_move_src_;
   std::vector<uint32_t> hist_move_dest_;
   std::vector<uint32_t> hist_move_size_;
@@ -318,6 +430,54 @@ struct TrainingShareStates {
     }
   }
 
+  void EnableLeafOrderedBins(double max_memory_mb) {
+    if (is_col_wise) {
+      Log::Warning("leaf_ordered_bins is only used with row-wise histogram building, set force_row_wise=true to use it");
+    } else if (multi_val_bin_wrapper_ != nullptr) {
+      multi_val_bin_wrapper_->EnableLeafOrdered(max_memory_mb);
+    }
+  }
+
+  void InitLeafOrderedBins(const data_size_t* partition_indices, data_size_t num_data) {
+    if (multi_val_bin_wrapper_ != nullptr) {
+      multi_val_bin_wrapper_->InitLeafOrdered(partition_indices, num_data);
+    }
+  }
+
+  void SplitLeafOrderedBins(data_size_t begin, data_size_t left_cnt, data_size_t right_cnt) {
+    if (multi_val_bin_wrapper_ != nullptr) {
+      multi_val_bin_wrapper_->SplitLeafOrdered(begin, left_cnt, right_cnt);
+    }
+  }
+
+  data_size_t LeafOrderedBegin(const data_size_t* data_indices, data_size_t num_data) const {
+    if (is_col_wise || multi_val_bin_wrapper_ == nullptr) {
+      return -1;
+    }
+    return multi_val_bin_wrapper_->LeafOrderedBegin(data_indices, num_data);
+  }
+
+  template <bool USE_QUANT_GRAD, int HIST_BITS>
+  void ConstructLeafOrderedHistograms(data_size_t leaf_begin,
+                                      data_size_t num_data,
+                                      const score_t* ordered_gradients,
+                                      const score_t* ordered_hessians,
+                                      hist_t* hist_data) {
+    multi_val_bin_wrapper_->ConstructLeafOrderedHistograms<USE_QUANT_GRAD, HIST_BITS>(
+      leaf_begin, num_data, ordered_gradients, ordered_hessians, &hist_buf_, hist_data);
+  }
+
+  void ConstructMultiOutputHistograms(const data_size_t* data_indices,
+                                      data_size_t num_data,
+                                      const std::vector<const score_t*>& gradients,
+                                      const std::vector<const score_t*>& hessians,
+                                      hist_t* out) {
+    if (multi_val_bin_wrapper_ != nullptr) {
+      multi_val_bin_wrapper_->ConstructMultiOutputHistograms(
+        data_indices, num_data, gradients, hessians, out);
+    }
+  }
+
   void SetUseSubrow(bool is_use_subrow) {
     if (multi_val_bin_wrapper_ != nullptr) {
       multi_val_bin_wrapper_->SetUseSubrow(is_use_subrow);
@@ -7,6 +7,8 @@
 
 #include <LightGBM/dataset.h>
 #include <LightGBM/meta.h>
+#include <LightGBM/utils/binary_writer.h>
+#include <LightGBM/utils/sparse_row.h>
 
 #include <string>
 #include <map>
@@ -115,6 +117,14 @@ class Tree {
                             const data_size_t* used_data_indices,
                             data_size_t num_data, double* score) const;
 
+  /*!
+  * \brief Map the splits onto the bins of another dataset, so that AddPredictionToScore can be used on it.
+  *        Every numerical threshold must be the upper bound of a bin, with the same missing value handling,
+  *        otherwise the bins cannot reproduce the decisions of the tree and it is a fatal error
+  * \param data The dataset, with the same features as the training data of the tree
+  */
+  void BindToDataset(const Dataset* data);
+
   /*!
   * \brief Get upper bound leaf value of this tree model
   */
@@ -131,14 +141,56 @@ class Tree {
   * \return Prediction result
   */
   inline double Predict(const double* feature_values) const;
-  inline double PredictByMap(const std::unordered_map<int, double>& feature_values) const;
+  inline double PredictSparse(const SparseRow& feature_values) const;
 
   inline int PredictLeafIndex(const double* feature_values) const;
-  inline int PredictLeafIndexByMap(const std::unordered_map<int, double>& feature_values) const;
+  inline int PredictLeafIndexSparse(const SparseRow& feature_values) const;
+
+  inline void PredictContrib(const double* feature_values, int num_features, double* output) const;
+  /*!
+  * \brief Feature contributions of a sparse record, only the split features and the expected value (at index
+  *        num_features) of output are updated
+  */
+  inline void PredictContribSparse(const SparseRow& feature_values, int num_features, double* output) const;
+
+  /*!
+  * \brief Scratch space of PredictContribBlock, reused across trees and blocks of records
+  */
+  struct ContribBlockBuffer {
+    /*! \brief Decision paths of TreeSHAP, one_fraction and pweight have one value per record */
+    std::vector<int> path_feature;
+    std::vector<double> path_zero_fraction;
+    std::vector<double> path_one_fraction;
+    std::vector<double> path_pweight;
+    /*! \brief One fractions of the children of the nodes on the current branch, one value per record */
+    std::vector<double> child_one_fraction;
+    /*! \brief Per-record state of UnwindPath and UnwoundPathSum */
+    std::vector<double> next_one_portion;
+    std::vector<double> total;
+    /*! \brief Whether each record goes to the left child of each node */
+    std::vector<uint8_t> go_left;
+    /*! \brief Contributions of each leaf to the features on its path, one value per record */
+    std::vector<int> leaf_begin;
+    std::vector<int> leaf_end;
+    std::vector<int> leaf_feature;
+    std::vector<double> leaf_contrib;
+    std::vector<int> stack;
+  };
 
-  inline void PredictContrib(const double* feature_values, int num_features, double* output);
-  inline void PredictContribByMap(const std::unordered_map<int, double>& feature_values,
-                                  int num_features, std::unordered_map<int, double>* output);
+  /*!
+  * \brief Feature contributions of a block of records, same as PredictContrib on each of them.
+  *        The TreeSHAP recursion is run once for the whole block: the path structure only depends on the tree,
+  *        and only the fractions which depend on the decisions of a record are computed per record.
+  *        Each record then sums the contributions of the leaves in the order PredictContrib visits them.
+  * \param features Feature values of the records, row-major with num_features values per record
+  * \param num_rows Number of records
+  * \param num_features Number of features
+  * \param output Contributions are added here, num_features + 1 values per record
+  * \param output_stride Distance between the outputs of two consecutive records
+  * \param buffer Scratch space
+  */
+  void PredictContribBlock(const double* features, int num_rows, int num_features,
+                           double* output, int output_stride, ContribBlockBuffer* buffer) const;
 
   /*! \brief Get Number of leaves*/
   inline int num_leaves() const { return num_leaves_; }
@@ -146,6 +198,9 @@ class Tree {
   /*! \brief Get depth of specific leaf*/
   inline int leaf_depth(int leaf_idx) const { return leaf_depth_[leaf_idx]; }
 
+  /*! \brief Get max depth of the leaves, -1 until RecomputeMaxDepth is called */
+  inline int max_depth() const { return max_depth_; }
+
   /*! \brief Get parent of specific leaf*/
   inline int leaf_parent(int leaf_idx) const {return leaf_parent_[leaf_idx]; }
 
@@ -176,6 +231,20 @@ class Tree {
     return threshold_in_bin_[node_idx];
   }
 
+  /*! \brief Get the split threshold of specific node, for categorical splits this is the index of its bitset */
+  inline double threshold(int node_idx) const { return threshold_[node_idx]; }
+
+  inline int8_t decision_type(int node_idx) const { return decision_type_[node_idx]; }
+
+  /*! \brief Get the number of categorical splits*/
+  inline int num_cat() const { return num_cat_; }
+
+  /*! \brief Get the bitset of categories (in feature value space) going left on categorical split cat_idx */
+  inline std::vector<uint32_t> cat_threshold(int cat_idx) const {
+    return std::vector<uint32_t>(cat_threshold_.begin() + cat_boundaries_[cat_idx],
+                                 cat_threshold_.begin() + cat_boundaries_[cat_idx + 1]);
+  }
+
   /*! \brief Get the number of data points that fall at or below this node*/
   inline int data_count(int node) const { return node >= 0 ? internal_count_[node] : leaf_count_[~node]; }
 
@@ -240,6 +309,25 @@ class Tree {
   /*! \brief Serialize this object to string*/
   std::string ToString() const;
 
+  /*! \brief Size in bytes of the binary form written by SaveBinaryToFile */
+  size_t SizesInByte() const;
+
+  /*!
+  * \brief Serialize this tree in binary form, every array aligned on 8 bytes
+  * \param writer Binary target
+  */
+  void SaveBinaryToFile(BinaryWriter* writer) const;
+
+  /*!
+  * \brief Create a tree from the binary form written by SaveBinaryToFile, checking that it fits in len bytes
+  *        and that its nodes can be walked on records of num_features features
+  * \param memory Start of the serialized tree
+  * \param len Number of bytes available from memory
+  * \param num_features Number of features of the model
+  * \param used_len Number of bytes used by the tree
+  */
+  static Tree* CreateFromBinary(const char* memory, size_t len, int num_features, size_t* used_len);
+
   /*! \brief Serialize this object to json*/
   std::string ToJSON() const;
 
@@ -319,6 +407,17 @@ class Tree {
 
   inline bool is_linear() const { return is_linear_; }
 
+  /*! \brief Whether all the nodes of each level share their split, see MarkOblivious */
+  inline bool is_oblivious() const { return is_oblivious_; }
+
+  /*!
+  * \brief Check whether the tree is oblivious (symmetric): all its leaves are on the last level, and all the
+  *        nodes of a level share the same numerical split. If so, the leaf of a record is then found from the
+  *        bits of the level decisions, and the level splits are written with the model
+  * \return Whether the tree is oblivious
+  */
+  bool MarkOblivious();
+
   #ifdef USE_CUDA
   inline bool is_cuda_tree() const { return is_cuda_tree_; }
   #endif  // USE_CUDA
@@ -420,7 +519,9 @@ class Tree {
   * \return Leaf index
   */
   inline int GetLeaf(const double* feature_values) const;
-  inline int GetLeafByMap(const std::unordered_map<int, double>& feature_values) const;
+  inline int GetLeafSparse(const SparseRow& feature_values) const;
+  /*! \brief Leaf of a record in an oblivious tree, without branches on the decisions */
+  inline int GetLeafOblivious(const double* feature_values) const;
 
   /*! \brief Serialize one node to json*/
   std::string NodeToJSON(int index) const;
@@ -428,7 +529,7 @@ class Tree {
   /*! \brief Serialize one node to if-else statement*/
   std::string NodeToIfElse(int index, bool predict_leaf_index) const;
 
-  std::string NodeToIfElseByMap(int index, bool predict_leaf_index) const;
+  std::string NodeToIfElseSparse(int index, bool predict_leaf_index) const;
 
   double ExpectedValue() const;
 
@@ -457,11 +558,22 @@ class Tree {
                 PathElement *parent_unique_path, double parent_zero_fraction,
                 double parent_one_fraction, int parent_feature_index) const;
 
-  void TreeSHAPByMap(const std::unordered_map<int, double>& feature_values,
-                     std::unordered_map<int, double>* phi,
-                     int node, int unique_depth,
-                     PathElement *parent_unique_path, double parent_zero_fraction,
-                     double parent_one_fraction, int parent_feature_index) const;
+  void TreeSHAPSparse(const SparseRow& feature_values, double *phi,
+                      int node, int unique_depth,
+                      PathElement *parent_unique_path, double parent_zero_fraction,
+                      double parent_one_fraction, int parent_feature_index) const;
+
+  /*!
+  * \brief TreeSHAP on a block of records, visiting the left child first.
+  *        The path of a node starts at element parent_path + unique_depth of the buffer,
+  *        node_depth is the depth of node in the tree
+  */
+  void TreeSHAPBlock(int num_rows, int node, int node_depth, int unique_depth, int parent_path,
+                     double parent_zero_fraction, const double* parent_one_fraction,
+                     int parent_feature_index, ContribBlockBuffer* buffer) const;
+
+  /*! \brief Empty tree, only used by CreateFromBinary */
+  Tree() = default;
 
   /*! \brief Extend our decision path with a fraction of one and zero extensions for TreeSHAP*/
   static void ExtendPath(PathElement *unique_path, int unique_depth,
@@ -473,6 +585,12 @@ class Tree {
   /*! determine what the total permutation weight would be if we unwound a previous extension in the decision path*/
   static double UnwoundPathSum(const PathElement *unique_path, int unique_depth, int path_index);
 
+  /*! \brief ExtendPath, UnwindPath and UnwoundPathSum on the path starting at element path of a block buffer */
+  static void ExtendPathBlock(ContribBlockBuffer* buffer, int num_rows, int path, int unique_depth,
+                              double zero_fraction, const double* one_fraction, int feature_index);
+  static void UnwindPathBlock(ContribBlockBuffer* buffer, int num_rows, int path, int unique_depth, int path_index);
+  static void UnwoundPathSumBlock(ContribBlockBuffer* buffer, int num_rows, int path, int unique_depth, int path_index);
+
   /*! \brief Number of max leaves*/
   int max_leaves_;
   /*! \brief Number of current leaves*/
@@ -532,6 +650,21 @@ class Tree {
   std::vector<std::vector<int>> leaf_features_;
   /* \brief features used in leaf linear models; indexing is relative to used_features_ */
   std::vector<std::vector<int>> leaf_features_inner_;
+  /*! \brief Split shared by all the nodes of one level of an oblivious tree */
+  struct ObliviousLevel {
+    double threshold;
+    int split_feature;
+    /*! \brief Whether NaN, or zero, is the missing value which goes to the default side */
+    int8_t nan_is_missing;
+    int8_t zero_is_missing;
+    int8_t default_right;
+  };
+  /*! \brief Tree is oblivious, see MarkOblivious */
+  bool is_oblivious_;
+  /*! \brief Split of each level of an oblivious tree */
+  std::vector<ObliviousLevel> oblivious_levels_;
+  /*! \brief Leaf reached by each mask of the level decisions, bit l is set when going right on level l */
+  std::vector<int> oblivious_leaf_;
   #ifdef USE_CUDA
   /*! \brief Marks whether this tree is a CUDATree */
   bool is_cuda_tree_;
@@ -542,6 +675,7 @@ inline void Tree::Split(int leaf, int feature, int real_feature,
                         double left_value, double right_value, int left_cnt, int right_cnt,
                         double left_weight, double right_weight, float gain) {
   int new_node_idx = num_leaves_ - 1;
+  is_oblivious_ = false;
   // update parent info
   int parent = leaf_parent_[leaf];
   if (parent >= 0) {
@@ -612,16 +746,16 @@ inline double Tree::Predict(const double* feature_values) const {
   }
 }
 
-inline double Tree::PredictByMap(const std::unordered_map<int, double>& feature_values) const {
+inline double Tree::PredictSparse(const SparseRow& feature_values) const {
   if (is_linear_) {
-    int leaf = (num_leaves_ > 1) ? GetLeafByMap(feature_values) : 0;
+    int leaf = (num_leaves_ > 1) ? GetLeafSparse(feature_values) : 0;
     double output = leaf_const_[leaf];
     bool nan_found = false;
     for (size_t i = 0; i < leaf_features_[leaf].size(); ++i) {
       int feat = leaf_features_[leaf][i];
-      auto val_it = feature_values.find(feat);
-      if (val_it != feature_values.end()) {
-        double feat_val = val_it->second;
+      const double* val_ptr = feature_values.Find(feat);
+      if (val_ptr != nullptr) {
+        double feat_val = *val_ptr;
         if (std::isnan(feat_val)) {
           nan_found = true;
           break;
@@ -637,7 +771,7 @@ inline double Tree::PredictByMap(const std::unordered_map<int, double>& feature_
     }
   } else {
     if (num_leaves_ > 1) {
-      int leaf = GetLeafByMap(feature_values);
+      int leaf = GetLeafSparse(feature_values);
       return LeafOutput(leaf);
     } else {
       return leaf_value_[0];
@@ -654,35 +788,36 @@ inline int Tree::PredictLeafIndex(const double* feature_values) const {
   }
 }
 
-inline int Tree::PredictLeafIndexByMap(const std::unordered_map<int, double>& feature_values) const {
+inline int Tree::PredictLeafIndexSparse(const SparseRow& feature_values) const {
   if (num_leaves_ > 1) {
-    int leaf = GetLeafByMap(feature_values);
+    int leaf = GetLeafSparse(feature_values);
     return leaf;
   } else {
     return 0;
   }
 }
 
-inline void Tree::PredictContrib(const double* feature_values, int num_features, double* output) {
+inline void Tree::PredictContrib(const double* feature_values, int num_features, double* output) const {
   output[num_features] += ExpectedValue();
   // Run the recursion with preallocated space for the unique path data
   if (num_leaves_ > 1) {
     CHECK_GE(max_depth_, 0);
     const int max_path_len = max_depth_ + 1;
-    std::vector<PathElement> unique_path_data(max_path_len*(max_path_len + 1) / 2);
+    static THREAD_LOCAL std::vector<PathElement> unique_path_data;
+    unique_path_data.resize(max_path_len*(max_path_len + 1) / 2);
     TreeSHAP(feature_values, output, 0, 0, unique_path_data.data(), 1, 1, -1);
   }
 }
 
-inline void Tree::PredictContribByMap(const std::unordered_map<int, double>& feature_values,
-                                      int num_features, std::unordered_map<int, double>* output) {
-  (*output)[num_features] += ExpectedValue();
+inline void Tree::PredictContribSparse(const SparseRow& feature_values, int num_features, double* output) const {
+  output[num_features] += ExpectedValue();
   // Run the recursion with preallocated space for the unique path data
   if (num_leaves_ > 1) {
     CHECK_GE(max_depth_, 0);
     const int max_path_len = max_depth_ + 1;
-    std::vector<PathElement> unique_path_data(max_path_len*(max_path_len + 1) / 2);
-    TreeSHAPByMap(feature_values, output, 0, 0, unique_path_data.data(), 1, 1, -1);
+    static THREAD_LOCAL std::vector<PathElement> unique_path_data;
+    unique_path_data.resize(max_path_len*(max_path_len + 1) / 2);
+    TreeSHAPSparse(feature_values, output, 0, 0, unique_path_data.data(), 1, 1, -1);
   }
 }
 
@@ -697,6 +832,9 @@ inline void Tree::RecomputeLeafDepths(int node, int depth) {
 }
 
 inline int Tree::GetLeaf(const double* feature_values) const {
+  if (is_oblivious_) {
+    return GetLeafOblivious(feature_values);
+  }
   int node = 0;
   if (num_cat_ > 0) {
     while (node >= 0) {
@@ -710,15 +848,31 @@ inline int Tree::GetLeaf(const double* feature_values) const {
   return ~node;
 }
 
-inline int Tree::GetLeafByMap(const std::unordered_map<int, double>& feature_values) const {
+inline int Tree::GetLeafOblivious(const double* feature_values) const {
+  int mask = 0;
+  const int num_levels = static_cast<int>(oblivious_levels_.size());
+  for (int level = 0; level < num_levels; ++level) {
+    const ObliviousLevel& cur = oblivious_levels_[level];
+    const double fval = feature_values[cur.split_feature];
+    // same decision as NumericalDecision, with bitwise operations instead of branches
+    const int is_nan = std::isnan(fval);
+    const double value = is_nan ? 0.0 : fval;
+    const int is_missing = (cur.nan_is_missing & is_nan) | (cur.zero_is_missing & IsZero(value));
+    const int is_greater = !(value <= cur.threshold);
+    mask |= ((is_missing & cur.default_right) | (~is_missing & is_greater)) << level;
+  }
+  return oblivious_leaf_[mask];
+}
+
+inline int Tree::GetLeafSparse(const SparseRow& feature_values) const {
   int node = 0;
   if (num_cat_ > 0) {
     while (node >= 0) {
-      node = Decision(feature_values.count(split_feature_[node]) > 0 ? feature_values.at(split_feature_[node]) : 0.0f, node);
+      node = Decision(feature_values.Get(split_feature_[node]), node);
     }
   } else {
     while (node >= 0) {
-      node = NumericalDecision(feature_values.count(split_feature_[node]) > 0 ? feature_values.at(split_feature_[node]) : 0.0f, node);
+      node = NumericalDecision(feature_values.Get(split_feature_[node]), node);
     }
   }
   return ~node;
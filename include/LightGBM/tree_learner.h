@@ -67,6 +67,14 @@ class TreeLearner {
   */
   virtual Tree* Train(const score_t* gradients, const score_t* hessians, bool is_first_tree) = 0;
 
+  /*!
+  * \brief Prepare the trees of one iteration, before Train is called for each of them
+  * \param gradients The first order gradients of each tree that will be trained
+  * \param hessians The second order gradients of each tree that will be trained
+  */
+  virtual void BeforeTrainIteration(const std::vector<const score_t*>& /*gradients*/,
+                                    const std::vector<const score_t*>& /*hessians*/) {}
+
   /*!
   * \brief use an existing tree to fit the new gradients and hessians.
   */
@@ -36,6 +36,7 @@
 #ifdef _MSC_VER
 #include <intrin.h>
 #pragma intrinsic(_BitScanReverse)
+#pragma intrinsic(_BitScanForward)
 #endif
 
 #if defined(_MSC_VER)
@@ -842,6 +843,20 @@ inline static bool FindInBitset(const uint32_t* bits, int n, T pos) {
   return (bits[i1] >> i2) & 1;
 }
 
+/*! \brief Index of the lowest set bit of x, x must not be 0 */
+inline static int CountTrailingZeros(uint64_t x) {
+#if defined(_MSC_VER)
+  unsigned long idx;
+  if (_BitScanForward(&idx, static_cast<unsigned long>(x & 0xFFFFFFFFu))) {
+    return static_cast<int>(idx);
+  }
+  _BitScanForward(&idx, static_cast<unsigned long>(x >> 32));
+  return static_cast<int>(idx) + 32;
+#else
+  return __builtin_ctzll(x);
+#endif
+}
+
 inline static bool CheckDoubleEqualOrdered(double a, double b) {
   double upper = std::nextafter(a, INFINITY);
   return b <= upper;
@@ -1255,6 +1270,36 @@ inline static std::string ArrayToString(const std::vector<T>& arr, size_t n) {
   return str_buf.str();
 }
 
+/*!
+* Appends the first n values of an array to a string, separated by ``delimiter``.
+* Unlike ``ArrayToString``, it does not go through a stream, so that lines can be
+* formatted directly into a larger buffer. It is locale-independent.
+* Floating point values holding small integers (such as leaf indices) take a much faster path,
+* which prints the same digits.
+*
+* \note If ``high_precision_output`` is set to true,
+*       floating point values are output with more digits of precision.
+*/
+template<bool high_precision_output = false, typename T>
+inline static void AppendArrayToString(const T* arr, size_t n, char delimiter, std::string* out) {
+  __TToStringHelper<T, std::is_floating_point<T>::value, high_precision_output> helper;
+  char buffer[32];
+  for (size_t i = 0; i < n; ++i) {
+    if (i > 0) {
+      out->push_back(delimiter);
+    }
+    const T value = arr[i];
+    if (std::is_floating_point<T>::value && std::fabs(value) < 1e6 && value == std::trunc(value)
+        && !(value == 0 && std::signbit(value))) {
+      fmt::format_int integer(static_cast<int64_t>(value));
+      out->append(integer.data(), integer.size());
+    } else {
+      helper(value, buffer, sizeof(buffer));
+      out->append(buffer);
+    }
+  }
+}
+
 
 }  // namespace CommonC
 
@@ -73,6 +73,23 @@ struct VirtualFileReader {
   static std::unique_ptr<VirtualFileReader> Make(const std::string& filename);
 };
 
+/*!
+ * \brief Read-only memory mapping of a whole file, the pages are shared with the other processes mapping it
+ */
+struct MappedFile {
+  virtual ~MappedFile() {}
+  /*! \brief Start of the mapped content */
+  virtual const char* data() const = 0;
+  /*! \brief Size of the mapped content in bytes */
+  virtual size_t size() const = 0;
+  /*!
+   * \brief Map filename into memory
+   * \param filename Filename of the data
+   * \return Mapping of the file, nullptr when it cannot be opened, is empty or cannot be mapped
+   */
+  static std::unique_ptr<MappedFile> Make(const std::string& filename);
+};
+
 }  // namespace LightGBM
 
 #endif   // LightGBM_UTILS_FILE_IO_H_
@@ -57,7 +57,10 @@ class ThreadExceptionHelper {
   }
   void ReThrow() {
     if (ex_ptr_ != nullptr) {
-      std::rethrow_exception(ex_ptr_);
+      // cleared first, the destructor must not throw it again while it unwinds
+      std::exception_ptr ex_ptr = ex_ptr_;
+      ex_ptr_ = nullptr;
+      std::rethrow_exception(ex_ptr);
     }
   }
   void CaptureException() {
@@ -0,0 +1,97 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#ifndef LIGHTGBM_UTILS_PIPELINE_WRITER_H_
+#define LIGHTGBM_UTILS_PIPELINE_WRITER_H_
+
+#include <LightGBM/utils/file_io.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace LightGBM {
+
+/*!
+* \brief A pipeline file writer, the counterpart of PipelineReader: blocks are pushed by the producer
+*        and written in the same order by a dedicated thread, so that the producer does not wait for the disk.
+*        At most max_pending_blocks blocks are queued, Push waits when the queue is full.
+*/
+class PipelineWriter {
+ public:
+  /*!
+  * \brief Start the writing thread
+  * \param writer File to write, must outlive this object
+  * \param max_pending_blocks Maximal number of blocks waiting to be written
+  */
+  explicit PipelineWriter(VirtualFileWriter* writer, size_t max_pending_blocks = 2)
+    : writer_(writer), max_pending_blocks_(max_pending_blocks) {
+    write_worker_ = std::thread([this] { WriteLoop(); });
+  }
+
+  ~PipelineWriter() {
+    Finish();
+  }
+
+  /*!
+  * \brief Queue a block, made of parts which are written one after the other
+  */
+  void Push(std::vector<std::string>&& block) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this] { return pending_blocks_.size() < max_pending_blocks_; });
+    pending_blocks_.push_back(std::move(block));
+    not_empty_.notify_one();
+  }
+
+  /*!
+  * \brief Wait for the queued blocks to be written and stop the writing thread
+  */
+  void Finish() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      finished_ = true;
+      not_empty_.notify_one();
+    }
+    if (write_worker_.joinable()) {
+      write_worker_.join();
+    }
+  }
+
+ private:
+  void WriteLoop() {
+    while (true) {
+      std::vector<std::string> block;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return !pending_blocks_.empty() || finished_; });
+        if (pending_blocks_.empty()) {
+          return;
+        }
+        block = std::move(pending_blocks_.front());
+        pending_blocks_.pop_front();
+        not_full_.notify_one();
+      }
+      for (const auto& part : block) {
+        writer_->Write(part.data(), part.size());
+      }
+    }
+  }
+
+  VirtualFileWriter* writer_;
+  size_t max_pending_blocks_;
+  std::deque<std::vector<std::string>> pending_blocks_;
+  bool finished_ = false;
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+  std::thread write_worker_;
+};
+
+}  // namespace LightGBM
+
+#endif   // LIGHTGBM_UTILS_PIPELINE_WRITER_H_
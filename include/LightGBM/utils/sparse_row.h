@@ -0,0 +1,69 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#ifndef LIGHTGBM_UTILS_SPARSE_ROW_H_
+#define LIGHTGBM_UTILS_SPARSE_ROW_H_
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace LightGBM {
+
+/*!
+* \brief Read-only view of a sparse record: (feature index, value) pairs sorted by index, without duplicates.
+*        Absent features are zero. Lookups are binary searches over the pairs, so that viewing a record
+*        needs no allocation.
+*/
+class SparseRow {
+ public:
+  SparseRow(const std::pair<int, double>* begin, const std::pair<int, double>* end) : begin_(begin), end_(end) {}
+
+  /*! \brief Value of feature, nullptr when the record does not hold it */
+  inline const double* Find(int feature) const {
+    const std::pair<int, double>* it = std::lower_bound(begin_, end_, feature,
+      [](const std::pair<int, double>& pair, int index) { return pair.first < index; });
+    return it != end_ && it->first == feature ? &it->second : nullptr;
+  }
+
+  /*! \brief Value of feature, 0.0 when the record does not hold it */
+  inline double Get(int feature) const {
+    const double* value = Find(feature);
+    return value != nullptr ? *value : 0.0;
+  }
+
+  inline const std::pair<int, double>* begin() const { return begin_; }
+  inline const std::pair<int, double>* end() const { return end_; }
+
+  /*!
+  * \brief Sort the pairs of a record by feature index and drop the duplicates, the last value of a feature wins
+  * \param pairs (feature index, value) pairs in any order, sorted in place
+  */
+  static void SortUnique(std::vector<std::pair<int, double>>* pairs) {
+    auto by_index = [](const std::pair<int, double>& a, const std::pair<int, double>& b) { return a.first < b.first; };
+    // CSR rows are usually strictly increasing already
+    if (std::adjacent_find(pairs->begin(), pairs->end(),
+                           [](const std::pair<int, double>& a, const std::pair<int, double>& b) {
+                             return a.first >= b.first; }) == pairs->end()) {
+      return;
+    }
+    std::stable_sort(pairs->begin(), pairs->end(), by_index);
+    // keep the last pair of each run of equal indices
+    size_t num_unique = 0;
+    for (size_t i = 0; i < pairs->size(); ++i) {
+      if (i + 1 < pairs->size() && (*pairs)[i + 1].first == (*pairs)[i].first) {
+        continue;
+      }
+      (*pairs)[num_unique++] = (*pairs)[i];
+    }
+    pairs->resize(num_unique);
+  }
+
+ private:
+  const std::pair<int, double>* begin_;
+  const std::pair<int, double>* end_;
+};
+
+}  // namespace LightGBM
+#endif   // LIGHTGBM_UTILS_SPARSE_ROW_H_
@@ -32,7 +32,7 @@ Application::Application(int argc, char** argv) {
   LoadParameters(argc, argv);
   // set number of threads for openmp
   OMP_SET_NUM_THREADS(config_.num_threads);
-  if (config_.data.size() == 0 && config_.task != TaskType::kConvertModel) {
+  if (config_.data.size() == 0 && config_.task != TaskType::kConvertModel && config_.task != TaskType::kCompileModel) {
     Log::Fatal("No training/prediction data, application quit");
   }
 
@@ -92,7 +92,7 @@ void Application::LoadData() {
   PredictFunction predict_fun = nullptr;
   // need to continue training
   if (boosting_->NumberOfTotalModel() > 0 && config_.task != TaskType::KRefitTree) {
-    predictor.reset(new Predictor(boosting_.get(), 0, -1, true, false, false, false, -1, -1));
+    predictor.reset(new Predictor(boosting_.get(), 0, -1, true, false, false, false, -1, -1, false, 0.0, false, false, false, false));
     predict_fun = predictor->GetPredictFunction();
   }
 
@@ -221,9 +221,9 @@ void Application::Train() {
 void Application::Predict() {
   if (config_.task == TaskType::KRefitTree) {
     // create predictor
-    Predictor predictor(boosting_.get(), 0, -1, false, true, false, false, 1, 1);
+    Predictor predictor(boosting_.get(), 0, -1, false, true, false, false, 1, 1, false, 0.0, false, false, false, false);
     predictor.Predict(config_.data.c_str(), config_.output_result.c_str(), config_.header, config_.predict_disable_shape_check,
-                      config_.precise_float_parser);
+                      config_.precise_float_parser, nullptr, "text", 0);
     TextReader<int> result_reader(config_.output_result.c_str(), false);
     result_reader.ReadAllLines();
 
@@ -264,10 +264,13 @@ void Application::Predict() {
     Predictor predictor(boosting_.get(), config_.start_iteration_predict, config_.num_iteration_predict, config_.predict_raw_score,
                         config_.predict_leaf_index, config_.predict_contrib,
                         config_.pred_early_stop, config_.pred_early_stop_freq,
-                        config_.pred_early_stop_margin);
+                        config_.pred_early_stop_margin, config_.pred_early_stop_exact,
+                        config_.pred_early_stop_threshold, config_.predict_quick_scorer,
+                        config_.predict_float32, config_.predict_binned, false);
     predictor.Predict(config_.data.c_str(),
                       config_.output_result.c_str(), config_.header, config_.predict_disable_shape_check,
-                      config_.precise_float_parser);
+                      config_.precise_float_parser, nullptr, config_.predict_output_format,
+                      Predictor::BlockSize(config_.predict_block_size, config_.predict_contrib));
     Log::Info("Finished prediction");
   }
 }
@@ -284,5 +287,15 @@ void Application::ConvertModel() {
   boosting_->SaveModelToIfElse(-1, config_.convert_model.c_str());
 }
 
+void Application::CompileModel() {
+  boosting_.reset(
+    Boosting::CreateBoosting(config_.boosting, config_.input_model.c_str()));
+  if (!boosting_->SaveModelToCompiled(-1, config_.compile_float32, config_.compiler, config_.compiler_flags,
+                                      config_.compiled_model.c_str())) {
+    Log::Fatal("Failed to write the C source of compiled model %s", config_.compiled_model.c_str());
+  }
+  Log::Info("Finished compiling model to %s", config_.compiled_model.c_str());
+}
+
 
 }  // namespace LightGBM
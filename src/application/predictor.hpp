@@ -10,14 +10,19 @@
 #include <LightGBM/meta.h>
 #include <LightGBM/utils/common.h>
 #include <LightGBM/utils/openmp_wrapper.h>
+#include <LightGBM/utils/pipeline_writer.h>
+#include <LightGBM/utils/sparse_row.h>
 #include <LightGBM/utils/text_reader.h>
 
 #include <string>
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
 #include <cstring>
 #include <functional>
 #include <map>
 #include <memory>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -37,50 +42,146 @@ class Predictor {
   * \param is_raw_score True if need to predict result with raw score
   * \param predict_leaf_index True to output leaf index instead of prediction score
   * \param predict_contrib True to output feature contributions instead of prediction score
+  * \param early_stop_exact True to stop the predictions early only when their decision cannot change
+  * \param early_stop_threshold Decision threshold on the raw score of binary models, with early_stop_exact
+  * \param use_quick_scorer True to score the eligible trees with the QuickScorer bitvector algorithm
+  * \param use_float32 True to predict scores with single precision thresholds, leaf values and feature buffers
+  * \param use_binned True to predict scores on records quantized into the positions of their values in the thresholds
+  * \param add_init_score True to predict only the raw score of the iterations in range, which is then
+  *                       completed by AddInitScore with the raw score of the iterations before start_iteration
   */
-  Predictor(Boosting* boosting, int start_iteration, int num_iteration, bool is_raw_score,
+  Predictor(const Boosting* boosting, int start_iteration, int num_iteration, bool is_raw_score,
             bool predict_leaf_index, bool predict_contrib, bool early_stop,
-            int early_stop_freq, double early_stop_margin) {
-    early_stop_ = CreatePredictionEarlyStopInstance(
+            int early_stop_freq, double early_stop_margin, bool early_stop_exact, double early_stop_threshold,
+            bool use_quick_scorer, bool use_float32, bool use_binned, bool add_init_score) {
+    if (add_init_score && (predict_leaf_index || predict_contrib)) {
+      Log::Fatal("Only normal and raw score predictions can start from previous scores");
+    }
+    // the output is converted once the initial score is added
+    convert_init_score_ = add_init_score && !is_raw_score;
+    is_raw_score = is_raw_score || add_init_score;
+    PredictionEarlyStopInstance early_stop_instance = CreatePredictionEarlyStopInstance(
         "none", LightGBM::PredictionEarlyStopConfig());
-    if (early_stop && !boosting->NeedAccuratePrediction()) {
+    bool use_early_stop = false;
+    // the margin of a partial raw score says nothing about the final prediction
+    if (early_stop && !add_init_score && !boosting->NeedAccuratePrediction()) {
+      use_early_stop = true;
       PredictionEarlyStopConfig pred_early_stop_config;
       CHECK_GT(early_stop_freq, 0);
       CHECK_GE(early_stop_margin, 0);
       pred_early_stop_config.margin_threshold = early_stop_margin;
       pred_early_stop_config.round_period = early_stop_freq;
-      if (boosting->NumberOfClasses() == 1) {
-        early_stop_ =
+      pred_early_stop_config.decision_threshold = early_stop_threshold;
+      if (early_stop_exact) {
+        early_stop_instance = CreatePredictionEarlyStopInstance("exact", pred_early_stop_config);
+      } else if (boosting->NumberOfClasses() == 1) {
+        early_stop_instance =
             CreatePredictionEarlyStopInstance("binary", pred_early_stop_config);
       } else {
-        early_stop_ = CreatePredictionEarlyStopInstance("multiclass",
-                                                        pred_early_stop_config);
+        early_stop_instance = CreatePredictionEarlyStopInstance("multiclass",
+                                                                pred_early_stop_config);
       }
     }
 
-    boosting->InitPredict(start_iteration, num_iteration, predict_contrib);
+    use_float32 = use_float32 && !predict_leaf_index && !predict_contrib;
+    if (use_float32 && boosting->IsLinear()) {
+      Log::Warning("Float32 prediction is not supported for linear trees, predicting with double precision");
+      use_float32 = false;
+    }
+    use_float32_ = use_float32;
+    const int kFeatureThreshold = 100000;
+    // sparse rows of wide models are renumbered onto the features used by the trees
+    use_compact_ = boosting->MaxFeatureIdx() + 1 > kFeatureThreshold && !predict_contrib && !use_float32 &&
+                   !boosting->IsLinear();
+    num_compact_feature_ = 0;
+    plan_.reset(boosting->CreatePredictionPlan(start_iteration, num_iteration, predict_contrib,
+                                               use_quick_scorer && !use_float32, use_float32,
+                                               use_binned && !use_float32, use_compact_, early_stop_instance));
     boosting_ = boosting;
     num_pred_one_row_ = boosting_->NumPredictOneRow(start_iteration,
         num_iteration, predict_leaf_index, predict_contrib);
     num_feature_ = boosting_->MaxFeatureIdx() + 1;
+    if (use_compact_) {
+      const std::vector<int>& compact_features = plan_->compact_features;
+      compact_index_.assign(num_feature_, -1);
+      for (int i = 0; i < static_cast<int>(compact_features.size()); ++i) {
+        compact_index_[compact_features[i]] = i;
+      }
+      num_compact_feature_ = static_cast<int>(compact_features.size());
+      if (predict_leaf_index) {
+        compact_predict_fun_ = [=](const double* features, double* output) {
+          boosting_->PredictLeafIndexCompact(*plan_, features, output);
+        };
+      } else if (is_raw_score) {
+        compact_predict_fun_ = [=](const double* features, double* output) {
+          boosting_->PredictRawCompact(*plan_, features, output);
+        };
+      } else {
+        compact_predict_fun_ = [=](const double* features, double* output) {
+          boosting_->PredictCompact(*plan_, features, output);
+        };
+      }
+    }
     predict_buf_.resize(
         OMP_NUM_THREADS(),
         std::vector<double, Common::AlignmentAllocator<double, kAlignedSize>>(
-            num_feature_, 0.0f));
-    const int kFeatureThreshold = 100000;
+            use_compact_ ? num_compact_feature_ : num_feature_, 0.0f));
     const size_t KSparseThreshold = static_cast<size_t>(0.01 * num_feature_);
+    is_raw_score_ = is_raw_score;
+    add_init_score_ = add_init_score;
+    // contributions ignore early stopping, blocks of rows are only stopped early by the exact check
+    support_block_ = !predict_leaf_index && (predict_contrib || !use_early_stop || early_stop_exact) &&
+                     !add_init_score && !use_float32 && num_feature_ <= kFeatureThreshold;
+    predict_contrib_ = predict_contrib;
+    block_buf_.resize(OMP_NUM_THREADS());
+    sparse_buf_.resize(OMP_NUM_THREADS());
+    block_rows_.resize(OMP_NUM_THREADS());
+    if (use_float32) {
+      predict_buf_f32_.resize(OMP_NUM_THREADS(), std::vector<float>(num_feature_, 0.0f));
+      if (is_raw_score) {
+        dense_predict_f32_fun_ = [=](const float* features, double* output) {
+          boosting_->PredictRawFloat32(*plan_, features, output);
+        };
+      } else {
+        dense_predict_f32_fun_ = [=](const float* features, double* output) {
+          boosting_->PredictFloat32(*plan_, features, output);
+        };
+      }
+    }
     if (predict_leaf_index) {
+      dense_predict_fun_ = [=](const double* features, double* output) {
+        boosting_->PredictLeafIndex(*plan_, features, output);
+      };
+    } else if (predict_contrib) {
+      dense_predict_fun_ = [=](const double* features, double* output) {
+        boosting_->PredictContrib(*plan_, features, output);
+      };
+    } else if (is_raw_score) {
+      dense_predict_fun_ = [=](const double* features, double* output) {
+        boosting_->PredictRaw(*plan_, features, output);
+      };
+    } else {
+      dense_predict_fun_ = [=](const double* features, double* output) {
+        boosting_->Predict(*plan_, features, output);
+      };
+    }
+    if (use_compact_) {
+      predict_fun_ = [=](const std::vector<std::pair<int, double>>& features,
+                         double* output) {
+        int tid = omp_get_thread_num();
+        PredictCompactRow(features, predict_buf_[tid].data(), output);
+      };
+    } else if (predict_leaf_index) {
       predict_fun_ = [=](const std::vector<std::pair<int, double>>& features,
                          double* output) {
         int tid = omp_get_thread_num();
         if (num_feature_ > kFeatureThreshold &&
             features.size() < KSparseThreshold) {
-          auto buf = CopyToPredictMap(features);
-          boosting_->PredictLeafIndexByMap(buf, output);
+          boosting_->PredictLeafIndexSparse(*plan_, CopyToSparseRow(features), output);
         } else {
           CopyToPredictBuffer(predict_buf_[tid].data(), features);
           // get result for leaf index
-          boosting_->PredictLeafIndex(predict_buf_[tid].data(), output);
+          boosting_->PredictLeafIndex(*plan_, predict_buf_[tid].data(), output);
           ClearPredictBuffer(predict_buf_[tid].data(), predict_buf_[tid].size(),
                              features);
         }
@@ -94,17 +195,24 @@ class Predictor {
         int tid = omp_get_thread_num();
         CopyToPredictBuffer(predict_buf_[tid].data(), features);
         // get feature importances
-        boosting_->PredictContrib(predict_buf_[tid].data(), output);
+        boosting_->PredictContrib(*plan_, predict_buf_[tid].data(), output);
         ClearPredictBuffer(predict_buf_[tid].data(), predict_buf_[tid].size(),
                            features);
       };
       predict_sparse_fun_ = [=](const std::vector<std::pair<int, double>>& features,
-                                std::vector<std::unordered_map<int, double>>* output) {
-        auto buf = CopyToPredictMap(features);
+                                std::vector<std::vector<std::pair<int, double>>>* output) {
         // get sparse feature importances
-        boosting_->PredictContribByMap(buf, output);
+        boosting_->PredictContribSparse(*plan_, CopyToSparseRow(features), output);
       };
 
+    } else if (use_float32) {
+      predict_fun_ = [=](const std::vector<std::pair<int, double>>& features,
+                         double* output) {
+        int tid = omp_get_thread_num();
+        CopyToPredictBuffer(predict_buf_f32_[tid].data(), features);
+        dense_predict_f32_fun_(predict_buf_f32_[tid].data(), output);
+        ClearPredictBuffer(predict_buf_f32_[tid].data(), predict_buf_f32_[tid].size(), features);
+      };
     } else {
       if (is_raw_score) {
         predict_fun_ = [=](const std::vector<std::pair<int, double>>& features,
@@ -112,12 +220,10 @@ class Predictor {
           int tid = omp_get_thread_num();
           if (num_feature_ > kFeatureThreshold &&
               features.size() < KSparseThreshold) {
-            auto buf = CopyToPredictMap(features);
-            boosting_->PredictRawByMap(buf, output, &early_stop_);
+            boosting_->PredictRawSparse(*plan_, CopyToSparseRow(features), output);
           } else {
             CopyToPredictBuffer(predict_buf_[tid].data(), features);
-            boosting_->PredictRaw(predict_buf_[tid].data(), output,
-                                  &early_stop_);
+            boosting_->PredictRaw(*plan_, predict_buf_[tid].data(), output);
             ClearPredictBuffer(predict_buf_[tid].data(),
                                predict_buf_[tid].size(), features);
           }
@@ -128,11 +234,10 @@ class Predictor {
           int tid = omp_get_thread_num();
           if (num_feature_ > kFeatureThreshold &&
               features.size() < KSparseThreshold) {
-            auto buf = CopyToPredictMap(features);
-            boosting_->PredictByMap(buf, output, &early_stop_);
+            boosting_->PredictSparse(*plan_, CopyToSparseRow(features), output);
           } else {
             CopyToPredictBuffer(predict_buf_[tid].data(), features);
-            boosting_->Predict(predict_buf_[tid].data(), output, &early_stop_);
+            boosting_->Predict(*plan_, predict_buf_[tid].data(), output);
             ClearPredictBuffer(predict_buf_[tid].data(),
                                predict_buf_[tid].size(), features);
           }
@@ -156,12 +261,167 @@ class Predictor {
     return predict_sparse_fun_;
   }
 
+  /*!
+  * \brief Predict one dense row without building its (index, value) pairs.
+  *        A contiguous float64 row covering all the features is handed to the model as is,
+  *        any other row is converted into buf. As with the pairs, values within kZeroThreshold of zero are zeros.
+  *        The buffer is owned by the caller, so that several threads can predict at the same time.
+  * \param row First feature value of the row
+  * \param num_col Number of features in the row
+  * \param col_stride Distance between two consecutive features of the row, in elements
+  * \param buf Buffer of NumFeatures() values, zero-initialized and only ever used by this method
+  *            with the same num_col. In float32 mode, its first half holds the float features
+  * \param output Prediction result
+  */
+  template <typename T>
+  void PredictDenseRow(const T* row, int num_col, int64_t col_stride, double* buf, double* output) const {
+    if (use_float32_) {
+      PredictDenseRowFloat32(row, num_col, col_stride, reinterpret_cast<float*>(buf), output);
+      return;
+    }
+    if (std::is_same<T, double>::value && col_stride == 1 && num_col >= num_feature_
+        && !HasDroppedZeros(row, num_feature_)) {
+      dense_predict_fun_(reinterpret_cast<const double*>(row), output);
+      return;
+    }
+    // features from num_col on are never written, so they stay zero
+    const int num_copy = std::min(num_col, num_feature_);
+    for (int i = 0; i < num_copy; ++i) {
+      buf[i] = ZeroThresholded(static_cast<double>(row[i * col_stride]));
+    }
+    dense_predict_fun_(buf, output);
+  }
+
+  /*!
+  * \brief Predict one row of (index, value) pairs with a feature buffer owned by the caller,
+  *        so that several threads can predict at the same time
+  * \param buf Buffer of NumFeatures() zeros, which are restored before returning
+  */
+  void PredictRow(const std::vector<std::pair<int, double>>& features, double* buf, double* output) const {
+    if (use_float32_) {
+      float* float_buf = reinterpret_cast<float*>(buf);
+      CopyToPredictBuffer(float_buf, features);
+      dense_predict_f32_fun_(float_buf, output);
+      ClearPredictBuffer(float_buf, num_feature_, features);
+      return;
+    }
+    if (use_compact_) {
+      PredictCompactRow(features, buf, output);
+      return;
+    }
+    CopyToPredictBuffer(buf, features);
+    dense_predict_fun_(buf, output);
+    ClearPredictBuffer(buf, num_feature_, features);
+  }
+
+  /*!
+  * \brief Complete a prediction made with add_init_score, by adding the raw score of the iterations
+  *        before start_iteration and converting the sum if a normal prediction was asked for
+  * \param init_score Raw score of the record for iterations [0, start_iteration)
+  * \param output Raw score of the record for the predicted iterations, replaced by the prediction result
+  */
+  void AddInitScore(const double* init_score, double* output) const {
+    for (int k = 0; k < num_pred_one_row_; ++k) {
+      output[k] += init_score[k];
+    }
+    if (convert_init_score_) {
+      boosting_->ConvertRawScore(*plan_, output, output);
+    }
+  }
+
+  /*! \brief Number of features of the buffers passed to PredictDenseRow and PredictRow */
+  inline int NumFeatures() const {
+    return num_feature_;
+  }
+
+  /*!
+  * \brief Rows per block of prediction, contributions are always computed by blocks
+  * \param predict_block_size Value of the predict_block_size parameter
+  * \param predict_contrib True when feature contributions are predicted
+  */
+  static int BlockSize(int predict_block_size, bool predict_contrib) {
+    const int kContribBlockSize = 32;
+    if (predict_block_size == 0 && predict_contrib) {
+      return kContribBlockSize;
+    }
+    return predict_block_size;
+  }
+
+  /*!
+  * \brief Whether PredictBlock can be used, i.e. contributions, or scores predicted without early stopping
+  *        or with exact early stopping
+  */
+  inline bool SupportsBlockPrediction() const {
+    return support_block_;
+  }
+
+  /*!
+  * \brief Predict a block of rows, scoring (or explaining) all the rows with one tree before moving on to the next tree
+  * \param get_row_fun Function returning the features of one row
+  * \param start_row Index of the first row of the block
+  * \param num_rows Number of rows in the block
+  * \param output Prediction result, written row after row
+  */
+  void PredictBlock(const std::function<std::vector<std::pair<int, double>>(int row_idx)>& get_row_fun,
+                    int start_row, int num_rows, double* output) {
+    int tid = omp_get_thread_num();
+    auto& buf = block_buf_[tid];
+    auto& rows = block_rows_[tid];
+    const size_t block_len = static_cast<size_t>(num_rows) * num_feature_;
+    if (buf.size() < block_len) {
+      buf.resize(block_len, 0.0f);
+    }
+    if (rows.size() < static_cast<size_t>(num_rows)) {
+      rows.resize(num_rows);
+    }
+    for (int i = 0; i < num_rows; ++i) {
+      rows[i] = get_row_fun(start_row + i);
+      CopyToPredictBuffer(buf.data() + static_cast<size_t>(i) * num_feature_, rows[i]);
+    }
+    if (predict_contrib_) {
+      boosting_->PredictContribBlock(*plan_, buf.data(), num_rows, output);
+    } else if (is_raw_score_) {
+      boosting_->PredictRawBlock(*plan_, buf.data(), num_rows, output);
+    } else {
+      boosting_->PredictBlock(*plan_, buf.data(), num_rows, output);
+    }
+    for (int i = 0; i < num_rows; ++i) {
+      ClearPredictBuffer(buf.data() + static_cast<size_t>(i) * num_feature_, num_feature_, rows[i]);
+    }
+  }
+
   /*!
   * \brief predicting on data, then saving result to disk
   * \param data_filename Filename of data
   * \param result_filename Filename of output result
+  * \param init_score_filename Filename of the raw score of iterations [0, start_iteration), one line per record
+  *                            with tab separated values as in a raw score result file.
+  *                            Only used with add_init_score, data_filename + ".init" when empty
+  * \param output_format "text" for tab separated values, one line per record,
+  *                      "float32" or "float64" for the raw binary values in native byte order
+  * \param block_size Rows predicted together by PredictBlock when it is supported, 0 to predict row by row
   */
-  void Predict(const char* data_filename, const char* result_filename, bool header, bool disable_shape_check, bool precise_float_parser) {
+  void Predict(const char* data_filename, const char* result_filename, bool header, bool disable_shape_check, bool precise_float_parser,
+               const char* init_score_filename, const std::string& output_format, int block_size) {
+    // size of the binary values written for each prediction, 0 for text
+    int value_size = 0;
+    if (output_format == std::string("float32")) {
+      value_size = sizeof(float);
+    } else if (output_format == std::string("float64")) {
+      value_size = sizeof(double);
+    } else if (output_format != std::string("text")) {
+      Log::Fatal("Unknown prediction output format %s", output_format.c_str());
+    }
+    std::vector<double> init_score;
+    data_size_t num_init_score = 0;
+    if (add_init_score_) {
+      num_init_score = LoadInitScore(data_filename, init_score_filename, &init_score);
+      // checked before the result file is created, so that no truncated result is left behind
+      const data_size_t num_data = TextReader<data_size_t>(data_filename, header).CountLine();
+      if (num_data != num_init_score) {
+        Log::Fatal("Initial score file has %d records, but data file has %d", num_init_score, num_data);
+      }
+    }
     auto writer = VirtualFileWriter::Make(result_filename);
     if (!writer->Init()) {
       Log::Fatal("Prediction results file %s cannot be created", result_filename);
@@ -227,46 +487,168 @@ class Predictor {
       }
     };
 
+    // the blocks are written by another thread while the next ones are read, parsed and predicted
+    PipelineWriter pipeline_writer(writer.get());
     std::function<void(data_size_t, const std::vector<std::string>&)>
-        process_fun = [&parser_fun, &writer, this](
-                          data_size_t, const std::vector<std::string>& lines) {
-      std::vector<std::pair<int, double>> oneline_features;
-      std::vector<std::string> result_to_write(lines.size());
+        process_fun = [&parser_fun, &pipeline_writer, &init_score, num_init_score, value_size, block_size, this](
+                          data_size_t start_idx, const std::vector<std::string>& lines) {
+      // errors cannot be thrown from the reader, a data file which grew since it was counted is reported once it is read
+      if (add_init_score_ && start_idx + static_cast<data_size_t>(lines.size()) > num_init_score) {
+        return;
+      }
+      // each thread predicts and formats a contiguous range of lines into its own part of the block
+      const data_size_t num_lines = static_cast<data_size_t>(lines.size());
+      const int num_parts = std::max(1, static_cast<int>(std::min<data_size_t>(OMP_NUM_THREADS(), num_lines)));
+      const data_size_t part_size = (num_lines + num_parts - 1) / num_parts;
+      std::vector<std::string> block(num_parts);
       OMP_INIT_EX();
-      #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static) firstprivate(oneline_features)
-      for (data_size_t i = 0; i < static_cast<data_size_t>(lines.size()); ++i) {
+      #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static, 1)
+      for (int part = 0; part < num_parts; ++part) {
         OMP_LOOP_EX_BEGIN();
-        oneline_features.clear();
-        // parser
-        parser_fun(lines[i].c_str(), &oneline_features);
-        // predict
-        std::vector<double> result(num_pred_one_row_);
-        predict_fun_(oneline_features, result.data());
-        auto str_result = Common::Join<double>(result, "\t");
-        result_to_write[i] = str_result;
+        const data_size_t part_start = part * part_size;
+        const data_size_t part_end = std::min(num_lines, part_start + part_size);
+        const data_size_t part_len = std::max<data_size_t>(0, part_end - part_start);
+        std::vector<double> result(static_cast<size_t>(part_len) * num_pred_one_row_, 0.0);
+        if (block_size > 0 && support_block_) {
+          std::vector<std::vector<std::pair<int, double>>> rows(part_len);
+          for (data_size_t i = 0; i < part_len; ++i) {
+            parser_fun(lines[part_start + i].c_str(), &rows[i]);
+          }
+          for (data_size_t i = 0; i < part_len; i += block_size) {
+            PredictBlock([&rows](int row_idx) { return rows[row_idx]; }, i,
+                         std::min<data_size_t>(block_size, part_len - i),
+                         result.data() + static_cast<size_t>(i) * num_pred_one_row_);
+          }
+        } else {
+          std::vector<std::pair<int, double>> oneline_features;
+          for (data_size_t i = 0; i < part_len; ++i) {
+            oneline_features.clear();
+            // parser
+            parser_fun(lines[part_start + i].c_str(), &oneline_features);
+            // predict
+            predict_fun_(oneline_features, result.data() + static_cast<size_t>(i) * num_pred_one_row_);
+          }
+        }
+        if (value_size > 0) {
+          block[part].reserve(static_cast<size_t>(part_len) * num_pred_one_row_ * value_size);
+        }
+        for (data_size_t i = 0; i < part_len; ++i) {
+          double* row_result = result.data() + static_cast<size_t>(i) * num_pred_one_row_;
+          if (add_init_score_) {
+            AddInitScore(init_score.data() + static_cast<size_t>(start_idx + part_start + i) * num_pred_one_row_,
+                         row_result);
+          }
+          AppendResult(row_result, value_size, &block[part]);
+        }
         OMP_LOOP_EX_END();
       }
       OMP_THROW_EX();
-      for (data_size_t i = 0; i < static_cast<data_size_t>(result_to_write.size()); ++i) {
-        writer->Write(result_to_write[i].c_str(), result_to_write[i].size());
-        writer->Write("\n", 1);
-      }
+      pipeline_writer.Push(std::move(block));
     };
-    predict_data_reader.ReadAllAndProcessParallel(process_fun);
+    const data_size_t num_data = predict_data_reader.ReadAllAndProcessParallel(process_fun);
+    pipeline_writer.Finish();
+    if (add_init_score_ && num_data != num_init_score) {
+      Log::Fatal("Initial score file has %d records, but data file has %d", num_init_score, num_data);
+    }
   }
 
  private:
-  void CopyToPredictBuffer(double* pred_buf, const std::vector<std::pair<int, double>>& features) {
+  template <typename T>
+  void PredictDenseRowFloat32(const T* row, int num_col, int64_t col_stride, float* buf, double* output) const {
+    if (std::is_same<T, float>::value && col_stride == 1 && num_col >= num_feature_
+        && !HasDroppedZeros(row, num_feature_)) {
+      dense_predict_f32_fun_(reinterpret_cast<const float*>(row), output);
+      return;
+    }
+    const int num_copy = std::min(num_col, num_feature_);
+    for (int i = 0; i < num_copy; ++i) {
+      buf[i] = static_cast<float>(ZeroThresholded(static_cast<double>(row[i * col_stride])));
+    }
+    dense_predict_f32_fun_(buf, output);
+  }
+
+  /*! \brief Value of a dense feature as seen through its (index, value) pair, which is dropped as a zero when tiny */
+  static inline double ZeroThresholded(double value) {
+    return std::fabs(value) > kZeroThreshold || std::isnan(value) ? value : 0.0;
+  }
+
+  /*! \brief Whether a contiguous row has nonzero values which ZeroThresholded turns into zeros */
+  template <typename T>
+  static bool HasDroppedZeros(const T* row, int num_values) {
+    for (int i = 0; i < num_values; ++i) {
+      if (row[i] != 0 && std::fabs(row[i]) <= kZeroThreshold) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /*! \brief Append the predictions of a record to the output, as a line of text when value_size is 0 */
+  void AppendResult(const double* result, int value_size, std::string* out) const {
+    if (value_size == 0) {
+      CommonC::AppendArrayToString<true>(result, num_pred_one_row_, '\t', out);
+      out->push_back('\n');
+    } else if (value_size == sizeof(float)) {
+      for (int k = 0; k < num_pred_one_row_; ++k) {
+        const float value = static_cast<float>(result[k]);
+        out->append(reinterpret_cast<const char*>(&value), sizeof(value));
+      }
+    } else {
+      out->append(reinterpret_cast<const char*>(result), sizeof(double) * num_pred_one_row_);
+    }
+  }
+
+  /*!
+  * \brief Load the raw scores to add to the predictions of data_filename
+  * \return Number of records in the file
+  */
+  data_size_t LoadInitScore(const char* data_filename, const char* init_score_filename,
+                            std::vector<double>* init_score) const {
+    std::string filename(init_score_filename == nullptr ? "" : init_score_filename);
+    if (filename.empty()) {
+      filename = std::string(data_filename) + ".init";
+    }
+    TextReader<data_size_t> reader(filename.c_str(), false);
+    const int num_pred_one_row = num_pred_one_row_;
+    data_size_t error_line = -1;
+    int error_num_values = 0;
+    const data_size_t num_data = reader.ReadAllAndProcess(
+      [init_score, num_pred_one_row, &error_line, &error_num_values] (data_size_t idx, const char* buffer, size_t size) {
+      if (error_line >= 0) {
+        return;
+      }
+      std::vector<double> values = Common::StringToArray<double>(std::string(buffer, size), '\t');
+      if (static_cast<int>(values.size()) != num_pred_one_row) {
+        error_line = idx;
+        error_num_values = static_cast<int>(values.size());
+        return;
+      }
+      init_score->insert(init_score->end(), values.begin(), values.end());
+    });
+    if (error_line >= 0) {
+      Log::Fatal("Initial score file should have %d values per line, got %d at line %d",
+                 num_pred_one_row, error_num_values, error_line + 1);
+    }
+    if (num_data == 0) {
+      Log::Fatal("Initial score file %s cannot be read or is empty", filename.c_str());
+    }
+    Log::Info("Loaded %d initial scores from %s", num_data, filename.c_str());
+    return num_data;
+  }
+
+  template <typename T>
+  void CopyToPredictBuffer(T* pred_buf, const std::vector<std::pair<int, double>>& features) const {
     for (const auto &feature : features) {
       if (feature.first < num_feature_) {
-        pred_buf[feature.first] = feature.second;
+        pred_buf[feature.first] = static_cast<T>(feature.second);
       }
     }
   }
 
-  void ClearPredictBuffer(double* pred_buf, size_t buf_size, const std::vector<std::pair<int, double>>& features) {
+  template <typename T>
+  void ClearPredictBuffer(T* pred_buf, size_t buf_size, const std::vector<std::pair<int, double>>& features) const {
     if (features.size() > static_cast<size_t>(buf_size / 2)) {
-      std::memset(pred_buf, 0, sizeof(double)*(buf_size));
+      std::memset(pred_buf, 0, sizeof(T)*(buf_size));
     } else {
       for (const auto &feature : features) {
         if (feature.first < num_feature_) {
@@ -276,14 +658,37 @@ class Predictor {
     }
   }
 
-  std::unordered_map<int, double> CopyToPredictMap(const std::vector<std::pair<int, double>>& features) {
-    std::unordered_map<int, double> buf;
+  /*!
+  * \brief Predict one row renumbered onto the compact features, the values of the other features are dropped
+  * \param buf Buffer of at least num_compact_feature_ zeros, which are restored before returning
+  */
+  void PredictCompactRow(const std::vector<std::pair<int, double>>& features, double* buf, double* output) const {
+    for (const auto &feature : features) {
+      if (feature.first < num_feature_ && compact_index_[feature.first] >= 0) {
+        buf[compact_index_[feature.first]] = feature.second;
+      }
+    }
+    compact_predict_fun_(buf, output);
+    for (const auto &feature : features) {
+      if (feature.first < num_feature_ && compact_index_[feature.first] >= 0) {
+        buf[compact_index_[feature.first]] = 0.0f;
+      }
+    }
+  }
+
+  /*!
+  * \brief Sorted copy of the features of one row in the buffer of this thread, viewed as a SparseRow
+  */
+  SparseRow CopyToSparseRow(const std::vector<std::pair<int, double>>& features) {
+    auto& buf = sparse_buf_[omp_get_thread_num()];
+    buf.clear();
     for (const auto &feature : features) {
       if (feature.first < num_feature_) {
-        buf[feature.first] = feature.second;
+        buf.push_back(feature);
       }
     }
-    return buf;
+    SparseRow::SortUnique(&buf);
+    return SparseRow(buf.data(), buf.data() + buf.size());
   }
 
   /*! \brief Boosting model */
@@ -291,10 +696,38 @@ class Predictor {
   /*! \brief function for prediction */
   PredictFunction predict_fun_;
   PredictSparseFunction predict_sparse_fun_;
-  PredictionEarlyStopInstance early_stop_;
+  /*! \brief Iteration range, early stopping and structures of the predictions, shared by the copies of this object */
+  std::shared_ptr<const PredictionPlan> plan_;
   int num_feature_;
   int num_pred_one_row_;
   std::vector<std::vector<double, Common::AlignmentAllocator<double, kAlignedSize>>> predict_buf_;
+  /*! \brief Per-thread sorted (index, value) pairs of a sparse row, used by CopyToSparseRow */
+  std::vector<std::vector<std::pair<int, double>>> sparse_buf_;
+  bool is_raw_score_;
+  bool support_block_;
+  bool predict_contrib_;
+  /*! \brief Whether the raw score of the previous iterations is added by AddInitScore */
+  bool add_init_score_;
+  /*! \brief Whether AddInitScore converts the completed raw score into a prediction */
+  bool convert_init_score_;
+  /*! \brief Per-thread feature buffers of a block of rows, used by PredictBlock */
+  std::vector<std::vector<double, Common::AlignmentAllocator<double, kAlignedSize>>> block_buf_;
+  std::vector<std::vector<std::vector<std::pair<int, double>>>> block_rows_;
+  /*! \brief Prediction on a full feature vector, used by PredictDenseRow */
+  std::function<void(const double*, double*)> dense_predict_fun_;
+  /*! \brief Whether scores are predicted in single precision, by dense_predict_f32_fun_ */
+  bool use_float32_;
+  /*! \brief Prediction on a full single precision feature vector */
+  std::function<void(const float*, double*)> dense_predict_f32_fun_;
+  /*! \brief Per-thread single precision feature buffers, used by predict_fun_ in float32 mode */
+  std::vector<std::vector<float>> predict_buf_f32_;
+  /*! \brief Whether rows are predicted on the compact features of the model, by compact_predict_fun_ */
+  bool use_compact_;
+  /*! \brief Compact index of each feature, -1 for the features no split uses */
+  std::vector<int> compact_index_;
+  int num_compact_feature_;
+  /*! \brief Prediction on a compact feature vector */
+  std::function<void(const double*, double*)> compact_predict_fun_;
 };
 
 }  // namespace LightGBM
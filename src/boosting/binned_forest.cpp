@@ -0,0 +1,183 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#include "binned_forest.h"
+
+#include <LightGBM/utils/log.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace LightGBM {
+
+namespace {
+
+/*! \brief Largest number of thresholds of a feature, one code is kept for NaN */
+const size_t kMaxThresholds = std::numeric_limits<uint16_t>::max() - 1;
+
+/*! \brief Largest double below -kZeroThreshold, values above it and up to kZeroThreshold are zero for Tree::IsZero */
+double BelowNegativeZeroThreshold() {
+  return std::nextafter(-kZeroThreshold, -std::numeric_limits<double>::infinity());
+}
+
+}  // namespace
+
+bool BinnedForest::CanBin(const std::vector<std::shared_ptr<Tree>>& models, int num_trees) {
+  for (int i = 0; i < num_trees; ++i) {
+    if (models[i] == nullptr || models[i]->is_linear()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+BinnedForest::BinnedForest(const std::vector<std::shared_ptr<Tree>>& models, int num_trees, int num_features) {
+  is_categorical_.assign(num_features, false);
+  nan_as_zero_.assign(num_features, true);
+  std::vector<std::vector<double>> feature_thresholds(num_features);
+  std::vector<bool> is_used(num_features, false);
+  std::vector<uint32_t> num_cat_words(num_features, 0);
+  for (int i = 0; i < num_trees; ++i) {
+    const Tree& tree = *models[i];
+    for (int node = 0; node < tree.num_leaves() - 1; ++node) {
+      const int feature = tree.split_feature(node);
+      const int8_t decision_type = tree.decision_type(node);
+      is_used[feature] = true;
+      if (Tree::GetDecisionType(decision_type, kCategoricalMask)) {
+        is_categorical_[feature] = true;
+        const int cat_idx = static_cast<int>(tree.threshold(node));
+        num_cat_words[feature] = std::max(num_cat_words[feature],
+                                          static_cast<uint32_t>(tree.cat_threshold(cat_idx).size()));
+      } else {
+        feature_thresholds[feature].push_back(tree.threshold(node));
+        if (Tree::GetMissingType(decision_type) != MissingType::None) {
+          nan_as_zero_[feature] = false;
+        }
+        if (Tree::GetMissingType(decision_type) == MissingType::Zero) {
+          feature_thresholds[feature].push_back(BelowNegativeZeroThreshold());
+          feature_thresholds[feature].push_back(kZeroThreshold);
+        }
+      }
+    }
+  }
+  threshold_boundaries_.push_back(0);
+  max_category_code_.assign(num_features, 0);
+  uint32_t max_code = 0;
+  for (int feature = 0; feature < num_features; ++feature) {
+    auto& thresholds = feature_thresholds[feature];
+    std::sort(thresholds.begin(), thresholds.end());
+    thresholds.erase(std::unique(thresholds.begin(), thresholds.end()), thresholds.end());
+    thresholds_.insert(thresholds_.end(), thresholds.begin(), thresholds.end());
+    threshold_boundaries_.push_back(static_cast<int>(thresholds_.size()));
+    if (!is_used[feature]) {
+      continue;
+    }
+    used_features_.push_back(feature);
+    if (is_categorical_[feature]) {
+      // code 0 is NaN and negative values, categories are shifted by one, and the last code is above all bitsets
+      max_category_code_[feature] = num_cat_words[feature] * 32 + 1;
+      max_code = std::max(max_code, max_category_code_[feature]);
+    } else {
+      // codes 0 to num_thresholds, plus one for NaN
+      max_code = std::max(max_code, static_cast<uint32_t>(thresholds.size()) + 1);
+    }
+    if (thresholds.size() > kMaxThresholds || max_category_code_[feature] > kMaxThresholds + 1) {
+      Log::Fatal("Feature %d has too many thresholds or categories for binned prediction", feature);
+    }
+  }
+  is_uint8_ = max_code <= std::numeric_limits<uint8_t>::max();
+  has_special_node_ = false;
+
+  cat_boundaries_.push_back(0);
+  for (int i = 0; i < num_trees; ++i) {
+    const Tree& tree = *models[i];
+    const int leaf_offset = static_cast<int>(leaf_value_.size());
+    const int cat_offset = static_cast<int>(cat_boundaries_.size()) - 1;
+    for (int j = 0; j < tree.num_leaves(); ++j) {
+      leaf_value_.push_back(tree.LeafOutput(j));
+    }
+    for (int j = 0; j < tree.num_cat(); ++j) {
+      const auto bitset = tree.cat_threshold(j);
+      cat_threshold_.insert(cat_threshold_.end(), bitset.begin(), bitset.end());
+      cat_boundaries_.push_back(static_cast<int>(cat_threshold_.size()));
+    }
+    if (tree.num_leaves() > 1) {
+      tree_root_.push_back(AppendSubtree(tree, 0, leaf_offset, cat_offset));
+    } else {
+      tree_root_.push_back(~leaf_offset);
+    }
+  }
+}
+
+uint32_t BinnedForest::ThresholdPosition(int feature, double threshold) const {
+  const double* begin = thresholds_.data() + threshold_boundaries_[feature];
+  const double* end = thresholds_.data() + threshold_boundaries_[feature + 1];
+  return static_cast<uint32_t>(std::lower_bound(begin, end, threshold) - begin);
+}
+
+uint32_t BinnedForest::Code(int feature, double fval, uint32_t nan_code) const {
+  if (is_categorical_[feature]) {
+    // same conversion as Tree::CategoricalDecision
+    if (std::isnan(fval) || fval <= -1.0) {
+      return 0;
+    }
+    const uint32_t max_code = max_category_code_[feature];
+    if (fval >= static_cast<double>(max_code - 1)) {
+      return max_code;
+    }
+    return static_cast<uint32_t>(static_cast<int>(fval)) + 1;
+  }
+  if (std::isnan(fval)) {
+    // same conversion as Tree::NumericalDecision for the splits that do not handle NaN
+    return nan_as_zero_[feature] ? ThresholdPosition(feature, 0.0) : nan_code;
+  }
+  // fval <= threshold[j] iff the position of the first threshold >= fval is <= j
+  return ThresholdPosition(feature, fval);
+}
+
+int BinnedForest::AppendSubtree(const Tree& tree, int node, int leaf_offset, int cat_offset) {
+  if (node < 0) {
+    return ~(leaf_offset + ~node);
+  }
+  const int pos = static_cast<int>(nodes_.size());
+  nodes_.emplace_back();
+  Node binned;
+  const int8_t decision_type = tree.decision_type(node);
+  const bool default_left = Tree::GetDecisionType(decision_type, kDefaultLeftMask);
+  binned.split_feature = tree.split_feature(node);
+  binned.flags = 0;
+  binned.default_begin = 0;
+  binned.default_end = 0;
+  if (Tree::GetDecisionType(decision_type, kCategoricalMask)) {
+    binned.flags |= kCategoricalFlag;
+    binned.threshold = static_cast<uint32_t>(cat_offset + static_cast<int>(tree.threshold(node)));
+  } else {
+    const double threshold = tree.threshold(node);
+    binned.threshold = ThresholdPosition(binned.split_feature, threshold);
+    const int8_t missing_type = Tree::GetMissingType(decision_type);
+    // splits on features without NaN codes are plain comparisons
+    if (missing_type != MissingType::None || !nan_as_zero_[binned.split_feature]) {
+      binned.flags |= kMissingFlag;
+      if (default_left) {
+        binned.flags |= kDefaultLeftFlag;
+      }
+      // same as Tree::NumericalDecision: NaN goes to the default direction, unless it is not missing and becomes 0
+      if (missing_type == MissingType::None ? 0.0 <= threshold : default_left) {
+        binned.flags |= kNaNLeftFlag;
+      }
+    }
+    if (missing_type == MissingType::Zero) {
+      binned.default_begin = static_cast<uint16_t>(ThresholdPosition(binned.split_feature, BelowNegativeZeroThreshold()) + 1);
+      binned.default_end = static_cast<uint16_t>(ThresholdPosition(binned.split_feature, kZeroThreshold) + 1);
+    }
+  }
+  // left subtree directly follows its parent
+  binned.left_child = AppendSubtree(tree, tree.left_child(node), leaf_offset, cat_offset);
+  binned.right_child = AppendSubtree(tree, tree.right_child(node), leaf_offset, cat_offset);
+  has_special_node_ = has_special_node_ || binned.flags != 0;
+  nodes_[pos] = binned;
+  return pos;
+}
+
+}  // namespace LightGBM
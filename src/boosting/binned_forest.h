@@ -0,0 +1,157 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#ifndef LIGHTGBM_BOOSTING_BINNED_FOREST_H_
+#define LIGHTGBM_BOOSTING_BINNED_FOREST_H_
+
+#include <LightGBM/meta.h>
+#include <LightGBM/tree.h>
+#include <LightGBM/utils/common.h>
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace LightGBM {
+
+/*!
+* \brief Forest evaluated on bin codes instead of raw feature values.
+*        The thresholds of all the numerical splits on a feature are gathered into one sorted table,
+*        and a record is quantized once into the position of each of its values in these tables,
+*        so that every split becomes an integer comparison against the position of its threshold.
+*        Categorical values are coded by their category, clamped above the largest one of the model.
+*        Codes are stored as uint8_t when every feature has at most 255 of them, as uint16_t otherwise.
+*        The quantization is exact: the trees take the same decisions as on the raw values.
+*/
+class BinnedForest {
+ public:
+  /*!
+  * \brief Build the tables and the nodes of models[0, num_trees)
+  * \param models All the trees of the model
+  * \param num_trees Number of trees, the thresholds of all of them go into the tables
+  * \param num_features Number of features of a record
+  */
+  BinnedForest(const std::vector<std::shared_ptr<Tree>>& models, int num_trees, int num_features);
+
+  /*! \brief Whether the trees models[0, num_trees) can be binned */
+  static bool CanBin(const std::vector<std::shared_ptr<Tree>>& models, int num_trees);
+
+  /*! \brief Whether the codes of a record fit in uint8_t */
+  inline bool IsUInt8() const { return is_uint8_; }
+
+  /*!
+  * \brief Quantize one record
+  * \param feature_values Feature values of this record
+  * \param codes Output, one code per feature
+  */
+  template <typename CODE_T>
+  void Quantize(const double* feature_values, CODE_T* codes) const {
+    for (const int feature : used_features_) {
+      codes[feature] = static_cast<CODE_T>(Code(feature, feature_values[feature], std::numeric_limits<CODE_T>::max()));
+    }
+  }
+
+  /*!
+  * \brief Prediction of one tree on a quantized record
+  * \param tree_idx Index of the tree
+  * \param codes Codes of this record, as written by Quantize
+  * \return Output of the leaf the record falls into
+  */
+  template <typename CODE_T>
+  inline double Predict(int tree_idx, const CODE_T* codes) const {
+    int node = tree_root_[tree_idx];
+    if (has_special_node_) {
+      while (node >= 0) {
+        const Node& cur = nodes_[node];
+        node = cur.flags == 0 ? NumericalDecision(codes[cur.split_feature], cur)
+                              : Decision(codes[cur.split_feature], std::numeric_limits<CODE_T>::max(), cur);
+      }
+    } else {
+      while (node >= 0) {
+        const Node& cur = nodes_[node];
+        node = NumericalDecision(codes[cur.split_feature], cur);
+      }
+    }
+    return leaf_value_[~node];
+  }
+
+ private:
+  /*! \brief One packed split node */
+  struct Node {
+    int32_t split_feature;
+    int32_t left_child;
+    int32_t right_child;
+    /*! \brief Position of the threshold in the table of the feature, or the index of the categorical bitset */
+    uint32_t threshold;
+    /*! \brief Codes [default_begin, default_end) go to the default direction, empty unless zero is missing */
+    uint16_t default_begin;
+    uint16_t default_end;
+    uint8_t flags;
+  };
+
+  /*! \brief Flags of a node, a node without any is a plain comparison */
+  static const uint8_t kCategoricalFlag = 1;
+  /*! \brief The split handles missing values, NaN (or zero) codes must be checked */
+  static const uint8_t kMissingFlag = 2;
+  static const uint8_t kDefaultLeftFlag = 4;
+  /*! \brief Direction of NaN values, which depends on the missing type of the split */
+  static const uint8_t kNaNLeftFlag = 8;
+
+  static inline int NumericalDecision(uint32_t code, const Node& node) {
+    return code <= node.threshold ? node.left_child : node.right_child;
+  }
+
+  /*! \brief Decision of a categorical split or of a split handling missing values */
+  inline int Decision(uint32_t code, uint32_t nan_code, const Node& node) const {
+    bool go_left;
+    if (node.flags & kCategoricalFlag) {
+      go_left = code > 0 && Common::FindInBitset(cat_threshold_.data() + cat_boundaries_[node.threshold],
+                                                 cat_boundaries_[node.threshold + 1] - cat_boundaries_[node.threshold],
+                                                 static_cast<int>(code - 1));
+    } else if (code == nan_code) {
+      go_left = (node.flags & kNaNLeftFlag) != 0;
+    } else if (code - node.default_begin < static_cast<uint32_t>(node.default_end - node.default_begin)) {
+      // value in the missing (zero) range of the split
+      go_left = (node.flags & kDefaultLeftFlag) != 0;
+    } else {
+      go_left = code <= node.threshold;
+    }
+    return go_left ? node.left_child : node.right_child;
+  }
+
+  /*! \brief Code of one feature value, nan_code for NaN values of numerical features */
+  uint32_t Code(int feature, double fval, uint32_t nan_code) const;
+
+  /*! \brief Position of threshold in the table of feature */
+  uint32_t ThresholdPosition(int feature, double threshold) const;
+
+  /*! \brief Append the subtree rooted at node of tree, return its encoded position */
+  int AppendSubtree(const Tree& tree, int node, int leaf_offset, int cat_offset);
+
+  /*! \brief Features used by at least one split */
+  std::vector<int> used_features_;
+  /*! \brief Whether each feature is categorical */
+  std::vector<bool> is_categorical_;
+  /*! \brief Whether NaN is coded as zero, when none of the splits on the feature handles missing values */
+  std::vector<bool> nan_as_zero_;
+  /*! \brief Sorted thresholds of each numerical feature, boundaries in threshold_boundaries_ */
+  std::vector<double> thresholds_;
+  std::vector<int> threshold_boundaries_;
+  /*! \brief Largest code of each categorical feature, which stands for all the unseen categories */
+  std::vector<uint32_t> max_category_code_;
+  std::vector<Node> nodes_;
+  std::vector<double> leaf_value_;
+  /*! \brief Encoded root of each tree, negative for single-leaf trees */
+  std::vector<int> tree_root_;
+  /*! \brief Bitsets of all categorical splits */
+  std::vector<int> cat_boundaries_;
+  std::vector<uint32_t> cat_threshold_;
+  bool is_uint8_;
+  /*! \brief Whether some node is not a plain comparison */
+  bool has_special_node_;
+};
+
+}  // namespace LightGBM
+#endif   // LIGHTGBM_BOOSTING_BINNED_FOREST_H_
@@ -0,0 +1,273 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#include "compiled_forest.h"
+
+#include <LightGBM/utils/log.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+
+namespace LightGBM {
+
+namespace {
+
+/*! \brief Header of the binary form: number of trees, nodes, leaves, categorical splits and bitset words, node size */
+const int kBinaryHeaderSize = 8;
+
+template <typename T>
+void WriteArray(BinaryWriter* writer, const T* data, size_t num) {
+  if (num > 0) {
+    writer->AlignedWrite(data, sizeof(T) * num);
+  }
+}
+
+template <typename T>
+const T* ViewArray(const char** p, const char* end, size_t num) {
+  const T* ret = reinterpret_cast<const T*>(*p);
+  const size_t bytes = BinaryWriter::AlignedSize(sizeof(T) * num);
+  if (static_cast<size_t>(end - *p) < bytes) {
+    Log::Fatal("Compiled forest binary format error, the buffer is too small");
+  }
+  *p += bytes;
+  return ret;
+}
+
+}  // namespace
+
+bool CompiledForest::CanCompile(const std::vector<std::shared_ptr<Tree>>& models, int start_tree, int num_trees) {
+  for (int i = start_tree; i < start_tree + num_trees; ++i) {
+    if (models[i] == nullptr || models[i]->is_linear()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+CompiledForest::CompiledForest(const std::vector<std::shared_ptr<Tree>>& models, int start_tree, int num_trees) {
+  size_t total_nodes = 0;
+  size_t total_leaves = 0;
+  for (int i = start_tree; i < start_tree + num_trees; ++i) {
+    total_nodes += static_cast<size_t>(models[i]->num_leaves() - 1);
+    total_leaves += static_cast<size_t>(models[i]->num_leaves());
+  }
+  CHECK_LE(total_leaves, static_cast<size_t>(INT32_MAX));
+  nodes_storage_.reserve(total_nodes);
+  leaf_value_storage_.reserve(total_leaves);
+  tree_root_storage_.reserve(num_trees);
+  leaf_offset_storage_.reserve(num_trees);
+  cat_boundaries_storage_.push_back(0);
+  has_categorical_ = false;
+  for (int i = start_tree; i < start_tree + num_trees; ++i) {
+    const Tree& tree = *models[i];
+    const int leaf_offset = static_cast<int>(leaf_value_storage_.size());
+    const int cat_offset = static_cast<int>(cat_boundaries_storage_.size()) - 1;
+    leaf_offset_storage_.push_back(leaf_offset);
+    for (int j = 0; j < tree.num_leaves(); ++j) {
+      leaf_value_storage_.push_back(tree.LeafOutput(j));
+    }
+    for (int j = 0; j < tree.num_cat(); ++j) {
+      const auto bitset = tree.cat_threshold(j);
+      cat_threshold_storage_.insert(cat_threshold_storage_.end(), bitset.begin(), bitset.end());
+      cat_boundaries_storage_.push_back(static_cast<int>(cat_threshold_storage_.size()));
+    }
+    has_categorical_ = has_categorical_ || tree.num_cat() > 0;
+    if (tree.num_leaves() > 1) {
+      tree_root_storage_.push_back(AppendSubtree(tree, 0, leaf_offset, cat_offset));
+    } else {
+      tree_root_storage_.push_back(~leaf_offset);
+    }
+  }
+  nodes_ = nodes_storage_.data();
+  leaf_value_ = leaf_value_storage_.data();
+  tree_root_ = tree_root_storage_.data();
+  leaf_offset_ = leaf_offset_storage_.data();
+  cat_boundaries_ = cat_boundaries_storage_.data();
+  cat_threshold_ = cat_threshold_storage_.data();
+  num_trees_ = num_trees;
+  num_nodes_ = static_cast<int>(nodes_storage_.size());
+  num_leaves_ = static_cast<int>(leaf_value_storage_.size());
+  num_cat_ = static_cast<int>(cat_boundaries_storage_.size()) - 1;
+}
+
+int CompiledForest::AppendSubtree(const Tree& tree, int node, int leaf_offset, int cat_offset) {
+  if (node < 0) {
+    return ~(leaf_offset + ~node);
+  }
+  const int pos = static_cast<int>(nodes_storage_.size());
+  nodes_storage_.emplace_back();
+  Node compiled;
+  compiled.decision_type = tree.decision_type(node);
+  compiled.split_feature = tree.split_feature(node);
+  if (Tree::GetDecisionType(compiled.decision_type, kCategoricalMask)) {
+    compiled.threshold = static_cast<double>(cat_offset + static_cast<int>(tree.threshold(node)));
+  } else {
+    compiled.threshold = tree.threshold(node);
+  }
+  // left subtree directly follows its parent
+  compiled.left_child = AppendSubtree(tree, tree.left_child(node), leaf_offset, cat_offset);
+  compiled.right_child = AppendSubtree(tree, tree.right_child(node), leaf_offset, cat_offset);
+  nodes_storage_[pos] = compiled;
+  return pos;
+}
+
+void CompiledForest::RemapFeatures(const std::vector<int>& feature_map) {
+  CHECK(owner_ == nullptr);
+  for (auto& node : nodes_storage_) {
+    node.split_feature = feature_map[node.split_feature];
+    CHECK_GE(node.split_feature, 0);
+  }
+}
+
+size_t CompiledForest::SizesInByte() const {
+  return BinaryWriter::AlignedSize(sizeof(int32_t) * kBinaryHeaderSize)
+    + BinaryWriter::AlignedSize(sizeof(Node) * num_nodes_)
+    + BinaryWriter::AlignedSize(sizeof(double) * num_leaves_)
+    + BinaryWriter::AlignedSize(sizeof(int) * num_trees_) * 2
+    + BinaryWriter::AlignedSize(sizeof(int) * (num_cat_ + 1))
+    + BinaryWriter::AlignedSize(sizeof(uint32_t) * cat_boundaries_[num_cat_]);
+}
+
+void CompiledForest::SaveBinaryToFile(BinaryWriter* writer) const {
+  const int32_t header[kBinaryHeaderSize] = {num_trees_, num_nodes_, num_leaves_, num_cat_,
+                                             cat_boundaries_[num_cat_], has_categorical_ ? 1 : 0,
+                                             static_cast<int32_t>(sizeof(Node)), 0};
+  writer->AlignedWrite(header, sizeof(header));
+  // copy the nodes field by field, so the padding bytes are written as zeros
+  const int kNodesPerChunk = 4096;
+  std::vector<char> chunk;
+  for (int begin = 0; begin < num_nodes_; begin += kNodesPerChunk) {
+    const int end = std::min(begin + kNodesPerChunk, num_nodes_);
+    chunk.assign(sizeof(Node) * (end - begin), 0);
+    for (int i = begin; i < end; ++i) {
+      char* dst = chunk.data() + sizeof(Node) * (i - begin);
+      const Node& node = nodes_[i];
+      std::memcpy(dst + offsetof(Node, threshold), &node.threshold, sizeof(node.threshold));
+      std::memcpy(dst + offsetof(Node, split_feature), &node.split_feature, sizeof(node.split_feature));
+      std::memcpy(dst + offsetof(Node, left_child), &node.left_child, sizeof(node.left_child));
+      std::memcpy(dst + offsetof(Node, right_child), &node.right_child, sizeof(node.right_child));
+      std::memcpy(dst + offsetof(Node, decision_type), &node.decision_type, sizeof(node.decision_type));
+    }
+    writer->Write(chunk.data(), chunk.size());
+  }
+  // sizeof(Node) is a multiple of 8, no padding is needed after the nodes
+  WriteArray(writer, leaf_value_, num_leaves_);
+  WriteArray(writer, tree_root_, num_trees_);
+  WriteArray(writer, leaf_offset_, num_trees_);
+  WriteArray(writer, cat_boundaries_, num_cat_ + 1);
+  WriteArray(writer, cat_threshold_, cat_boundaries_[num_cat_]);
+}
+
+CompiledForest* CompiledForest::CreateFromBinary(const char* memory, size_t len, int num_features,
+                                                 std::shared_ptr<const void> owner) {
+  static_assert(sizeof(Node) % 8 == 0, "CompiledForest::Node must keep the following arrays aligned");
+  if (reinterpret_cast<uintptr_t>(memory) % 8 != 0) {
+    Log::Fatal("Compiled forest binary format error, the buffer is not aligned on 8 bytes");
+  }
+  const char* p = memory;
+  const char* end = memory + len;
+  const int32_t* header = ViewArray<int32_t>(&p, end, kBinaryHeaderSize);
+  if (header[6] != static_cast<int32_t>(sizeof(Node))) {
+    Log::Fatal("Compiled forest binary format error, the node size %d does not match %d",
+               header[6], static_cast<int>(sizeof(Node)));
+  }
+  if (header[0] < 0 || header[1] < 0 || header[2] < 0 || header[3] < 0 || header[4] < 0) {
+    Log::Fatal("Compiled forest binary format error, negative array size");
+  }
+  std::unique_ptr<CompiledForest> forest(new CompiledForest());
+  forest->num_trees_ = header[0];
+  forest->num_nodes_ = header[1];
+  forest->num_leaves_ = header[2];
+  forest->num_cat_ = header[3];
+  forest->has_categorical_ = header[5] != 0;
+  forest->nodes_ = ViewArray<Node>(&p, end, forest->num_nodes_);
+  forest->leaf_value_ = ViewArray<double>(&p, end, forest->num_leaves_);
+  forest->tree_root_ = ViewArray<int>(&p, end, forest->num_trees_);
+  forest->leaf_offset_ = ViewArray<int>(&p, end, forest->num_trees_);
+  forest->cat_boundaries_ = ViewArray<int>(&p, end, forest->num_cat_ + 1);
+  if (forest->cat_boundaries_[0] != 0 || forest->cat_boundaries_[forest->num_cat_] != header[4] ||
+      !std::is_sorted(forest->cat_boundaries_, forest->cat_boundaries_ + forest->num_cat_ + 1)) {
+    Log::Fatal("Compiled forest binary format error, wrong size of categorical bitsets");
+  }
+  forest->cat_threshold_ = ViewArray<uint32_t>(&p, end, header[4]);
+  // the arrays are walked without checks, children follow their parent in pre-order
+  auto is_valid_child = [&forest] (int child, int parent) {
+    return child >= 0 ? child > parent && child < forest->num_nodes_ : ~child < forest->num_leaves_;
+  };
+  for (int i = 0; i < forest->num_nodes_; ++i) {
+    const Node& node = forest->nodes_[i];
+    if (node.split_feature < 0 || node.split_feature >= num_features ||
+        !is_valid_child(node.left_child, i) || !is_valid_child(node.right_child, i)) {
+      Log::Fatal("Compiled forest binary format error, wrong node %d", i);
+    }
+    if (Tree::GetDecisionType(node.decision_type, kCategoricalMask) &&
+        !(node.threshold >= 0 && node.threshold < forest->num_cat_)) {
+      Log::Fatal("Compiled forest binary format error, wrong categorical split of node %d", i);
+    }
+  }
+  for (int i = 0; i < forest->num_trees_; ++i) {
+    if (!is_valid_child(forest->tree_root_[i], -1) || forest->leaf_offset_[i] < 0 ||
+        forest->leaf_offset_[i] > forest->num_leaves_) {
+      Log::Fatal("Compiled forest binary format error, wrong root of tree %d", i);
+    }
+  }
+  forest->owner_ = std::move(owner);
+  return forest.release();
+}
+
+CompiledForest* CompiledForest::CreateView(std::shared_ptr<const CompiledForest> forest, int start_tree, int num_trees) {
+  CHECK(start_tree >= 0 && num_trees >= 0 && start_tree + num_trees <= forest->num_trees_);
+  // roots and leaf offsets are positions in the arrays of the whole forest, only the tree range moves
+  std::unique_ptr<CompiledForest> view(new CompiledForest());
+  view->nodes_ = forest->nodes_;
+  view->leaf_value_ = forest->leaf_value_;
+  view->tree_root_ = forest->tree_root_ + start_tree;
+  view->leaf_offset_ = forest->leaf_offset_ + start_tree;
+  view->cat_boundaries_ = forest->cat_boundaries_;
+  view->cat_threshold_ = forest->cat_threshold_;
+  view->num_trees_ = num_trees;
+  view->num_nodes_ = forest->num_nodes_;
+  view->num_leaves_ = forest->num_leaves_;
+  view->num_cat_ = forest->num_cat_;
+  view->has_categorical_ = forest->has_categorical_;
+  view->is_view_ = true;
+  view->owner_ = std::move(forest);
+  return view.release();
+}
+
+const float Float32Forest::kZeroThreshold_ = Float32Forest::RoundDown(kZeroThreshold);
+
+float Float32Forest::RoundDown(double value) {
+  float ret = static_cast<float>(value);
+  if (static_cast<double>(ret) > value) {
+    ret = std::nextafter(ret, -std::numeric_limits<float>::infinity());
+  }
+  return ret;
+}
+
+Float32Forest::Float32Forest(const CompiledForest& forest) {
+  nodes_.resize(forest.num_nodes_);
+  for (int i = 0; i < forest.num_nodes_; ++i) {
+    const CompiledForest::Node& node = forest.nodes_[i];
+    Node& float_node = nodes_[i];
+    if (Tree::GetDecisionType(node.decision_type, kCategoricalMask)) {
+      float_node.threshold = static_cast<float>(node.threshold);
+    } else {
+      float_node.threshold = RoundDown(node.threshold);
+    }
+    float_node.split_feature = node.split_feature;
+    float_node.left_child = node.left_child;
+    float_node.right_child = node.right_child;
+    float_node.decision_type = node.decision_type;
+  }
+  leaf_value_.assign(forest.leaf_value_, forest.leaf_value_ + forest.num_leaves_);
+  tree_root_.assign(forest.tree_root_, forest.tree_root_ + forest.num_trees_);
+  cat_boundaries_.assign(forest.cat_boundaries_, forest.cat_boundaries_ + forest.num_cat_ + 1);
+  cat_threshold_.assign(forest.cat_threshold_, forest.cat_threshold_ + forest.cat_boundaries_[forest.num_cat_]);
+  has_categorical_ = forest.has_categorical_;
+}
+
+}  // namespace LightGBM
@@ -0,0 +1,316 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#ifndef LIGHTGBM_BOOSTING_COMPILED_FOREST_H_
+#define LIGHTGBM_BOOSTING_COMPILED_FOREST_H_
+
+#include <LightGBM/meta.h>
+#include <LightGBM/tree.h>
+#include <LightGBM/utils/binary_writer.h>
+#include <LightGBM/utils/common.h>
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace LightGBM {
+
+/*!
+* \brief Immutable, flattened copy of a forest used for inference.
+*        The nodes of all trees are packed into one contiguous array (each tree laid out in pre-order,
+*        so the left child usually sits on the next cache line), and the leaf outputs of all trees
+*        into another one. A child index >= 0 is a position in the node array, a negative one is
+*        the bitwise complement of a position in the leaf array.
+*        The arrays are either owned, or viewed in place from a binary model (e.g. a mapped file)
+*        or from another forest.
+*/
+class CompiledForest {
+ public:
+  /*! \brief One packed split node */
+  struct Node {
+    /*! \brief Threshold on feature value, or the global index of the categorical bitset */
+    double threshold;
+    int32_t split_feature;
+    int32_t left_child;
+    int32_t right_child;
+    int8_t decision_type;
+  };
+
+  /*!
+  * \brief Build the flattened forest of models[start_tree, start_tree + num_trees)
+  * \param models All the trees of the model, the compiled ones must not be linear
+  * \param start_tree Index of the first tree to compile
+  * \param num_trees Number of trees to compile
+  */
+  CompiledForest(const std::vector<std::shared_ptr<Tree>>& models, int start_tree, int num_trees);
+
+  /*! \brief Whether the trees models[start_tree, start_tree + num_trees) can be compiled */
+  static bool CanCompile(const std::vector<std::shared_ptr<Tree>>& models, int start_tree, int num_trees);
+
+  /*! \brief Disable copy, the arrays may point into the own storage */
+  CompiledForest(const CompiledForest&) = delete;
+  CompiledForest& operator=(const CompiledForest&) = delete;
+
+  /*!
+  * \brief Use a forest written by SaveBinaryToFile in place, without copying its arrays
+  * \param memory Start of the binary forest, must be aligned on 8 bytes
+  * \param len Number of bytes available from memory
+  * \param num_features Number of features of the model, the split features must be below
+  * \param owner Keeps memory alive as long as the forest is used
+  * \return The forest viewing memory
+  */
+  static CompiledForest* CreateFromBinary(const char* memory, size_t len, int num_features,
+                                          std::shared_ptr<const void> owner);
+
+  /*!
+  * \brief Use the trees [start_tree, start_tree + num_trees) of another forest, without copying its arrays
+  * \param forest Forest viewed, kept alive as long as the view is used
+  * \param start_tree Index in forest of the first tree of the view
+  * \param num_trees Number of trees of the view
+  * \return The forest viewing the arrays of forest
+  */
+  static CompiledForest* CreateView(std::shared_ptr<const CompiledForest> forest, int start_tree, int num_trees);
+
+  /*! \brief Whether the arrays are viewed from another forest which is still used elsewhere */
+  inline bool IsSharedView() const { return is_view_ && owner_.use_count() > 1; }
+
+  /*! \brief Size of the binary form written by SaveBinaryToFile */
+  size_t SizesInByte() const;
+
+  /*! \brief Write the binary form of the forest, every array aligned on 8 bytes */
+  void SaveBinaryToFile(BinaryWriter* writer) const;
+
+  inline int num_trees() const { return num_trees_; }
+
+  /*!
+  * \brief Renumber the split features, only for a forest compiled from trees
+  * \param feature_map New index of each feature, every split feature must have one
+  */
+  void RemapFeatures(const std::vector<int>& feature_map);
+
+  /*!
+  * \brief Prediction of one tree on one record
+  * \param tree_idx Index of the tree
+  * \param feature_values Feature value of this record
+  * \return Output of the leaf the record falls into
+  */
+  inline double Predict(int tree_idx, const double* feature_values) const {
+    return leaf_value_[GetGlobalLeaf(tree_idx, feature_values)];
+  }
+
+  /*!
+  * \brief Leaf index (local to the tree) of one record
+  */
+  inline int PredictLeafIndex(int tree_idx, const double* feature_values) const {
+    return GetGlobalLeaf(tree_idx, feature_values) - leaf_offset_[tree_idx];
+  }
+
+ private:
+  inline int GetGlobalLeaf(int tree_idx, const double* feature_values) const {
+    int node = tree_root_[tree_idx];
+    if (has_categorical_) {
+      while (node >= 0) {
+        const Node& cur = nodes_[node];
+        node = Decision(feature_values[cur.split_feature], cur);
+      }
+    } else {
+      while (node >= 0) {
+        const Node& cur = nodes_[node];
+        node = NumericalDecision(feature_values[cur.split_feature], cur);
+      }
+    }
+    return ~node;
+  }
+
+  static inline int NumericalDecision(double fval, const Node& node) {
+    const int8_t missing_type = Tree::GetMissingType(node.decision_type);
+    if (std::isnan(fval) && missing_type != MissingType::NaN) {
+      fval = 0.0f;
+    }
+    if ((missing_type == MissingType::Zero && Tree::IsZero(fval))
+        || (missing_type == MissingType::NaN && std::isnan(fval))) {
+      if (Tree::GetDecisionType(node.decision_type, kDefaultLeftMask)) {
+        return node.left_child;
+      } else {
+        return node.right_child;
+      }
+    }
+    if (fval <= node.threshold) {
+      return node.left_child;
+    } else {
+      return node.right_child;
+    }
+  }
+
+  inline int CategoricalDecision(double fval, const Node& node) const {
+    int int_fval;
+    if (std::isnan(fval)) {
+      return node.right_child;
+    } else {
+      int_fval = static_cast<int>(fval);
+      if (int_fval < 0) {
+        return node.right_child;
+      }
+    }
+    const int cat_idx = static_cast<int>(node.threshold);
+    if (Common::FindInBitset(cat_threshold_ + cat_boundaries_[cat_idx],
+                             cat_boundaries_[cat_idx + 1] - cat_boundaries_[cat_idx], int_fval)) {
+      return node.left_child;
+    }
+    return node.right_child;
+  }
+
+  inline int Decision(double fval, const Node& node) const {
+    if (Tree::GetDecisionType(node.decision_type, kCategoricalMask)) {
+      return CategoricalDecision(fval, node);
+    } else {
+      return NumericalDecision(fval, node);
+    }
+  }
+
+  CompiledForest() = default;
+
+  friend class Float32Forest;
+
+  /*! \brief Append the subtree rooted at node of tree to nodes_storage_, return its encoded position */
+  int AppendSubtree(const Tree& tree, int node, int leaf_offset, int cat_offset);
+
+  /*! \brief Split nodes of all trees */
+  const Node* nodes_ = nullptr;
+  /*! \brief Leaf outputs of all trees */
+  const double* leaf_value_ = nullptr;
+  /*! \brief Encoded root of each tree, negative for single-leaf trees */
+  const int* tree_root_ = nullptr;
+  /*! \brief Position of the first leaf of each tree in leaf_value_ */
+  const int* leaf_offset_ = nullptr;
+  /*! \brief Bitsets of all categorical splits */
+  const int* cat_boundaries_ = nullptr;
+  const uint32_t* cat_threshold_ = nullptr;
+  int num_trees_ = 0;
+  int num_nodes_ = 0;
+  int num_leaves_ = 0;
+  int num_cat_ = 0;
+  bool has_categorical_ = false;
+  /*! \brief Whether owner_ is the forest the arrays are viewed from, see CreateView */
+  bool is_view_ = false;
+  /*! \brief Storage of the arrays above, when the forest is compiled from trees */
+  std::vector<Node> nodes_storage_;
+  std::vector<double> leaf_value_storage_;
+  std::vector<int> tree_root_storage_;
+  std::vector<int> leaf_offset_storage_;
+  std::vector<int> cat_boundaries_storage_;
+  std::vector<uint32_t> cat_threshold_storage_;
+  /*! \brief Memory viewed by the arrays above, when the forest is used in place */
+  std::shared_ptr<const void> owner_;
+};
+
+/*!
+* \brief Single precision copy of a CompiledForest, with the same layout.
+*        Numerical thresholds are rounded down to the nearest float, so that a float32 feature value
+*        goes to the same side of every split as with the double forest; leaf values are rounded
+*        to the nearest float.
+*/
+class Float32Forest {
+ public:
+  /*! \brief One packed split node */
+  struct Node {
+    /*! \brief Threshold on feature value, or the global index of the categorical bitset */
+    float threshold;
+    int32_t split_feature;
+    int32_t left_child;
+    int32_t right_child;
+    int8_t decision_type;
+  };
+
+  explicit Float32Forest(const CompiledForest& forest);
+
+  /*!
+  * \brief Prediction of one tree on one record
+  * \param tree_idx Index of the tree
+  * \param feature_values Feature value of this record
+  * \return Output of the leaf the record falls into
+  */
+  inline float Predict(int tree_idx, const float* feature_values) const {
+    int node = tree_root_[tree_idx];
+    if (has_categorical_) {
+      while (node >= 0) {
+        const Node& cur = nodes_[node];
+        node = Decision(feature_values[cur.split_feature], cur);
+      }
+    } else {
+      while (node >= 0) {
+        const Node& cur = nodes_[node];
+        node = NumericalDecision(feature_values[cur.split_feature], cur);
+      }
+    }
+    return leaf_value_[~node];
+  }
+
+  /*! \brief Largest float which is not greater than value */
+  static float RoundDown(double value);
+
+ private:
+  static inline bool IsZero(float fval) {
+    return fval >= -kZeroThreshold_ && fval <= kZeroThreshold_;
+  }
+
+  static inline int NumericalDecision(float fval, const Node& node) {
+    const int8_t missing_type = Tree::GetMissingType(node.decision_type);
+    if (std::isnan(fval) && missing_type != MissingType::NaN) {
+      fval = 0.0f;
+    }
+    if ((missing_type == MissingType::Zero && IsZero(fval))
+        || (missing_type == MissingType::NaN && std::isnan(fval))) {
+      if (Tree::GetDecisionType(node.decision_type, kDefaultLeftMask)) {
+        return node.left_child;
+      } else {
+        return node.right_child;
+      }
+    }
+    if (fval <= node.threshold) {
+      return node.left_child;
+    } else {
+      return node.right_child;
+    }
+  }
+
+  inline int CategoricalDecision(float fval, const Node& node) const {
+    int int_fval;
+    if (std::isnan(fval)) {
+      return node.right_child;
+    } else {
+      int_fval = static_cast<int>(fval);
+      if (int_fval < 0) {
+        return node.right_child;
+      }
+    }
+    const int cat_idx = static_cast<int>(node.threshold);
+    if (Common::FindInBitset(cat_threshold_.data() + cat_boundaries_[cat_idx],
+                             cat_boundaries_[cat_idx + 1] - cat_boundaries_[cat_idx], int_fval)) {
+      return node.left_child;
+    }
+    return node.right_child;
+  }
+
+  inline int Decision(float fval, const Node& node) const {
+    if (Tree::GetDecisionType(node.decision_type, kCategoricalMask)) {
+      return CategoricalDecision(fval, node);
+    } else {
+      return NumericalDecision(fval, node);
+    }
+  }
+
+  /*! \brief kZeroThreshold rounded down, a float is zero for Tree::IsZero iff it is for IsZero */
+  static const float kZeroThreshold_;
+  std::vector<Node> nodes_;
+  std::vector<float> leaf_value_;
+  std::vector<int> tree_root_;
+  std::vector<int> cat_boundaries_;
+  std::vector<uint32_t> cat_threshold_;
+  bool has_categorical_;
+};
+
+}  // namespace LightGBM
+#endif   // LIGHTGBM_BOOSTING_COMPILED_FOREST_H_
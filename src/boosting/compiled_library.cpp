@@ -0,0 +1,84 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#include "compiled_library.h"
+
+#include <LightGBM/utils/log.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+namespace LightGBM {
+
+std::unique_ptr<CompiledLibrary> CompiledLibrary::Open(const std::string& filename) {
+  std::unique_ptr<CompiledLibrary> library(new CompiledLibrary());
+#ifdef _WIN32
+  library->handle_ = reinterpret_cast<void*>(LoadLibraryA(filename.c_str()));
+  if (library->handle_ == nullptr) {
+    Log::Fatal("Could not load compiled model %s", filename.c_str());
+  }
+#else
+  // a name without slash would be searched in the library path instead of the working directory
+  const std::string path = filename.find('/') == std::string::npos ? "./" + filename : filename;
+  library->handle_ = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (library->handle_ == nullptr) {
+    Log::Fatal("Could not load compiled model %s: %s", filename.c_str(), dlerror());
+  }
+#endif
+  typedef int (*IntFunction)();
+  auto abi_version = reinterpret_cast<IntFunction>(library->Symbol("lgbm_compiled_abi_version"));
+  auto num_trees = reinterpret_cast<IntFunction>(library->Symbol("lgbm_compiled_num_trees"));
+  auto num_tree_per_iteration = reinterpret_cast<IntFunction>(library->Symbol("lgbm_compiled_num_tree_per_iteration"));
+  auto num_features = reinterpret_cast<IntFunction>(library->Symbol("lgbm_compiled_num_features"));
+  library->predict_raw_ = reinterpret_cast<PredictRawFunction>(library->Symbol("lgbm_compiled_predict_raw"));
+  library->predict_raw_float32_ = reinterpret_cast<PredictRawFloat32Function>(
+    library->Symbol("lgbm_compiled_predict_raw_float32"));
+  library->model_string_ = reinterpret_cast<ModelStringFunction>(library->Symbol("lgbm_compiled_model_string"));
+  if (abi_version == nullptr || num_trees == nullptr || num_tree_per_iteration == nullptr || num_features == nullptr
+      || library->predict_raw_ == nullptr || library->model_string_ == nullptr) {
+    Log::Fatal("%s is not a compiled LightGBM model", filename.c_str());
+  }
+  if (abi_version() != kAbiVersion) {
+    Log::Fatal("Compiled model %s has version %d, expected %d, compile the model again",
+               filename.c_str(), abi_version(), kAbiVersion);
+  }
+  library->num_trees_ = num_trees();
+  library->num_tree_per_iteration_ = num_tree_per_iteration();
+  library->num_features_ = num_features();
+  return library;
+}
+
+CompiledLibrary::~CompiledLibrary() {
+  if (handle_ != nullptr) {
+#ifdef _WIN32
+    FreeLibrary(reinterpret_cast<HMODULE>(handle_));
+#else
+    dlclose(handle_);
+#endif
+  }
+}
+
+void* CompiledLibrary::Symbol(const char* name) const {
+#ifdef _WIN32
+  return reinterpret_cast<void*>(GetProcAddress(reinterpret_cast<HMODULE>(handle_), name));
+#else
+  return dlsym(handle_, name);
+#endif
+}
+
+std::string CompiledLibrary::ModelString() const {
+  std::string model;
+  for (const char* const* chunk = model_string_(); *chunk != nullptr; ++chunk) {
+    model += *chunk;
+  }
+  return model;
+}
+
+}  // namespace LightGBM
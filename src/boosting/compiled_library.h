@@ -0,0 +1,87 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#ifndef LIGHTGBM_BOOSTING_COMPILED_LIBRARY_H_
+#define LIGHTGBM_BOOSTING_COMPILED_LIBRARY_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace LightGBM {
+
+/*!
+* \brief Shared library built from the C source of GBDT::ModelToCompiledSource.
+*        The library exports the model string it was generated from, the shape of the forest,
+*        and the batch entry points predicting the raw scores of contiguous rows.
+*/
+class CompiledLibrary {
+ public:
+  /*! \brief Version of the exported interface, written into the generated source */
+  static const int kAbiVersion = 1;
+
+  /*!
+  * \brief Load a compiled model
+  * \param filename Path of the shared library
+  * \return The loaded library, fails when it cannot be loaded or was not generated by this version
+  */
+  static std::unique_ptr<CompiledLibrary> Open(const std::string& filename);
+
+  ~CompiledLibrary();
+
+  /*! \brief Disable copy, the handle is released by the destructor */
+  CompiledLibrary(const CompiledLibrary&) = delete;
+  CompiledLibrary& operator=(const CompiledLibrary&) = delete;
+
+  /*! \brief Text model the library was generated from */
+  std::string ModelString() const;
+
+  inline int num_trees() const { return num_trees_; }
+  inline int num_tree_per_iteration() const { return num_tree_per_iteration_; }
+  inline int num_features() const { return num_features_; }
+
+  /*! \brief Whether the library has the float32 entry point */
+  inline bool HasFloat32() const { return predict_raw_float32_ != nullptr; }
+
+  /*!
+  * \brief Raw scores of iterations [start_iteration, start_iteration + num_iteration) for a block of rows
+  * \param rows Feature values, row_stride values from one row to the next
+  * \param num_rows Number of rows
+  * \param row_stride Distance between two rows, at least num_features()
+  * \param output Output, num_tree_per_iteration() scores per row, summed in the same order as GBDT::PredictRaw
+  */
+  inline void PredictRaw(const double* rows, int64_t num_rows, int64_t row_stride,
+                         int start_iteration, int num_iteration, double* output) const {
+    predict_raw_(rows, num_rows, row_stride, start_iteration, num_iteration, output);
+  }
+
+  /*! \brief Same as PredictRaw on float32 rows, as GBDT::PredictRawFloat32 */
+  inline void PredictRawFloat32(const float* rows, int64_t num_rows, int64_t row_stride,
+                                int start_iteration, int num_iteration, double* output) const {
+    predict_raw_float32_(rows, num_rows, row_stride, start_iteration, num_iteration, output);
+  }
+
+ private:
+  typedef void (*PredictRawFunction)(const double*, int64_t, int64_t, int, int, double*);
+  typedef void (*PredictRawFloat32Function)(const float*, int64_t, int64_t, int, int, double*);
+  typedef const char* const* (*ModelStringFunction)();
+
+  CompiledLibrary() = default;
+
+  /*! \brief Address of an exported symbol, nullptr when absent */
+  void* Symbol(const char* name) const;
+
+  /*! \brief Handle of the loaded library */
+  void* handle_ = nullptr;
+  PredictRawFunction predict_raw_ = nullptr;
+  PredictRawFloat32Function predict_raw_float32_ = nullptr;
+  /*! \brief Returns the chunks of the model string, terminated by nullptr */
+  ModelStringFunction model_string_ = nullptr;
+  int num_trees_ = 0;
+  int num_tree_per_iteration_ = 0;
+  int num_features_ = 0;
+};
+
+}  // namespace LightGBM
+#endif   // LIGHTGBM_BOOSTING_COMPILED_LIBRARY_H_
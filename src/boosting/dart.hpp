@@ -131,6 +131,7 @@ class DART: public GBDT {
     for (auto i : drop_index_) {
       for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
         auto curr_tree = i * num_tree_per_iteration_ + cur_tree_id;
+        UnshareTree(curr_tree);
         models_[curr_tree]->Shrinkage(-1.0);
         train_score_updater_->AddScore(models_[curr_tree].get(), cur_tree_id);
       }
@@ -162,6 +163,7 @@ class DART: public GBDT {
         for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
           auto curr_tree = i * num_tree_per_iteration_ + cur_tree_id;
           // update validation score
+          UnshareTree(curr_tree);
           models_[curr_tree]->Shrinkage(1.0f / (k + 1.0f));
           for (auto& score_updater : valid_score_updater_) {
             score_updater->AddScore(models_[curr_tree].get(), cur_tree_id);
@@ -180,6 +182,7 @@ class DART: public GBDT {
         for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
           auto curr_tree = i * num_tree_per_iteration_ + cur_tree_id;
           // update validation score
+          UnshareTree(curr_tree);
           models_[curr_tree]->Shrinkage(shrinkage_rate_);
           for (auto& score_updater : valid_score_updater_) {
             score_updater->AddScore(models_[curr_tree].get(), cur_tree_id);
@@ -12,6 +12,7 @@
 #include <LightGBM/utils/openmp_wrapper.h>
 #include <LightGBM/sample_strategy.h>
 
+#include <algorithm>
 #include <chrono>
 #include <ctime>
 #include <queue>
@@ -35,7 +36,6 @@ GBDT::GBDT()
       max_feature_idx_(0),
       num_tree_per_iteration_(1),
       num_class_(1),
-      num_iteration_for_pred_(0),
       shrinkage_rate_(0.1f),
       num_init_iteration_(0) {
   average_output_ = false;
@@ -61,7 +61,6 @@ void GBDT::Init(const Config* config, const Dataset* train_data, const Objective
     CHECK_EQ(static_cast<size_t>(train_data_->num_total_features()), config->feature_contri.size());
   }
   iter_ = 0;
-  num_iteration_for_pred_ = 0;
   max_feature_idx_ = 0;
   num_class_ = config->num_class;
   config_ = std::unique_ptr<Config>(new Config(*config));
@@ -254,8 +253,7 @@ void GBDT::RefitTree(const int* tree_leaf_prediction, const size_t nrow, const s
   CHECK_EQ(static_cast<size_t>(num_data_), nrow);
   CHECK_EQ(models_.size(), ncol);
 
-  int num_iterations = static_cast<int>(models_.size() / num_tree_per_iteration_);
-  std::vector<int> leaf_pred(num_data_);
+  int max_leaves = 0;
   if (linear_tree_) {
     std::vector<int> max_leaves_by_thread = std::vector<int>(OMP_NUM_THREADS(), 0);
     #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
@@ -265,26 +263,84 @@ void GBDT::RefitTree(const int* tree_leaf_prediction, const size_t nrow, const s
         max_leaves_by_thread[tid] = std::max(max_leaves_by_thread[tid], tree_leaf_prediction[i * ncol + j]);
       }
     }
-    int max_leaves = *std::max_element(max_leaves_by_thread.begin(), max_leaves_by_thread.end());
+    max_leaves = *std::max_element(max_leaves_by_thread.begin(), max_leaves_by_thread.end());
     max_leaves += 1;
-    tree_learner_->InitLinear(train_data_, max_leaves);
   }
 
-  for (int iter = 0; iter < num_iterations; ++iter) {
-    Boosting();
-    for (int tree_id = 0; tree_id < num_tree_per_iteration_; ++tree_id) {
-      int model_index = iter * num_tree_per_iteration_ + tree_id;
+  RefitTreeByBlocks(1, max_leaves, [this, tree_leaf_prediction, ncol] (int model_start, std::vector<std::vector<int>>* leaf_pred) {
+    for (int k = 0; k < static_cast<int>(leaf_pred->size()); ++k) {
+      const int model_index = model_start + k;
+      std::vector<int>& leaves = (*leaf_pred)[k];
       #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
       for (int i = 0; i < num_data_; ++i) {
-        leaf_pred[i] = tree_leaf_prediction[i * ncol + model_index];
-        CHECK_LT(leaf_pred[i], models_[model_index]->num_leaves());
+        leaves[i] = tree_leaf_prediction[i * ncol + model_index];
+        CHECK_LT(leaves[i], models_[model_index]->num_leaves());
+      }
+    }
+  });
+}
+
+void GBDT::RefitTree(size_t nrow, const std::function<void(data_size_t row_idx, double* features)>& get_row_fun) {
+  CHECK_GT(nrow, 0);
+  CHECK_EQ(static_cast<size_t>(num_data_), nrow);
+  CHECK_GT(models_.size(), 0);
+
+  int max_leaves = 0;
+  for (const auto& tree : models_) {
+    max_leaves = std::max(max_leaves, tree->num_leaves());
+  }
+  // the leaves of a block of iterations are computed with one pass on the features,
+  // and only the leaf indices of this block are stored
+  const size_t num_leaf_pred_per_iteration = static_cast<size_t>(num_data_) * num_tree_per_iteration_;
+  const int iterations_per_block = static_cast<int>(
+    std::max<size_t>(1, static_cast<size_t>(config_->refit_leaf_buffer_size) / num_leaf_pred_per_iteration));
+  const int num_features = max_feature_idx_ + 1;
+  std::vector<std::vector<double>> features_by_thread(OMP_NUM_THREADS());
+
+  RefitTreeByBlocks(iterations_per_block, max_leaves,
+                    [this, &get_row_fun, &features_by_thread, num_features] (int model_start, std::vector<std::vector<int>>* leaf_pred) {
+    const int num_models = static_cast<int>(leaf_pred->size());
+    OMP_INIT_EX();
+    #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
+    for (data_size_t i = 0; i < num_data_; ++i) {
+      OMP_LOOP_EX_BEGIN();
+      std::vector<double>& features = features_by_thread[omp_get_thread_num()];
+      features.assign(num_features, 0.0);
+      get_row_fun(i, features.data());
+      for (int k = 0; k < num_models; ++k) {
+        (*leaf_pred)[k][i] = models_[model_start + k]->PredictLeafIndex(features.data());
+      }
+      OMP_LOOP_EX_END();
+    }
+    OMP_THROW_EX();
+  });
+}
+
+void GBDT::RefitTreeByBlocks(int iterations_per_block, int max_leaves,
+                             const std::function<void(int model_start, std::vector<std::vector<int>>* leaf_pred)>& leaf_fun) {
+  ResetPredictionCache();
+  if (linear_tree_) {
+    tree_learner_->InitLinear(train_data_, max_leaves);
+  }
+
+  int num_iterations = static_cast<int>(models_.size() / num_tree_per_iteration_);
+  std::vector<std::vector<int>> leaf_pred;
+  for (int block_start = 0; block_start < num_iterations; block_start += iterations_per_block) {
+    const int block_end = std::min(num_iterations, block_start + iterations_per_block);
+    const int model_start = block_start * num_tree_per_iteration_;
+    leaf_pred.resize(static_cast<size_t>(block_end - block_start) * num_tree_per_iteration_, std::vector<int>(num_data_));
+    leaf_fun(model_start, &leaf_pred);
+    for (int iter = block_start; iter < block_end; ++iter) {
+      Boosting();
+      for (int tree_id = 0; tree_id < num_tree_per_iteration_; ++tree_id) {
+        int model_index = iter * num_tree_per_iteration_ + tree_id;
+        size_t offset = static_cast<size_t>(tree_id) * num_data_;
+        auto grad = gradients_pointer_ + offset;
+        auto hess = hessians_pointer_ + offset;
+        auto new_tree = tree_learner_->FitByExistingTree(models_[model_index].get(), leaf_pred[model_index - model_start], grad, hess);
+        train_score_updater_->AddScore(tree_learner_.get(), new_tree, tree_id);
+        models_[model_index].reset(new_tree);
       }
-      size_t offset = static_cast<size_t>(tree_id) * num_data_;
-      auto grad = gradients_pointer_ + offset;
-      auto hess = hessians_pointer_ + offset;
-      auto new_tree = tree_learner_->FitByExistingTree(models_[model_index].get(), leaf_pred, grad, hess);
-      train_score_updater_->AddScore(tree_learner_.get(), new_tree, tree_id);
-      models_[model_index].reset(new_tree);
     }
   }
 }
@@ -337,6 +393,7 @@ double GBDT::BoostFromAverage(int class_id, bool update_scorer) {
 
 bool GBDT::TrainOneIter(const score_t* gradients, const score_t* hessians) {
   Common::FunctionTimer fun_timer("GBDT::TrainOneIter", global_timer);
+  ResetPredictionCache();
   std::vector<double> init_scores(num_tree_per_iteration_, 0.0);
   // boosting first
   if (gradients == nullptr || hessians == nullptr) {
@@ -375,11 +432,15 @@ bool GBDT::TrainOneIter(const score_t* gradients, const score_t* hessians) {
     ResetGradientBuffers();
   }
 
-  bool should_continue = false;
+  // the gradients of all the trees are ready before the first one is trained,
+  // so the tree learner can share work between them
+  std::vector<const score_t*> tree_gradients(num_tree_per_iteration_, nullptr);
+  std::vector<const score_t*> tree_hessians(num_tree_per_iteration_, nullptr);
+  std::vector<const score_t*> trained_gradients;
+  std::vector<const score_t*> trained_hessians;
   for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
-    const size_t offset = static_cast<size_t>(cur_tree_id) * num_data_;
-    std::unique_ptr<Tree> new_tree(new Tree(2, false, false));
     if (class_need_train_[cur_tree_id] && train_data_->num_features() > 0) {
+      const size_t offset = static_cast<size_t>(cur_tree_id) * num_data_;
       auto grad = gradients + offset;
       auto hess = hessians + offset;
       // need to copy gradients for bagging subset.
@@ -391,8 +452,23 @@ bool GBDT::TrainOneIter(const score_t* gradients, const score_t* hessians) {
         grad = gradients_pointer_ + offset;
         hess = hessians_pointer_ + offset;
       }
+      tree_gradients[cur_tree_id] = grad;
+      tree_hessians[cur_tree_id] = hess;
+      trained_gradients.push_back(grad);
+      trained_hessians.push_back(hess);
+    }
+  }
+  if (!trained_gradients.empty()) {
+    tree_learner_->BeforeTrainIteration(trained_gradients, trained_hessians);
+  }
+
+  bool should_continue = false;
+  for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
+    const size_t offset = static_cast<size_t>(cur_tree_id) * num_data_;
+    std::unique_ptr<Tree> new_tree(new Tree(2, false, false));
+    if (tree_gradients[cur_tree_id] != nullptr) {
       bool is_first_tree = models_.size() < static_cast<size_t>(num_tree_per_iteration_);
-      new_tree.reset(tree_learner_->Train(grad, hess, is_first_tree));
+      new_tree.reset(tree_learner_->Train(tree_gradients[cur_tree_id], tree_hessians[cur_tree_id], is_first_tree));
     }
 
     if (new_tree->num_leaves() > 1) {
@@ -442,9 +518,11 @@ bool GBDT::TrainOneIter(const score_t* gradients, const score_t* hessians) {
 
 void GBDT::RollbackOneIter() {
   if (iter_ <= 0) { return; }
+  ResetPredictionCache();
   // reset score
   for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
     auto curr_tree = models_.size() - num_tree_per_iteration_ + cur_tree_id;
+    UnshareTree(curr_tree);
     models_[curr_tree]->Shrinkage(-1.0);
     train_score_updater_->AddScore(models_[curr_tree].get(), cur_tree_id);
     for (auto& score_updater : valid_score_updater_) {
@@ -470,6 +548,7 @@ bool GBDT::EvalAndCheckEarlyStopping() {
               iter_, iter_ - early_stopping_round_);
     Log::Info("Output of best iteration round:\n%s", best_msg.c_str());
     // pop last early_stopping_round_ models
+    ResetPredictionCache();
     for (int i = 0; i < early_stopping_round_ * num_tree_per_iteration_; ++i) {
       models_.pop_back();
     }
@@ -626,27 +705,76 @@ const double* GBDT::GetTrainingScore(int64_t* out_len) {
   return train_score_updater_->score();
 }
 
-void GBDT::PredictContrib(const double* features, double* output) const {
+void GBDT::PredictContrib(const PredictionPlan& plan, const double* features, double* output) const {
+  const auto& gbdt_plan = static_cast<const GBDTPredictionPlan&>(plan);
   // set zero
   const int num_features = max_feature_idx_ + 1;
   std::memset(output, 0, sizeof(double) * num_tree_per_iteration_ * (num_features + 1));
-  const int end_iteration_for_pred = start_iteration_for_pred_ + num_iteration_for_pred_;
-  for (int i = start_iteration_for_pred_; i < end_iteration_for_pred; ++i) {
+  for (int i = 0; i < plan.num_iteration; ++i) {
     // predict all the trees for one iteration
     for (int k = 0; k < num_tree_per_iteration_; ++k) {
-      models_[i * num_tree_per_iteration_ + k]->PredictContrib(features, num_features, output + k*(num_features + 1));
+      gbdt_plan.trees[i * num_tree_per_iteration_ + k]->PredictContrib(features, num_features,
+                                                                       output + k*(num_features + 1));
     }
   }
 }
 
-void GBDT::PredictContribByMap(const std::unordered_map<int, double>& features,
-                               std::vector<std::unordered_map<int, double>>* output) const {
+void GBDT::PredictContribBlock(const PredictionPlan& plan, const double* features, int num_rows,
+                               double* output) const {
+  const auto& gbdt_plan = static_cast<const GBDTPredictionPlan&>(plan);
+  static THREAD_LOCAL Tree::ContribBlockBuffer buffer;
+  // set zero
   const int num_features = max_feature_idx_ + 1;
-  const int end_iteration_for_pred = start_iteration_for_pred_ + num_iteration_for_pred_;
-  for (int i = start_iteration_for_pred_; i < end_iteration_for_pred; ++i) {
+  const int output_stride = num_tree_per_iteration_ * (num_features + 1);
+  std::memset(output, 0, sizeof(double) * output_stride * num_rows);
+  for (int i = 0; i < plan.num_iteration; ++i) {
     // predict all the trees for one iteration
     for (int k = 0; k < num_tree_per_iteration_; ++k) {
-      models_[i * num_tree_per_iteration_ + k]->PredictContribByMap(features, num_features, &((*output)[k]));
+      gbdt_plan.trees[i * num_tree_per_iteration_ + k]->PredictContribBlock(features, num_rows, num_features,
+                                                                            output + k*(num_features + 1),
+                                                                            output_stride, &buffer);
+    }
+  }
+}
+
+void GBDT::PredictContribSparse(const PredictionPlan& plan, const SparseRow& features,
+                                std::vector<std::vector<std::pair<int, double>>>* output) const {
+  const auto& gbdt_plan = static_cast<const GBDTPredictionPlan&>(plan);
+  const int num_features = max_feature_idx_ + 1;
+  // contributions are accumulated densely, only the entries of the split features are written, then reset
+  static THREAD_LOCAL std::vector<double> phi;
+  phi.resize(num_features + 1, 0.0);
+  for (int k = 0; k < num_tree_per_iteration_; ++k) {
+    for (int i = 0; i < plan.num_iteration; ++i) {
+      gbdt_plan.trees[i * num_tree_per_iteration_ + k]->PredictContribSparse(features, num_features, phi.data());
+    }
+    auto& class_output = (*output)[k];
+    class_output.clear();
+    for (const int feature : gbdt_plan.contrib_features[k]) {
+      class_output.emplace_back(feature, phi[feature]);
+      phi[feature] = 0.0;
+    }
+    class_output.emplace_back(num_features, phi[num_features]);
+    phi[num_features] = 0.0;
+  }
+}
+
+void GBDT::SetContribFeatures(GBDTPredictionPlan* plan) const {
+  const int num_features = max_feature_idx_ + 1;
+  plan->contrib_features.assign(num_tree_per_iteration_, std::vector<int>());
+  std::vector<bool> is_used(num_features);
+  for (int k = 0; k < num_tree_per_iteration_; ++k) {
+    std::fill(is_used.begin(), is_used.end(), false);
+    for (int i = 0; i < plan->num_iteration; ++i) {
+      const Tree* tree = plan->trees[i * num_tree_per_iteration_ + k];
+      for (int node = 0; node < tree->num_leaves() - 1; ++node) {
+        is_used[tree->split_feature(node)] = true;
+      }
+    }
+    for (int feature = 0; feature < num_features; ++feature) {
+      if (is_used[feature]) {
+        plan->contrib_features[k].push_back(feature);
+      }
     }
   }
 }
@@ -712,6 +840,81 @@ double GBDT::GetLowerBoundValue() const {
   return min_value;
 }
 
+Boosting* GBDT::CreateView(int start_iteration, int num_iteration) {
+  const int total_iteration = static_cast<int>(models_.size()) / num_tree_per_iteration_;
+  start_iteration = std::max(0, std::min(start_iteration, total_iteration));
+  if (num_iteration <= 0 || num_iteration > total_iteration - start_iteration) {
+    num_iteration = total_iteration - start_iteration;
+  }
+  const int start_tree = start_iteration * num_tree_per_iteration_;
+  const int num_trees = num_iteration * num_tree_per_iteration_;
+  // shared trees are never written again, fill their lazily computed depth now
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
+  for (int i = start_tree; i < start_tree + num_trees; ++i) {
+    if (models_[i]->max_depth() < 0) {
+      models_[i]->RecomputeMaxDepth();
+    }
+  }
+  std::unique_ptr<GBDT> view(new GBDT());
+  view->models_.assign(models_.begin() + start_tree, models_.begin() + start_tree + num_trees);
+  view->num_class_ = num_class_;
+  view->num_tree_per_iteration_ = num_tree_per_iteration_;
+  view->label_idx_ = label_idx_;
+  view->max_feature_idx_ = max_feature_idx_;
+  view->average_output_ = average_output_;
+  view->feature_names_ = feature_names_;
+  view->feature_infos_ = feature_infos_;
+  view->monotone_constraints_ = monotone_constraints_;
+  view->linear_tree_ = linear_tree_;
+  view->loaded_parameter_ = loaded_parameter_;
+  view->parser_config_str_ = parser_config_str_;
+  if (objective_function_ != nullptr) {
+    view->loaded_objective_.reset(ObjectiveFunction::CreateObjectiveFunction(objective_function_->ToString()));
+    view->objective_function_ = view->loaded_objective_.get();
+  }
+  view->num_init_iteration_ = num_iteration;
+  // the view predicts on the flattened forest of this booster, built now so that all the views share it,
+  // except for oblivious trees, which are not walked on it
+  GBDTPredictionCache* cache = PredictionCache();
+  const int num_models = static_cast<int>(models_.size());
+  const bool all_oblivious = std::all_of(models_.begin(), models_.end(),
+                                         [] (const std::shared_ptr<Tree>& tree) { return tree->is_oblivious(); });
+  if (!all_oblivious && cache->compiled_forest == nullptr && CompiledForest::CanCompile(models_, 0, num_models)) {
+    cache->compiled_forest.reset(new CompiledForest(models_, 0, num_models));
+  }
+  if (cache->compiled_forest != nullptr) {
+    view->PredictionCache()->compiled_forest.reset(
+        CompiledForest::CreateView(cache->compiled_forest, start_tree, num_trees));
+  }
+  return view.release();
+}
+
+void GBDT::GetMemoryUsage(int64_t* own_bytes, int64_t* shared_bytes) const {
+  *own_bytes = 0;
+  *shared_bytes = 0;
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  // the current cache holds one more reference to each tree
+  const int64_t own_count = cache_ != nullptr ? 2 : 1;
+  for (const auto& tree : models_) {
+    const int64_t size = static_cast<int64_t>(tree->SizesInByte());
+    if (tree.use_count() > own_count) {
+      *shared_bytes += size;
+    } else {
+      *own_bytes += size;
+    }
+  }
+  const CompiledForest* compiled_forest = cache_ != nullptr ? cache_->compiled_forest.get() : nullptr;
+  if (compiled_forest != nullptr) {
+    const int64_t size = static_cast<int64_t>(compiled_forest->SizesInByte());
+    if (cache_->compiled_forest.use_count() > 1 || compiled_forest->IsSharedView()) {
+      *shared_bytes += size;
+    } else {
+      *own_bytes += size;
+    }
+  }
+}
+
 void GBDT::ResetTrainingData(const Dataset* train_data, const ObjectiveFunction* objective_function,
                              const std::vector<const Metric*>& training_metrics) {
   if (train_data != train_data_ && !train_data_->CheckAlign(*train_data)) {
@@ -20,10 +20,15 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <sstream>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "binned_forest.h"
+#include "compiled_forest.h"
+#include "compiled_library.h"
+#include "quick_scorer.h"
 #include "cuda/cuda_score_updater.hpp"
 #include "score_updater.hpp"
 
@@ -31,6 +36,72 @@ namespace LightGBM {
 
 using json11_internal_lightgbm::Json;
 
+/*!
+* \brief Structures predicting a snapshot of the trees of a GBDT, built on demand by GBDT::CreatePredictionPlan.
+*        Each field is set once under GBDT::cache_mutex_ and never modified after, and the GBDT starts a new cache
+*        whenever its trees change, so the plans holding this one keep predicting the trees it was built from.
+*/
+struct GBDTPredictionCache {
+  /*! \brief Trees the structures below were built from */
+  std::vector<std::shared_ptr<Tree>> models;
+  /*! \brief Flattened copy of models, may be viewed by other boosters */
+  std::shared_ptr<const CompiledForest> compiled_forest;
+  /*! \brief Single precision copy of compiled_forest */
+  std::unique_ptr<Float32Forest> float32_forest;
+  /*! \brief Forest evaluated on quantized records */
+  std::unique_ptr<BinnedForest> binned_forest;
+  /*! \brief Copy of compiled_forest splitting on compact features */
+  std::unique_ptr<CompiledForest> compact_forest;
+  /*! \brief Raw index of each compact feature */
+  std::vector<int> compact_features;
+  /*! \brief Bitvector scorers of all the tree ranges planned so far */
+  std::vector<std::unique_ptr<QuickScorer>> quick_scorers;
+  /*! \brief Shared library the model was loaded from */
+  std::shared_ptr<const CompiledLibrary> compiled_library;
+};
+
+/*!
+* \brief Prediction plan of a GBDT: the trees of the predicted iterations, the structure scoring them
+*        and the transformation of the raw scores
+*/
+struct GBDTPredictionPlan : public PredictionPlan {
+  /*! \brief Keeps the trees and the structures below alive */
+  std::shared_ptr<const GBDTPredictionCache> cache;
+  /*! \brief Trees of the predicted iterations, tree k of iteration start_iteration + i at i * num_tree_per_iteration + k */
+  std::vector<const Tree*> trees;
+  /*! \brief Index of trees[0] in the forests */
+  int start_tree = 0;
+  /*! \brief Flattened forest, trees are walked one by one when nullptr */
+  const CompiledForest* forest = nullptr;
+  /*! \brief Single precision forest, only set with use_float32 */
+  const Float32Forest* float32_forest = nullptr;
+  /*! \brief Forest splitting on compact features, only set with use_compact_features */
+  const CompiledForest* compact_forest = nullptr;
+  /*! \brief Scores go through the compiled library when set */
+  const CompiledLibrary* compiled_library = nullptr;
+  /*! \brief Scores go through the binned forest when set */
+  const BinnedForest* binned_forest = nullptr;
+  /*! \brief Scores go through the bitvector scorer of trees when set */
+  const QuickScorer* quick_scorer = nullptr;
+  /*! \brief Whether early_stop may stop a prediction before its last iteration */
+  bool can_stop_early = false;
+  /*!
+  * \brief Bounds of the raw score added by the iterations after i, for the exact early stopping:
+  *        sums of the lowest and of the highest leaf values of tree k at (i + 1) * num_tree_per_iteration + k.
+  *        Empty when the trees cannot be bounded (linear trees)
+  */
+  std::vector<double> remaining_min;
+  std::vector<double> remaining_max;
+  /*! \brief Bound of the rounding errors of the sums of raw scores, kept as a margin by the exact early stopping */
+  double stop_tolerance = 0.0;
+  /*! \brief Objective converting the raw scores, nullptr for raw outputs */
+  std::shared_ptr<const ObjectiveFunction> objective_function;
+  /*! \brief Whether the raw scores are averaged over the iterations */
+  bool average_output = false;
+  /*! \brief Features split on by the trees of each class, in increasing order, only set with is_pred_contrib */
+  std::vector<std::vector<int>> contrib_features;
+};
+
 /*!
 * \brief GBDT algorithm implementation. including Training, prediction, bagging.
 */
@@ -69,21 +140,21 @@ class GBDT : public GBDTBase {
   */
   void MergeFrom(const Boosting* other) override {
     auto other_gbdt = reinterpret_cast<const GBDT*>(other);
+    ResetPredictionCache();
     // tmp move to other vector
     auto original_models = std::move(models_);
-    models_ = std::vector<std::unique_ptr<Tree>>();
+    models_ = std::vector<std::shared_ptr<Tree>>();
     // push model from other first
     for (const auto& tree : other_gbdt->models_) {
-      auto new_tree = std::unique_ptr<Tree>(new Tree(*(tree.get())));
+      auto new_tree = std::shared_ptr<Tree>(new Tree(*(tree.get())));
       models_.push_back(std::move(new_tree));
     }
     num_init_iteration_ = static_cast<int>(models_.size()) / num_tree_per_iteration_;
     // push model in current object
     for (const auto& tree : original_models) {
-      auto new_tree = std::unique_ptr<Tree>(new Tree(*(tree.get())));
+      auto new_tree = std::shared_ptr<Tree>(new Tree(*(tree.get())));
       models_.push_back(std::move(new_tree));
     }
-    num_iteration_for_pred_ = static_cast<int>(models_.size()) / num_tree_per_iteration_;
   }
 
   void ShuffleModels(int start_iter, int end_iter) override {
@@ -93,6 +164,7 @@ class GBDT : public GBDTBase {
       end_iter = total_iter;
     }
     end_iter = std::min(total_iter, end_iter);
+    ResetPredictionCache();
     auto original_models = std::move(models_);
     std::vector<int> indices(total_iter);
     for (int i = 0; i < total_iter; ++i) {
@@ -103,11 +175,11 @@ class GBDT : public GBDTBase {
       int j = tmp_rand.NextShort(i + 1, end_iter);
       std::swap(indices[i], indices[j]);
     }
-    models_ = std::vector<std::unique_ptr<Tree>>();
+    models_ = std::vector<std::shared_ptr<Tree>>();
     for (int i = 0; i < total_iter; ++i) {
       for (int j = 0; j < num_tree_per_iteration_; ++j) {
         int tree_idx = indices[i] * num_tree_per_iteration_ + j;
-        auto new_tree = std::unique_ptr<Tree>(new Tree(*(original_models[tree_idx].get())));
+        auto new_tree = std::shared_ptr<Tree>(new Tree(*(original_models[tree_idx].get())));
         models_.push_back(std::move(new_tree));
       }
     }
@@ -145,6 +217,8 @@ class GBDT : public GBDTBase {
 
   void RefitTree(const int* tree_leaf_prediction, const size_t nrow, const size_t ncol) override;
 
+  void RefitTree(size_t nrow, const std::function<void(data_size_t row_idx, double* features)>& get_row_fun) override;
+
   /*!
   * \brief Training logic
   * \param gradients nullptr for using default objective, otherwise use self-defined boosting
@@ -270,6 +344,9 @@ class GBDT : public GBDTBase {
   */
   void GetPredictAt(int data_idx, double* out_result, int64_t* out_len) override;
 
+  void PredictForDataset(const Dataset* data, int start_iteration, int num_iteration,
+                         bool is_raw_score, double* output) const override;
+
   /*!
   * \brief Get number of prediction for one data
   * \param start_iteration Start index of the iteration to predict
@@ -295,26 +372,43 @@ class GBDT : public GBDTBase {
     return num_pred_in_one_row;
   }
 
-  void PredictRaw(const double* features, double* output,
-                  const PredictionEarlyStopInstance* earlyStop) const override;
+  void PredictRaw(const PredictionPlan& plan, const double* features, double* output) const override;
+
+  void PredictRawSparse(const PredictionPlan& plan, const SparseRow& features, double* output) const override;
+
+  void Predict(const PredictionPlan& plan, const double* features, double* output) const override;
+
+  void PredictSparse(const PredictionPlan& plan, const SparseRow& features, double* output) const override;
+
+  void PredictRawBlock(const PredictionPlan& plan, const double* features, int num_rows, double* output) const override;
 
-  void PredictRawByMap(const std::unordered_map<int, double>& features, double* output,
-                       const PredictionEarlyStopInstance* early_stop) const override;
+  void PredictBlock(const PredictionPlan& plan, const double* features, int num_rows, double* output) const override;
 
-  void Predict(const double* features, double* output,
-               const PredictionEarlyStopInstance* earlyStop) const override;
+  void ConvertRawScore(const PredictionPlan& plan, const double* raw_score, double* output) const override;
 
-  void PredictByMap(const std::unordered_map<int, double>& features, double* output,
-                    const PredictionEarlyStopInstance* early_stop) const override;
+  void PredictRawFloat32(const PredictionPlan& plan, const float* features, double* output) const override;
 
-  void PredictLeafIndex(const double* features, double* output) const override;
+  void PredictFloat32(const PredictionPlan& plan, const float* features, double* output) const override;
 
-  void PredictLeafIndexByMap(const std::unordered_map<int, double>& features, double* output) const override;
+  double GetFloat32Deviation(int start_iteration, int num_iteration, int* out_num_inexact_thresholds) const override;
 
-  void PredictContrib(const double* features, double* output) const override;
+  void PredictRawCompact(const PredictionPlan& plan, const double* features, double* output) const override;
 
-  void PredictContribByMap(const std::unordered_map<int, double>& features,
-                           std::vector<std::unordered_map<int, double>>* output) const override;
+  void PredictCompact(const PredictionPlan& plan, const double* features, double* output) const override;
+
+  void PredictLeafIndexCompact(const PredictionPlan& plan, const double* features, double* output) const override;
+
+  void PredictLeafIndex(const PredictionPlan& plan, const double* features, double* output) const override;
+
+  void PredictLeafIndexSparse(const PredictionPlan& plan, const SparseRow& features, double* output) const override;
+
+  void PredictContrib(const PredictionPlan& plan, const double* features, double* output) const override;
+
+  void PredictContribBlock(const PredictionPlan& plan, const double* features, int num_rows,
+                           double* output) const override;
+
+  void PredictContribSparse(const PredictionPlan& plan, const SparseRow& features,
+                            std::vector<std::vector<std::pair<int, double>>>* output) const override;
 
   /*!
   * \brief Dump model to json format string
@@ -367,6 +461,35 @@ class GBDT : public GBDTBase {
   */
   bool LoadModelFromString(const char* buffer, size_t len) override;
 
+  /*!
+  * \brief Save model to a binary file
+  * \param start_iteration The model will be saved start from
+  * \param num_iterations Number of model that want to save, -1 means save all
+  * \param feature_importance_type Type of feature importance, 0: split, 1: gain
+  * \param filename Filename that want to save to
+  * \return true if succeeded
+  */
+  bool SaveModelToBinaryFile(int start_iteration, int num_iterations, int feature_importance_type,
+                             const char* filename) const override;
+
+  /*!
+  * \brief Restore from a binary model, viewing its compiled forest in place when owner is set
+  */
+  bool LoadModelFromBinary(const char* buffer, size_t len, std::shared_ptr<const void> owner) override;
+
+  /*!
+  * \brief Translate model to self-contained C code, with batch entry points over blocks of rows
+  * \param num_iteration Number of iterations that want to translate, -1 means translate all
+  * \param use_float32 Whether to also generate the entry point predicting float32 records
+  * \return C source of the model
+  */
+  std::string ModelToCompiledSource(int num_iteration, bool use_float32) const;
+
+  bool SaveModelToCompiled(int num_iteration, bool use_float32, const std::string& compiler,
+                           const std::string& compiler_flags, const char* filename) const override;
+
+  bool LoadModelFromCompiled(const char* filename) override;
+
   /*!
   * \brief Calculate feature importances
   * \param num_iteration Number of model that want to use for feature importance, -1 means use all
@@ -423,23 +546,17 @@ class GBDT : public GBDTBase {
   */
   inline int NumberOfClasses() const override { return num_class_; }
 
-  inline void InitPredict(int start_iteration, int num_iteration, bool is_pred_contrib) override {
-    num_iteration_for_pred_ = static_cast<int>(models_.size()) / num_tree_per_iteration_;
-    start_iteration = std::max(start_iteration, 0);
-    start_iteration = std::min(start_iteration, num_iteration_for_pred_);
-    if (num_iteration > 0) {
-      num_iteration_for_pred_ = std::min(num_iteration, num_iteration_for_pred_ - start_iteration);
-    } else {
-      num_iteration_for_pred_ = num_iteration_for_pred_ - start_iteration;
-    }
-    start_iteration_for_pred_ = start_iteration;
-    if (is_pred_contrib) {
-      #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
-      for (int i = 0; i < static_cast<int>(models_.size()); ++i) {
-        models_[i]->RecomputeMaxDepth();
-      }
-    }
-  }
+  PredictionPlan* CreatePredictionPlan(int start_iteration, int num_iteration, bool is_pred_contrib,
+                                       bool use_quick_scorer, bool use_float32, bool use_binned,
+                                       bool use_compact_features,
+                                       const PredictionEarlyStopInstance& early_stop) const override;
+
+  /*!
+  * \brief Create a prediction-only booster sharing the trees of some iterations, see LGBM_BoosterCreateView
+  */
+  Boosting* CreateView(int start_iteration, int num_iteration) override;
+
+  void GetMemoryUsage(int64_t* own_bytes, int64_t* shared_bytes) const override;
 
   inline double GetLeafValue(int tree_idx, int leaf_idx) const override {
     CHECK(tree_idx >= 0 && static_cast<size_t>(tree_idx) < models_.size());
@@ -450,6 +567,8 @@ class GBDT : public GBDTBase {
   inline void SetLeafValue(int tree_idx, int leaf_idx, double val) override {
     CHECK(tree_idx >= 0 && static_cast<size_t>(tree_idx) < models_.size());
     CHECK(leaf_idx >= 0 && leaf_idx < models_[tree_idx]->num_leaves());
+    ResetPredictionCache();
+    UnshareTree(tree_idx);
     models_[tree_idx]->SetLeafOutput(leaf_idx, val);
   }
 
@@ -485,6 +604,16 @@ class GBDT : public GBDTBase {
   */
   virtual void Boosting();
 
+  /*!
+  * \brief Refit the trees a block of iterations at a time
+  * \param iterations_per_block Number of iterations of which the leaf indices are computed together
+  * \param max_leaves Maximal number of leaves of the trees, used by linear trees
+  * \param leaf_fun Fills the leaf indices of the training data in the trees model_start, model_start + 1, ...
+  *                 one vector per tree
+  */
+  void RefitTreeByBlocks(int iterations_per_block, int max_leaves,
+                         const std::function<void(int model_start, std::vector<std::vector<int>>* leaf_pred)>& leaf_fun);
+
   /*!
   * \brief updating score after tree was trained
   * \param tree Trained tree of this iteration
@@ -512,6 +641,142 @@ class GBDT : public GBDTBase {
   */
   void ResetGradientBuffers();
 
+  /*!
+  * \brief Start a new prediction cache, must be called before models_ are modified.
+  *        The plans created so far keep the previous cache, with its snapshot of the trees
+  */
+  inline void ResetPredictionCache() {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    cache_.reset();
+  }
+
+  /*!
+  * \brief Prediction cache of the current trees, created on first use, cache_mutex_ must be held
+  */
+  inline GBDTPredictionCache* PredictionCache() const {
+    if (cache_ == nullptr) {
+      cache_.reset(new GBDTPredictionCache());
+      cache_->models = models_;
+    }
+    return cache_.get();
+  }
+
+  /*!
+  * \brief Copy a tree shared with views (see CreateView) or with prediction plans,
+  *        must be called after ResetPredictionCache and before the tree is modified in place
+  */
+  inline void UnshareTree(size_t tree_idx) {
+    if (models_[tree_idx].use_count() > 1) {
+      models_[tree_idx].reset(new Tree(*models_[tree_idx]));
+    }
+  }
+
+  /*!
+  * \brief Range [*start_model, *end_model) of the trees saved for the given iterations
+  */
+  void GetModelRange(int start_iteration, int num_iteration, int* start_model, int* end_model) const;
+
+  /*! \brief Write the model type and the global fields of the model, one key=value per line */
+  void SaveModelHeader(std::stringstream* ss) const;
+
+  /*! \brief Write the feature importances, the parameters and the parser config */
+  void SaveModelTrailer(int num_iteration, int feature_importance_type, std::stringstream* ss) const;
+
+  /*!
+  * \brief Restore the fields written by SaveModelHeader
+  * \param p Start of the header
+  * \param end End of the buffer
+  * \param key_vals Output, all the keys of the header
+  * \return Position after the header, i.e. the first tree of a text model
+  */
+  const char* LoadModelHeader(const char* p, const char* end, std::unordered_map<std::string, std::string>* key_vals);
+
+  /*! \brief Restore the fields written by SaveModelTrailer */
+  void LoadModelTrailer(const char* p, const char* end);
+
+  /*!
+  * \brief Set the contrib_features of plan from its trees
+  */
+  void SetContribFeatures(GBDTPredictionPlan* plan) const;
+
+  /*!
+  * \brief Build the compact forest and features of cache from all its trees
+  */
+  void BuildCompactForest(GBDTPredictionCache* cache) const;
+
+  /*!
+  * \brief Bound the raw scores of the remaining iterations of plan, for the exact early stopping
+  */
+  void SetEarlyStopBounds(GBDTPredictionPlan* plan) const;
+
+  /*!
+  * \brief Whether a prediction stops once the trees of iteration iter (relative to the plan) were added to output
+  */
+  inline bool StopsAfterIteration(const GBDTPredictionPlan& plan, const PredictionEarlyStopInstance& early_stop,
+                                  int iter, const double* output) const {
+    if (!early_stop.is_exact) {
+      return early_stop.callback_function(output, num_tree_per_iteration_);
+    }
+    if (plan.remaining_max.empty()) {
+      return false;
+    }
+    const double* remaining_min = plan.remaining_min.data() + static_cast<size_t>(iter + 1) * num_tree_per_iteration_;
+    const double* remaining_max = plan.remaining_max.data() + static_cast<size_t>(iter + 1) * num_tree_per_iteration_;
+    if (num_tree_per_iteration_ == 1) {
+      return output[0] + remaining_min[0] > early_stop.decision_threshold + plan.stop_tolerance ||
+             output[0] + remaining_max[0] < early_stop.decision_threshold - plan.stop_tolerance;
+    }
+    // the best class must stay ahead of all the others
+    const int best = static_cast<int>(std::max_element(output, output + num_tree_per_iteration_) - output);
+    const double best_lower = output[best] + remaining_min[best] - plan.stop_tolerance;
+    for (int k = 0; k < num_tree_per_iteration_; ++k) {
+      if (k != best && output[k] + remaining_max[k] + plan.stop_tolerance >= best_lower) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /*!
+  * \brief Raw prediction of a block of rows, tree by tree for a period of early_stop at a time, after which
+  *        the stopped rows are removed from the rows still predicted
+  */
+  void PredictRawBlockStoppingEarly(const GBDTPredictionPlan& plan, const double* features, int num_rows,
+                                    double* output) const;
+
+  /*!
+  * \brief Raw prediction with the trees of forest, or with the trees of plan when it is null
+  */
+  void PredictRawWithForest(const GBDTPredictionPlan& plan, const CompiledForest* forest, const double* features,
+                            double* output, const PredictionEarlyStopInstance* early_stop) const;
+
+  /*!
+  * \brief Raw prediction with the quick scorer of plan, trees it cannot score are predicted one by one
+  */
+  void PredictRawQuickScorer(const GBDTPredictionPlan& plan, const double* features, double* output,
+                             const PredictionEarlyStopInstance* early_stop) const;
+
+  /*!
+  * \brief Raw prediction with the binned forest of plan, on the record quantized into codes of type CODE_T
+  */
+  template <typename CODE_T>
+  void PredictRawBinned(const GBDTPredictionPlan& plan, const double* features, double* output,
+                        const PredictionEarlyStopInstance* early_stop) const;
+
+  /*!
+  * \brief Turn the raw score of num_iteration iterations into the prediction of plan
+  */
+  inline void ConvertOutput(const GBDTPredictionPlan& plan, int num_iteration, double* output) const {
+    if (plan.average_output) {
+      for (int k = 0; k < num_tree_per_iteration_; ++k) {
+        output[k] /= num_iteration;
+      }
+    }
+    if (plan.objective_function != nullptr) {
+      plan.objective_function->ConvertOutput(output, output);
+    }
+  }
+
   /*! \brief current iteration */
   int iter_;
   /*! \brief Pointer to training data */
@@ -542,8 +807,8 @@ class GBDT : public GBDTBase {
   std::vector<std::vector<double>> best_score_;
   /*! \brief output message of best iteration */
   std::vector<std::vector<std::string>> best_msg_;
-  /*! \brief Trained models(trees) */
-  std::vector<std::unique_ptr<Tree>> models_;
+  /*! \brief Trained models(trees), read-only while shared with the views created by CreateView */
+  std::vector<std::shared_ptr<Tree>> models_;
   /*! \brief Max feature index of training data*/
   int max_feature_idx_;
   /*! \brief Parser config file content */
@@ -585,10 +850,6 @@ class GBDT : public GBDTBase {
   int num_class_;
   /*! \brief Index of label column */
   data_size_t label_idx_;
-  /*! \brief number of used model */
-  int num_iteration_for_pred_;
-  /*! \brief Start iteration of used model */
-  int start_iteration_for_pred_;
   /*! \brief Shrinkage rate for one iteration */
   double shrinkage_rate_;
   /*! \brief Number of loaded initial models */
@@ -598,7 +859,7 @@ class GBDT : public GBDTBase {
   std::vector<std::string> feature_infos_;
   std::vector<bool> class_need_train_;
   bool is_constant_hessian_;
-  std::unique_ptr<ObjectiveFunction> loaded_objective_;
+  std::shared_ptr<ObjectiveFunction> loaded_objective_;
   bool average_output_;
   bool need_re_bagging_;
   bool balanced_bagging_;
@@ -607,6 +868,10 @@ class GBDT : public GBDTBase {
   Json forced_splits_json_;
   bool linear_tree_;
   std::unique_ptr<SampleStrategy> data_sample_strategy_;
+  /*! \brief Structures predicting the current trees, created on demand and held by the prediction plans */
+  mutable std::shared_ptr<GBDTPredictionCache> cache_;
+  /*! \brief Guards cache_ and the builds of its fields, so that plans can be created concurrently */
+  mutable std::mutex cache_mutex_;
 };
 
 }  // namespace LightGBM
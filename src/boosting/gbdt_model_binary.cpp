@@ -0,0 +1,193 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#include <LightGBM/utils/common.h>
+#include <LightGBM/utils/file_io.h>
+#include <LightGBM/utils/log.h>
+#include <LightGBM/utils/openmp_wrapper.h>
+
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gbdt.h"
+
+namespace LightGBM {
+
+/*
+ * Layout of a binary model, every section is aligned on 8 bytes:
+ *   token | int32 version | uint32 byte order mark
+ *   size_t length | header text (same lines as a text model, up to feature_infos)
+ *   size_t num_trees | size_t size of each tree | binary trees (Tree::SaveBinaryToFile)
+ *   size_t length | compiled forest (CompiledForest::SaveBinaryToFile), empty for linear trees
+ *   size_t length | trailer text (feature importances, parameters and parser config)
+ */
+const char* kModelBinaryToken = "______LightGBM_Binary_Model_Token______\n";
+const int32_t kModelBinaryVersion = 1;
+const uint32_t kModelBinaryByteOrderMark = 0x01020304;
+
+namespace {
+
+/*! \brief Write the length of str, then str */
+size_t WriteSection(BinaryWriter* writer, const std::string& str) {
+  const size_t len = str.size();
+  return writer->AlignedWrite(&len, sizeof(len)) + writer->AlignedWrite(str.data(), len);
+}
+
+/*! \brief Sequential reader of a binary model, checking the bounds of the buffer */
+class BinaryModelReader {
+ public:
+  BinaryModelReader(const char* buffer, size_t len) : p_(buffer), end_(buffer + len) {}
+
+  /*! \brief Skip num_bytes (aligned), return their start */
+  const char* Skip(size_t num_bytes) {
+    // a size close to the maximum wraps around when aligned
+    const size_t aligned = BinaryWriter::AlignedSize(num_bytes);
+    if (static_cast<size_t>(end_ - p_) < aligned || aligned < num_bytes) {
+      Log::Fatal("Model format error, the binary model is truncated");
+    }
+    const char* ret = p_;
+    p_ += aligned;
+    return ret;
+  }
+
+  template <typename T>
+  T Read() {
+    T ret;
+    std::memcpy(&ret, Skip(sizeof(T)), sizeof(T));
+    return ret;
+  }
+
+ private:
+  const char* p_;
+  const char* end_;
+};
+
+}  // namespace
+
+bool GBDT::SaveModelToBinaryFile(int start_iteration, int num_iteration, int feature_importance_type,
+                                 const char* filename) const {
+  auto writer = VirtualFileWriter::Make(filename);
+  if (!writer->Init()) {
+    Log::Fatal("Model file %s is not available for writes", filename);
+  }
+  int start_model = 0;
+  int num_used_model = 0;
+  GetModelRange(start_iteration, num_iteration, &start_model, &num_used_model);
+  const int num_trees = num_used_model - start_model;
+
+  writer->AlignedWrite(kModelBinaryToken, std::strlen(kModelBinaryToken));
+  writer->Write(&kModelBinaryVersion, sizeof(kModelBinaryVersion));
+  writer->Write(&kModelBinaryByteOrderMark, sizeof(kModelBinaryByteOrderMark));
+
+  std::stringstream header;
+  Common::C_stringstream(header);
+  SaveModelHeader(&header);
+  WriteSection(writer.get(), header.str());
+
+  std::vector<size_t> tree_sizes(num_trees + 1);
+  tree_sizes[0] = static_cast<size_t>(num_trees);
+  #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
+  for (int i = 0; i < num_trees; ++i) {
+    tree_sizes[i + 1] = models_[start_model + i]->SizesInByte();
+  }
+  writer->AlignedWrite(tree_sizes.data(), sizeof(size_t) * tree_sizes.size());
+  for (int i = 0; i < num_trees; ++i) {
+    models_[start_model + i]->SaveBinaryToFile(writer.get());
+  }
+
+  if (CompiledForest::CanCompile(models_, start_model, num_trees)) {
+    CompiledForest forest(models_, start_model, num_trees);
+    const size_t forest_size = forest.SizesInByte();
+    writer->AlignedWrite(&forest_size, sizeof(forest_size));
+    forest.SaveBinaryToFile(writer.get());
+  } else {
+    const size_t forest_size = 0;
+    writer->AlignedWrite(&forest_size, sizeof(forest_size));
+  }
+
+  std::stringstream trailer;
+  Common::C_stringstream(trailer);
+  SaveModelTrailer(num_iteration, feature_importance_type, &trailer);
+  return WriteSection(writer.get(), trailer.str()) > 0;
+}
+
+bool GBDT::LoadModelFromBinary(const char* buffer, size_t len, std::shared_ptr<const void> owner) {
+  ResetPredictionCache();
+  models_.clear();
+  if (reinterpret_cast<uintptr_t>(buffer) % 8 != 0) {
+    Log::Fatal("Binary model must be aligned on 8 bytes");
+  }
+  BinaryModelReader reader(buffer, len);
+  const size_t size_of_token = std::strlen(kModelBinaryToken);
+  if (len < size_of_token || std::memcmp(buffer, kModelBinaryToken, size_of_token) != 0) {
+    Log::Fatal("Model format error, not a binary model");
+  }
+  reader.Skip(size_of_token);
+  const char* version = reader.Skip(sizeof(int32_t) + sizeof(uint32_t));
+  int32_t model_version;
+  uint32_t byte_order_mark;
+  std::memcpy(&model_version, version, sizeof(model_version));
+  std::memcpy(&byte_order_mark, version + sizeof(model_version), sizeof(byte_order_mark));
+  if (byte_order_mark != kModelBinaryByteOrderMark) {
+    Log::Fatal("Binary model was saved on a machine with a different byte order");
+  }
+  if (model_version != kModelBinaryVersion) {
+    Log::Fatal("Unsupported binary model version %d, expected %d", model_version, kModelBinaryVersion);
+  }
+
+  const size_t header_len = reader.Read<size_t>();
+  const char* header = reader.Skip(header_len);
+  std::unordered_map<std::string, std::string> key_vals;
+  LoadModelHeader(header, header + header_len, &key_vals);
+
+  const size_t num_trees = reader.Read<size_t>();
+  if (num_trees > len / sizeof(size_t)) {
+    Log::Fatal("Model format error, wrong number of trees");
+  }
+  std::vector<size_t> tree_sizes(num_trees);
+  if (num_trees > 0) {
+    std::memcpy(tree_sizes.data(), reader.Skip(sizeof(size_t) * num_trees), sizeof(size_t) * num_trees);
+  }
+  std::vector<const char*> tree_starts(num_trees);
+  for (size_t i = 0; i < num_trees; ++i) {
+    tree_starts[i] = reader.Skip(tree_sizes[i]);
+    models_.emplace_back(nullptr);
+  }
+  // the trees own copies of their arrays, only the compiled forest below is used in place
+  OMP_INIT_EX();
+  #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
+  for (int i = 0; i < static_cast<int>(num_trees); ++i) {
+    OMP_LOOP_EX_BEGIN();
+    size_t used_len = 0;
+    models_[i].reset(Tree::CreateFromBinary(tree_starts[i], tree_sizes[i], max_feature_idx_ + 1, &used_len));
+    if (used_len != tree_sizes[i]) {
+      Log::Fatal("Model format error, tree %d has a wrong size", i);
+    }
+    OMP_LOOP_EX_END();
+  }
+  OMP_THROW_EX();
+
+  const size_t forest_size = reader.Read<size_t>();
+  const char* forest = reader.Skip(forest_size);
+  if (forest_size > 0 && owner != nullptr) {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    auto& compiled_forest = PredictionCache()->compiled_forest;
+    compiled_forest.reset(CompiledForest::CreateFromBinary(forest, forest_size, max_feature_idx_ + 1,
+                                                           std::move(owner)));
+    if (compiled_forest->num_trees() != static_cast<int>(num_trees)) {
+      Log::Fatal("Model format error, the compiled forest does not match the trees");
+    }
+  }
+
+  num_init_iteration_ = static_cast<int>(models_.size()) / num_tree_per_iteration_;
+  iter_ = 0;
+  const size_t trailer_len = reader.Read<size_t>();
+  const char* trailer = reader.Skip(trailer_len);
+  LoadModelTrailer(trailer, trailer + trailer_len);
+  return true;
+}
+
+}  // namespace LightGBM
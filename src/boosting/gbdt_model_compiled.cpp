@@ -0,0 +1,395 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#include <LightGBM/utils/common.h>
+#include <LightGBM/utils/log.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <ios>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "compiled_forest.h"
+#include "compiled_library.h"
+#include "gbdt.h"
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace LightGBM {
+
+namespace {
+
+/*! \brief Longest string literal written into the generated source */
+const size_t kMaxLiteralLength = 2000;
+
+/*! \brief Exact C literal of value, as a hexadecimal floating constant */
+std::string DoubleLiteral(double value) {
+  if (std::isinf(value)) {
+    return value > 0 ? "HUGE_VAL" : "-HUGE_VAL";
+  }
+  std::stringstream str_buf;
+  Common::C_stringstream(str_buf);
+  str_buf << std::hexfloat << value;
+  return str_buf.str();
+}
+
+std::string FloatLiteral(float value) {
+  if (std::isinf(value)) {
+    return value > 0 ? "HUGE_VALF" : "-HUGE_VALF";
+  }
+  return DoubleLiteral(value) + "f";
+}
+
+/*!
+* \brief Write the subtree rooted at node as nested comparisons against immediate thresholds
+* \param tree The tree
+* \param node Node of the tree, a leaf when negative
+* \param cat_offset Index of the first bitset of the tree in the bitsets of the model
+* \param use_float32 Whether the records are float32, as Float32Forest: thresholds are rounded down,
+*        leaf values rounded to the nearest float
+* \param indent Indentation of the subtree
+*/
+void WriteSubtree(std::stringstream* str_buf, const Tree& tree, int node, int cat_offset, bool use_float32,
+                  const std::string& indent) {
+  if (node < 0) {
+    const double leaf_value = tree.LeafOutput(~node);
+    *str_buf << indent << "return "
+             << (use_float32 ? FloatLiteral(static_cast<float>(leaf_value)) : DoubleLiteral(leaf_value)) << ";\n";
+    return;
+  }
+  const std::string fval = "x[" + std::to_string(tree.split_feature(node)) + "]";
+  const int8_t decision_type = tree.decision_type(node);
+  const bool default_left = Tree::GetDecisionType(decision_type, kDefaultLeftMask);
+  std::string go_right;
+  if (Tree::GetDecisionType(decision_type, kCategoricalMask)) {
+    go_right = "lgbm_categorical_right(" + fval + ", " + std::to_string(cat_offset + static_cast<int>(tree.threshold(node)))
+               + ")";
+  } else {
+    const double threshold = tree.threshold(node);
+    const std::string threshold_literal = use_float32 ? FloatLiteral(Float32Forest::RoundDown(threshold))
+                                                      : DoubleLiteral(threshold);
+    const int8_t missing_type = Tree::GetMissingType(decision_type);
+    // same as Tree::NumericalDecision, NaN fails every comparison
+    if (missing_type == MissingType::Zero) {
+      // NaN is zero, zero goes to the default direction
+      const std::string zero = use_float32 ? FloatLiteral(Float32Forest::RoundDown(kZeroThreshold))
+                                           : DoubleLiteral(kZeroThreshold);
+      const std::string is_zero = "(" + fval + " >= -" + zero + " && " + fval + " <= " + zero + ")";
+      go_right = default_left ? "!" + is_zero + " && " + fval + " > " + threshold_literal
+                              : is_zero + " || " + fval + " != " + fval + " || " + fval + " > " + threshold_literal;
+    } else if (missing_type == MissingType::None ? 0.0 > threshold : !default_left) {
+      // NaN goes right, as the default direction or as 0
+      go_right = "!(" + fval + " <= " + threshold_literal + ")";
+    } else {
+      go_right = fval + " > " + threshold_literal;
+    }
+  }
+  *str_buf << indent << "if (" << go_right << ") {\n";
+  WriteSubtree(str_buf, tree, tree.right_child(node), cat_offset, use_float32, indent + "  ");
+  *str_buf << indent << "} else {\n";
+  WriteSubtree(str_buf, tree, tree.left_child(node), cat_offset, use_float32, indent + "  ");
+  *str_buf << indent << "}\n";
+}
+
+/*! \brief Write the definition of a static array, C does not allow empty ones */
+template <typename T, typename ToLiteral>
+void WriteArray(std::stringstream* str_buf, const char* declaration, const std::vector<T>& values,
+                const ToLiteral& to_literal) {
+  *str_buf << declaration << "[] = {";
+  if (values.empty()) {
+    *str_buf << "0";
+  }
+  for (size_t i = 0; i < values.size(); ++i) {
+    *str_buf << (i % 8 == 0 ? "\n  " : " ") << to_literal(values[i]) << ",";
+  }
+  *str_buf << "\n};\n\n";
+}
+
+/*! \brief Write str as adjacent string literals, one per line of str */
+void WriteStringLiterals(std::stringstream* str_buf, const std::string& str) {
+  size_t literal_length = 0;
+  *str_buf << "  \"";
+  for (size_t i = 0; i < str.size(); ++i) {
+    const unsigned char c = static_cast<unsigned char>(str[i]);
+    if (c == '\\' || c == '"' || c == '?') {
+      // '?' is escaped against trigraphs
+      *str_buf << '\\' << c;
+    } else if (c == '\n') {
+      *str_buf << "\\n";
+    } else if (c < 0x20 || c >= 0x7f) {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\%03o", c);
+      *str_buf << escaped;
+    } else {
+      *str_buf << c;
+    }
+    if ((c == '\n' || ++literal_length >= kMaxLiteralLength) && i + 1 < str.size()) {
+      *str_buf << "\"\n  \"";
+      literal_length = 0;
+    }
+  }
+  *str_buf << "\",\n";
+}
+
+/*! \brief Write the bitsets of the categorical splits and the decision on them */
+void WriteCategorical(std::stringstream* str_buf, const std::vector<int>& cat_boundaries,
+                      const std::vector<uint32_t>& cat_threshold) {
+  WriteArray(str_buf, "static const int32_t lgbm_cat_boundaries", cat_boundaries, [](int value) {
+    return std::to_string(value);
+  });
+  WriteArray(str_buf, "static const uint32_t lgbm_cat_threshold", cat_threshold, [](uint32_t value) {
+    return std::to_string(value) + "u";
+  });
+  *str_buf << "/* whether a value goes right at a categorical split, as Tree::CategoricalDecision */\n"
+           << "static int lgbm_categorical_right(double fval, int32_t cat_idx) {\n"
+           << "  int32_t int_fval, word;\n"
+           << "  if (fval != fval) {\n"
+           << "    return 1;\n"
+           << "  }\n"
+           << "  int_fval = (int32_t)fval;\n"
+           << "  if (int_fval < 0) {\n"
+           << "    return 1;\n"
+           << "  }\n"
+           << "  word = int_fval / 32;\n"
+           << "  if (word >= lgbm_cat_boundaries[cat_idx + 1] - lgbm_cat_boundaries[cat_idx]) {\n"
+           << "    return 1;\n"
+           << "  }\n"
+           << "  return !((lgbm_cat_threshold[lgbm_cat_boundaries[cat_idx] + word] >> (int_fval % 32)) & 1);\n"
+           << "}\n\n";
+}
+
+/*!
+* \brief Write the trees and the batch entry point of one precision
+* \param models Trees to compile
+* \param cat_offsets Index of the first bitset of each tree in the bitsets of the model
+* \param use_float32 Whether the entry point is the one of float32 records
+*/
+void WriteTrees(std::stringstream* str_buf, const std::vector<const Tree*>& models, const std::vector<int>& cat_offsets,
+                bool use_float32) {
+  const std::string suffix = use_float32 ? "_float32" : "";
+  const std::string value_type = use_float32 ? "float" : "double";
+  const std::string tree_function = "lgbm_tree" + suffix + "_";
+  for (size_t i = 0; i < models.size(); ++i) {
+    *str_buf << "static " << value_type << " " << tree_function << i << "(const " << value_type << "* x) {\n";
+    if (models[i]->num_leaves() > 1) {
+      WriteSubtree(str_buf, *models[i], 0, cat_offsets[i], use_float32, "  ");
+    } else {
+      WriteSubtree(str_buf, *models[i], ~0, cat_offsets[i], use_float32, "  ");
+    }
+    *str_buf << "}\n\n";
+  }
+  *str_buf << "static " << value_type << " (*const lgbm_trees" << suffix << "[])(const " << value_type << "*) = {";
+  for (size_t i = 0; i < models.size(); ++i) {
+    *str_buf << (i % 8 == 0 ? "\n  " : " ") << tree_function << i << ",";
+  }
+  if (models.empty()) {
+    *str_buf << "0";
+  }
+  *str_buf << "\n};\n\n";
+
+  *str_buf << "LGBM_EXPORT void lgbm_compiled_predict_raw" << suffix << "(const " << value_type
+           << "* rows, int64_t num_rows, int64_t row_stride,\n"
+           << "    int start_iteration, int num_iteration, double* output) {\n"
+           << "  const int start_tree = start_iteration * LGBM_NUM_TREE_PER_ITERATION;\n"
+           << "  const int end_tree = (start_iteration + num_iteration) * LGBM_NUM_TREE_PER_ITERATION;\n"
+           << "  int64_t block_start;\n"
+           << "  memset(output, 0, sizeof(double) * (size_t)num_rows * LGBM_NUM_TREE_PER_ITERATION);\n"
+           << "  for (block_start = 0; block_start < num_rows; block_start += LGBM_BLOCK_SIZE) {\n"
+           << "    const int64_t block_end = num_rows - block_start < LGBM_BLOCK_SIZE ? num_rows"
+           << " : block_start + LGBM_BLOCK_SIZE;\n"
+           << "    int tree;\n"
+           << "    /* trees in the outer loop, each row sums its trees in the same order as GBDT::PredictRaw */\n"
+           << "    for (tree = start_tree; tree < end_tree; ++tree) {\n"
+           << "      " << value_type << " (*const predict_tree)(const " << value_type << "*) = lgbm_trees" << suffix
+           << "[tree];\n"
+           << "      double* out = output + tree % LGBM_NUM_TREE_PER_ITERATION;\n"
+           << "      int64_t row;\n"
+           << "      for (row = block_start; row < block_end; ++row) {\n"
+           << "        out[row * LGBM_NUM_TREE_PER_ITERATION] += predict_tree(rows + row * row_stride);\n"
+           << "      }\n"
+           << "    }\n"
+           << "  }\n"
+           << "}\n\n";
+}
+
+#ifdef _WIN32
+/*! \brief Quote arg so that the C runtime of the spawned program parses it back unchanged */
+std::string QuoteArgument(const std::string& arg) {
+  if (!arg.empty() && arg.find_first_of(" \t\n\v\"") == std::string::npos) {
+    return arg;
+  }
+  std::string quoted = "\"";
+  size_t num_backslashes = 0;
+  for (char c : arg) {
+    if (c == '\\') {
+      ++num_backslashes;
+      continue;
+    }
+    // backslashes are literal unless they precede a quote
+    quoted.append(c == '"' ? 2 * num_backslashes + 1 : num_backslashes, '\\');
+    num_backslashes = 0;
+    quoted.push_back(c);
+  }
+  quoted.append(2 * num_backslashes, '\\');
+  quoted.push_back('"');
+  return quoted;
+}
+#endif
+
+/*!
+* \brief Run a program and wait for it, without going through a shell
+* \param args Name of the program, searched in the PATH, followed by its arguments
+* \return Exit code of the program, -1 when it could not be run
+*/
+int RunProcess(const std::vector<std::string>& args) {
+#ifdef _WIN32
+  std::vector<std::string> quoted_args;
+  for (const auto& arg : args) {
+    quoted_args.push_back(QuoteArgument(arg));
+  }
+  std::vector<const char*> argv;
+  for (const auto& arg : quoted_args) {
+    argv.push_back(arg.c_str());
+  }
+  argv.push_back(nullptr);
+  return static_cast<int>(_spawnvp(_P_WAIT, args[0].c_str(), argv.data()));
+#else
+  std::vector<char*> argv;
+  for (const auto& arg : args) {
+    argv.push_back(const_cast<char*>(arg.c_str()));
+  }
+  argv.push_back(nullptr);
+  const pid_t pid = fork();
+  if (pid < 0) {
+    return -1;
+  }
+  if (pid == 0) {
+    execvp(argv[0], argv.data());
+    _exit(127);
+  }
+  int status;
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) {
+      return -1;
+    }
+  }
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+}
+
+}  // namespace
+
+std::string GBDT::ModelToCompiledSource(int num_iteration, bool use_float32) const {
+  int num_used_model = static_cast<int>(models_.size());
+  if (num_iteration > 0) {
+    num_used_model = std::min(num_iteration * num_tree_per_iteration_, num_used_model);
+  }
+  if (!CompiledForest::CanCompile(models_, 0, num_used_model)) {
+    Log::Fatal("Cannot compile a model with linear trees");
+  }
+  std::vector<const Tree*> models;
+  std::vector<int> cat_offsets;
+  std::vector<int> cat_boundaries(1, 0);
+  std::vector<uint32_t> cat_threshold;
+  for (int i = 0; i < num_used_model; ++i) {
+    const Tree& tree = *models_[i];
+    models.push_back(&tree);
+    cat_offsets.push_back(static_cast<int>(cat_boundaries.size()) - 1);
+    for (int j = 0; j < tree.num_cat(); ++j) {
+      const auto bitset = tree.cat_threshold(j);
+      cat_threshold.insert(cat_threshold.end(), bitset.begin(), bitset.end());
+      cat_boundaries.push_back(static_cast<int>(cat_threshold.size()));
+    }
+  }
+
+  std::stringstream str_buf;
+  Common::C_stringstream(str_buf);
+  str_buf << "/* LightGBM model compiled by task=compile, loaded by LGBM_BoosterLoadCompiled */\n"
+          << "#include <math.h>\n"
+          << "#include <stdint.h>\n"
+          << "#include <string.h>\n\n"
+          << "#ifdef _WIN32\n"
+          << "#define LGBM_EXPORT __declspec(dllexport)\n"
+          << "#else\n"
+          << "#define LGBM_EXPORT __attribute__((visibility(\"default\")))\n"
+          << "#endif\n\n"
+          << "#define LGBM_NUM_TREES " << num_used_model << "\n"
+          << "#define LGBM_NUM_TREE_PER_ITERATION " << num_tree_per_iteration_ << "\n"
+          << "#define LGBM_NUM_FEATURES " << max_feature_idx_ + 1 << "\n"
+          << "/* rows scored by one tree before the next one */\n"
+          << "#define LGBM_BLOCK_SIZE 64\n\n";
+
+  if (cat_boundaries.size() > 1) {
+    WriteCategorical(&str_buf, cat_boundaries, cat_threshold);
+  }
+  WriteTrees(&str_buf, models, cat_offsets, false);
+  if (use_float32) {
+    WriteTrees(&str_buf, models, cat_offsets, true);
+  }
+
+  str_buf << "static const char* const lgbm_model_string_chunks[] = {\n";
+  WriteStringLiterals(&str_buf, SaveModelToString(0, num_iteration, 0));
+  str_buf << "  0\n"
+          << "};\n\n"
+          << "LGBM_EXPORT int lgbm_compiled_abi_version(void) { return " << CompiledLibrary::kAbiVersion << "; }\n"
+          << "LGBM_EXPORT int lgbm_compiled_num_trees(void) { return LGBM_NUM_TREES; }\n"
+          << "LGBM_EXPORT int lgbm_compiled_num_tree_per_iteration(void) { return LGBM_NUM_TREE_PER_ITERATION; }\n"
+          << "LGBM_EXPORT int lgbm_compiled_num_features(void) { return LGBM_NUM_FEATURES; }\n"
+          << "LGBM_EXPORT const char* const* lgbm_compiled_model_string(void) { return lgbm_model_string_chunks; }\n";
+  return str_buf.str();
+}
+
+bool GBDT::SaveModelToCompiled(int num_iteration, bool use_float32, const std::string& compiler,
+                               const std::string& compiler_flags, const char* filename) const {
+  const std::string source_filename = std::string(filename) + ".c";
+  std::ofstream source_file(source_filename);
+  source_file << ModelToCompiledSource(num_iteration, use_float32);
+  source_file.close();
+  if (!source_file) {
+    return false;
+  }
+  // no shell runs the compiler, so file names need no escaping and the flags are only split at whitespace
+  std::vector<std::string> args = {compiler};
+  for (const auto& flag : Common::Split(compiler_flags.c_str(), " \t\r\n")) {
+    args.push_back(flag);
+  }
+  for (const std::string& arg : {std::string("-shared"), std::string("-fPIC"), std::string("-o"),
+                                 std::string(filename), source_filename}) {
+    args.push_back(arg);
+  }
+  const std::string command = Common::Join(args, " ");
+  Log::Info("Compiling model: %s", command.c_str());
+  if (RunProcess(args) != 0) {
+    Log::Fatal("Failed to compile model, command: %s", command.c_str());
+  }
+  return true;
+}
+
+bool GBDT::LoadModelFromCompiled(const char* filename) {
+  std::shared_ptr<const CompiledLibrary> library(CompiledLibrary::Open(filename));
+  const std::string model_str = library->ModelString();
+  if (!LoadModelFromString(model_str.c_str(), model_str.size())) {
+    return false;
+  }
+  if (library->num_trees() != static_cast<int>(models_.size())
+      || library->num_tree_per_iteration() != num_tree_per_iteration_
+      || library->num_features() != max_feature_idx_ + 1) {
+    Log::Fatal("Compiled model %s does not match the model it embeds", filename);
+  }
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  PredictionCache()->compiled_library = library;
+  return true;
+}
+
+}  // namespace LightGBM
@@ -162,30 +162,30 @@ std::string GBDT::ModelToIfElse(int num_iteration) const {
 
   pred_str_buf << "\t" << "int early_stop_round_counter = 0;" << '\n';
   pred_str_buf << "\t" << "std::memset(output, 0, sizeof(double) * num_tree_per_iteration_);" << '\n';
-  pred_str_buf << "\t" << "for (int i = 0; i < num_iteration_for_pred_; ++i) {" << '\n';
+  pred_str_buf << "\t" << "for (int i = plan.start_iteration; i < plan.start_iteration + plan.num_iteration; ++i) {" << '\n';
   pred_str_buf << "\t\t" << "for (int k = 0; k < num_tree_per_iteration_; ++k) {" << '\n';
   pred_str_buf << "\t\t\t" << "output[k] += (*PredictTreePtr[i * num_tree_per_iteration_ + k])(features);" << '\n';
   pred_str_buf << "\t\t" << "}" << '\n';
   pred_str_buf << "\t\t" << "++early_stop_round_counter;" << '\n';
-  pred_str_buf << "\t\t" << "if (early_stop->round_period == early_stop_round_counter) {" << '\n';
-  pred_str_buf << "\t\t\t" << "if (early_stop->callback_function(output, num_tree_per_iteration_))" << '\n';
+  pred_str_buf << "\t\t" << "if (plan.early_stop.round_period == early_stop_round_counter) {" << '\n';
+  pred_str_buf << "\t\t\t" << "if (plan.early_stop.callback_function(output, num_tree_per_iteration_))" << '\n';
   pred_str_buf << "\t\t\t\t" << "return;" << '\n';
   pred_str_buf << "\t\t\t" << "early_stop_round_counter = 0;" << '\n';
   pred_str_buf << "\t\t" << "}" << '\n';
   pred_str_buf << "\t" << "}" << '\n';
 
-  str_buf << "void GBDT::PredictRaw(const double* features, double *output, const PredictionEarlyStopInstance* early_stop) const {" << '\n';
+  str_buf << "void GBDT::PredictRaw(const PredictionPlan& plan, const double* features, double *output) const {" << '\n';
   str_buf << pred_str_buf.str();
   str_buf << "}" << '\n';
   str_buf << '\n';
 
-  // PredictRawByMap
-  str_buf << "double (*PredictTreeByMapPtr[])(const std::unordered_map<int, double>&) = { ";
+  // PredictRawSparse
+  str_buf << "double (*PredictTreeSparsePtr[])(const SparseRow&) = { ";
   for (int i = 0; i < num_used_model; ++i) {
     if (i > 0) {
       str_buf << " , ";
     }
-    str_buf << "PredictTree" << i << "ByMap";
+    str_buf << "PredictTree" << i << "Sparse";
   }
   str_buf << " };" << '\n' << '\n';
 
@@ -194,48 +194,34 @@ std::string GBDT::ModelToIfElse(int num_iteration) const {
 
   pred_str_buf_map << "\t" << "int early_stop_round_counter = 0;" << '\n';
   pred_str_buf_map << "\t" << "std::memset(output, 0, sizeof(double) * num_tree_per_iteration_);" << '\n';
-  pred_str_buf_map << "\t" << "for (int i = 0; i < num_iteration_for_pred_; ++i) {" << '\n';
+  pred_str_buf_map << "\t" << "for (int i = plan.start_iteration; i < plan.start_iteration + plan.num_iteration; ++i) {" << '\n';
   pred_str_buf_map << "\t\t" << "for (int k = 0; k < num_tree_per_iteration_; ++k) {" << '\n';
-  pred_str_buf_map << "\t\t\t" << "output[k] += (*PredictTreeByMapPtr[i * num_tree_per_iteration_ + k])(features);" << '\n';
+  pred_str_buf_map << "\t\t\t" << "output[k] += (*PredictTreeSparsePtr[i * num_tree_per_iteration_ + k])(features);" << '\n';
   pred_str_buf_map << "\t\t" << "}" << '\n';
   pred_str_buf_map << "\t\t" << "++early_stop_round_counter;" << '\n';
-  pred_str_buf_map << "\t\t" << "if (early_stop->round_period == early_stop_round_counter) {" << '\n';
-  pred_str_buf_map << "\t\t\t" << "if (early_stop->callback_function(output, num_tree_per_iteration_))" << '\n';
+  pred_str_buf_map << "\t\t" << "if (plan.early_stop.round_period == early_stop_round_counter) {" << '\n';
+  pred_str_buf_map << "\t\t\t" << "if (plan.early_stop.callback_function(output, num_tree_per_iteration_))" << '\n';
   pred_str_buf_map << "\t\t\t\t" << "return;" << '\n';
   pred_str_buf_map << "\t\t\t" << "early_stop_round_counter = 0;" << '\n';
   pred_str_buf_map << "\t\t" << "}" << '\n';
   pred_str_buf_map << "\t" << "}" << '\n';
 
-  str_buf << "void GBDT::PredictRawByMap(const std::unordered_map<int, double>& features, double* output, const PredictionEarlyStopInstance* early_stop) const {" << '\n';
+  str_buf << "void GBDT::PredictRawSparse(const PredictionPlan& plan, const SparseRow& features, double* output) const {" << '\n';
   str_buf << pred_str_buf_map.str();
   str_buf << "}" << '\n';
   str_buf << '\n';
 
   // Predict
-  str_buf << "void GBDT::Predict(const double* features, double *output, const PredictionEarlyStopInstance* early_stop) const {" << '\n';
-  str_buf << "\t" << "PredictRaw(features, output, early_stop);" << '\n';
-  str_buf << "\t" << "if (average_output_) {" << '\n';
-  str_buf << "\t\t" << "for (int k = 0; k < num_tree_per_iteration_; ++k) {" << '\n';
-  str_buf << "\t\t\t" << "output[k] /= num_iteration_for_pred_;" << '\n';
-  str_buf << "\t\t" << "}" << '\n';
-  str_buf << "\t" << "}" << '\n';
-  str_buf << "\t" << "if (objective_function_ != nullptr) {" << '\n';
-  str_buf << "\t\t" << "objective_function_->ConvertOutput(output, output);" << '\n';
-  str_buf << "\t" << "}" << '\n';
+  str_buf << "void GBDT::Predict(const PredictionPlan& plan, const double* features, double *output) const {" << '\n';
+  str_buf << "\t" << "PredictRaw(plan, features, output);" << '\n';
+  str_buf << "\t" << "ConvertOutput(static_cast<const GBDTPredictionPlan&>(plan), plan.num_iteration, output);" << '\n';
   str_buf << "}" << '\n';
   str_buf << '\n';
 
-  // PredictByMap
-  str_buf << "void GBDT::PredictByMap(const std::unordered_map<int, double>& features, double* output, const PredictionEarlyStopInstance* early_stop) const {" << '\n';
-  str_buf << "\t" << "PredictRawByMap(features, output, early_stop);" << '\n';
-  str_buf << "\t" << "if (average_output_) {" << '\n';
-  str_buf << "\t\t" << "for (int k = 0; k < num_tree_per_iteration_; ++k) {" << '\n';
-  str_buf << "\t\t\t" << "output[k] /= num_iteration_for_pred_;" << '\n';
-  str_buf << "\t\t" << "}" << '\n';
-  str_buf << "\t" << "}" << '\n';
-  str_buf << "\t" << "if (objective_function_ != nullptr) {" << '\n';
-  str_buf << "\t\t" << "objective_function_->ConvertOutput(output, output);" << '\n';
-  str_buf << "\t" << "}" << '\n';
+  // PredictSparse
+  str_buf << "void GBDT::PredictSparse(const PredictionPlan& plan, const SparseRow& features, double* output) const {" << '\n';
+  str_buf << "\t" << "PredictRawSparse(plan, features, output);" << '\n';
+  str_buf << "\t" << "ConvertOutput(static_cast<const GBDTPredictionPlan&>(plan), plan.num_iteration, output);" << '\n';
   str_buf << "}" << '\n';
   str_buf << '\n';
 
@@ -254,27 +240,29 @@ std::string GBDT::ModelToIfElse(int num_iteration) const {
   }
   str_buf << " };" << '\n' << '\n';
 
-  str_buf << "void GBDT::PredictLeafIndex(const double* features, double *output) const {" << '\n';
-  str_buf << "\t" << "int total_tree = num_iteration_for_pred_ * num_tree_per_iteration_;" << '\n';
+  str_buf << "void GBDT::PredictLeafIndex(const PredictionPlan& plan, const double* features, double *output) const {" << '\n';
+  str_buf << "\t" << "int start_tree = plan.start_iteration * num_tree_per_iteration_;" << '\n';
+  str_buf << "\t" << "int total_tree = plan.num_iteration * num_tree_per_iteration_;" << '\n';
   str_buf << "\t" << "for (int i = 0; i < total_tree; ++i) {" << '\n';
-  str_buf << "\t\t" << "output[i] = (*PredictTreeLeafPtr[i])(features);" << '\n';
+  str_buf << "\t\t" << "output[i] = (*PredictTreeLeafPtr[start_tree + i])(features);" << '\n';
   str_buf << "\t" << "}" << '\n';
   str_buf << "}" << '\n';
 
-  // PredictLeafIndexByMap
-  str_buf << "double (*PredictTreeLeafByMapPtr[])(const std::unordered_map<int, double>&) = { ";
+  // PredictLeafIndexSparse
+  str_buf << "double (*PredictTreeLeafSparsePtr[])(const SparseRow&) = { ";
   for (int i = 0; i < num_used_model; ++i) {
     if (i > 0) {
       str_buf << " , ";
     }
-    str_buf << "PredictTree" << i << "LeafByMap";
+    str_buf << "PredictTree" << i << "LeafSparse";
   }
   str_buf << " };" << '\n' << '\n';
 
-  str_buf << "void GBDT::PredictLeafIndexByMap(const std::unordered_map<int, double>& features, double* output) const {" << '\n';
-  str_buf << "\t" << "int total_tree = num_iteration_for_pred_ * num_tree_per_iteration_;" << '\n';
+  str_buf << "void GBDT::PredictLeafIndexSparse(const PredictionPlan& plan, const SparseRow& features, double* output) const {" << '\n';
+  str_buf << "\t" << "int start_tree = plan.start_iteration * num_tree_per_iteration_;" << '\n';
+  str_buf << "\t" << "int total_tree = plan.num_iteration * num_tree_per_iteration_;" << '\n';
   str_buf << "\t" << "for (int i = 0; i < total_tree; ++i) {" << '\n';
-  str_buf << "\t\t" << "output[i] = (*PredictTreeLeafByMapPtr[i])(features);" << '\n';
+  str_buf << "\t\t" << "output[i] = (*PredictTreeLeafSparsePtr[start_tree + i])(features);" << '\n';
   str_buf << "\t" << "}" << '\n';
   str_buf << "}" << '\n';
 
@@ -308,38 +296,74 @@ bool GBDT::SaveModelToIfElse(int num_iteration, const char* filename) const {
   return static_cast<bool>(output_file);
 }
 
-std::string GBDT::SaveModelToString(int start_iteration, int num_iteration, int feature_importance_type) const {
-  std::stringstream ss;
-  Common::C_stringstream(ss);
-
+void GBDT::SaveModelHeader(std::stringstream* ss) const {
   // output model type
-  ss << SubModelName() << '\n';
-  ss << "version=" << kModelVersion << '\n';
+  *ss << SubModelName() << '\n';
+  *ss << "version=" << kModelVersion << '\n';
   // output number of class
-  ss << "num_class=" << num_class_ << '\n';
-  ss << "num_tree_per_iteration=" << num_tree_per_iteration_ << '\n';
+  *ss << "num_class=" << num_class_ << '\n';
+  *ss << "num_tree_per_iteration=" << num_tree_per_iteration_ << '\n';
   // output label index
-  ss << "label_index=" << label_idx_ << '\n';
+  *ss << "label_index=" << label_idx_ << '\n';
   // output max_feature_idx
-  ss << "max_feature_idx=" << max_feature_idx_ << '\n';
+  *ss << "max_feature_idx=" << max_feature_idx_ << '\n';
   // output objective
   if (objective_function_ != nullptr) {
-    ss << "objective=" << objective_function_->ToString() << '\n';
+    *ss << "objective=" << objective_function_->ToString() << '\n';
   }
 
   if (average_output_) {
-    ss << "average_output" << '\n';
+    *ss << "average_output" << '\n';
   }
 
-  ss << "feature_names=" << CommonC::Join(feature_names_, " ") << '\n';
+  *ss << "feature_names=" << CommonC::Join(feature_names_, " ") << '\n';
 
   if (monotone_constraints_.size() != 0) {
-    ss << "monotone_constraints=" << CommonC::Join(monotone_constraints_, " ")
-       << '\n';
+    *ss << "monotone_constraints=" << CommonC::Join(monotone_constraints_, " ")
+        << '\n';
   }
 
-  ss << "feature_infos=" << CommonC::Join(feature_infos_, " ") << '\n';
+  *ss << "feature_infos=" << CommonC::Join(feature_infos_, " ") << '\n';
+}
 
+void GBDT::SaveModelTrailer(int num_iteration, int feature_importance_type, std::stringstream* ss) const {
+  std::vector<double> feature_importances = FeatureImportance(
+      num_iteration, feature_importance_type);
+  // store the importance first
+  std::vector<std::pair<size_t, std::string>> pairs;
+  for (size_t i = 0; i < feature_importances.size(); ++i) {
+    size_t feature_importances_int = static_cast<size_t>(feature_importances[i]);
+    if (feature_importances_int > 0) {
+      pairs.emplace_back(feature_importances_int, feature_names_[i]);
+    }
+  }
+  // sort the importance
+  std::stable_sort(pairs.begin(), pairs.end(),
+                   [](const std::pair<size_t, std::string>& lhs,
+                      const std::pair<size_t, std::string>& rhs) {
+    return lhs.first > rhs.first;
+  });
+  *ss << '\n' << "feature_importances:" << '\n';
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    *ss << pairs[i].second << "=" << std::to_string(pairs[i].first) << '\n';
+  }
+  if (config_ != nullptr) {
+    *ss << "\nparameters:" << '\n';
+    *ss << config_->ToString() << "\n";
+    *ss << "end of parameters" << '\n';
+  } else if (!loaded_parameter_.empty()) {
+    *ss << "\nparameters:" << '\n';
+    *ss << loaded_parameter_ << "\n";
+    *ss << "end of parameters" << '\n';
+  }
+  if (!parser_config_str_.empty()) {
+    *ss << "\nparser:" << '\n';
+    *ss << parser_config_str_ << "\n";
+    *ss << "end of parser" << '\n';
+  }
+}
+
+void GBDT::GetModelRange(int start_iteration, int num_iteration, int* start_model, int* end_model) const {
   int num_used_model = static_cast<int>(models_.size());
   int total_iteration = num_used_model / num_tree_per_iteration_;
   start_iteration = std::max(start_iteration, 0);
@@ -348,8 +372,19 @@ std::string GBDT::SaveModelToString(int start_iteration, int num_iteration, int
     int end_iteration = start_iteration + num_iteration;
     num_used_model = std::min(end_iteration * num_tree_per_iteration_, num_used_model);
   }
+  *start_model = start_iteration * num_tree_per_iteration_;
+  *end_model = num_used_model;
+}
 
-  int start_model = start_iteration * num_tree_per_iteration_;
+std::string GBDT::SaveModelToString(int start_iteration, int num_iteration, int feature_importance_type) const {
+  std::stringstream ss;
+  Common::C_stringstream(ss);
+
+  SaveModelHeader(&ss);
+
+  int start_model = 0;
+  int num_used_model = 0;
+  GetModelRange(start_iteration, num_iteration, &start_model, &num_used_model);
 
   std::vector<std::string> tree_strs(num_used_model - start_model);
   std::vector<size_t> tree_sizes(num_used_model - start_model);
@@ -370,40 +405,7 @@ std::string GBDT::SaveModelToString(int start_iteration, int num_iteration, int
     tree_strs[i].clear();
   }
   ss << "end of trees" << "\n";
-  std::vector<double> feature_importances = FeatureImportance(
-      num_iteration, feature_importance_type);
-  // store the importance first
-  std::vector<std::pair<size_t, std::string>> pairs;
-  for (size_t i = 0; i < feature_importances.size(); ++i) {
-    size_t feature_importances_int = static_cast<size_t>(feature_importances[i]);
-    if (feature_importances_int > 0) {
-      pairs.emplace_back(feature_importances_int, feature_names_[i]);
-    }
-  }
-  // sort the importance
-  std::stable_sort(pairs.begin(), pairs.end(),
-                   [](const std::pair<size_t, std::string>& lhs,
-                      const std::pair<size_t, std::string>& rhs) {
-    return lhs.first > rhs.first;
-  });
-  ss << '\n' << "feature_importances:" << '\n';
-  for (size_t i = 0; i < pairs.size(); ++i) {
-    ss << pairs[i].second << "=" << std::to_string(pairs[i].first) << '\n';
-  }
-  if (config_ != nullptr) {
-    ss << "\nparameters:" << '\n';
-    ss << config_->ToString() << "\n";
-    ss << "end of parameters" << '\n';
-  } else if (!loaded_parameter_.empty()) {
-    ss << "\nparameters:" << '\n';
-    ss << loaded_parameter_ << "\n";
-    ss << "end of parameters" << '\n';
-  }
-  if (!parser_config_str_.empty()) {
-    ss << "\nparser:" << '\n';
-    ss << parser_config_str_ << "\n";
-    ss << "end of parser" << '\n';
-  }
+  SaveModelTrailer(num_iteration, feature_importance_type, &ss);
   return ss.str();
 }
 
@@ -418,13 +420,8 @@ bool GBDT::SaveModelToFile(int start_iteration, int num_iteration, int feature_i
   return size > 0;
 }
 
-bool GBDT::LoadModelFromString(const char* buffer, size_t len) {
-  // use serialized string to restore this object
-  models_.clear();
-  auto c_str = buffer;
-  auto p = c_str;
-  auto end = p + len;
-  std::unordered_map<std::string, std::string> key_vals;
+const char* GBDT::LoadModelHeader(const char* p, const char* end,
+                                  std::unordered_map<std::string, std::string>* key_vals) {
   while (p < end) {
     auto line_len = Common::GetLine(p);
     if (line_len > 0) {
@@ -432,14 +429,14 @@ bool GBDT::LoadModelFromString(const char* buffer, size_t len) {
       if (!Common::StartsWith(cur_line, "Tree=")) {
         auto strs = Common::Split(cur_line.c_str(), '=');
         if (strs.size() == 1) {
-          key_vals[strs[0]] = "";
+          (*key_vals)[strs[0]] = "";
         } else if (strs.size() == 2) {
-          key_vals[strs[0]] = strs[1];
+          (*key_vals)[strs[0]] = strs[1];
         } else if (strs.size() > 2) {
           if (strs[0] == "feature_names") {
-            key_vals[strs[0]] = cur_line.substr(std::strlen("feature_names="));
+            (*key_vals)[strs[0]] = cur_line.substr(std::strlen("feature_names="));
           } else if (strs[0] == "monotone_constraints") {
-            key_vals[strs[0]] = cur_line.substr(std::strlen("monotone_constraints="));
+            (*key_vals)[strs[0]] = cur_line.substr(std::strlen("monotone_constraints="));
           } else {
             // Use first 128 chars to avoid exceed the message buffer.
             Log::Fatal("Wrong line at model file: %s", cur_line.substr(0, std::min<size_t>(128, cur_line.size())).c_str());
@@ -454,125 +451,74 @@ bool GBDT::LoadModelFromString(const char* buffer, size_t len) {
   }
 
   // get number of classes
-  if (key_vals.count("num_class")) {
-    Common::Atoi(key_vals["num_class"].c_str(), &num_class_);
+  if (key_vals->count("num_class")) {
+    Common::Atoi((*key_vals)["num_class"].c_str(), &num_class_);
   } else {
     Log::Fatal("Model file doesn't specify the number of classes");
-    return false;
   }
 
-  if (key_vals.count("num_tree_per_iteration")) {
-    Common::Atoi(key_vals["num_tree_per_iteration"].c_str(), &num_tree_per_iteration_);
+  if (key_vals->count("num_tree_per_iteration")) {
+    Common::Atoi((*key_vals)["num_tree_per_iteration"].c_str(), &num_tree_per_iteration_);
   } else {
     num_tree_per_iteration_ = num_class_;
   }
 
   // get index of label
-  if (key_vals.count("label_index")) {
-    Common::Atoi(key_vals["label_index"].c_str(), &label_idx_);
+  if (key_vals->count("label_index")) {
+    Common::Atoi((*key_vals)["label_index"].c_str(), &label_idx_);
   } else {
     Log::Fatal("Model file doesn't specify the label index");
-    return false;
   }
 
   // get max_feature_idx first
-  if (key_vals.count("max_feature_idx")) {
-    Common::Atoi(key_vals["max_feature_idx"].c_str(), &max_feature_idx_);
+  if (key_vals->count("max_feature_idx")) {
+    Common::Atoi((*key_vals)["max_feature_idx"].c_str(), &max_feature_idx_);
   } else {
     Log::Fatal("Model file doesn't specify max_feature_idx");
-    return false;
   }
 
   // get average_output
-  if (key_vals.count("average_output")) {
+  if (key_vals->count("average_output")) {
     average_output_ = true;
   }
 
   // get feature names
-  if (key_vals.count("feature_names")) {
-    feature_names_ = Common::Split(key_vals["feature_names"].c_str(), ' ');
+  if (key_vals->count("feature_names")) {
+    feature_names_ = Common::Split((*key_vals)["feature_names"].c_str(), ' ');
     if (feature_names_.size() != static_cast<size_t>(max_feature_idx_ + 1)) {
       Log::Fatal("Wrong size of feature_names");
-      return false;
     }
   } else {
     Log::Fatal("Model file doesn't contain feature_names");
-    return false;
   }
 
   // get monotone_constraints
-  if (key_vals.count("monotone_constraints")) {
-    monotone_constraints_ = CommonC::StringToArray<int8_t>(key_vals["monotone_constraints"].c_str(), ' ');
+  if (key_vals->count("monotone_constraints")) {
+    monotone_constraints_ = CommonC::StringToArray<int8_t>((*key_vals)["monotone_constraints"].c_str(), ' ');
     if (monotone_constraints_.size() != static_cast<size_t>(max_feature_idx_ + 1)) {
       Log::Fatal("Wrong size of monotone_constraints");
-      return false;
     }
   }
 
-  if (key_vals.count("feature_infos")) {
-    feature_infos_ = Common::Split(key_vals["feature_infos"].c_str(), ' ');
+  if (key_vals->count("feature_infos")) {
+    feature_infos_ = Common::Split((*key_vals)["feature_infos"].c_str(), ' ');
     if (feature_infos_.size() != static_cast<size_t>(max_feature_idx_ + 1)) {
       Log::Fatal("Wrong size of feature_infos");
-      return false;
     }
   } else {
     Log::Fatal("Model file doesn't contain feature_infos");
-    return false;
   }
 
-  if (key_vals.count("objective")) {
-    auto str = key_vals["objective"];
+  if (key_vals->count("objective")) {
+    auto str = (*key_vals)["objective"];
     loaded_objective_.reset(ObjectiveFunction::CreateObjectiveFunction(ParseObjectiveAlias(str)));
     objective_function_ = loaded_objective_.get();
   }
 
-  if (!key_vals.count("tree_sizes")) {
-    while (p < end) {
-      auto line_len = Common::GetLine(p);
-      if (line_len > 0) {
-        std::string cur_line(p, line_len);
-        if (Common::StartsWith(cur_line, "Tree=")) {
-          p += line_len;
-          p = Common::SkipNewLine(p);
-          size_t used_len = 0;
-          models_.emplace_back(new Tree(p, &used_len));
-          p += used_len;
-        } else {
-          break;
-        }
-      }
-      p = Common::SkipNewLine(p);
-    }
-  } else {
-    std::vector<size_t> tree_sizes = CommonC::StringToArray<size_t>(key_vals["tree_sizes"].c_str(), ' ');
-    std::vector<size_t> tree_boundries(tree_sizes.size() + 1, 0);
-    int num_trees = static_cast<int>(tree_sizes.size());
-    for (int i = 0; i < num_trees; ++i) {
-      tree_boundries[i + 1] = tree_boundries[i] + tree_sizes[i];
-      models_.emplace_back(nullptr);
-    }
-    OMP_INIT_EX();
-    #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
-    for (int i = 0; i < num_trees; ++i) {
-      OMP_LOOP_EX_BEGIN();
-      auto cur_p = p + tree_boundries[i];
-      auto line_len = Common::GetLine(cur_p);
-      std::string cur_line(cur_p, line_len);
-      if (Common::StartsWith(cur_line, "Tree=")) {
-        cur_p += line_len;
-        cur_p = Common::SkipNewLine(cur_p);
-        size_t used_len = 0;
-        models_[i].reset(new Tree(cur_p, &used_len));
-      } else {
-        Log::Fatal("Model format error, expect a tree here. met %s", cur_line.c_str());
-      }
-      OMP_LOOP_EX_END();
-    }
-    OMP_THROW_EX();
-  }
-  num_iteration_for_pred_ = static_cast<int>(models_.size()) / num_tree_per_iteration_;
-  num_init_iteration_ = num_iteration_for_pred_;
-  iter_ = 0;
+  return p;
+}
+
+void GBDT::LoadModelTrailer(const char* p, const char* end) {
   bool is_inparameter = false, is_inparser = false;
   std::stringstream ss;
   Common::C_stringstream(ss);
@@ -621,6 +567,64 @@ bool GBDT::LoadModelFromString(const char* buffer, size_t len) {
   parser_config_str_ = ss.str();
   ss.clear();
   ss.str("");
+}
+
+bool GBDT::LoadModelFromString(const char* buffer, size_t len) {
+  // use serialized string to restore this object
+  ResetPredictionCache();
+  models_.clear();
+  auto p = buffer;
+  auto end = p + len;
+  std::unordered_map<std::string, std::string> key_vals;
+  p = LoadModelHeader(p, end, &key_vals);
+
+  if (!key_vals.count("tree_sizes")) {
+    while (p < end) {
+      auto line_len = Common::GetLine(p);
+      if (line_len > 0) {
+        std::string cur_line(p, line_len);
+        if (Common::StartsWith(cur_line, "Tree=")) {
+          p += line_len;
+          p = Common::SkipNewLine(p);
+          size_t used_len = 0;
+          models_.emplace_back(new Tree(p, &used_len));
+          p += used_len;
+        } else {
+          break;
+        }
+      }
+      p = Common::SkipNewLine(p);
+    }
+  } else {
+    std::vector<size_t> tree_sizes = CommonC::StringToArray<size_t>(key_vals["tree_sizes"].c_str(), ' ');
+    std::vector<size_t> tree_boundries(tree_sizes.size() + 1, 0);
+    int num_trees = static_cast<int>(tree_sizes.size());
+    for (int i = 0; i < num_trees; ++i) {
+      tree_boundries[i + 1] = tree_boundries[i] + tree_sizes[i];
+      models_.emplace_back(nullptr);
+    }
+    OMP_INIT_EX();
+    #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
+    for (int i = 0; i < num_trees; ++i) {
+      OMP_LOOP_EX_BEGIN();
+      auto cur_p = p + tree_boundries[i];
+      auto line_len = Common::GetLine(cur_p);
+      std::string cur_line(cur_p, line_len);
+      if (Common::StartsWith(cur_line, "Tree=")) {
+        cur_p += line_len;
+        cur_p = Common::SkipNewLine(cur_p);
+        size_t used_len = 0;
+        models_[i].reset(new Tree(cur_p, &used_len));
+      } else {
+        Log::Fatal("Model format error, expect a tree here. met %s", cur_line.c_str());
+      }
+      OMP_LOOP_EX_END();
+    }
+    OMP_THROW_EX();
+  }
+  num_init_iteration_ = static_cast<int>(models_.size()) / num_tree_per_iteration_;
+  iter_ = 0;
+  LoadModelTrailer(p, end);
   return true;
 }
 
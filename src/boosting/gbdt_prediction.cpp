@@ -6,24 +6,190 @@
 #include <LightGBM/prediction_early_stop.h>
 #include <LightGBM/utils/openmp_wrapper.h>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include "gbdt.h"
 
 namespace LightGBM {
 
-void GBDT::PredictRaw(const double* features, double* output, const PredictionEarlyStopInstance* early_stop) const {
+PredictionPlan* GBDT::CreatePredictionPlan(int start_iteration, int num_iteration, bool is_pred_contrib,
+                                           bool use_quick_scorer, bool use_float32, bool use_binned,
+                                           bool use_compact_features,
+                                           const PredictionEarlyStopInstance& early_stop) const {
+  std::unique_ptr<GBDTPredictionPlan> plan(new GBDTPredictionPlan());
+  const int total_iteration = static_cast<int>(models_.size()) / num_tree_per_iteration_;
+  start_iteration = std::max(start_iteration, 0);
+  start_iteration = std::min(start_iteration, total_iteration);
+  if (num_iteration > 0) {
+    num_iteration = std::min(num_iteration, total_iteration - start_iteration);
+  } else {
+    num_iteration = total_iteration - start_iteration;
+  }
+  plan->start_iteration = start_iteration;
+  plan->num_iteration = num_iteration;
+  plan->early_stop = early_stop;
+  // a check after the last iteration does not change the output
+  plan->can_stop_early = early_stop.round_period < num_iteration;
+  plan->average_output = average_output_;
+  if (objective_function_ != nullptr) {
+    // the training objective belongs to the caller of Init, the plan gets its own copy
+    if (objective_function_ == loaded_objective_.get()) {
+      plan->objective_function = loaded_objective_;
+    } else {
+      plan->objective_function.reset(ObjectiveFunction::CreateObjectiveFunction(objective_function_->ToString()));
+    }
+  }
+  plan->start_tree = start_iteration * num_tree_per_iteration_;
+  const int num_trees = num_iteration * num_tree_per_iteration_;
+
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  GBDTPredictionCache* cache = PredictionCache();
+  plan->cache = cache_;
+  const auto& models = cache->models;
+  const int num_models = static_cast<int>(models.size());
+  plan->trees.resize(num_trees);
+  for (int i = 0; i < num_trees; ++i) {
+    plan->trees[i] = models[plan->start_tree + i].get();
+  }
+  if (early_stop.is_exact && plan->can_stop_early) {
+    SetEarlyStopBounds(plan.get());
+  }
+  if (is_pred_contrib) {
+    // the depth is only written here, under cache_mutex_, before any plan explains the tree
+    #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
+    for (int i = plan->start_tree; i < plan->start_tree + num_trees; ++i) {
+      if (models[i]->max_depth() < 0) {
+        models[i]->RecomputeMaxDepth();
+      }
+    }
+    SetContribFeatures(plan.get());
+  }
+  // oblivious trees find their leaves from the level splits faster than by walking the compiled nodes,
+  // their forest is only compiled for its single precision copy
+  const bool all_oblivious = std::all_of(plan->trees.begin(), plan->trees.end(),
+                                         [] (const Tree* tree) { return tree->is_oblivious(); });
+  if ((!all_oblivious || use_float32) && cache->compiled_forest == nullptr &&
+      CompiledForest::CanCompile(models, 0, num_models)) {
+    cache->compiled_forest.reset(new CompiledForest(models, 0, num_models));
+  }
+  if (!all_oblivious) {
+    plan->forest = cache->compiled_forest.get();
+  }
+  if (use_float32) {
+    if (cache->float32_forest == nullptr) {
+      CHECK(cache->compiled_forest != nullptr);
+      cache->float32_forest.reset(new Float32Forest(*cache->compiled_forest));
+    }
+    plan->float32_forest = cache->float32_forest.get();
+  }
+  if (use_compact_features) {
+    if (cache->compact_forest == nullptr) {
+      CHECK(CompiledForest::CanCompile(models, 0, num_models));
+      BuildCompactForest(cache);
+    }
+    plan->compact_forest = cache->compact_forest.get();
+    plan->compact_features = cache->compact_features;
+  }
+  // a compiled model scores any range of its iterations, but does not explain them
+  if (cache->compiled_library != nullptr && !is_pred_contrib) {
+    plan->compiled_library = cache->compiled_library.get();
+  } else if (use_binned && !is_pred_contrib && BinnedForest::CanBin(models, num_models)) {
+    if (cache->binned_forest == nullptr) {
+      cache->binned_forest.reset(new BinnedForest(models, num_models, max_feature_idx_ + 1));
+      Log::Debug("Binned prediction with %s codes", cache->binned_forest->IsUInt8() ? "uint8" : "uint16");
+    }
+    plan->binned_forest = cache->binned_forest.get();
+  } else if (use_quick_scorer && !is_pred_contrib) {
+    const QuickScorer* scorer = nullptr;
+    for (const auto& cached : cache->quick_scorers) {
+      if (cached->start_tree() == plan->start_tree && cached->num_trees() == num_trees) {
+        scorer = cached.get();
+      }
+    }
+    if (scorer == nullptr) {
+      cache->quick_scorers.emplace_back(new QuickScorer(models, plan->start_tree, num_trees));
+      scorer = cache->quick_scorers.back().get();
+    }
+    plan->quick_scorer = scorer;
+  }
+  return plan.release();
+}
+
+void GBDT::SetEarlyStopBounds(GBDTPredictionPlan* plan) const {
+  const int num_trees = static_cast<int>(plan->trees.size());
+  for (const Tree* tree : plan->trees) {
+    if (tree->is_linear()) {
+      Log::Warning("Exact early stopping is not supported for linear trees, predicting all the iterations");
+      return;
+    }
+  }
+  plan->remaining_min.assign(static_cast<size_t>(num_trees + num_tree_per_iteration_), 0.0);
+  plan->remaining_max.assign(static_cast<size_t>(num_trees + num_tree_per_iteration_), 0.0);
+  double sum_abs = 0.0;
+  for (int tree_idx = num_trees - 1; tree_idx >= 0; --tree_idx) {
+    const Tree* tree = plan->trees[tree_idx];
+    double min_value = tree->LeafOutput(0);
+    double max_value = tree->LeafOutput(0);
+    for (int leaf = 1; leaf < tree->num_leaves(); ++leaf) {
+      min_value = std::min(min_value, tree->LeafOutput(leaf));
+      max_value = std::max(max_value, tree->LeafOutput(leaf));
+    }
+    plan->remaining_min[tree_idx] = plan->remaining_min[tree_idx + num_tree_per_iteration_] + min_value;
+    plan->remaining_max[tree_idx] = plan->remaining_max[tree_idx + num_tree_per_iteration_] + max_value;
+    sum_abs += std::max(std::fabs(min_value), std::fabs(max_value));
+  }
+  // each of the num_trees additions of a raw score, or of a bound, is rounded by at most epsilon of a partial sum
+  plan->stop_tolerance = (num_trees + 1) * std::numeric_limits<double>::epsilon() * (sum_abs + 1.0);
+}
+
+void GBDT::PredictRaw(const PredictionPlan& plan, const double* features, double* output) const {
+  const auto& gbdt_plan = static_cast<const GBDTPredictionPlan&>(plan);
+  if (gbdt_plan.compiled_library != nullptr && !gbdt_plan.can_stop_early) {
+    gbdt_plan.compiled_library->PredictRaw(features, 1, max_feature_idx_ + 1, plan.start_iteration, plan.num_iteration,
+                                           output);
+    return;
+  }
+  if (gbdt_plan.binned_forest != nullptr) {
+    if (gbdt_plan.binned_forest->IsUInt8()) {
+      PredictRawBinned<uint8_t>(gbdt_plan, features, output, &plan.early_stop);
+    } else {
+      PredictRawBinned<uint16_t>(gbdt_plan, features, output, &plan.early_stop);
+    }
+    return;
+  }
+  if (gbdt_plan.quick_scorer != nullptr) {
+    PredictRawQuickScorer(gbdt_plan, features, output, &plan.early_stop);
+    return;
+  }
+  PredictRawWithForest(gbdt_plan, gbdt_plan.forest, features, output, &plan.early_stop);
+}
+
+void GBDT::PredictRawCompact(const PredictionPlan& plan, const double* features, double* output) const {
+  const auto& gbdt_plan = static_cast<const GBDTPredictionPlan&>(plan);
+  PredictRawWithForest(gbdt_plan, gbdt_plan.compact_forest, features, output, &plan.early_stop);
+}
+
+void GBDT::PredictRawWithForest(const GBDTPredictionPlan& plan, const CompiledForest* forest, const double* features,
+                                double* output, const PredictionEarlyStopInstance* early_stop) const {
   int early_stop_round_counter = 0;
   // set zero
   std::memset(output, 0, sizeof(double) * num_tree_per_iteration_);
-  const int end_iteration_for_pred = start_iteration_for_pred_ + num_iteration_for_pred_;
-  for (int i = start_iteration_for_pred_; i < end_iteration_for_pred; ++i) {
+  for (int i = 0; i < plan.num_iteration; ++i) {
     // predict all the trees for one iteration
     for (int k = 0; k < num_tree_per_iteration_; ++k) {
-      output[k] += models_[i * num_tree_per_iteration_ + k]->Predict(features);
+      const int tree_idx = i * num_tree_per_iteration_ + k;
+      output[k] += forest != nullptr ? forest->Predict(plan.start_tree + tree_idx, features)
+                                     : plan.trees[tree_idx]->Predict(features);
     }
     // check early stopping
     ++early_stop_round_counter;
-    if (early_stop->round_period == early_stop_round_counter) {
-      if (early_stop->callback_function(output, num_tree_per_iteration_)) {
+    if (early_stop != nullptr && early_stop->round_period == early_stop_round_counter) {
+      if (StopsAfterIteration(plan, *early_stop, i, output)) {
         return;
       }
       early_stop_round_counter = 0;
@@ -31,20 +197,31 @@ void GBDT::PredictRaw(const double* features, double* output, const PredictionEa
   }
 }
 
-void GBDT::PredictRawByMap(const std::unordered_map<int, double>& features, double* output, const PredictionEarlyStopInstance* early_stop) const {
+void GBDT::PredictRawQuickScorer(const GBDTPredictionPlan& plan, const double* features, double* output,
+                                 const PredictionEarlyStopInstance* early_stop) const {
+  const QuickScorer* scorer = plan.quick_scorer;
+  static THREAD_LOCAL std::vector<double> tree_output;
+  tree_output.resize(scorer->num_trees());
+  scorer->Predict(features, tree_output.data());
   int early_stop_round_counter = 0;
   // set zero
   std::memset(output, 0, sizeof(double) * num_tree_per_iteration_);
-  const int end_iteration_for_pred = start_iteration_for_pred_ + num_iteration_for_pred_;
-  for (int i = start_iteration_for_pred_; i < end_iteration_for_pred; ++i) {
-    // predict all the trees for one iteration
+  const CompiledForest* forest = plan.forest;
+  for (int i = 0; i < plan.num_iteration; ++i) {
+    // sum up in the same order as PredictRaw
     for (int k = 0; k < num_tree_per_iteration_; ++k) {
-      output[k] += models_[i * num_tree_per_iteration_ + k]->PredictByMap(features);
+      const int tree_idx = i * num_tree_per_iteration_ + k;
+      if (scorer->IsScored(tree_idx)) {
+        output[k] += tree_output[tree_idx];
+      } else {
+        output[k] += forest != nullptr ? forest->Predict(plan.start_tree + tree_idx, features)
+                                       : plan.trees[tree_idx]->Predict(features);
+      }
     }
     // check early stopping
     ++early_stop_round_counter;
-    if (early_stop->round_period == early_stop_round_counter) {
-      if (early_stop->callback_function(output, num_tree_per_iteration_)) {
+    if (early_stop != nullptr && early_stop->round_period == early_stop_round_counter) {
+      if (StopsAfterIteration(plan, *early_stop, i, output)) {
         return;
       }
       early_stop_round_counter = 0;
@@ -52,45 +229,328 @@ void GBDT::PredictRawByMap(const std::unordered_map<int, double>& features, doub
   }
 }
 
-void GBDT::Predict(const double* features, double* output, const PredictionEarlyStopInstance* early_stop) const {
-  PredictRaw(features, output, early_stop);
-  if (average_output_) {
+template <typename CODE_T>
+void GBDT::PredictRawBinned(const GBDTPredictionPlan& plan, const double* features, double* output,
+                            const PredictionEarlyStopInstance* early_stop) const {
+  const BinnedForest* forest = plan.binned_forest;
+  static THREAD_LOCAL std::vector<CODE_T> codes;
+  codes.resize(static_cast<size_t>(max_feature_idx_) + 1);
+  forest->Quantize(features, codes.data());
+  int early_stop_round_counter = 0;
+  // set zero
+  std::memset(output, 0, sizeof(double) * num_tree_per_iteration_);
+  for (int i = 0; i < plan.num_iteration; ++i) {
+    // sum up in the same order as PredictRaw
     for (int k = 0; k < num_tree_per_iteration_; ++k) {
-      output[k] /= num_iteration_for_pred_;
+      output[k] += forest->Predict(plan.start_tree + i * num_tree_per_iteration_ + k, codes.data());
+    }
+    // check early stopping
+    ++early_stop_round_counter;
+    if (early_stop != nullptr && early_stop->round_period == early_stop_round_counter) {
+      if (StopsAfterIteration(plan, *early_stop, i, output)) {
+        return;
+      }
+      early_stop_round_counter = 0;
     }
   }
-  if (objective_function_ != nullptr) {
-    objective_function_->ConvertOutput(output, output);
+}
+
+void GBDT::PredictRawSparse(const PredictionPlan& plan, const SparseRow& features, double* output) const {
+  const auto& gbdt_plan = static_cast<const GBDTPredictionPlan&>(plan);
+  int early_stop_round_counter = 0;
+  // set zero
+  std::memset(output, 0, sizeof(double) * num_tree_per_iteration_);
+  for (int i = 0; i < plan.num_iteration; ++i) {
+    // predict all the trees for one iteration
+    for (int k = 0; k < num_tree_per_iteration_; ++k) {
+      output[k] += gbdt_plan.trees[i * num_tree_per_iteration_ + k]->PredictSparse(features);
+    }
+    // check early stopping
+    ++early_stop_round_counter;
+    if (plan.early_stop.round_period == early_stop_round_counter) {
+      if (StopsAfterIteration(gbdt_plan, plan.early_stop, i, output)) {
+        return;
+      }
+      early_stop_round_counter = 0;
+    }
   }
 }
 
-void GBDT::PredictByMap(const std::unordered_map<int, double>& features, double* output, const PredictionEarlyStopInstance* early_stop) const {
-  PredictRawByMap(features, output, early_stop);
-  if (average_output_) {
+void GBDT::Predict(const PredictionPlan& plan, const double* features, double* output) const {
+  PredictRaw(plan, features, output);
+  ConvertOutput(static_cast<const GBDTPredictionPlan&>(plan), plan.num_iteration, output);
+}
+
+void GBDT::PredictCompact(const PredictionPlan& plan, const double* features, double* output) const {
+  PredictRawCompact(plan, features, output);
+  ConvertOutput(static_cast<const GBDTPredictionPlan&>(plan), plan.num_iteration, output);
+}
+
+void GBDT::PredictSparse(const PredictionPlan& plan, const SparseRow& features, double* output) const {
+  PredictRawSparse(plan, features, output);
+  ConvertOutput(static_cast<const GBDTPredictionPlan&>(plan), plan.num_iteration, output);
+}
+
+void GBDT::PredictRawBlock(const PredictionPlan& plan, const double* features, int num_rows, double* output) const {
+  const auto& gbdt_plan = static_cast<const GBDTPredictionPlan&>(plan);
+  const size_t num_features = static_cast<size_t>(max_feature_idx_) + 1;
+  if (gbdt_plan.compiled_library != nullptr && !gbdt_plan.can_stop_early) {
+    gbdt_plan.compiled_library->PredictRaw(features, num_rows, num_features, plan.start_iteration, plan.num_iteration,
+                                           output);
+    return;
+  }
+  const PredictionEarlyStopInstance* early_stop = gbdt_plan.can_stop_early ? &plan.early_stop : nullptr;
+  // set zero
+  std::memset(output, 0, sizeof(double) * num_tree_per_iteration_ * num_rows);
+  if (gbdt_plan.binned_forest != nullptr) {
+    for (int row = 0; row < num_rows; ++row) {
+      if (gbdt_plan.binned_forest->IsUInt8()) {
+        PredictRawBinned<uint8_t>(gbdt_plan, features + row * num_features, output + row * num_tree_per_iteration_,
+                                  early_stop);
+      } else {
+        PredictRawBinned<uint16_t>(gbdt_plan, features + row * num_features, output + row * num_tree_per_iteration_,
+                                   early_stop);
+      }
+    }
+    return;
+  }
+  if (gbdt_plan.quick_scorer != nullptr) {
+    for (int row = 0; row < num_rows; ++row) {
+      PredictRawQuickScorer(gbdt_plan, features + row * num_features, output + row * num_tree_per_iteration_,
+                            early_stop);
+    }
+    return;
+  }
+  if (early_stop != nullptr) {
+    PredictRawBlockStoppingEarly(gbdt_plan, features, num_rows, output);
+    return;
+  }
+  const CompiledForest* forest = gbdt_plan.forest;
+  const int num_trees = plan.num_iteration * num_tree_per_iteration_;
+  // trees in the outer loop, so that the sum of each row is accumulated in the same order as in PredictRaw
+  for (int tree_idx = 0; tree_idx < num_trees; ++tree_idx) {
+    double* out_ptr = output + tree_idx % num_tree_per_iteration_;
+    if (forest != nullptr) {
+      for (int row = 0; row < num_rows; ++row) {
+        out_ptr[row * num_tree_per_iteration_] += forest->Predict(gbdt_plan.start_tree + tree_idx,
+                                                                  features + row * num_features);
+      }
+    } else {
+      const Tree* tree = gbdt_plan.trees[tree_idx];
+      for (int row = 0; row < num_rows; ++row) {
+        out_ptr[row * num_tree_per_iteration_] += tree->Predict(features + row * num_features);
+      }
+    }
+  }
+}
+
+void GBDT::PredictRawBlockStoppingEarly(const GBDTPredictionPlan& plan, const double* features, int num_rows,
+                                        double* output) const {
+  const size_t num_features = static_cast<size_t>(max_feature_idx_) + 1;
+  const CompiledForest* forest = plan.forest;
+  static THREAD_LOCAL std::vector<int> active_rows;
+  active_rows.resize(num_rows);
+  for (int row = 0; row < num_rows; ++row) {
+    active_rows[row] = row;
+  }
+  int num_active_rows = num_rows;
+  const int period = plan.early_stop.round_period;
+  for (int start_iter = 0; start_iter < plan.num_iteration && num_active_rows > 0; start_iter += period) {
+    const int end_iter = std::min(plan.num_iteration, start_iter + period);
+    // each row is summed up in the same order as in PredictRaw
+    for (int tree_idx = start_iter * num_tree_per_iteration_; tree_idx < end_iter * num_tree_per_iteration_; ++tree_idx) {
+      double* out_ptr = output + tree_idx % num_tree_per_iteration_;
+      for (int i = 0; i < num_active_rows; ++i) {
+        const int row = active_rows[i];
+        out_ptr[row * num_tree_per_iteration_] += forest != nullptr
+            ? forest->Predict(plan.start_tree + tree_idx, features + row * num_features)
+            : plan.trees[tree_idx]->Predict(features + row * num_features);
+      }
+    }
+    // a check after the last iteration does not change the output
+    if (end_iter - start_iter < period) {
+      break;
+    }
+    // compact the rows which go on, in order
+    int num_kept_rows = 0;
+    for (int i = 0; i < num_active_rows; ++i) {
+      const int row = active_rows[i];
+      if (!StopsAfterIteration(plan, plan.early_stop, end_iter - 1, output + row * num_tree_per_iteration_)) {
+        active_rows[num_kept_rows++] = row;
+      }
+    }
+    num_active_rows = num_kept_rows;
+  }
+}
+
+void GBDT::PredictBlock(const PredictionPlan& plan, const double* features, int num_rows, double* output) const {
+  PredictRawBlock(plan, features, num_rows, output);
+  for (int row = 0; row < num_rows; ++row) {
+    ConvertOutput(static_cast<const GBDTPredictionPlan&>(plan), plan.num_iteration,
+                  output + row * num_tree_per_iteration_);
+  }
+}
+
+void GBDT::ConvertRawScore(const PredictionPlan& plan, const double* raw_score, double* output) const {
+  if (output != raw_score) {
+    std::memcpy(output, raw_score, sizeof(double) * num_tree_per_iteration_);
+  }
+  // the raw score covers every iteration before the end of the predicted range
+  ConvertOutput(static_cast<const GBDTPredictionPlan&>(plan), plan.start_iteration + plan.num_iteration, output);
+}
+
+void GBDT::PredictRawFloat32(const PredictionPlan& plan, const float* features, double* output) const {
+  const auto& gbdt_plan = static_cast<const GBDTPredictionPlan&>(plan);
+  if (gbdt_plan.compiled_library != nullptr && gbdt_plan.compiled_library->HasFloat32() && !gbdt_plan.can_stop_early) {
+    gbdt_plan.compiled_library->PredictRawFloat32(features, 1, max_feature_idx_ + 1, plan.start_iteration,
+                                                  plan.num_iteration, output);
+    return;
+  }
+  int early_stop_round_counter = 0;
+  // set zero
+  std::memset(output, 0, sizeof(double) * num_tree_per_iteration_);
+  const Float32Forest* forest = gbdt_plan.float32_forest;
+  for (int i = 0; i < plan.num_iteration; ++i) {
+    // predict all the trees for one iteration, summing up in double as PredictRaw
     for (int k = 0; k < num_tree_per_iteration_; ++k) {
-      output[k] /= num_iteration_for_pred_;
+      output[k] += forest->Predict(gbdt_plan.start_tree + i * num_tree_per_iteration_ + k, features);
+    }
+    // check early stopping
+    ++early_stop_round_counter;
+    if (plan.early_stop.round_period == early_stop_round_counter) {
+      if (StopsAfterIteration(gbdt_plan, plan.early_stop, i, output)) {
+        return;
+      }
+      early_stop_round_counter = 0;
     }
   }
-  if (objective_function_ != nullptr) {
-    objective_function_->ConvertOutput(output, output);
+}
+
+void GBDT::PredictFloat32(const PredictionPlan& plan, const float* features, double* output) const {
+  PredictRawFloat32(plan, features, output);
+  ConvertOutput(static_cast<const GBDTPredictionPlan&>(plan), plan.num_iteration, output);
+}
+
+double GBDT::GetFloat32Deviation(int start_iteration, int num_iteration, int* out_num_inexact_thresholds) const {
+  int start_model = 0;
+  int end_model = 0;
+  GetModelRange(start_iteration, num_iteration, &start_model, &end_model);
+  int num_inexact_thresholds = 0;
+  std::vector<double> deviation(num_tree_per_iteration_, 0.0);
+  for (int i = start_model; i < end_model; ++i) {
+    const Tree& tree = *models_[i];
+    for (int node = 0; node < tree.num_leaves() - 1; ++node) {
+      if (!Tree::GetDecisionType(tree.decision_type(node), kCategoricalMask)
+          && static_cast<double>(Float32Forest::RoundDown(tree.threshold(node))) != tree.threshold(node)) {
+        ++num_inexact_thresholds;
+      }
+    }
+    double max_leaf_deviation = 0.0;
+    for (int leaf = 0; leaf < tree.num_leaves(); ++leaf) {
+      const double value = tree.LeafOutput(leaf);
+      max_leaf_deviation = std::max(max_leaf_deviation, std::fabs(static_cast<double>(static_cast<float>(value)) - value));
+    }
+    // each record falls into exactly one leaf of each tree
+    deviation[i % num_tree_per_iteration_] += max_leaf_deviation;
   }
+  *out_num_inexact_thresholds = num_inexact_thresholds;
+  return *std::max_element(deviation.begin(), deviation.end());
 }
 
-void GBDT::PredictLeafIndex(const double* features, double* output) const {
-  int start_tree = start_iteration_for_pred_ * num_tree_per_iteration_;
-  int num_trees = num_iteration_for_pred_ * num_tree_per_iteration_;
-  const auto* models_ptr = models_.data() + start_tree;
+void GBDT::PredictLeafIndex(const PredictionPlan& plan, const double* features, double* output) const {
+  const auto& gbdt_plan = static_cast<const GBDTPredictionPlan&>(plan);
+  const int num_trees = plan.num_iteration * num_tree_per_iteration_;
+  const CompiledForest* forest = gbdt_plan.forest;
+  if (forest != nullptr) {
+    for (int i = 0; i < num_trees; ++i) {
+      output[i] = forest->PredictLeafIndex(gbdt_plan.start_tree + i, features);
+    }
+    return;
+  }
   for (int i = 0; i < num_trees; ++i) {
-    output[i] = models_ptr[i]->PredictLeafIndex(features);
+    output[i] = gbdt_plan.trees[i]->PredictLeafIndex(features);
   }
 }
 
-void GBDT::PredictLeafIndexByMap(const std::unordered_map<int, double>& features, double* output) const {
-  int start_tree = start_iteration_for_pred_ * num_tree_per_iteration_;
-  int num_trees = num_iteration_for_pred_ * num_tree_per_iteration_;
-  const auto* models_ptr = models_.data() + start_tree;
+void GBDT::PredictLeafIndexCompact(const PredictionPlan& plan, const double* features, double* output) const {
+  const auto& gbdt_plan = static_cast<const GBDTPredictionPlan&>(plan);
+  const int num_trees = plan.num_iteration * num_tree_per_iteration_;
+  const CompiledForest* forest = gbdt_plan.compact_forest;
   for (int i = 0; i < num_trees; ++i) {
-    output[i] = models_ptr[i]->PredictLeafIndexByMap(features);
+    output[i] = forest->PredictLeafIndex(gbdt_plan.start_tree + i, features);
+  }
+}
+
+void GBDT::BuildCompactForest(GBDTPredictionCache* cache) const {
+  const auto& models = cache->models;
+  const int num_models = static_cast<int>(models.size());
+  std::vector<int> feature_map(max_feature_idx_ + 1, -1);
+  for (int i = 0; i < num_models; ++i) {
+    for (int node = 0; node < models[i]->num_leaves() - 1; ++node) {
+      feature_map[models[i]->split_feature(node)] = 0;
+    }
+  }
+  cache->compact_features.clear();
+  for (int feature = 0; feature <= max_feature_idx_; ++feature) {
+    if (feature_map[feature] >= 0) {
+      feature_map[feature] = static_cast<int>(cache->compact_features.size());
+      cache->compact_features.push_back(feature);
+    }
+  }
+  cache->compact_forest.reset(new CompiledForest(models, 0, num_models));
+  cache->compact_forest->RemapFeatures(feature_map);
+  Log::Debug("Compact prediction on %d of %d features", static_cast<int>(cache->compact_features.size()),
+             max_feature_idx_ + 1);
+}
+
+void GBDT::PredictLeafIndexSparse(const PredictionPlan& plan, const SparseRow& features, double* output) const {
+  const auto& gbdt_plan = static_cast<const GBDTPredictionPlan&>(plan);
+  const int num_trees = plan.num_iteration * num_tree_per_iteration_;
+  for (int i = 0; i < num_trees; ++i) {
+    output[i] = gbdt_plan.trees[i]->PredictLeafIndexSparse(features);
+  }
+}
+
+void GBDT::PredictForDataset(const Dataset* data, int start_iteration, int num_iteration,
+                             bool is_raw_score, double* output) const {
+  if (data->num_total_features() != max_feature_idx_ + 1) {
+    Log::Fatal("The number of features in the Dataset (%d) is not the same as it was in the model (%d)",
+               data->num_total_features(), max_feature_idx_ + 1);
+  }
+  int start_model = 0;
+  int end_model = 0;
+  GetModelRange(start_iteration, num_iteration, &start_model, &end_model);
+  const int num_trees = end_model - start_model;
+  // the bins of the model are the ones of its training data, map copies of the trees onto the bins of data
+  std::vector<std::unique_ptr<Tree>> trees(num_trees);
+  for (int i = 0; i < num_trees; ++i) {
+    trees[i].reset(new Tree(*models_[start_model + i]));
+    trees[i]->BindToDataset(data);
+  }
+  // scores of each class are contiguous, as in ScoreUpdater
+  const data_size_t num_data = data->num_data();
+  std::vector<double> score(static_cast<size_t>(num_data) * num_tree_per_iteration_, 0.0);
+  for (int i = 0; i < num_trees; ++i) {
+    const int k = (start_model + i) % num_tree_per_iteration_;
+    trees[i]->AddPredictionToScore(data, num_data, score.data() + static_cast<size_t>(num_data) * k);
+  }
+  const int num_used_iteration = num_trees / num_tree_per_iteration_;
+  #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
+  for (data_size_t i = 0; i < num_data; ++i) {
+    double* row = output + static_cast<size_t>(num_tree_per_iteration_) * i;
+    for (int k = 0; k < num_tree_per_iteration_; ++k) {
+      row[k] = score[static_cast<size_t>(num_data) * k + i];
+    }
+    if (!is_raw_score) {
+      if (average_output_) {
+        for (int k = 0; k < num_tree_per_iteration_; ++k) {
+          row[k] /= num_used_iteration;
+        }
+      }
+      if (objective_function_ != nullptr) {
+        objective_function_->ConvertOutput(row, row);
+      }
+    }
   }
 }
 
@@ -18,7 +18,9 @@ PredictionEarlyStopInstance CreateNone(const PredictionEarlyStopConfig&) {
     [](const double*, int) {
     return false;
   },
-    std::numeric_limits<int>::max()  // make sure the lambda is almost never called
+    std::numeric_limits<int>::max(),  // make sure the lambda is almost never called
+    false,
+    0.0
   };
 }
 
@@ -47,7 +49,9 @@ PredictionEarlyStopInstance CreateMulticlass(const PredictionEarlyStopConfig& co
 
     return false;
   },
-    config.round_period
+    config.round_period,
+    false,
+    0.0
   };
 }
 
@@ -68,7 +72,20 @@ PredictionEarlyStopInstance CreateBinary(const PredictionEarlyStopConfig& config
 
     return false;
   },
-    config.round_period
+    config.round_period,
+    false,
+    0.0
+  };
+}
+
+PredictionEarlyStopInstance CreateExact(const PredictionEarlyStopConfig& config) {
+  return PredictionEarlyStopInstance{
+    [](const double*, int) {
+    return false;
+  },
+    config.round_period,
+    true,
+    config.decision_threshold
   };
 }
 
@@ -80,6 +97,8 @@ PredictionEarlyStopInstance CreatePredictionEarlyStopInstance(const std::string&
     return CreateMulticlass(config);
   } else if (type == "binary") {
     return CreateBinary(config);
+  } else if (type == "exact") {
+    return CreateExact(config);
   } else {
     Log::Fatal("Unknown early stopping type: %s", type.c_str());
   }
@@ -0,0 +1,143 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#include "quick_scorer.h"
+
+#include <LightGBM/utils/common.h>
+#include <LightGBM/utils/log.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace LightGBM {
+
+bool QuickScorer::CanScore(const Tree& tree) {
+  return !tree.is_linear() && tree.num_cat() == 0 && tree.num_leaves() <= kMaxLeaves;
+}
+
+QuickScorer::QuickScorer(const std::vector<std::shared_ptr<Tree>>& models, int start_tree, int num_trees)
+  : start_tree_(start_tree) {
+  int num_features = 0;
+  int num_leaves = 0;
+  for (int i = 0; i < num_trees; ++i) {
+    const Tree& tree = *models[start_tree + i];
+    if (!CanScore(tree)) {
+      continue;
+    }
+    for (int node = 0; node < tree.num_leaves() - 1; ++node) {
+      num_features = std::max(num_features, tree.split_feature(node) + 1);
+    }
+    num_leaves += tree.num_leaves();
+  }
+  std::vector<std::vector<Condition>> lists(static_cast<size_t>(num_features) * kNumConditionLists);
+  leaf_offset_.resize(num_trees, -1);
+  leaf_value_.resize(num_leaves);
+  int leaf_offset = 0;
+  for (int i = 0; i < num_trees; ++i) {
+    const Tree& tree = *models[start_tree + i];
+    if (!CanScore(tree)) {
+      continue;
+    }
+    leaf_offset_[i] = leaf_offset;
+    if (tree.num_leaves() > 1) {
+      AddSubtree(tree, 0, i, 0, leaf_offset, &lists);
+    } else {
+      leaf_value_[leaf_offset] = tree.LeafOutput(0);
+    }
+    leaf_offset += tree.num_leaves();
+  }
+  list_boundaries_.push_back(0);
+  for (int feature = 0; feature < num_features; ++feature) {
+    bool is_used = false;
+    for (int kind = 0; kind < kNumConditionLists; ++kind) {
+      auto& list = lists[feature * kNumConditionLists + kind];
+      std::stable_sort(list.begin(), list.end(), [](const Condition& a, const Condition& b) {
+        return a.threshold < b.threshold;
+      });
+      conditions_.insert(conditions_.end(), list.begin(), list.end());
+      list_boundaries_.push_back(static_cast<int>(conditions_.size()));
+      is_used = is_used || !list.empty();
+    }
+    if (is_used) {
+      used_features_.push_back(feature);
+    }
+  }
+}
+
+int QuickScorer::AddSubtree(const Tree& tree, int node, int tree_idx, int first_bit, int leaf_offset,
+                            std::vector<std::vector<Condition>>* lists) {
+  if (node < 0) {
+    leaf_value_[leaf_offset + first_bit] = tree.LeafOutput(~node);
+    return 1;
+  }
+  const int num_left = AddSubtree(tree, tree.left_child(node), tree_idx, first_bit, leaf_offset, lists);
+  const int num_right = AddSubtree(tree, tree.right_child(node), tree_idx, first_bit + num_left, leaf_offset, lists);
+  Condition condition;
+  condition.threshold = tree.threshold(node);
+  // going right makes every leaf of the left subtree unreachable
+  condition.mask = ~(((static_cast<uint64_t>(1) << num_left) - 1) << first_bit);
+  condition.tree_idx = tree_idx;
+  const int8_t decision_type = tree.decision_type(node);
+  const int8_t missing_type = Tree::GetMissingType(decision_type);
+  const bool default_left = Tree::GetDecisionType(decision_type, kDefaultLeftMask);
+  const size_t list_offset = static_cast<size_t>(tree.split_feature(node)) * kNumConditionLists;
+  if (missing_type == MissingType::Zero) {
+    (*lists)[list_offset + kZeroMissing].push_back(condition);
+    if (!default_left) {
+      (*lists)[list_offset + kZeroDefaultRight].push_back(condition);
+    }
+  } else if (missing_type == MissingType::NaN) {
+    (*lists)[list_offset + kNaNMissing].push_back(condition);
+    if (!default_left) {
+      (*lists)[list_offset + kNaNDefaultRight].push_back(condition);
+    }
+  } else {
+    (*lists)[list_offset + kNoneMissing].push_back(condition);
+  }
+  return num_left + num_right;
+}
+
+void QuickScorer::Predict(const double* feature_values, double* tree_output) const {
+  static THREAD_LOCAL std::vector<uint64_t> leaves;
+  leaves.assign(leaf_offset_.size(), ~static_cast<uint64_t>(0));
+  uint64_t* leaves_ptr = leaves.data();
+  const Condition* conditions = conditions_.data();
+  // clear the leaves of the conditions in [begin, end) whose threshold is below fval
+  auto scan = [leaves_ptr, conditions](int begin, int end, double fval) {
+    for (int i = begin; i < end && conditions[i].threshold < fval; ++i) {
+      leaves_ptr[conditions[i].tree_idx] &= conditions[i].mask;
+    }
+  };
+  auto apply_all = [leaves_ptr, conditions](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      leaves_ptr[conditions[i].tree_idx] &= conditions[i].mask;
+    }
+  };
+  for (const int feature : used_features_) {
+    const int* bounds = list_boundaries_.data() + static_cast<size_t>(feature) * kNumConditionLists;
+    const double raw_fval = feature_values[feature];
+    const bool is_nan = std::isnan(raw_fval);
+    // same conversion as Tree::NumericalDecision for the splits that do not handle NaN
+    const double fval = is_nan ? 0.0f : raw_fval;
+    scan(bounds[kNoneMissing], bounds[kNoneMissing + 1], fval);
+    if (Tree::IsZero(fval)) {
+      apply_all(bounds[kZeroDefaultRight], bounds[kZeroDefaultRight + 1]);
+    } else {
+      scan(bounds[kZeroMissing], bounds[kZeroMissing + 1], fval);
+    }
+    if (is_nan) {
+      apply_all(bounds[kNaNDefaultRight], bounds[kNaNDefaultRight + 1]);
+    } else {
+      scan(bounds[kNaNMissing], bounds[kNaNMissing + 1], raw_fval);
+    }
+  }
+  const int num_trees = static_cast<int>(leaf_offset_.size());
+  for (int i = 0; i < num_trees; ++i) {
+    if (leaf_offset_[i] >= 0) {
+      tree_output[i] = leaf_value_[leaf_offset_[i] + Common::CountTrailingZeros(leaves_ptr[i])];
+    }
+  }
+}
+
+}  // namespace LightGBM
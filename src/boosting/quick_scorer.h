@@ -0,0 +1,106 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#ifndef LIGHTGBM_BOOSTING_QUICK_SCORER_H_
+#define LIGHTGBM_BOOSTING_QUICK_SCORER_H_
+
+#include <LightGBM/meta.h>
+#include <LightGBM/tree.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace LightGBM {
+
+/*!
+* \brief QuickScorer-style evaluation of a range of trees.
+*        The leaves of each tree are numbered from left to right, and every split node carries the
+*        bitmask of the leaves outside of its left subtree. For each feature, the thresholds of all
+*        the trees are kept sorted, so a record is scored by scanning them feature by feature and
+*        clearing the leaves that became unreachable; the exit leaf of a tree is then the lowest bit
+*        left set in its bitvector.
+*        Only numerical, non-linear trees with at most 64 leaves can be scored this way, the other
+*        trees of the range are left to the caller.
+*/
+class QuickScorer {
+ public:
+  /*! \brief Maximal number of leaves of a tree, one bit per leaf */
+  static const int kMaxLeaves = 64;
+
+  /*!
+  * \brief Build the scorer over models[start_tree, start_tree + num_trees)
+  * \param models All the trees of the model
+  * \param start_tree Index of the first tree to score
+  * \param num_trees Number of trees to score
+  */
+  QuickScorer(const std::vector<std::shared_ptr<Tree>>& models, int start_tree, int num_trees);
+
+  /*! \brief Whether tree can be scored by the bitvector algorithm */
+  static bool CanScore(const Tree& tree);
+
+  inline int start_tree() const { return start_tree_; }
+
+  inline int num_trees() const { return static_cast<int>(leaf_offset_.size()); }
+
+  /*! \brief Whether the tree_idx-th tree of the range is scored, otherwise it must be predicted by the caller */
+  inline bool IsScored(int tree_idx) const { return leaf_offset_[tree_idx] >= 0; }
+
+  /*!
+  * \brief Score one record
+  * \param feature_values Feature value of this record
+  * \param tree_output Output buffer of size num_trees(), only the entries of scored trees are written
+  */
+  void Predict(const double* feature_values, double* tree_output) const;
+
+ private:
+  /*! \brief A split node, as seen from the feature it splits on */
+  struct Condition {
+    /*! \brief Threshold, the condition is false (the record goes right) when the feature value is greater */
+    double threshold;
+    /*! \brief Leaves which stay reachable when the record goes right */
+    uint64_t mask;
+    /*! \brief Index of the tree in the range */
+    int tree_idx;
+  };
+
+  /*! \brief Kinds of condition lists kept for each feature */
+  enum ConditionList {
+    /*! \brief Splits without missing value handling, NaN is treated as zero */
+    kNoneMissing = 0,
+    /*! \brief Splits with zero as missing, used when the value is not zero */
+    kZeroMissing,
+    /*! \brief Splits with zero as missing and the default direction right, used when the value is zero */
+    kZeroDefaultRight,
+    /*! \brief Splits with NaN as missing, used when the value is not NaN */
+    kNaNMissing,
+    /*! \brief Splits with NaN as missing and the default direction right, used when the value is NaN */
+    kNaNDefaultRight,
+    kNumConditionLists
+  };
+
+  /*!
+  * \brief Number the leaves of the subtree rooted at node from left to right, starting at first_bit,
+  *        and add its split nodes to lists (one per feature and kind of condition)
+  * \return Number of leaves of the subtree
+  */
+  int AddSubtree(const Tree& tree, int node, int tree_idx, int first_bit, int leaf_offset,
+                 std::vector<std::vector<Condition>>* lists);
+
+  /*! \brief Index of the first tree of the range in the model */
+  int start_tree_;
+  /*! \brief Conditions of all the features, grouped by feature and by kind, sorted by threshold */
+  std::vector<Condition> conditions_;
+  /*! \brief Boundaries of each (feature, kind) list in conditions_ */
+  std::vector<int> list_boundaries_;
+  /*! \brief Features used by at least one scored tree */
+  std::vector<int> used_features_;
+  /*! \brief Position of the leftmost leaf of each tree in leaf_value_, -1 for trees that are not scored */
+  std::vector<int> leaf_offset_;
+  /*! \brief Leaf outputs of all the scored trees, in left-to-right order */
+  std::vector<double> leaf_value_;
+};
+
+}  // namespace LightGBM
+#endif   // LIGHTGBM_BOOSTING_QUICK_SCORER_H_
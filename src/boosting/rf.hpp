@@ -109,6 +109,7 @@ class RF : public GBDT {
   }
 
   bool TrainOneIter(const score_t* gradients, const score_t* hessians) override {
+    ResetPredictionCache();
     // bagging logic
     data_sample_strategy_ ->Bagging(iter_, tree_learner_.get(), gradients_.data(), hessians_.data());
     const bool is_use_subset = data_sample_strategy_->is_use_subset();
@@ -183,10 +184,12 @@ class RF : public GBDT {
 
   void RollbackOneIter() override {
     if (iter_ <= 0) { return; }
+    ResetPredictionCache();
     int cur_iter = iter_ + num_init_iteration_ - 1;
     // reset score
     for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
       auto curr_tree = cur_iter * num_tree_per_iteration_ + cur_tree_id;
+      UnshareTree(curr_tree);
       models_[curr_tree]->Shrinkage(-1.0);
       MultiplyScore(cur_tree_id, (iter_ + num_init_iteration_));
       train_score_updater_->AddScore(models_[curr_tree].get(), cur_tree_id);
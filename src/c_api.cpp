@@ -15,17 +15,23 @@
 #include <LightGBM/prediction_early_stop.h>
 #include <LightGBM/utils/byte_buffer.h>
 #include <LightGBM/utils/common.h>
+#include <LightGBM/utils/file_io.h>
 #include <LightGBM/utils/log.h>
 #include <LightGBM/utils/openmp_wrapper.h>
 #include <LightGBM/utils/random.h>
 #include <LightGBM/utils/threading.h>
 
 #include <string>
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <stdexcept>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 #include "application/predictor.hpp"
@@ -51,20 +57,187 @@ catch(...) { return LGBM_APIHandleException("unknown exception"); } \
 return 0;
 
 #define UNIQUE_LOCK(mtx) \
-std::unique_lock<yamc::alternate::shared_mutex> lock(mtx);
+std::unique_lock<std::remove_reference<decltype(mtx)>::type> lock(mtx);
 
 #define SHARED_LOCK(mtx) \
-yamc::shared_lock<yamc::alternate::shared_mutex> lock(&mtx);
+yamc::shared_lock<std::remove_reference<decltype(mtx)>::type> lock(&mtx);
 
 const int PREDICTOR_TYPES = 4;
 
+/*! \brief Rows per block of prediction, contributions are always computed by blocks */
+inline int PredictBlockSize(const Config& config, int predict_type) {
+  return Predictor::BlockSize(config.predict_block_size, predict_type == C_API_PREDICT_CONTRIB);
+}
+
+/*!
+ * \brief Shared mutex of a Booster, which additionally admits lock-free readers.
+ *
+ * Fast single-row predictions only touch two atomics to enter and leave, so that threads
+ * sharing one model never serialize on a mutex. A writer takes the underlying mutex and then
+ * waits for the lock-free readers to drain; a lock-free reader which sees a writer falls back
+ * to the blocking shared lock.
+ */
+class BoosterMutex {
+ public:
+  void lock() {
+    mutex_.lock();
+    writer_.store(true);
+    while (fast_readers_.load() > 0) {
+      std::this_thread::yield();
+    }
+  }
+
+  void unlock() {
+    writer_.store(false);
+    mutex_.unlock();
+  }
+
+  void lock_shared() {
+    mutex_.lock_shared();
+  }
+
+  void unlock_shared() {
+    mutex_.unlock_shared();
+  }
+
+  /*! \brief Enter as a lock-free reader, fails if a writer holds or waits for the mutex */
+  bool try_lock_fast() {
+    fast_readers_.fetch_add(1);
+    if (writer_.load()) {
+      fast_readers_.fetch_sub(1);
+      return false;
+    }
+    return true;
+  }
+
+  void unlock_fast() {
+    fast_readers_.fetch_sub(1);
+  }
+
+ private:
+  yamc::alternate::shared_mutex mutex_;
+  std::atomic<int> fast_readers_{0};
+  std::atomic<bool> writer_{false};
+};
+
+/*! \brief Read access to a Booster, lock-free unless the Booster is being modified */
+class FastSharedLock {
+ public:
+  explicit FastSharedLock(BoosterMutex* mutex) : mutex_(mutex), is_fast_(mutex->try_lock_fast()) {
+    if (!is_fast_) {
+      mutex_->lock_shared();
+    }
+  }
+
+  ~FastSharedLock() {
+    if (is_fast_) {
+      mutex_->unlock_fast();
+    } else {
+      mutex_->unlock_shared();
+    }
+  }
+
+  FastSharedLock(const FastSharedLock&) = delete;
+  FastSharedLock& operator=(const FastSharedLock&) = delete;
+
+ private:
+  BoosterMutex* mutex_;
+  bool is_fast_;
+};
+
+/*!
+ * \brief Fixed set of feature buffers handed out to concurrent callers without locking.
+ *
+ * A caller probes each slot at most once, starting from one derived from its thread id so that
+ * a thread usually gets the same (cache-warm) buffer back. When all the slots are taken it
+ * gets a buffer of its own instead of waiting.
+ * Buffers are allocated on first use and handed back zeroed or dirty exactly as the caller left them.
+ */
+class PredictBufferPool {
+ private:
+  struct Slot {
+    std::atomic<bool> in_use{false};
+    std::vector<double, Common::AlignmentAllocator<double, kAlignedSize>> buf;
+    // keep the flags of different slots on different cache lines
+    char padding[64];
+  };
+
+ public:
+  /*! \brief A buffer borrowed from the pool for the lifetime of this object */
+  class Buffer {
+   public:
+    explicit Buffer(PredictBufferPool* pool) : pool_(pool), slot_(pool->Acquire()) {
+      if (slot_ != nullptr) {
+        data_ = slot_->buf.data();
+      } else {
+        overflow_.resize(pool_->buf_size_, 0.0f);
+        data_ = overflow_.data();
+      }
+    }
+
+    ~Buffer() {
+      if (slot_ != nullptr) {
+        slot_->in_use.store(false, std::memory_order_release);
+      }
+    }
+
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+
+    inline double* data() const { return data_; }
+
+   private:
+    PredictBufferPool* pool_;
+    Slot* slot_;
+    double* data_;
+    std::vector<double> overflow_;
+  };
+
+  PredictBufferPool(int num_slots, int buf_size) : slots_(num_slots), buf_size_(buf_size) {
+    for (auto& slot : slots_) {
+      slot.reset(new Slot());
+    }
+  }
+
+ private:
+  Slot* Acquire() {
+    const size_t num_slots = slots_.size();
+    const size_t start = std::hash<std::thread::id>()(std::this_thread::get_id());
+    for (size_t i = 0; i < num_slots; ++i) {
+      Slot* slot = slots_[(start + i) % num_slots].get();
+      if (!slot->in_use.load(std::memory_order_relaxed) && !slot->in_use.exchange(true, std::memory_order_acquire)) {
+        if (slot->buf.empty()) {
+          slot->buf.resize(buf_size_, 0.0f);
+        }
+        return slot;
+      }
+    }
+    return nullptr;
+  }
+
+  std::vector<std::unique_ptr<Slot>> slots_;
+  const int buf_size_;
+};
+
+// Predict one dense row of float32 or float64 values, without building its (index, value) pairs
+inline void PredictDenseRow(const Predictor& predictor, const void* row, int data_type, int num_col, int64_t col_stride,
+                            double* buf, double* output) {
+  if (data_type == C_API_DTYPE_FLOAT32) {
+    predictor.PredictDenseRow(reinterpret_cast<const float*>(row), num_col, col_stride, buf, output);
+  } else if (data_type == C_API_DTYPE_FLOAT64) {
+    predictor.PredictDenseRow(reinterpret_cast<const double*>(row), num_col, col_stride, buf, output);
+  } else {
+    Log::Fatal("Unknown data type in PredictDenseRow");
+  }
+}
+
 // Single row predictor to abstract away caching logic
 class SingleRowPredictorInner {
  public:
   PredictFunction predict_function;
   int64_t num_pred_in_one_row;
 
-  SingleRowPredictorInner(int predict_type, Boosting* boosting, const Config& config, int start_iter, int num_iter) {
+  SingleRowPredictorInner(int predict_type, const Boosting* boosting, const Config& config, int start_iter, int num_iter) {
     bool is_predict_leaf = false;
     bool is_raw_score = false;
     bool predict_contrib = false;
@@ -78,9 +251,16 @@ class SingleRowPredictorInner {
     early_stop_ = config.pred_early_stop;
     early_stop_freq_ = config.pred_early_stop_freq;
     early_stop_margin_ = config.pred_early_stop_margin;
+    early_stop_exact_ = config.pred_early_stop_exact;
+    early_stop_threshold_ = config.pred_early_stop_threshold;
+    quick_scorer_ = config.predict_quick_scorer;
+    float32_ = config.predict_float32;
+    binned_ = config.predict_binned;
+    start_iter_ = start_iter;
     iter_ = num_iter;
     predictor_.reset(new Predictor(boosting, start_iter, iter_, is_raw_score, is_predict_leaf, predict_contrib,
-                                   early_stop_, early_stop_freq_, early_stop_margin_));
+                                   early_stop_, early_stop_freq_, early_stop_margin_, early_stop_exact_,
+                                   early_stop_threshold_, quick_scorer_, float32_, binned_, false));
     num_pred_in_one_row = boosting->NumPredictOneRow(start_iter, iter_, is_predict_leaf, predict_contrib);
     predict_function = predictor_->GetPredictFunction();
     num_total_model_ = boosting->NumberOfTotalModel();
@@ -88,19 +268,41 @@ class SingleRowPredictorInner {
 
   ~SingleRowPredictorInner() {}
 
-  bool IsPredictorEqual(const Config& config, int iter, Boosting* boosting) {
+  void PredictDense(const void* row, int data_type, int num_col, int64_t col_stride, double* output) {
+    dense_buf_.resize(predictor_->NumFeatures(), 0.0f);
+    PredictDenseRow(*predictor_, row, data_type, num_col, col_stride, dense_buf_.data(), output);
+  }
+
+  inline const Predictor& predictor() const {
+    return *predictor_;
+  }
+
+  bool IsPredictorEqual(const Config& config, int start_iter, int iter, const Boosting* boosting) {
     return early_stop_ == config.pred_early_stop &&
       early_stop_freq_ == config.pred_early_stop_freq &&
       early_stop_margin_ == config.pred_early_stop_margin &&
+      early_stop_exact_ == config.pred_early_stop_exact &&
+      early_stop_threshold_ == config.pred_early_stop_threshold &&
+      quick_scorer_ == config.predict_quick_scorer &&
+      float32_ == config.predict_float32 &&
+      binned_ == config.predict_binned &&
+      start_iter_ == start_iter &&
       iter_ == iter &&
       num_total_model_ == boosting->NumberOfTotalModel();
   }
 
  private:
   std::unique_ptr<Predictor> predictor_;
+  std::vector<double> dense_buf_;
   bool early_stop_;
   int early_stop_freq_;
   double early_stop_margin_;
+  bool early_stop_exact_;
+  double early_stop_threshold_;
+  bool quick_scorer_;
+  bool float32_;
+  bool binned_;
+  int start_iter_;
   int iter_;
   int num_total_model_;
 };
@@ -115,14 +317,16 @@ class SingleRowPredictorInner {
  */
 struct SingleRowPredictor {
  public:
-  SingleRowPredictor(yamc::alternate::shared_mutex *booster_mutex,
+  SingleRowPredictor(BoosterMutex *booster_mutex,
              const char *parameters,
              const int data_type,
              const int32_t num_cols,
              int predict_type,
              Boosting *boosting,
              int start_iter,
-             int num_iter) : config(Config::Str2Map(parameters)), data_type(data_type), num_cols(num_cols), single_row_predictor_inner(predict_type, boosting, config, start_iter, num_iter), booster_mutex(booster_mutex) {
+             int num_iter) : config(Config::Str2Map(parameters)), data_type(data_type), num_cols(num_cols), single_row_predictor_inner(predict_type, boosting, config, start_iter, num_iter), booster_mutex(booster_mutex),
+             buffer_pool(std::max(4, 2 * static_cast<int>(std::thread::hardware_concurrency())),
+                         single_row_predictor_inner.predictor().NumFeatures()) {
     if (!config.predict_disable_shape_check && num_cols != boosting->MaxFeatureIdx() + 1) {
       Log::Fatal("The number of features in data (%d) is not the same as it was in training data (%d).\n"\
                  "You can set ``predict_disable_shape_check=true`` to discard this error, but please be aware what you are doing.", num_cols, boosting->MaxFeatureIdx() + 1);
@@ -131,15 +335,24 @@ struct SingleRowPredictor {
 
   void Predict(std::function<std::vector<std::pair<int, double>>(int row_idx)> get_row_fun,
                double* out_result, int64_t* out_len) const {
-    UNIQUE_LOCK(single_row_predictor_mutex)
-    yamc::shared_lock<yamc::alternate::shared_mutex> booster_shared_lock(booster_mutex);
-
     auto one_row = get_row_fun(0);
-    single_row_predictor_inner.predict_function(one_row, out_result);
+    FastSharedLock booster_shared_lock(booster_mutex);
+    PredictBufferPool::Buffer buf(&buffer_pool);
+    single_row_predictor_inner.predictor().PredictRow(one_row, buf.data(), out_result);
 
     *out_len = single_row_predictor_inner.num_pred_in_one_row;
   }
 
+  void PredictDense(const void* row, double* out_result, int64_t* out_len) const {
+    FastSharedLock booster_shared_lock(booster_mutex);
+    PredictBufferPool::Buffer buf(&buffer_pool);
+    PredictDenseRow(single_row_predictor_inner.predictor(), row, data_type, num_cols, 1, buf.data(), out_result);
+
+    *out_len = single_row_predictor_inner.num_pred_in_one_row;
+  }
+
+  int64_t num_pred_in_one_row() const { return single_row_predictor_inner.num_pred_in_one_row; }
+
  public:
   Config config;
   const int data_type;
@@ -149,14 +362,11 @@ struct SingleRowPredictor {
   SingleRowPredictorInner single_row_predictor_inner;
 
   // Prevent the booster from being modified while we have a predictor relying on it during prediction
-  yamc::alternate::shared_mutex *booster_mutex;
-
-  // If several threads try to predict at the same time using the same SingleRowPredictor
-  // we want them to still provide correct values, so the mutex is necessary due to the shared
-  // resources in the predictor.
-  // However the recommended approach is to instantiate one SingleRowPredictor per thread,
-  // to avoid contention here.
-  mutable yamc::alternate::shared_mutex single_row_predictor_mutex;
+  BoosterMutex *booster_mutex;
+
+  // Several threads may predict at the same time using the same SingleRowPredictor,
+  // each of them borrows its own feature buffer from this pool instead of taking a mutex.
+  mutable PredictBufferPool buffer_pool;
 };
 
 class Booster {
@@ -410,6 +620,31 @@ class Booster {
   void Refit(const int32_t* leaf_preds, int32_t nrow, int32_t ncol) {
     UNIQUE_LOCK(mutex_)
     boosting_->RefitTree(leaf_preds, nrow, ncol);
+    ResetSingleRowPredictors();
+  }
+
+  void RefitForMat(int32_t nrow, int32_t ncol, const std::function<const void*(int row_idx)>& get_row_ptr,
+                   int data_type, int64_t col_stride) {
+    UNIQUE_LOCK(mutex_)
+    if (ncol != boosting_->MaxFeatureIdx() + 1) {
+      Log::Fatal("The number of features in data (%d) is not the same as it was in training data (%d).",
+                 ncol, boosting_->MaxFeatureIdx() + 1);
+    }
+    boosting_->RefitTree(nrow, [&get_row_ptr, data_type, ncol, col_stride] (data_size_t row_idx, double* features) {
+      const void* row = get_row_ptr(row_idx);
+      if (data_type == C_API_DTYPE_FLOAT32) {
+        const float* row_f = reinterpret_cast<const float*>(row);
+        for (int j = 0; j < ncol; ++j) {
+          features[j] = row_f[j * col_stride];
+        }
+      } else {
+        const double* row_d = reinterpret_cast<const double*>(row);
+        for (int j = 0; j < ncol; ++j) {
+          features[j] = row_d[j * col_stride];
+        }
+      }
+    });
+    ResetSingleRowPredictors();
   }
 
   bool TrainOneIter(const score_t* gradients, const score_t* hessians) {
@@ -425,18 +660,25 @@ class Booster {
   void SetSingleRowPredictorInner(int start_iteration, int num_iteration, int predict_type, const Config& config) {
       UNIQUE_LOCK(mutex_)
       if (single_row_predictor_[predict_type].get() == nullptr ||
-          !single_row_predictor_[predict_type]->IsPredictorEqual(config, num_iteration, boosting_.get())) {
+          !single_row_predictor_[predict_type]->IsPredictorEqual(config, start_iteration, num_iteration, boosting_.get())) {
         single_row_predictor_[predict_type].reset(new SingleRowPredictorInner(predict_type, boosting_.get(),
                                                                          config, start_iteration, num_iteration));
       }
   }
 
+  /*!
+  * \brief Drop the cached single row predictors, which keep predicting the trees they were created with.
+  *        Must be called when trees are modified without changing their number, under the unique lock
+  */
+  void ResetSingleRowPredictors() {
+    for (auto& predictor : single_row_predictor_) {
+      predictor.reset();
+    }
+  }
+
   std::unique_ptr<SingleRowPredictor> InitSingleRowPredictor(int predict_type, int start_iteration, int num_iteration, int data_type, int32_t num_cols, const char *parameters) {
-    // Workaround https://github.com/microsoft/LightGBM/issues/6142 by locking here
-    // This is only a workaround because if predictors are initialized differently it may still behave incorrectly,
-    // and because multiple racing Predictor initializations through LGBM_BoosterPredictForMat suffers from that same issue of Predictor init writing things in the booster.
-    // Once #6142 is fixed (predictor doesn't write in the Booster as should have been the case since 1c35c3b9ede9adab8ccc5fd7b4b2b6af188a79f0), this line can be removed.
-    UNIQUE_LOCK(mutex_)
+    // the predictor gets its own prediction plan, the booster is only read
+    SHARED_LOCK(mutex_)
 
     return std::unique_ptr<SingleRowPredictor>(new SingleRowPredictor(
       &mutex_, parameters, data_type, num_cols, predict_type, boosting_.get(), start_iteration, num_iteration));
@@ -459,7 +701,21 @@ class Booster {
     *out_len = single_row_predictor->num_pred_in_one_row;
   }
 
-  Predictor CreatePredictor(int start_iteration, int num_iteration, int predict_type, int ncol, const Config& config) const {
+  void PredictSingleRowDense(int predict_type, int ncol, const void* row, int data_type, int64_t col_stride,
+                             const Config& config, double* out_result, int64_t* out_len) const {
+    if (!config.predict_disable_shape_check && ncol != boosting_->MaxFeatureIdx() + 1) {
+      Log::Fatal("The number of features in data (%d) is not the same as it was in training data (%d).\n"\
+                 "You can set ``predict_disable_shape_check=true`` to discard this error, but please be aware what you are doing.", ncol, boosting_->MaxFeatureIdx() + 1);
+    }
+    UNIQUE_LOCK(mutex_)
+    const auto& single_row_predictor = single_row_predictor_[predict_type];
+    single_row_predictor->PredictDense(row, data_type, ncol, col_stride, out_result);
+
+    *out_len = single_row_predictor->num_pred_in_one_row;
+  }
+
+  Predictor CreatePredictor(int start_iteration, int num_iteration, int predict_type, int ncol, const Config& config,
+                            bool add_init_score) const {
     if (!config.predict_disable_shape_check && ncol != boosting_->MaxFeatureIdx() + 1) {
       Log::Fatal("The number of features in data (%d) is not the same as it was in training data (%d).\n" \
                  "You can set ``predict_disable_shape_check=true`` to discard this error, but please be aware what you are doing.", ncol, boosting_->MaxFeatureIdx() + 1);
@@ -478,15 +734,17 @@ class Booster {
     }
 
     return Predictor(boosting_.get(), start_iteration, num_iteration, is_raw_score, is_predict_leaf, predict_contrib,
-                        config.pred_early_stop, config.pred_early_stop_freq, config.pred_early_stop_margin);
+                        config.pred_early_stop, config.pred_early_stop_freq, config.pred_early_stop_margin,
+                        config.pred_early_stop_exact, config.pred_early_stop_threshold,
+                        config.predict_quick_scorer, config.predict_float32, config.predict_binned, add_init_score);
   }
 
   void Predict(int start_iteration, int num_iteration, int predict_type, int nrow, int ncol,
                std::function<std::vector<std::pair<int, double>>(int row_idx)> get_row_fun,
                const Config& config,
-               double* out_result, int64_t* out_len) const {
+               double* out_result, int64_t* out_len, const double* init_score = nullptr) const {
     SHARED_LOCK(mutex_);
-    auto predictor = CreatePredictor(start_iteration, num_iteration, predict_type, ncol, config);
+    auto predictor = CreatePredictor(start_iteration, num_iteration, predict_type, ncol, config, init_score != nullptr);
     bool is_predict_leaf = false;
     bool predict_contrib = false;
     if (predict_type == C_API_PREDICT_LEAF_INDEX) {
@@ -495,6 +753,22 @@ class Booster {
       predict_contrib = true;
     }
     int64_t num_pred_in_one_row = boosting_->NumPredictOneRow(start_iteration, num_iteration, is_predict_leaf, predict_contrib);
+    const int block_size = PredictBlockSize(config, predict_type);
+    if (block_size > 0 && predictor.SupportsBlockPrediction()) {
+      const int num_blocks = (nrow + block_size - 1) / block_size;
+      OMP_INIT_EX();
+      #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
+      for (int i = 0; i < num_blocks; ++i) {
+        OMP_LOOP_EX_BEGIN();
+        const int start_row = i * block_size;
+        auto pred_wrt_ptr = out_result + static_cast<size_t>(num_pred_in_one_row) * start_row;
+        predictor.PredictBlock(get_row_fun, start_row, std::min(block_size, nrow - start_row), pred_wrt_ptr);
+        OMP_LOOP_EX_END();
+      }
+      OMP_THROW_EX();
+      *out_len = num_pred_in_one_row * nrow;
+      return;
+    }
     auto pred_fun = predictor.GetPredictFunction();
     OMP_INIT_EX();
     #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
@@ -503,27 +777,103 @@ class Booster {
       auto one_row = get_row_fun(i);
       auto pred_wrt_ptr = out_result + static_cast<size_t>(num_pred_in_one_row) * i;
       pred_fun(one_row, pred_wrt_ptr);
+      if (init_score != nullptr) {
+        predictor.AddInitScore(init_score + static_cast<size_t>(num_pred_in_one_row) * i, pred_wrt_ptr);
+      }
+      OMP_LOOP_EX_END();
+    }
+    OMP_THROW_EX();
+    *out_len = num_pred_in_one_row * nrow;
+  }
+
+  void PredictDense(int start_iteration, int num_iteration, int predict_type, int nrow, int ncol,
+                    const std::function<const void*(int row_idx)>& get_row_ptr, int data_type, int64_t col_stride,
+                    const Config& config, double* out_result, int64_t* out_len,
+                    const double* init_score = nullptr) const {
+    SHARED_LOCK(mutex_);
+    auto predictor = CreatePredictor(start_iteration, num_iteration, predict_type, ncol, config, init_score != nullptr);
+    bool is_predict_leaf = false;
+    bool predict_contrib = false;
+    if (predict_type == C_API_PREDICT_LEAF_INDEX) {
+      is_predict_leaf = true;
+    } else if (predict_type == C_API_PREDICT_CONTRIB) {
+      predict_contrib = true;
+    }
+    int64_t num_pred_in_one_row = boosting_->NumPredictOneRow(start_iteration, num_iteration, is_predict_leaf, predict_contrib);
+    std::vector<std::vector<double>> bufs(OMP_NUM_THREADS());
+    OMP_INIT_EX();
+    #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
+    for (int i = 0; i < nrow; ++i) {
+      OMP_LOOP_EX_BEGIN();
+      auto& buf = bufs[omp_get_thread_num()];
+      if (buf.empty()) {
+        buf.resize(predictor.NumFeatures(), 0.0f);
+      }
+      auto pred_wrt_ptr = out_result + static_cast<size_t>(num_pred_in_one_row) * i;
+      PredictDenseRow(predictor, get_row_ptr(i), data_type, ncol, col_stride, buf.data(), pred_wrt_ptr);
+      if (init_score != nullptr) {
+        predictor.AddInitScore(init_score + static_cast<size_t>(num_pred_in_one_row) * i, pred_wrt_ptr);
+      }
       OMP_LOOP_EX_END();
     }
     OMP_THROW_EX();
     *out_len = num_pred_in_one_row * nrow;
   }
 
+  template <typename T>
+  void PredictLeafIndexDense(int start_iteration, int num_iteration, int nrow, int ncol,
+                             const std::function<const void*(int row_idx)>& get_row_ptr, int data_type,
+                             int64_t col_stride, const Config& config, T* out_result, int64_t* out_len) const {
+    SHARED_LOCK(mutex_);
+    auto predictor = CreatePredictor(start_iteration, num_iteration, C_API_PREDICT_LEAF_INDEX, ncol, config, false);
+    const int64_t num_pred_in_one_row = boosting_->NumPredictOneRow(start_iteration, num_iteration, true, false);
+    std::vector<std::vector<double>> bufs(OMP_NUM_THREADS());
+    // the leaves of one row are predicted as double, then narrowed
+    std::vector<std::vector<double>> leaves_by_thread(OMP_NUM_THREADS());
+    std::vector<char> overflow_by_thread(OMP_NUM_THREADS(), 0);
+    OMP_INIT_EX();
+    #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
+    for (int i = 0; i < nrow; ++i) {
+      OMP_LOOP_EX_BEGIN();
+      const int tid = omp_get_thread_num();
+      auto& buf = bufs[tid];
+      auto& leaves = leaves_by_thread[tid];
+      if (buf.empty()) {
+        buf.resize(predictor.NumFeatures(), 0.0f);
+        leaves.resize(num_pred_in_one_row);
+      }
+      PredictDenseRow(predictor, get_row_ptr(i), data_type, ncol, col_stride, buf.data(), leaves.data());
+      T* pred_wrt_ptr = out_result + static_cast<size_t>(num_pred_in_one_row) * i;
+      for (int64_t k = 0; k < num_pred_in_one_row; ++k) {
+        if (leaves[k] > std::numeric_limits<T>::max()) {
+          overflow_by_thread[tid] = 1;
+        }
+        pred_wrt_ptr[k] = static_cast<T>(leaves[k]);
+      }
+      OMP_LOOP_EX_END();
+    }
+    OMP_THROW_EX();
+    if (std::find(overflow_by_thread.begin(), overflow_by_thread.end(), 1) != overflow_by_thread.end()) {
+      Log::Fatal("The leaf indices do not fit in the output type, use C_API_DTYPE_INT32 instead");
+    }
+    *out_len = num_pred_in_one_row * nrow;
+  }
+
   void PredictSparse(int start_iteration, int num_iteration, int predict_type, int64_t nrow, int ncol,
                      std::function<std::vector<std::pair<int, double>>(int64_t row_idx)> get_row_fun,
                      const Config& config, int64_t* out_elements_size,
-                     std::vector<std::vector<std::unordered_map<int, double>>>* agg_ptr,
+                     std::vector<std::vector<std::vector<std::pair<int, double>>>>* agg_ptr,
                      int32_t** out_indices, void** out_data, int data_type,
                      bool* is_data_float32_ptr, int num_matrices) const {
-    auto predictor = CreatePredictor(start_iteration, num_iteration, predict_type, ncol, config);
+    auto predictor = CreatePredictor(start_iteration, num_iteration, predict_type, ncol, config, false);
     auto pred_sparse_fun = predictor.GetPredictSparseFunction();
-    std::vector<std::vector<std::unordered_map<int, double>>>& agg = *agg_ptr;
+    std::vector<std::vector<std::vector<std::pair<int, double>>>>& agg = *agg_ptr;
     OMP_INIT_EX();
     #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
     for (int64_t i = 0; i < nrow; ++i) {
       OMP_LOOP_EX_BEGIN();
       auto one_row = get_row_fun(i);
-      agg[i] = std::vector<std::unordered_map<int, double>>(num_matrices);
+      agg[i].resize(num_matrices);
       pred_sparse_fun(one_row, &agg[i]);
       OMP_LOOP_EX_END();
     }
@@ -531,7 +881,7 @@ class Booster {
     // calculate the nonzero data and indices size
     int64_t elements_size = 0;
     for (int64_t i = 0; i < static_cast<int64_t>(agg.size()); ++i) {
-      auto row_vector = agg[i];
+      const auto& row_vector = agg[i];
       for (int j = 0; j < static_cast<int>(row_vector.size()); ++j) {
         elements_size += static_cast<int64_t>(row_vector[j].size());
       }
@@ -572,7 +922,7 @@ class Booster {
       return;
     }
     // aggregated per row feature contribution results
-    std::vector<std::vector<std::unordered_map<int, double>>> agg(nrow);
+    std::vector<std::vector<std::vector<std::pair<int, double>>>> agg(nrow);
     int64_t elements_size = 0;
     PredictSparse(start_iteration, num_iteration, predict_type, nrow, ncol, get_row_fun, config, &elements_size, &agg,
                   out_indices, out_data, data_type, &is_data_float32, num_matrices);
@@ -582,7 +932,7 @@ class Booster {
     int64_t row_vector_cnt = 0;
     for (int m = 0; m < num_matrices; ++m) {
       for (int64_t i = 0; i < static_cast<int64_t>(agg.size()); ++i) {
-        auto row_vector = agg[i];
+        const auto& row_vector = agg[i];
         auto row_vector_size = row_vector[m].size();
         // keep track of the row_vector sizes for parallelization
         row_sizes[row_vector_cnt] = static_cast<int>(row_vector_size);
@@ -614,7 +964,7 @@ class Booster {
       #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
       for (int64_t i = 0; i < static_cast<int64_t>(agg.size()); ++i) {
         OMP_LOOP_EX_BEGIN();
-        auto row_vector = agg[i];
+        const auto& row_vector = agg[i];
         int64_t row_start_index = matrix_start_index + i;
         int64_t element_index = row_matrix_offsets[row_start_index] + matrix_offsets[m];
         int64_t indptr_loop_index = indptr_index + i;
@@ -650,7 +1000,7 @@ class Booster {
     SHARED_LOCK(mutex_);
     // Get the number of trees per iteration (for multiclass scenario we output multiple sparse matrices)
     int num_matrices = boosting_->NumModelPerIteration();
-    auto predictor = CreatePredictor(start_iteration, num_iteration, predict_type, ncol, config);
+    auto predictor = CreatePredictor(start_iteration, num_iteration, predict_type, ncol, config, false);
     auto pred_sparse_fun = predictor.GetPredictSparseFunction();
     bool is_col_ptr_int32 = false;
     bool is_data_float32 = false;
@@ -666,7 +1016,7 @@ class Booster {
       return;
     }
     // aggregated per row feature contribution results
-    std::vector<std::vector<std::unordered_map<int, double>>> agg(nrow);
+    std::vector<std::vector<std::vector<std::pair<int, double>>>> agg(nrow);
     int64_t elements_size = 0;
     PredictSparse(start_iteration, num_iteration, predict_type, nrow, ncol, get_row_fun, config, &elements_size, &agg,
                   out_indices, out_data, data_type, &is_data_float32, num_matrices);
@@ -676,7 +1026,7 @@ class Booster {
     for (int m = 0; m < num_matrices; ++m) {
       column_sizes[m] = std::vector<int64_t>(num_output_cols, 0);
       for (int64_t i = 0; i < static_cast<int64_t>(agg.size()); ++i) {
-        auto row_vector = agg[i];
+        const auto& row_vector = agg[i];
         for (auto it = row_vector[m].begin(); it != row_vector[m].end(); ++it) {
           column_sizes[m][it->first] += 1;
         }
@@ -727,7 +1077,7 @@ class Booster {
     for (int m = 0; m < num_matrices; ++m) {
       OMP_LOOP_EX_BEGIN();
       for (int64_t i = 0; i < static_cast<int64_t>(agg.size()); ++i) {
-        auto row_vector = agg[i];
+        const auto& row_vector = agg[i];
         for (auto it = row_vector[m].begin(); it != row_vector[m].end(); ++it) {
           int64_t col_idx = it->first;
           int64_t element_index = column_start_indices[m][col_idx] +
@@ -753,7 +1103,8 @@ class Booster {
 
   void Predict(int start_iteration, int num_iteration, int predict_type, const char* data_filename,
                int data_has_header, const Config& config,
-               const char* result_filename) const {
+               const char* result_filename, bool add_init_score = false,
+               const char* init_score_filename = nullptr) const {
     SHARED_LOCK(mutex_)
     bool is_predict_leaf = false;
     bool is_raw_score = false;
@@ -768,16 +1119,30 @@ class Booster {
       is_raw_score = false;
     }
     Predictor predictor(boosting_.get(), start_iteration, num_iteration, is_raw_score, is_predict_leaf, predict_contrib,
-                        config.pred_early_stop, config.pred_early_stop_freq, config.pred_early_stop_margin);
+                        config.pred_early_stop, config.pred_early_stop_freq, config.pred_early_stop_margin,
+                        config.pred_early_stop_exact, config.pred_early_stop_threshold,
+                        config.predict_quick_scorer, config.predict_float32, config.predict_binned, add_init_score);
     bool bool_data_has_header = data_has_header > 0 ? true : false;
     predictor.Predict(data_filename, result_filename, bool_data_has_header, config.predict_disable_shape_check,
-                      config.precise_float_parser);
+                      config.precise_float_parser, init_score_filename, config.predict_output_format,
+                      PredictBlockSize(config, predict_type));
   }
 
   void GetPredictAt(int data_idx, double* out_result, int64_t* out_len) const {
     boosting_->GetPredictAt(data_idx, out_result, out_len);
   }
 
+  void PredictForDataset(int start_iteration, int num_iteration, int predict_type, const Dataset* data,
+                         double* out_result, int64_t* out_len) const {
+    if (predict_type != C_API_PREDICT_NORMAL && predict_type != C_API_PREDICT_RAW_SCORE) {
+      Log::Fatal("Only normal and raw score predictions are supported on a Dataset");
+    }
+    SHARED_LOCK(mutex_);
+    boosting_->PredictForDataset(data, start_iteration, num_iteration,
+                                 predict_type == C_API_PREDICT_RAW_SCORE, out_result);
+    *out_len = static_cast<int64_t>(data->num_data()) * boosting_->NumModelPerIteration();
+  }
+
   void SaveModelToFile(int start_iteration, int num_iteration, int feature_importance_type, const char* filename) const {
     boosting_->SaveModelToFile(start_iteration, num_iteration, feature_importance_type, filename);
   }
@@ -787,6 +1152,48 @@ class Booster {
     boosting_->LoadModelFromString(model_str, len);
   }
 
+  void LoadModelFromBinary(const char* filename, const void* buffer, int64_t buffer_len) {
+    std::shared_ptr<const void> owner;
+    const char* data = nullptr;
+    size_t len = 0;
+    if (filename != nullptr) {
+      std::shared_ptr<MappedFile> file(MappedFile::Make(filename));
+      if (file == nullptr) {
+        Log::Fatal("Could not map model file %s", filename);
+      }
+      data = file->data();
+      len = file->size();
+      owner = file;
+    } else {
+      // copy the buffer, it may not be aligned nor outlive the booster
+      auto storage = std::make_shared<std::vector<uint64_t>>((buffer_len + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+      std::memcpy(storage->data(), buffer, buffer_len);
+      data = reinterpret_cast<const char*>(storage->data());
+      len = static_cast<size_t>(buffer_len);
+      owner = storage;
+    }
+    boosting_->LoadModelFromBinary(data, len, owner);
+  }
+
+  void LoadModelFromCompiled(const char* filename) {
+    if (!boosting_->LoadModelFromCompiled(filename)) {
+      Log::Fatal("Failed to load the model embedded in compiled model %s", filename);
+    }
+  }
+
+  void SaveModelToCompiled(int num_iteration, bool use_float32, const std::string& compiler,
+                           const std::string& compiler_flags, const char* filename) const {
+    if (!boosting_->SaveModelToCompiled(num_iteration, use_float32, compiler, compiler_flags, filename)) {
+      Log::Fatal("Failed to write the C source of compiled model %s", filename);
+    }
+  }
+
+  void SaveModelToBinaryFile(int start_iteration, int num_iteration, int feature_importance_type, const char* filename) const {
+    if (!boosting_->SaveModelToBinaryFile(start_iteration, num_iteration, feature_importance_type, filename)) {
+      Log::Fatal("Failed to write binary model file %s", filename);
+    }
+  }
+
   std::string SaveModelToString(int start_iteration, int num_iteration,
                                 int feature_importance_type) const {
     return boosting_->SaveModelToString(start_iteration,
@@ -821,11 +1228,13 @@ class Booster {
   void SetLeafValue(int tree_idx, int leaf_idx, double val) {
     UNIQUE_LOCK(mutex_)
     dynamic_cast<GBDTBase*>(boosting_.get())->SetLeafValue(tree_idx, leaf_idx, val);
+    ResetSingleRowPredictors();
   }
 
   void ShuffleModels(int start_iter, int end_iter) {
     UNIQUE_LOCK(mutex_)
     boosting_->ShuffleModels(start_iter, end_iter);
+    ResetSingleRowPredictors();
   }
 
   int GetEvalCounts() const {
@@ -869,6 +1278,19 @@ class Booster {
     return idx;
   }
 
+  Booster* CreateView(int start_iteration, int num_iteration) {
+    // building the shared forest and the tree depths must not race with a prediction of this booster
+    UNIQUE_LOCK(mutex_)
+    std::unique_ptr<Booster> view(new Booster(nullptr));
+    view->boosting_.reset(boosting_->CreateView(start_iteration, num_iteration));
+    return view.release();
+  }
+
+  void GetMemoryUsage(int64_t* out_own_bytes, int64_t* out_shared_bytes) const {
+    SHARED_LOCK(mutex_)
+    boosting_->GetMemoryUsage(out_own_bytes, out_shared_bytes);
+  }
+
   const Boosting* GetBoosting() const { return boosting_.get(); }
 
  private:
@@ -885,7 +1307,7 @@ class Booster {
   /*! \brief Training objective function */
   std::unique_ptr<ObjectiveFunction> objective_fun_;
   /*! \brief mutex for threading safe call */
-  mutable yamc::alternate::shared_mutex mutex_;
+  mutable BoosterMutex mutex_;
 };
 
 }  // namespace LightGBM
@@ -1968,6 +2390,62 @@ int LGBM_BoosterLoadModelFromString(
   API_END();
 }
 
+int LGBM_BoosterCreateFromModelBinary(
+  const char* filename,
+  const void* buffer,
+  int64_t buffer_len,
+  int* out_num_iterations,
+  BoosterHandle* out) {
+  API_BEGIN();
+  if ((filename == nullptr) == (buffer == nullptr)) {
+    Log::Fatal("Exactly one of filename and buffer must be provided");
+  }
+  if (buffer != nullptr && buffer_len <= 0) {
+    Log::Fatal("The length of the binary model buffer must be positive");
+  }
+  auto ret = std::unique_ptr<Booster>(new Booster(nullptr));
+  ret->LoadModelFromBinary(filename, buffer, buffer_len);
+  *out_num_iterations = ret->GetBoosting()->GetCurrentIteration();
+  *out = ret.release();
+  API_END();
+}
+
+int LGBM_BoosterLoadCompiled(
+  const char* filename,
+  int* out_num_iterations,
+  BoosterHandle* out) {
+  API_BEGIN();
+  auto ret = std::unique_ptr<Booster>(new Booster(nullptr));
+  ret->LoadModelFromCompiled(filename);
+  *out_num_iterations = ret->GetBoosting()->GetCurrentIteration();
+  *out = ret.release();
+  API_END();
+}
+
+int LGBM_BoosterCreateView(
+  BoosterHandle handle,
+  int start_iteration,
+  int num_iteration,
+  int* out_num_iterations,
+  BoosterHandle* out) {
+  API_BEGIN();
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  auto ret = std::unique_ptr<Booster>(ref_booster->CreateView(start_iteration, num_iteration));
+  *out_num_iterations = ret->GetBoosting()->GetCurrentIteration();
+  *out = ret.release();
+  API_END();
+}
+
+int LGBM_BoosterGetMemoryUsage(
+  BoosterHandle handle,
+  int64_t* out_own_bytes,
+  int64_t* out_shared_bytes) {
+  API_BEGIN();
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  ref_booster->GetMemoryUsage(out_own_bytes, out_shared_bytes);
+  API_END();
+}
+
 int LGBM_BoosterGetLoadedParam(
   BoosterHandle handle,
   int64_t buffer_len,
@@ -2058,6 +2536,26 @@ int LGBM_BoosterRefit(BoosterHandle handle, const int32_t* leaf_preds, int32_t n
   API_END();
 }
 
+int LGBM_BoosterRefitForMat(BoosterHandle handle,
+                            const void* data,
+                            int data_type,
+                            int32_t nrow,
+                            int32_t ncol,
+                            int is_row_major) {
+  API_BEGIN();
+  if (data_type != C_API_DTYPE_FLOAT32 && data_type != C_API_DTYPE_FLOAT64) {
+    Log::Fatal("Unknown data type in RefitForMat");
+  }
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  const int64_t elem_size = data_type == C_API_DTYPE_FLOAT32 ? sizeof(float) : sizeof(double);
+  const char* data_ptr = reinterpret_cast<const char*>(data);
+  const int64_t row_stride = is_row_major ? static_cast<int64_t>(ncol) : 1;
+  const int64_t col_stride = is_row_major ? 1 : static_cast<int64_t>(nrow);
+  ref_booster->RefitForMat(nrow, ncol, [=](int row_idx) { return data_ptr + elem_size * row_stride * row_idx; },
+                           data_type, col_stride);
+  API_END();
+}
+
 int LGBM_BoosterUpdateOneIter(BoosterHandle handle, int* is_finished) {
   API_BEGIN();
   Booster* ref_booster = reinterpret_cast<Booster*>(handle);
@@ -2210,6 +2708,26 @@ int LGBM_BoosterPredictForFile(BoosterHandle handle,
   API_END();
 }
 
+int LGBM_BoosterPredictForFileFromScore(BoosterHandle handle,
+                                        const char* data_filename,
+                                        int data_has_header,
+                                        int predict_type,
+                                        const char* init_score_filename,
+                                        int start_iteration,
+                                        int num_iteration,
+                                        const char* parameter,
+                                        const char* result_filename) {
+  API_BEGIN();
+  auto param = Config::Str2Map(parameter);
+  Config config;
+  config.Set(param);
+  OMP_SET_NUM_THREADS(config.num_threads);
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  ref_booster->Predict(start_iteration, num_iteration, predict_type, data_filename, data_has_header,
+                       config, result_filename, true, init_score_filename);
+  API_END();
+}
+
 int LGBM_BoosterCalcNumPredict(BoosterHandle handle,
                                int num_row,
                                int predict_type,
@@ -2223,6 +2741,18 @@ int LGBM_BoosterCalcNumPredict(BoosterHandle handle,
   API_END();
 }
 
+int LGBM_BoosterGetFloat32Deviation(BoosterHandle handle,
+                                    int start_iteration,
+                                    int num_iteration,
+                                    int* out_num_inexact_thresholds,
+                                    double* out_max_deviation) {
+  API_BEGIN();
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  *out_max_deviation = ref_booster->GetBoosting()->GetFloat32Deviation(start_iteration, num_iteration,
+                                                                       out_num_inexact_thresholds);
+  API_END();
+}
+
 // Naming: In future versions of LightGBM, public API named around `FastConfig` should be made named around
 // `SingleRowPredictor`, because it is specific to single row prediction, and doesn't actually hold only config.
 // For now this is kept as `FastConfig` for backwards compatibility.
@@ -2235,6 +2765,18 @@ int LGBM_FastConfigFree(FastConfigHandle fastConfig) {
   API_END();
 }
 
+int LGBM_FastConfigGetShape(FastConfigHandle fastConfig,
+                            int* out_data_type,
+                            int32_t* out_ncol,
+                            int64_t* out_len) {
+  API_BEGIN();
+  const SingleRowPredictor* single_row_predictor = reinterpret_cast<const SingleRowPredictor*>(fastConfig);
+  *out_data_type = single_row_predictor->data_type;
+  *out_ncol = single_row_predictor->num_cols;
+  *out_len = single_row_predictor->num_pred_in_one_row();
+  API_END();
+}
+
 int LGBM_BoosterPredictForCSR(BoosterHandle handle,
                               const void* indptr,
                               int indptr_type,
@@ -2268,6 +2810,43 @@ int LGBM_BoosterPredictForCSR(BoosterHandle handle,
   API_END();
 }
 
+int LGBM_BoosterPredictForCSRFromScore(BoosterHandle handle,
+                                       const void* indptr,
+                                       int indptr_type,
+                                       const int32_t* indices,
+                                       const void* data,
+                                       int data_type,
+                                       int64_t nindptr,
+                                       int64_t nelem,
+                                       int64_t num_col,
+                                       int predict_type,
+                                       const double* init_score,
+                                       int start_iteration,
+                                       int num_iteration,
+                                       const char* parameter,
+                                       int64_t* out_len,
+                                       double* out_result) {
+  API_BEGIN();
+  if (num_col <= 0) {
+    Log::Fatal("The number of columns should be greater than zero.");
+  } else if (num_col >= INT32_MAX) {
+    Log::Fatal("The number of columns should be smaller than INT32_MAX.");
+  }
+  if (init_score == nullptr) {
+    Log::Fatal("The initial scores should not be NULL.");
+  }
+  auto param = Config::Str2Map(parameter);
+  Config config;
+  config.Set(param);
+  OMP_SET_NUM_THREADS(config.num_threads);
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  auto get_row_fun = RowFunctionFromCSR<int>(indptr, indptr_type, indices, data, data_type, nindptr, nelem);
+  int nrow = static_cast<int>(nindptr - 1);
+  ref_booster->Predict(start_iteration, num_iteration, predict_type, nrow, static_cast<int>(num_col), get_row_fun,
+                       config, out_result, out_len, init_score);
+  API_END();
+}
+
 int LGBM_BoosterPredictSparseOutput(BoosterHandle handle,
                                     const void* indptr,
                                     int indptr_type,
@@ -2513,9 +3092,106 @@ int LGBM_BoosterPredictForMat(BoosterHandle handle,
   config.Set(param);
   OMP_SET_NUM_THREADS(config.num_threads);
   Booster* ref_booster = reinterpret_cast<Booster*>(handle);
-  auto get_row_fun = RowPairFunctionFromDenseMatric(data, nrow, ncol, data_type, is_row_major);
-  ref_booster->Predict(start_iteration, num_iteration, predict_type, nrow, ncol, get_row_fun,
-                       config, out_result, out_len);
+  if (PredictBlockSize(config, predict_type) > 0) {
+    auto get_row_fun = RowPairFunctionFromDenseMatric(data, nrow, ncol, data_type, is_row_major);
+    ref_booster->Predict(start_iteration, num_iteration, predict_type, nrow, ncol, get_row_fun,
+                         config, out_result, out_len);
+  } else {
+    const int64_t elem_size = data_type == C_API_DTYPE_FLOAT32 ? sizeof(float) : sizeof(double);
+    const char* data_ptr = reinterpret_cast<const char*>(data);
+    // row-major rows are contiguous, column-major ones are strided by the number of rows
+    const int64_t row_stride = is_row_major ? static_cast<int64_t>(ncol) : 1;
+    const int64_t col_stride = is_row_major ? 1 : static_cast<int64_t>(nrow);
+    ref_booster->PredictDense(start_iteration, num_iteration, predict_type, nrow, ncol,
+                              [=](int row_idx) { return data_ptr + elem_size * row_stride * row_idx; },
+                              data_type, col_stride, config, out_result, out_len);
+  }
+  API_END();
+}
+
+int LGBM_BoosterPredictLeafIndexForMat(BoosterHandle handle,
+                                       const void* data,
+                                       int data_type,
+                                       int32_t nrow,
+                                       int32_t ncol,
+                                       int is_row_major,
+                                       int start_iteration,
+                                       int num_iteration,
+                                       const char* parameter,
+                                       int out_type,
+                                       int64_t* out_len,
+                                       void* out_result) {
+  API_BEGIN();
+  auto param = Config::Str2Map(parameter);
+  Config config;
+  config.Set(param);
+  OMP_SET_NUM_THREADS(config.num_threads);
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  const int64_t elem_size = data_type == C_API_DTYPE_FLOAT32 ? sizeof(float) : sizeof(double);
+  const char* data_ptr = reinterpret_cast<const char*>(data);
+  const int64_t row_stride = is_row_major ? static_cast<int64_t>(ncol) : 1;
+  const int64_t col_stride = is_row_major ? 1 : static_cast<int64_t>(nrow);
+  auto get_row_ptr = [=](int row_idx) { return data_ptr + elem_size * row_stride * row_idx; };
+  if (out_type == C_API_DTYPE_INT32) {
+    ref_booster->PredictLeafIndexDense(start_iteration, num_iteration, nrow, ncol, get_row_ptr, data_type, col_stride,
+                                       config, reinterpret_cast<int32_t*>(out_result), out_len);
+  } else if (out_type == C_API_DTYPE_INT16) {
+    ref_booster->PredictLeafIndexDense(start_iteration, num_iteration, nrow, ncol, get_row_ptr, data_type, col_stride,
+                                       config, reinterpret_cast<int16_t*>(out_result), out_len);
+  } else {
+    Log::Fatal("Leaf indices can only be predicted as int32 or int16");
+  }
+  API_END();
+}
+
+int LGBM_BoosterPredictForMatFromScore(BoosterHandle handle,
+                                       const void* data,
+                                       int data_type,
+                                       int32_t nrow,
+                                       int32_t ncol,
+                                       int is_row_major,
+                                       int predict_type,
+                                       const double* init_score,
+                                       int start_iteration,
+                                       int num_iteration,
+                                       const char* parameter,
+                                       int64_t* out_len,
+                                       double* out_result) {
+  API_BEGIN();
+  if (init_score == nullptr) {
+    Log::Fatal("The initial scores should not be NULL.");
+  }
+  auto param = Config::Str2Map(parameter);
+  Config config;
+  config.Set(param);
+  OMP_SET_NUM_THREADS(config.num_threads);
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  const int64_t elem_size = data_type == C_API_DTYPE_FLOAT32 ? sizeof(float) : sizeof(double);
+  const char* data_ptr = reinterpret_cast<const char*>(data);
+  const int64_t row_stride = is_row_major ? static_cast<int64_t>(ncol) : 1;
+  const int64_t col_stride = is_row_major ? 1 : static_cast<int64_t>(nrow);
+  ref_booster->PredictDense(start_iteration, num_iteration, predict_type, nrow, ncol,
+                            [=](int row_idx) { return data_ptr + elem_size * row_stride * row_idx; },
+                            data_type, col_stride, config, out_result, out_len, init_score);
+  API_END();
+}
+
+int LGBM_BoosterPredictForDataset(BoosterHandle handle,
+                                  const DatasetHandle dataset,
+                                  int predict_type,
+                                  int start_iteration,
+                                  int num_iteration,
+                                  const char* parameter,
+                                  int64_t* out_len,
+                                  double* out_result) {
+  API_BEGIN();
+  auto param = Config::Str2Map(parameter);
+  Config config;
+  config.Set(param);
+  OMP_SET_NUM_THREADS(config.num_threads);
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  const Dataset* data = reinterpret_cast<const Dataset*>(dataset);
+  ref_booster->PredictForDataset(start_iteration, num_iteration, predict_type, data, out_result, out_len);
   API_END();
 }
 
@@ -2536,9 +3212,10 @@ int LGBM_BoosterPredictForMatSingleRow(BoosterHandle handle,
   config.Set(param);
   OMP_SET_NUM_THREADS(config.num_threads);
   Booster* ref_booster = reinterpret_cast<Booster*>(handle);
-  auto get_row_fun = RowPairFunctionFromDenseMatric(data, 1, ncol, data_type, is_row_major);
   ref_booster->SetSingleRowPredictorInner(start_iteration, num_iteration, predict_type, config);
-  ref_booster->PredictSingleRow(predict_type, ncol, get_row_fun, config, out_result, out_len);
+  // a single row is contiguous whatever the layout
+  (void) is_row_major;  // UNUSED VARIABLE
+  ref_booster->PredictSingleRowDense(predict_type, ncol, data, data_type, 1, config, out_result, out_len);
   API_END();
 }
 
@@ -2569,8 +3246,7 @@ int LGBM_BoosterPredictForMatSingleRowFast(FastConfigHandle fastConfig_handle,
   API_BEGIN();
   SingleRowPredictor *single_row_predictor = reinterpret_cast<SingleRowPredictor*>(fastConfig_handle);
   // Single row in row-major format:
-  auto get_row_fun = RowPairFunctionFromDenseMatric(data, 1, single_row_predictor->num_cols, single_row_predictor->data_type, 1);
-  single_row_predictor->Predict(get_row_fun, out_result, out_len);
+  single_row_predictor->PredictDense(data, out_result, out_len);
   API_END();
 }
 
@@ -2592,8 +3268,14 @@ int LGBM_BoosterPredictForMats(BoosterHandle handle,
   config.Set(param);
   OMP_SET_NUM_THREADS(config.num_threads);
   Booster* ref_booster = reinterpret_cast<Booster*>(handle);
-  auto get_row_fun = RowPairFunctionFromDenseRows(data, ncol, data_type);
-  ref_booster->Predict(start_iteration, num_iteration, predict_type, nrow, ncol, get_row_fun, config, out_result, out_len);
+  if (PredictBlockSize(config, predict_type) > 0) {
+    auto get_row_fun = RowPairFunctionFromDenseRows(data, ncol, data_type);
+    ref_booster->Predict(start_iteration, num_iteration, predict_type, nrow, ncol, get_row_fun, config, out_result, out_len);
+  } else {
+    ref_booster->PredictDense(start_iteration, num_iteration, predict_type, nrow, ncol,
+                              [=](int row_idx) { return data[row_idx]; },
+                              data_type, 1, config, out_result, out_len);
+  }
   API_END();
 }
 
@@ -2660,6 +3342,34 @@ int LGBM_BoosterSaveModel(BoosterHandle handle,
   API_END();
 }
 
+int LGBM_BoosterSaveModelBinary(BoosterHandle handle,
+                                int start_iteration,
+                                int num_iteration,
+                                int feature_importance_type,
+                                const char* filename) {
+  API_BEGIN();
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  ref_booster->SaveModelToBinaryFile(start_iteration, num_iteration,
+                                     feature_importance_type, filename);
+  API_END();
+}
+
+int LGBM_BoosterSaveModelCompiled(BoosterHandle handle,
+                                  int num_iteration,
+                                  int use_float32,
+                                  const char* compiler,
+                                  const char* compiler_flags,
+                                  const char* filename) {
+  API_BEGIN();
+  Config default_config;
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  ref_booster->SaveModelToCompiled(num_iteration, use_float32 != 0,
+                                   compiler != nullptr ? compiler : default_config.compiler,
+                                   compiler_flags != nullptr ? compiler_flags : default_config.compiler_flags,
+                                   filename);
+  API_END();
+}
+
 int LGBM_BoosterSaveModelToString(BoosterHandle handle,
                                   int start_iteration,
                                   int num_iteration,
@@ -176,6 +176,8 @@ void GetTaskType(const std::unordered_map<std::string, std::string>& params, Tas
       *task = TaskType::KRefitTree;
     } else if (value == std::string("save_binary")) {
       *task = TaskType::kSaveBinary;
+    } else if (value == std::string("compile") || value == std::string("compile_model")) {
+      *task = TaskType::kCompileModel;
     } else {
       Log::Fatal("Unknown task type %s", value.c_str());
     }
@@ -451,6 +453,54 @@ void Config::CheckParamConflict(const std::unordered_map<std::string, std::strin
     Log::Warning("Cannot use \"intermediate\" or \"advanced\" monotone constraints with feature fraction different from 1, auto set monotone constraints to \"basic\" method.");
     monotone_constraints_method = "basic";
   }
+  if (grow_policy != std::string("leafwise") && grow_policy != std::string("depthwise")) {
+    Log::Fatal("Unknown grow_policy %s", grow_policy.c_str());
+  }
+  if (grow_policy == std::string("depthwise")) {
+    if (tree_learner != std::string("serial") || device_type != std::string("cpu")) {
+      Log::Warning("Depth-wise growth only works with the serial tree learner on CPU, auto set grow_policy to \"leafwise\".");
+      grow_policy = "leafwise";
+    } else if (!forcedsplits_filename.empty()) {
+      Log::Fatal("Don't support forcedsplits with depthwise grow_policy");
+    } else if (monotone_constraints_method != std::string("basic")) {
+      // the leaves updated by "intermediate" monotone constraints may not have their histograms yet
+      Log::Warning("Cannot use \"intermediate\" or \"advanced\" monotone constraints with depthwise grow_policy, auto set to \"basic\" method.");
+      monotone_constraints_method = "basic";
+    }
+  }
+  if (oblivious_tree) {
+    if (tree_learner != std::string("serial") || device_type != std::string("cpu")) {
+      Log::Fatal("Oblivious trees only work with the serial tree learner on CPU");
+    } else if (linear_tree) {
+      Log::Fatal("Cannot use oblivious trees with linear trees");
+    } else if (!forcedsplits_filename.empty()) {
+      Log::Fatal("Don't support forcedsplits with oblivious trees");
+    } else if (!monotone_constraints.empty() || !interaction_constraints.empty()) {
+      Log::Fatal("Don't support monotone or interaction constraints with oblivious trees");
+    }
+    if (use_quantized_grad) {
+      Log::Warning("Quantized training is not supported with oblivious trees. Switch to full precision training.");
+      use_quantized_grad = false;
+    }
+    if (histogram_pool_size > 0) {
+      // the splits of a level are chosen from the histograms of all its leaves
+      Log::Warning("Oblivious trees keep the histograms of all the leaves, auto set histogram_pool_size to -1.");
+      histogram_pool_size = -1;
+    }
+  }
+  if (multiclass_root_histograms) {
+    if (tree_learner != std::string("serial") || device_type != std::string("cpu")) {
+      Log::Warning("multiclass_root_histograms only works with the serial tree learner on CPU, auto set it to false.");
+      multiclass_root_histograms = false;
+    } else if (use_quantized_grad) {
+      Log::Warning("Cannot use multiclass_root_histograms with quantized training, auto set it to false.");
+      multiclass_root_histograms = false;
+    } else if (feature_fraction < 1.0) {
+      // the root histograms are constructed before the features of each tree are sampled
+      Log::Warning("Cannot use multiclass_root_histograms with feature_fraction < 1.0, auto set it to false.");
+      multiclass_root_histograms = false;
+    }
+  }
   if (max_depth > 0 && monotone_penalty >= max_depth) {
     Log::Warning("Monotone penalty greater than tree depth. Monotone features won't be used.");
   }
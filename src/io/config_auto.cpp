@@ -54,6 +54,7 @@ const std::unordered_map<std::string, std::string>& Config::alias_table() {
   {"random_seed", "seed"},
   {"random_state", "seed"},
   {"hist_pool_size", "histogram_pool_size"},
+  {"symmetric_tree", "oblivious_tree"},
   {"min_data_per_leaf", "min_data_in_leaf"},
   {"min_data", "min_data_in_leaf"},
   {"min_child_samples", "min_data_in_leaf"},
@@ -155,6 +156,7 @@ const std::unordered_map<std::string, std::string>& Config::alias_table() {
   {"pred_name", "output_result"},
   {"name_pred", "output_result"},
   {"convert_model_file", "convert_model"},
+  {"compiled_model_file", "compiled_model"},
   {"num_classes", "num_class"},
   {"unbalance", "is_unbalance"},
   {"unbalanced_sets", "is_unbalance"},
@@ -200,7 +202,12 @@ const std::unordered_set<std::string>& Config::parameter_set() {
   "force_col_wise",
   "force_row_wise",
   "histogram_pool_size",
+  "leaf_ordered_bins",
+  "leaf_ordered_bins_max_memory",
+  "multiclass_root_histograms",
   "max_depth",
+  "grow_policy",
+  "oblivious_tree",
   "min_data_in_leaf",
   "min_sum_hessian_in_leaf",
   "bagging_fraction",
@@ -241,6 +248,7 @@ const std::unordered_set<std::string>& Config::parameter_set() {
   "feature_contri",
   "forcedsplits_filename",
   "refit_decay_rate",
+  "refit_leaf_buffer_size",
   "cegb_tradeoff",
   "cegb_penalty_split",
   "cegb_penalty_feature_lazy",
@@ -288,9 +296,20 @@ const std::unordered_set<std::string>& Config::parameter_set() {
   "pred_early_stop",
   "pred_early_stop_freq",
   "pred_early_stop_margin",
+  "pred_early_stop_exact",
+  "pred_early_stop_threshold",
+  "predict_block_size",
+  "predict_quick_scorer",
+  "predict_float32",
+  "predict_binned",
+  "predict_output_format",
   "output_result",
   "convert_model_language",
   "convert_model",
+  "compiled_model",
+  "compile_float32",
+  "compiler",
+  "compiler_flags",
   "objective_seed",
   "num_class",
   "is_unbalance",
@@ -353,8 +372,18 @@ void Config::GetMembersFromString(const std::unordered_map<std::string, std::str
 
   GetDouble(params, "histogram_pool_size", &histogram_pool_size);
 
+  GetBool(params, "leaf_ordered_bins", &leaf_ordered_bins);
+
+  GetDouble(params, "leaf_ordered_bins_max_memory", &leaf_ordered_bins_max_memory);
+
+  GetBool(params, "multiclass_root_histograms", &multiclass_root_histograms);
+
   GetInt(params, "max_depth", &max_depth);
 
+  GetString(params, "grow_policy", &grow_policy);
+
+  GetBool(params, "oblivious_tree", &oblivious_tree);
+
   GetInt(params, "min_data_in_leaf", &min_data_in_leaf);
   CHECK_GE(min_data_in_leaf, 0);
 
@@ -473,6 +502,9 @@ void Config::GetMembersFromString(const std::unordered_map<std::string, std::str
   CHECK_GE(refit_decay_rate, 0.0);
   CHECK_LE(refit_decay_rate, 1.0);
 
+  GetInt(params, "refit_leaf_buffer_size", &refit_leaf_buffer_size);
+  CHECK_GT(refit_leaf_buffer_size, 0);
+
   GetDouble(params, "cegb_tradeoff", &cegb_tradeoff);
   CHECK_GE(cegb_tradeoff, 0.0);
 
@@ -579,12 +611,35 @@ void Config::GetMembersFromString(const std::unordered_map<std::string, std::str
 
   GetDouble(params, "pred_early_stop_margin", &pred_early_stop_margin);
 
+  GetBool(params, "pred_early_stop_exact", &pred_early_stop_exact);
+
+  GetDouble(params, "pred_early_stop_threshold", &pred_early_stop_threshold);
+
+  GetInt(params, "predict_block_size", &predict_block_size);
+  CHECK_GE(predict_block_size, 0);
+
+  GetBool(params, "predict_quick_scorer", &predict_quick_scorer);
+
+  GetBool(params, "predict_float32", &predict_float32);
+
+  GetBool(params, "predict_binned", &predict_binned);
+
+  GetString(params, "predict_output_format", &predict_output_format);
+
   GetString(params, "output_result", &output_result);
 
   GetString(params, "convert_model_language", &convert_model_language);
 
   GetString(params, "convert_model", &convert_model);
 
+  GetString(params, "compiled_model", &compiled_model);
+
+  GetBool(params, "compile_float32", &compile_float32);
+
+  GetString(params, "compiler", &compiler);
+
+  GetString(params, "compiler_flags", &compiler_flags);
+
   GetInt(params, "objective_seed", &objective_seed);
 
   GetInt(params, "num_class", &num_class);
@@ -680,7 +735,12 @@ std::string Config::SaveMembersToString() const {
   str_buf << "[force_col_wise: " << force_col_wise << "]\n";
   str_buf << "[force_row_wise: " << force_row_wise << "]\n";
   str_buf << "[histogram_pool_size: " << histogram_pool_size << "]\n";
+  str_buf << "[leaf_ordered_bins: " << leaf_ordered_bins << "]\n";
+  str_buf << "[leaf_ordered_bins_max_memory: " << leaf_ordered_bins_max_memory << "]\n";
+  str_buf << "[multiclass_root_histograms: " << multiclass_root_histograms << "]\n";
   str_buf << "[max_depth: " << max_depth << "]\n";
+  str_buf << "[grow_policy: " << grow_policy << "]\n";
+  str_buf << "[oblivious_tree: " << oblivious_tree << "]\n";
   str_buf << "[min_data_in_leaf: " << min_data_in_leaf << "]\n";
   str_buf << "[min_sum_hessian_in_leaf: " << min_sum_hessian_in_leaf << "]\n";
   str_buf << "[bagging_fraction: " << bagging_fraction << "]\n";
@@ -721,6 +781,7 @@ std::string Config::SaveMembersToString() const {
   str_buf << "[feature_contri: " << Common::Join(feature_contri, ",") << "]\n";
   str_buf << "[forcedsplits_filename: " << forcedsplits_filename << "]\n";
   str_buf << "[refit_decay_rate: " << refit_decay_rate << "]\n";
+  str_buf << "[refit_leaf_buffer_size: " << refit_leaf_buffer_size << "]\n";
   str_buf << "[cegb_tradeoff: " << cegb_tradeoff << "]\n";
   str_buf << "[cegb_penalty_split: " << cegb_penalty_split << "]\n";
   str_buf << "[cegb_penalty_feature_lazy: " << Common::Join(cegb_penalty_feature_lazy, ",") << "]\n";
@@ -805,7 +866,12 @@ const std::unordered_map<std::string, std::vector<std::string>>& Config::paramet
     {"force_col_wise", {}},
     {"force_row_wise", {}},
     {"histogram_pool_size", {"hist_pool_size"}},
+    {"leaf_ordered_bins", {}},
+    {"leaf_ordered_bins_max_memory", {}},
+    {"multiclass_root_histograms", {}},
     {"max_depth", {}},
+    {"grow_policy", {}},
+    {"oblivious_tree", {"symmetric_tree"}},
     {"min_data_in_leaf", {"min_data_per_leaf", "min_data", "min_child_samples", "min_samples_leaf"}},
     {"min_sum_hessian_in_leaf", {"min_sum_hessian_per_leaf", "min_sum_hessian", "min_hessian", "min_child_weight"}},
     {"bagging_fraction", {"sub_row", "subsample", "bagging"}},
@@ -846,6 +912,7 @@ const std::unordered_map<std::string, std::vector<std::string>>& Config::paramet
     {"feature_contri", {"feature_contrib", "fc", "fp", "feature_penalty"}},
     {"forcedsplits_filename", {"fs", "forced_splits_filename", "forced_splits_file", "forced_splits"}},
     {"refit_decay_rate", {}},
+    {"refit_leaf_buffer_size", {}},
     {"cegb_tradeoff", {}},
     {"cegb_penalty_split", {}},
     {"cegb_penalty_feature_lazy", {}},
@@ -893,9 +960,20 @@ const std::unordered_map<std::string, std::vector<std::string>>& Config::paramet
     {"pred_early_stop", {}},
     {"pred_early_stop_freq", {}},
     {"pred_early_stop_margin", {}},
+    {"pred_early_stop_exact", {}},
+    {"pred_early_stop_threshold", {}},
+    {"predict_block_size", {}},
+    {"predict_quick_scorer", {}},
+    {"predict_float32", {}},
+    {"predict_binned", {}},
+    {"predict_output_format", {}},
     {"output_result", {"predict_result", "prediction_result", "predict_name", "prediction_name", "pred_name", "name_pred"}},
     {"convert_model_language", {}},
     {"convert_model", {"convert_model_file"}},
+    {"compiled_model", {"compiled_model_file"}},
+    {"compile_float32", {}},
+    {"compiler", {}},
+    {"compiler_flags", {}},
     {"objective_seed", {}},
     {"num_class", {"num_classes"}},
     {"is_unbalance", {"unbalance", "unbalanced_sets"}},
@@ -949,7 +1027,12 @@ const std::unordered_map<std::string, std::string>& Config::ParameterTypes() {
     {"force_col_wise", "bool"},
     {"force_row_wise", "bool"},
     {"histogram_pool_size", "double"},
+    {"leaf_ordered_bins", "bool"},
+    {"leaf_ordered_bins_max_memory", "double"},
+    {"multiclass_root_histograms", "bool"},
     {"max_depth", "int"},
+    {"grow_policy", "string"},
+    {"oblivious_tree", "bool"},
     {"min_data_in_leaf", "int"},
     {"min_sum_hessian_in_leaf", "double"},
     {"bagging_fraction", "double"},
@@ -990,6 +1073,7 @@ const std::unordered_map<std::string, std::string>& Config::ParameterTypes() {
     {"feature_contri", "vector<double>"},
     {"forcedsplits_filename", "string"},
     {"refit_decay_rate", "double"},
+    {"refit_leaf_buffer_size", "int"},
     {"cegb_tradeoff", "double"},
     {"cegb_penalty_split", "double"},
     {"cegb_penalty_feature_lazy", "vector<double>"},
@@ -1037,9 +1121,20 @@ const std::unordered_map<std::string, std::string>& Config::ParameterTypes() {
     {"pred_early_stop", "bool"},
     {"pred_early_stop_freq", "int"},
     {"pred_early_stop_margin", "double"},
+    {"pred_early_stop_exact", "bool"},
+    {"pred_early_stop_threshold", "double"},
+    {"predict_block_size", "int"},
+    {"predict_quick_scorer", "bool"},
+    {"predict_float32", "bool"},
+    {"predict_binned", "bool"},
+    {"predict_output_format", "string"},
     {"output_result", "string"},
     {"convert_model_language", "string"},
     {"convert_model", "string"},
+    {"compiled_model", "string"},
+    {"compile_float32", "bool"},
+    {"compiler", "string"},
+    {"compiler_flags", "string"},
     {"objective_seed", "int"},
     {"num_class", "int"},
     {"is_unbalance", "bool"},
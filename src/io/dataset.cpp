@@ -1258,19 +1258,43 @@ void Dataset::ConstructHistogramsMultiVal(const data_size_t* data_indices,
       data_indices, num_data, gradients, hessians, hist_data);
 }
 
-template <bool USE_INDICES, bool USE_HESSIAN, bool USE_QUANT_GRAD, int HIST_BITS>
-void Dataset::ConstructHistogramsInner(
-    const std::vector<int8_t>& is_feature_used, const data_size_t* data_indices,
-    data_size_t num_data, const score_t* gradients, const score_t* hessians,
-    score_t* ordered_gradients, score_t* ordered_hessians,
-    TrainingShareStates* share_state, hist_t* hist_data) const {
-  if (!share_state->is_col_wise) {
-    return ConstructHistogramsMultiVal<USE_INDICES, false, USE_QUANT_GRAD, HIST_BITS>(
-        data_indices, num_data, gradients, hessians, share_state, hist_data);
+template <bool USE_QUANT_GRAD, int HIST_BITS>
+void Dataset::ConstructHistogramsLeafOrdered(const data_size_t* data_indices,
+                                             data_size_t leaf_begin,
+                                             data_size_t num_data,
+                                             const score_t* gradients,
+                                             const score_t* hessians,
+                                             score_t* ordered_gradients,
+                                             score_t* ordered_hessians,
+                                             TrainingShareStates* share_state,
+                                             hist_t* hist_data) const {
+  Common::FunctionTimer fun_time("Dataset::ConstructHistogramsLeafOrdered",
+                                 global_timer);
+  // the gradients are ordered at the position of the leaf, like its rows in the leaf-ordered bins
+  if (USE_QUANT_GRAD) {
+    int16_t* ordered_gradients_and_hessians = reinterpret_cast<int16_t*>(ordered_gradients) + leaf_begin;
+    const int16_t* gradients_and_hessians = reinterpret_cast<const int16_t*>(gradients);
+#pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static, 512) if (num_data >= 1024)
+    for (data_size_t i = 0; i < num_data; ++i) {
+      ordered_gradients_and_hessians[i] = gradients_and_hessians[data_indices[i]];
+    }
+    share_state->ConstructLeafOrderedHistograms<USE_QUANT_GRAD, HIST_BITS>(
+        leaf_begin, num_data, ordered_gradients, nullptr, hist_data);
+  } else {
+#pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static, 512) if (num_data >= 1024)
+    for (data_size_t i = 0; i < num_data; ++i) {
+      ordered_gradients[leaf_begin + i] = gradients[data_indices[i]];
+      ordered_hessians[leaf_begin + i] = hessians[data_indices[i]];
+    }
+    share_state->ConstructLeafOrderedHistograms<USE_QUANT_GRAD, HIST_BITS>(
+        leaf_begin, num_data, ordered_gradients, ordered_hessians, hist_data);
   }
-  std::vector<int> used_dense_group;
+}
+
+int Dataset::GetUsedGroups(const std::vector<int8_t>& is_feature_used,
+                           std::vector<int>* used_dense_group) const {
   int multi_val_groud_id = -1;
-  used_dense_group.reserve(num_groups_);
+  used_dense_group->reserve(num_groups_);
   for (int group = 0; group < num_groups_; ++group) {
     const int f_start = group_feature_start_[group];
     const int f_cnt = group_feature_cnt_[group];
@@ -1286,10 +1310,31 @@ void Dataset::ConstructHistogramsInner(
       if (feature_groups_[group]->is_multi_val_) {
         multi_val_groud_id = group;
       } else {
-        used_dense_group.push_back(group);
+        used_dense_group->push_back(group);
       }
     }
   }
+  return multi_val_groud_id;
+}
+
+template <bool USE_INDICES, bool USE_HESSIAN, bool USE_QUANT_GRAD, int HIST_BITS>
+void Dataset::ConstructHistogramsInner(
+    const std::vector<int8_t>& is_feature_used, const data_size_t* data_indices,
+    data_size_t num_data, const score_t* gradients, const score_t* hessians,
+    score_t* ordered_gradients, score_t* ordered_hessians,
+    TrainingShareStates* share_state, hist_t* hist_data) const {
+  if (!share_state->is_col_wise) {
+    const data_size_t leaf_begin = USE_INDICES ? share_state->LeafOrderedBegin(data_indices, num_data) : -1;
+    if (leaf_begin >= 0) {
+      return ConstructHistogramsLeafOrdered<USE_QUANT_GRAD, HIST_BITS>(
+          data_indices, leaf_begin, num_data, gradients, hessians, ordered_gradients, ordered_hessians,
+          share_state, hist_data);
+    }
+    return ConstructHistogramsMultiVal<USE_INDICES, false, USE_QUANT_GRAD, HIST_BITS>(
+        data_indices, num_data, gradients, hessians, share_state, hist_data);
+  }
+  std::vector<int> used_dense_group;
+  const int multi_val_groud_id = GetUsedGroups(is_feature_used, &used_dense_group);
   int num_used_dense_group = static_cast<int>(used_dense_group.size());
   global_timer.Start("Dataset::dense_bin_histogram");
   auto ptr_ordered_grad = gradients;
@@ -1485,6 +1530,144 @@ template void Dataset::ConstructHistogramsInner<false, true, true, 32>(CONSTRUCT
 
 template void Dataset::ConstructHistogramsInner<false, false, true, 32>(CONSTRUCT_HISTOGRAMS_INNER_PARMA) const;
 
+void Dataset::ConstructHistogramsMultiLeaf(const std::vector<int8_t>& is_feature_used,
+                                           const data_size_t* data_indices, const int* leaf_slots,
+                                           data_size_t num_data,
+                                           const std::vector<const data_size_t*>& leaf_data_indices,
+                                           const std::vector<data_size_t>& leaf_num_data,
+                                           const score_t* gradients, const score_t* hessians,
+                                           score_t* ordered_gradients, score_t* ordered_hessians,
+                                           TrainingShareStates* share_state,
+                                           const std::vector<hist_t*>& hist_data) const {
+  Common::FunctionTimer fun_time("Dataset::ConstructHistogramsMultiLeaf", global_timer);
+  const int num_slots = static_cast<int>(hist_data.size());
+  if (num_data <= 0 || num_slots == 0) {
+    return;
+  }
+  if (!share_state->is_col_wise) {
+    // row-wise histograms have no pass per feature group to share
+    for (int slot = 0; slot < num_slots; ++slot) {
+      ConstructHistograms<false, 0>(is_feature_used, leaf_data_indices[slot], leaf_num_data[slot],
+                                    gradients, hessians, ordered_gradients, ordered_hessians,
+                                    share_state, hist_data[slot]);
+    }
+    return;
+  }
+  std::vector<int> used_dense_group;
+  const int multi_val_groud_id = GetUsedGroups(is_feature_used, &used_dense_group);
+  const int num_used_dense_group = static_cast<int>(used_dense_group.size());
+  const bool use_hessian = !share_state->is_constant_hessian;
+  if (num_used_dense_group > 0) {
+    global_timer.Start("Dataset::dense_bin_histogram");
+#pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static, 512) if (num_data >= 1024)
+    for (data_size_t i = 0; i < num_data; ++i) {
+      ordered_gradients[i] = gradients[data_indices[i]];
+      if (use_hessian) {
+        ordered_hessians[i] = hessians[data_indices[i]];
+      }
+    }
+    OMP_INIT_EX();
+#pragma omp parallel for schedule(static) num_threads(share_state->num_threads)
+    for (int gi = 0; gi < num_used_dense_group; ++gi) {
+      OMP_LOOP_EX_BEGIN();
+      const int group = used_dense_group[gi];
+      const int num_bin = feature_groups_[group]->num_total_bin_;
+      std::vector<hist_t*> group_hist_data(num_slots);
+      for (int slot = 0; slot < num_slots; ++slot) {
+        group_hist_data[slot] = hist_data[slot] + group_bin_boundaries_[group] * 2;
+        std::memset(reinterpret_cast<void*>(group_hist_data[slot]), 0,
+                    num_bin * kHistEntrySize);
+      }
+      feature_groups_[group]->bin_data_->ConstructHistogramMultiLeaf(
+          data_indices, 0, num_data, leaf_slots, ordered_gradients,
+          use_hessian ? ordered_hessians : nullptr, group_hist_data.data());
+      if (!use_hessian) {
+        for (int slot = 0; slot < num_slots; ++slot) {
+          hist_t* data_ptr = group_hist_data[slot];
+          auto cnt_dst = reinterpret_cast<hist_cnt_t*>(data_ptr + 1);
+          for (int i = 0; i < num_bin * 2; i += 2) {
+            data_ptr[i + 1] = static_cast<double>(cnt_dst[i]) * hessians[0];
+          }
+        }
+      }
+      OMP_LOOP_EX_END();
+    }
+    OMP_THROW_EX();
+    global_timer.Stop("Dataset::dense_bin_histogram");
+  }
+  if (multi_val_groud_id >= 0) {
+    // the multi-value bin is constructed row-wise, one leaf after the other
+    for (int slot = 0; slot < num_slots; ++slot) {
+      ConstructHistogramsMultiVal<true, false, false, 0>(
+          leaf_data_indices[slot], leaf_num_data[slot], gradients, hessians, share_state,
+          hist_data[slot] + group_bin_boundaries_[multi_val_groud_id] * 2);
+    }
+  }
+}
+
+void Dataset::ConstructHistogramsMultiOutput(const std::vector<int8_t>& is_feature_used,
+                                             const data_size_t* data_indices, data_size_t num_data,
+                                             const std::vector<const score_t*>& gradients,
+                                             const std::vector<const score_t*>& hessians,
+                                             TrainingShareStates* share_state,
+                                             hist_t* hist_data) const {
+  Common::FunctionTimer fun_time("Dataset::ConstructHistogramsMultiOutput", global_timer);
+  const int num_outputs = static_cast<int>(gradients.size());
+  const int num_values = num_outputs * 2;
+  if (num_data <= 0 || num_outputs == 0) {
+    return;
+  }
+  // the bins not written by the groups stay zero
+  std::memset(reinterpret_cast<void*>(hist_data), 0,
+              static_cast<size_t>(share_state->num_hist_total_bin()) * num_values * sizeof(hist_t));
+  if (!share_state->is_col_wise) {
+    share_state->ConstructMultiOutputHistograms(data_indices, num_data, gradients, hessians, hist_data);
+    return;
+  }
+  std::vector<int> used_dense_group;
+  const int multi_val_groud_id = GetUsedGroups(is_feature_used, &used_dense_group);
+  const int num_used_dense_group = static_cast<int>(used_dense_group.size());
+  if (num_used_dense_group > 0) {
+    global_timer.Start("Dataset::dense_bin_histogram");
+    // the gradients are interleaved by chunks of rows, so they are not copied all at once,
+    // and the chunks are accumulated in order, so each histogram sums its data in the same order
+    const data_size_t chunk_size = std::max<data_size_t>(1024, (1 << 20) / num_values);
+    std::vector<score_t> ordered_gradients_and_hessians(
+        static_cast<size_t>(std::min(chunk_size, num_data)) * num_values);
+    for (data_size_t chunk_start = 0; chunk_start < num_data; chunk_start += chunk_size) {
+      const data_size_t chunk_end = std::min(chunk_start + chunk_size, num_data);
+      int n_block = 1;
+      data_size_t block_size = chunk_end - chunk_start;
+      Threading::BlockInfo<data_size_t>(chunk_end - chunk_start, 512, &n_block, &block_size);
+#pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static, 1)
+      for (int t = 0; t < n_block; ++t) {
+        const data_size_t start = chunk_start + t * block_size;
+        const data_size_t end = std::min(start + block_size, chunk_end);
+        InterleaveGradientsAndHessians(
+            data_indices, start, end, gradients, hessians,
+            ordered_gradients_and_hessians.data() + static_cast<size_t>(start - chunk_start) * num_values);
+      }
+      OMP_INIT_EX();
+#pragma omp parallel for schedule(static) num_threads(share_state->num_threads)
+      for (int gi = 0; gi < num_used_dense_group; ++gi) {
+        OMP_LOOP_EX_BEGIN();
+        const int group = used_dense_group[gi];
+        feature_groups_[group]->bin_data_->ConstructHistogramMultiOutput(
+            data_indices, chunk_start, chunk_end, num_outputs, ordered_gradients_and_hessians.data(),
+            hist_data + static_cast<size_t>(group_bin_boundaries_[group]) * num_values);
+        OMP_LOOP_EX_END();
+      }
+      OMP_THROW_EX();
+    }
+    global_timer.Stop("Dataset::dense_bin_histogram");
+  }
+  if (multi_val_groud_id >= 0) {
+    share_state->ConstructMultiOutputHistograms(
+        data_indices, num_data, gradients, hessians,
+        hist_data + static_cast<size_t>(group_bin_boundaries_[multi_val_groud_id]) * num_values);
+  }
+}
+
 void Dataset::FixHistogram(int feature_idx, double sum_gradient,
                            double sum_hessian, hist_t* data) const {
   const int group = feature2group_[feature_idx];
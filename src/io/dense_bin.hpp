@@ -13,6 +13,8 @@
 #include <cstring>
 #include <vector>
 
+#include "histogram_kernels.hpp"
+
 namespace LightGBM {
 
 template <typename VAL_T, bool IS_4BIT>
@@ -101,6 +103,14 @@ class DenseBin : public Bin {
                                const score_t* ordered_gradients,
                                const score_t* ordered_hessians,
                                hist_t* out) const {
+#ifdef LGBM_HISTOGRAM_KERNELS
+    if (sizeof(VAL_T) == 1 && HistogramKernels::IsSupported()) {
+      HistogramKernels::ConstructDense<USE_INDICES, USE_HESSIAN, IS_4BIT>(
+          reinterpret_cast<const uint8_t*>(data_.data()), data_indices, start, end,
+          ordered_gradients, ordered_hessians, out);
+      return;
+    }
+#endif
     data_size_t i = start;
     hist_t* grad = out;
     hist_t* hess = out + 1;
@@ -176,6 +186,13 @@ class DenseBin : public Bin {
                                data_size_t start, data_size_t end,
                                const score_t* ordered_gradients,
                                hist_t* out) const {
+#ifdef LGBM_HISTOGRAM_KERNELS
+    if (sizeof(VAL_T) == 1 && HistogramKernels::IsSupported()) {
+      HistogramKernels::ConstructDenseInt<USE_INDICES, USE_HESSIAN, IS_4BIT, PACKED_HIST_T, HIST_BITS>(
+          reinterpret_cast<const uint8_t*>(data_.data()), data_indices, start, end, ordered_gradients, out);
+      return;
+    }
+#endif
     data_size_t i = start;
     PACKED_HIST_T* out_ptr = reinterpret_cast<PACKED_HIST_T*>(out);
     const int16_t* gradients_ptr = reinterpret_cast<const int16_t*>(ordered_gradients);
@@ -311,6 +328,101 @@ class DenseBin : public Bin {
         nullptr, start, end, ordered_gradients, out);
   }
 
+  template <bool USE_HESSIAN>
+  void ConstructHistogramMultiLeafInner(const data_size_t* data_indices,
+                                        data_size_t start, data_size_t end,
+                                        const int* leaf_slots,
+                                        const score_t* ordered_gradients,
+                                        const score_t* ordered_hessians,
+                                        hist_t* const* out) const {
+    data_size_t i = start;
+    const data_size_t pf_offset = 64 / sizeof(VAL_T);
+    const data_size_t pf_end = end - pf_offset;
+    for (; i < end; ++i) {
+      const auto idx = data_indices[i];
+      if (i < pf_end) {
+        const auto pf_idx = data_indices[i + pf_offset];
+        if (IS_4BIT) {
+          PREFETCH_T0(data_.data() + (pf_idx >> 1));
+        } else {
+          PREFETCH_T0(data_.data() + pf_idx);
+        }
+      }
+      hist_t* grad = out[leaf_slots[i]];
+      const auto ti = static_cast<uint32_t>(data(idx)) << 1;
+      grad[ti] += ordered_gradients[i];
+      if (USE_HESSIAN) {
+        grad[ti + 1] += ordered_hessians[i];
+      } else {
+        ++reinterpret_cast<hist_cnt_t*>(grad + 1)[ti];
+      }
+    }
+  }
+
+  void ConstructHistogramMultiLeaf(const data_size_t* data_indices,
+                                   data_size_t start, data_size_t end,
+                                   const int* leaf_slots,
+                                   const score_t* ordered_gradients,
+                                   const score_t* ordered_hessians,
+                                   hist_t* const* out) const override {
+    if (ordered_hessians != nullptr) {
+      ConstructHistogramMultiLeafInner<true>(data_indices, start, end, leaf_slots,
+                                             ordered_gradients, ordered_hessians, out);
+    } else {
+      ConstructHistogramMultiLeafInner<false>(data_indices, start, end, leaf_slots,
+                                              ordered_gradients, nullptr, out);
+    }
+  }
+
+  template <bool USE_INDICES>
+  void ConstructHistogramMultiOutputInner(const data_size_t* data_indices,
+                                          data_size_t start, data_size_t end,
+                                          int num_outputs,
+                                          const score_t* ordered_gradients_and_hessians,
+                                          hist_t* out) const {
+    const int num_values = num_outputs * 2;
+    data_size_t i = start;
+    if (USE_INDICES) {
+      const data_size_t pf_offset = 64 / sizeof(VAL_T);
+      const data_size_t pf_end = end - pf_offset;
+      for (; i < pf_end; ++i) {
+        const auto pf_idx = data_indices[i + pf_offset];
+        if (IS_4BIT) {
+          PREFETCH_T0(data_.data() + (pf_idx >> 1));
+        } else {
+          PREFETCH_T0(data_.data() + pf_idx);
+        }
+        hist_t* bin_hist = out + static_cast<size_t>(data(data_indices[i])) * num_values;
+        const score_t* gh = ordered_gradients_and_hessians + static_cast<size_t>(i - start) * num_values;
+        for (int j = 0; j < num_values; ++j) {
+          bin_hist[j] += gh[j];
+        }
+      }
+    }
+    for (; i < end; ++i) {
+      const auto idx = USE_INDICES ? data_indices[i] : i;
+      hist_t* bin_hist = out + static_cast<size_t>(data(idx)) * num_values;
+      const score_t* gh = ordered_gradients_and_hessians + static_cast<size_t>(i - start) * num_values;
+      for (int j = 0; j < num_values; ++j) {
+        bin_hist[j] += gh[j];
+      }
+    }
+  }
+
+  void ConstructHistogramMultiOutput(const data_size_t* data_indices,
+                                     data_size_t start, data_size_t end,
+                                     int num_outputs,
+                                     const score_t* ordered_gradients_and_hessians,
+                                     hist_t* out) const override {
+    if (data_indices != nullptr) {
+      ConstructHistogramMultiOutputInner<true>(data_indices, start, end, num_outputs,
+                                               ordered_gradients_and_hessians, out);
+    } else {
+      ConstructHistogramMultiOutputInner<false>(nullptr, start, end, num_outputs,
+                                                ordered_gradients_and_hessians, out);
+    }
+  }
+
   template <bool MISS_IS_ZERO, bool MISS_IS_NA, bool MFB_IS_ZERO,
             bool MFB_IS_NA, bool USE_MIN_BIN>
   data_size_t SplitInner(uint32_t min_bin, uint32_t max_bin,
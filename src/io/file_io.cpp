@@ -11,6 +11,18 @@
 #include <sstream>
 #include <unordered_map>
 
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace LightGBM {
 
 struct LocalFile : VirtualFileReader, VirtualFileWriter {
@@ -67,4 +79,94 @@ bool VirtualFileWriter::Exists(const std::string& filename) {
   return file.Exists();
 }
 
+#ifdef _WIN32
+struct LocalMappedFile : MappedFile {
+  ~LocalMappedFile() {
+    if (data_ != nullptr) {
+      UnmapViewOfFile(data_);
+    }
+    if (mapping_ != NULL) {
+      CloseHandle(mapping_);
+    }
+    if (file_ != INVALID_HANDLE_VALUE) {
+      CloseHandle(file_);
+    }
+  }
+
+  bool Init(const std::string& filename) {
+    file_ = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file_ == INVALID_HANDLE_VALUE) {
+      return false;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_, &file_size) || file_size.QuadPart <= 0) {
+      return false;
+    }
+    size_ = static_cast<size_t>(file_size.QuadPart);
+    mapping_ = CreateFileMappingA(file_, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping_ == NULL) {
+      return false;
+    }
+    data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    return data_ != nullptr;
+  }
+
+  const char* data() const { return data_; }
+
+  size_t size() const { return size_; }
+
+ private:
+  HANDLE file_ = INVALID_HANDLE_VALUE;
+  HANDLE mapping_ = NULL;
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+};
+#else
+struct LocalMappedFile : MappedFile {
+  ~LocalMappedFile() {
+    if (data_ != nullptr) {
+      munmap(const_cast<char*>(data_), size_);
+    }
+  }
+
+  bool Init(const std::string& filename) {
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+      close(fd);
+      return false;
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+    void* addr = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    // the mapping stays valid once the descriptor is closed
+    close(fd);
+    if (addr == MAP_FAILED) {
+      return false;
+    }
+    data_ = static_cast<const char*>(addr);
+    return true;
+  }
+
+  const char* data() const { return data_; }
+
+  size_t size() const { return size_; }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+};
+#endif  // _WIN32
+
+std::unique_ptr<MappedFile> MappedFile::Make(const std::string& filename) {
+  std::unique_ptr<LocalMappedFile> file(new LocalMappedFile());
+  if (!file->Init(filename)) {
+    return nullptr;
+  }
+  return std::unique_ptr<MappedFile>(file.release());
+}
+
 }  // namespace LightGBM
@@ -0,0 +1,308 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+// the intrinsics come first, common.h defines _mm_malloc as a macro when MM_MALLOC is not available
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#include "histogram_kernels.hpp"
+
+#ifdef LGBM_HISTOGRAM_KERNELS
+
+#include <cstring>
+
+// the kernels are compiled for AVX2 whatever the flags of the build, they run only when the CPU supports it
+#if defined(__GNUC__) || defined(__clang__)
+#define LGBM_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define LGBM_TARGET_AVX2
+#endif
+
+namespace LightGBM {
+
+bool HistogramKernels::IsSupported() {
+  static const bool is_supported = [] {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+      return false;
+    }
+    __cpuid(info, 1);
+    // the OS must save the AVX registers
+    const bool has_osxsave = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0;
+    if (!has_osxsave || (_xgetbv(0) & 6) != 6) {
+      return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+  }();
+  return is_supported;
+}
+
+namespace {
+
+template <bool IS_4BIT>
+inline uint32_t GetBin(const uint8_t* data, data_size_t idx) {
+  if (IS_4BIT) {
+    return (data[idx >> 1] >> ((idx & 1) << 2)) & 0xf;
+  } else {
+    return data[idx];
+  }
+}
+
+template <bool IS_4BIT>
+inline void PrefetchBin(const uint8_t* data, data_size_t idx) {
+  PREFETCH_T0(data + (IS_4BIT ? (idx >> 1) : idx));
+}
+
+template <typename PACKED_HIST_T, int HIST_BITS, bool USE_HESSIAN>
+inline PACKED_HIST_T PackGradient(int16_t gradient_16) {
+  if (HIST_BITS == 8) {
+    return gradient_16;
+  } else {
+    return (static_cast<PACKED_HIST_T>(static_cast<int8_t>(gradient_16 >> 8)) << HIST_BITS) |
+           (USE_HESSIAN ? static_cast<PACKED_HIST_T>(gradient_16 & 0xff) : 1);
+  }
+}
+
+/*! \brief Adds a (gradient, hessian) pair to a bin with a single load and store */
+LGBM_TARGET_AVX2 inline void AddPair(hist_t* bin, __m128d gradient_and_hessian) {
+  _mm_storeu_pd(bin, _mm_add_pd(_mm_loadu_pd(bin), gradient_and_hessian));
+}
+
+// the private histograms of the quantized kernels are not worth clearing and merging for fewer rows
+const data_size_t kMinDataForPrivateHistograms = 1024;
+
+}  // namespace
+
+template <bool USE_INDICES, bool USE_HESSIAN, bool IS_4BIT>
+LGBM_TARGET_AVX2 void HistogramKernels::ConstructDense(const uint8_t* data, const data_size_t* data_indices,
+                                                       data_size_t start, data_size_t end,
+                                                       const score_t* ordered_gradients,
+                                                       const score_t* ordered_hessians, hist_t* out) {
+  const int num_bin = IS_4BIT ? 16 : 256;
+  const data_size_t pf_offset = 64;
+  // with constant hessians the counts go to four private histograms, merged at the end, so that consecutive
+  // rows of the same bin do not wait on each other's counts, the counts do not depend on the order
+  hist_cnt_t private_cnts[4][num_bin];
+  if (!USE_HESSIAN) {
+    std::memset(private_cnts, 0, sizeof(private_cnts));
+  }
+  data_size_t i = start;
+  // four rows at a time: their gradients (and hessians) are converted together, each row then adds a
+  // (gradient, hessian) pair to its bin, in the order of the rows
+  for (; i + 4 <= end; i += 4) {
+    uint32_t bins[4];
+    for (int k = 0; k < 4; ++k) {
+      const data_size_t idx = USE_INDICES ? data_indices[i + k] : i + k;
+      if (USE_INDICES && i + k + pf_offset < end) {
+        PrefetchBin<IS_4BIT>(data, data_indices[i + k + pf_offset]);
+      }
+      bins[k] = GetBin<IS_4BIT>(data, idx);
+    }
+    if (USE_HESSIAN) {
+      const __m256d gradients = _mm256_cvtps_pd(_mm_loadu_ps(ordered_gradients + i));
+      const __m256d hessians = _mm256_cvtps_pd(_mm_loadu_ps(ordered_hessians + i));
+      const __m256d pairs_02 = _mm256_unpacklo_pd(gradients, hessians);
+      const __m256d pairs_13 = _mm256_unpackhi_pd(gradients, hessians);
+      AddPair(out + (bins[0] << 1), _mm256_castpd256_pd128(pairs_02));
+      AddPair(out + (bins[1] << 1), _mm256_castpd256_pd128(pairs_13));
+      AddPair(out + (bins[2] << 1), _mm256_extractf128_pd(pairs_02, 1));
+      AddPair(out + (bins[3] << 1), _mm256_extractf128_pd(pairs_13, 1));
+    } else {
+      for (int k = 0; k < 4; ++k) {
+        out[bins[k] << 1] += ordered_gradients[i + k];
+        ++private_cnts[k][bins[k]];
+      }
+    }
+  }
+  for (; i < end; ++i) {
+    const data_size_t idx = USE_INDICES ? data_indices[i] : i;
+    const uint32_t bin = GetBin<IS_4BIT>(data, idx);
+    if (USE_HESSIAN) {
+      AddPair(out + (bin << 1), _mm_set_pd(ordered_hessians[i], ordered_gradients[i]));
+    } else {
+      out[bin << 1] += ordered_gradients[i];
+      ++private_cnts[0][bin];
+    }
+  }
+  if (!USE_HESSIAN) {
+    // only the bins of the feature group are in its histogram
+    hist_cnt_t* out_cnt = reinterpret_cast<hist_cnt_t*>(out);
+    for (int bin = 0; bin < num_bin; ++bin) {
+      const hist_cnt_t cnt = private_cnts[0][bin] + private_cnts[1][bin] + private_cnts[2][bin] + private_cnts[3][bin];
+      if (cnt != 0) {
+        out_cnt[(bin << 1) + 1] += cnt;
+      }
+    }
+  }
+}
+
+template <bool USE_INDICES, bool USE_HESSIAN, bool IS_4BIT, typename PACKED_HIST_T, int HIST_BITS>
+LGBM_TARGET_AVX2 void HistogramKernels::ConstructDenseInt(const uint8_t* data, const data_size_t* data_indices,
+                                                          data_size_t start, data_size_t end,
+                                                          const score_t* ordered_gradients, hist_t* out) {
+  const int num_bin = IS_4BIT ? 16 : 256;
+  const data_size_t pf_offset = 64;
+  PACKED_HIST_T* out_ptr = reinterpret_cast<PACKED_HIST_T*>(out);
+  const int16_t* gradients_ptr = reinterpret_cast<const int16_t*>(ordered_gradients);
+  data_size_t i = start;
+  if (end - start >= kMinDataForPrivateHistograms) {
+    // consecutive rows of the same bin wait on each other's sums, the rows are spread over four private
+    // histograms to break these dependencies, the integer sums do not depend on the order
+    PACKED_HIST_T private_hists[4][num_bin];
+    std::memset(private_hists, 0, sizeof(private_hists));
+    for (; i + 4 <= end; i += 4) {
+      for (int k = 0; k < 4; ++k) {
+        const data_size_t idx = USE_INDICES ? data_indices[i + k] : i + k;
+        if (USE_INDICES && i + k + pf_offset < end) {
+          PrefetchBin<IS_4BIT>(data, data_indices[i + k + pf_offset]);
+        }
+        const uint32_t bin = GetBin<IS_4BIT>(data, idx);
+        private_hists[k][bin] += PackGradient<PACKED_HIST_T, HIST_BITS, USE_HESSIAN>(gradients_ptr[i + k]);
+      }
+    }
+    // only the bins of the feature group are in its histogram
+    for (int bin = 0; bin < num_bin; ++bin) {
+      const PACKED_HIST_T sum = private_hists[0][bin] + private_hists[1][bin] + private_hists[2][bin] + private_hists[3][bin];
+      if (sum != 0) {
+        out_ptr[bin] += sum;
+      }
+    }
+  }
+  for (; i < end; ++i) {
+    const data_size_t idx = USE_INDICES ? data_indices[i] : i;
+    out_ptr[GetBin<IS_4BIT>(data, idx)] += PackGradient<PACKED_HIST_T, HIST_BITS, USE_HESSIAN>(gradients_ptr[i]);
+  }
+}
+
+template <bool USE_INDICES, bool ORDERED>
+LGBM_TARGET_AVX2 void HistogramKernels::ConstructMultiValDense(const uint8_t* data, int num_feature,
+                                                               const uint32_t* offsets,
+                                                               const data_size_t* data_indices,
+                                                               data_size_t start, data_size_t end,
+                                                               const score_t* gradients, const score_t* hessians,
+                                                               hist_t* out) {
+  const data_size_t pf_offset = 32;
+  alignas(32) uint32_t bins[8];
+  for (data_size_t i = start; i < end; ++i) {
+    const data_size_t idx = USE_INDICES ? data_indices[i] : i;
+    if (USE_INDICES && i + pf_offset < end) {
+      const data_size_t pf_idx = data_indices[i + pf_offset];
+      if (!ORDERED) {
+        PREFETCH_T0(gradients + pf_idx);
+        PREFETCH_T0(hessians + pf_idx);
+      }
+      PREFETCH_T0(data + static_cast<size_t>(pf_idx) * num_feature);
+    }
+    const uint8_t* row = data + static_cast<size_t>(idx) * num_feature;
+    const data_size_t score_idx = ORDERED ? i : idx;
+    const __m128d gradient_and_hessian = _mm_set_pd(hessians[score_idx], gradients[score_idx]);
+    int j = 0;
+    // the histogram positions of eight features at a time
+    for (; j + 8 <= num_feature; j += 8) {
+      const __m256i row_bins = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + j)));
+      const __m256i feature_offsets = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets + j));
+      _mm256_store_si256(reinterpret_cast<__m256i*>(bins),
+                         _mm256_slli_epi32(_mm256_add_epi32(row_bins, feature_offsets), 1));
+      for (int k = 0; k < 8; ++k) {
+        AddPair(out + bins[k], gradient_and_hessian);
+      }
+    }
+    for (; j < num_feature; ++j) {
+      AddPair(out + ((row[j] + offsets[j]) << 1), gradient_and_hessian);
+    }
+  }
+}
+
+template <bool USE_INDICES, typename PACKED_HIST_T, int HIST_BITS>
+LGBM_TARGET_AVX2 void HistogramKernels::ConstructMultiValDenseInt(const uint8_t* data, int num_feature,
+                                                                  const uint32_t* offsets,
+                                                                  const data_size_t* data_indices,
+                                                                  data_size_t start, data_size_t end,
+                                                                  const score_t* gradients_and_hessians,
+                                                                  hist_t* out) {
+  const data_size_t pf_offset = 32;
+  PACKED_HIST_T* out_ptr = reinterpret_cast<PACKED_HIST_T*>(out);
+  const int16_t* gradients_ptr = reinterpret_cast<const int16_t*>(gradients_and_hessians);
+  alignas(32) uint32_t bins[8];
+  for (data_size_t i = start; i < end; ++i) {
+    const data_size_t idx = USE_INDICES ? data_indices[i] : i;
+    if (USE_INDICES && i + pf_offset < end) {
+      const data_size_t pf_idx = data_indices[i + pf_offset];
+      PREFETCH_T0(gradients_ptr + pf_idx);
+      PREFETCH_T0(data + static_cast<size_t>(pf_idx) * num_feature);
+    }
+    const uint8_t* row = data + static_cast<size_t>(idx) * num_feature;
+    const PACKED_HIST_T gradient_packed = PackGradient<PACKED_HIST_T, HIST_BITS, true>(gradients_ptr[idx]);
+    int j = 0;
+    for (; j + 8 <= num_feature; j += 8) {
+      const __m256i row_bins = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + j)));
+      const __m256i feature_offsets = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets + j));
+      _mm256_store_si256(reinterpret_cast<__m256i*>(bins), _mm256_add_epi32(row_bins, feature_offsets));
+      for (int k = 0; k < 8; ++k) {
+        out_ptr[bins[k]] += gradient_packed;
+      }
+    }
+    for (; j < num_feature; ++j) {
+      out_ptr[row[j] + offsets[j]] += gradient_packed;
+    }
+  }
+}
+
+// explicitly initialize template methods, for cross module call
+#define DENSE_PARAMS \
+  const uint8_t* data, const data_size_t* data_indices, data_size_t start, data_size_t end, \
+  const score_t* ordered_gradients, const score_t* ordered_hessians, hist_t* out
+
+#define DENSE_INT_PARAMS \
+  const uint8_t* data, const data_size_t* data_indices, data_size_t start, data_size_t end, \
+  const score_t* ordered_gradients, hist_t* out
+
+#define MULTI_VAL_DENSE_PARAMS \
+  const uint8_t* data, int num_feature, const uint32_t* offsets, const data_size_t* data_indices, \
+  data_size_t start, data_size_t end, const score_t* gradients, const score_t* hessians, hist_t* out
+
+#define MULTI_VAL_DENSE_INT_PARAMS \
+  const uint8_t* data, int num_feature, const uint32_t* offsets, const data_size_t* data_indices, \
+  data_size_t start, data_size_t end, const score_t* gradients_and_hessians, hist_t* out
+
+#define INSTANTIATE_DENSE(USE_INDICES, USE_HESSIAN) \
+  template void HistogramKernels::ConstructDense<USE_INDICES, USE_HESSIAN, false>(DENSE_PARAMS); \
+  template void HistogramKernels::ConstructDense<USE_INDICES, USE_HESSIAN, true>(DENSE_PARAMS); \
+  template void HistogramKernels::ConstructDenseInt<USE_INDICES, USE_HESSIAN, false, int16_t, 8>(DENSE_INT_PARAMS); \
+  template void HistogramKernels::ConstructDenseInt<USE_INDICES, USE_HESSIAN, true, int16_t, 8>(DENSE_INT_PARAMS); \
+  template void HistogramKernels::ConstructDenseInt<USE_INDICES, USE_HESSIAN, false, int32_t, 16>(DENSE_INT_PARAMS); \
+  template void HistogramKernels::ConstructDenseInt<USE_INDICES, USE_HESSIAN, true, int32_t, 16>(DENSE_INT_PARAMS); \
+  template void HistogramKernels::ConstructDenseInt<USE_INDICES, USE_HESSIAN, false, int64_t, 32>(DENSE_INT_PARAMS); \
+  template void HistogramKernels::ConstructDenseInt<USE_INDICES, USE_HESSIAN, true, int64_t, 32>(DENSE_INT_PARAMS);
+
+INSTANTIATE_DENSE(true, true)
+INSTANTIATE_DENSE(true, false)
+INSTANTIATE_DENSE(false, true)
+INSTANTIATE_DENSE(false, false)
+
+template void HistogramKernels::ConstructMultiValDense<true, true>(MULTI_VAL_DENSE_PARAMS);
+template void HistogramKernels::ConstructMultiValDense<true, false>(MULTI_VAL_DENSE_PARAMS);
+template void HistogramKernels::ConstructMultiValDense<false, false>(MULTI_VAL_DENSE_PARAMS);
+
+template void HistogramKernels::ConstructMultiValDenseInt<true, int16_t, 8>(MULTI_VAL_DENSE_INT_PARAMS);
+template void HistogramKernels::ConstructMultiValDenseInt<false, int16_t, 8>(MULTI_VAL_DENSE_INT_PARAMS);
+template void HistogramKernels::ConstructMultiValDenseInt<true, int32_t, 16>(MULTI_VAL_DENSE_INT_PARAMS);
+template void HistogramKernels::ConstructMultiValDenseInt<false, int32_t, 16>(MULTI_VAL_DENSE_INT_PARAMS);
+template void HistogramKernels::ConstructMultiValDenseInt<true, int64_t, 32>(MULTI_VAL_DENSE_INT_PARAMS);
+template void HistogramKernels::ConstructMultiValDenseInt<false, int64_t, 32>(MULTI_VAL_DENSE_INT_PARAMS);
+
+}  // namespace LightGBM
+
+#endif  // LGBM_HISTOGRAM_KERNELS
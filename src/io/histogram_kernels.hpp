@@ -0,0 +1,67 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#ifndef LIGHTGBM_IO_HISTOGRAM_KERNELS_HPP_
+#define LIGHTGBM_IO_HISTOGRAM_KERNELS_HPP_
+
+#include <LightGBM/bin.h>
+#include <LightGBM/meta.h>
+
+#include <cstdint>
+
+// the kernels are compiled for x86 CPUs, and for float gradients only
+#if (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)) && !defined(SCORE_T_USE_DOUBLE)
+#define LGBM_HISTOGRAM_KERNELS
+#endif
+
+namespace LightGBM {
+
+#ifdef LGBM_HISTOGRAM_KERNELS
+
+/*!
+ * \brief Histogram construction of 8-bit and 4-bit bins with AVX2 instructions, used in place of the
+ *        scalar loops of the dense bins when the CPU supports them.
+ *        The rows are accumulated in the same order as by the scalar loops, so the histograms, and the
+ *        models, do not depend on the CPU.
+ */
+class HistogramKernels {
+ public:
+  /*! \brief Whether the CPU (and the OS) supports AVX2, detected once */
+  static bool IsSupported();
+
+  /*!
+  * \brief Histogram of one feature group with a bin per row, as DenseBin::ConstructHistogramInner
+  * \param data Bins, two per byte when IS_4BIT
+  * \param data_indices Rows of the leaf, used when USE_INDICES
+  * \param ordered_hessians Hessians, or counts accumulated when !USE_HESSIAN
+  */
+  template <bool USE_INDICES, bool USE_HESSIAN, bool IS_4BIT>
+  static void ConstructDense(const uint8_t* data, const data_size_t* data_indices, data_size_t start, data_size_t end,
+                             const score_t* ordered_gradients, const score_t* ordered_hessians, hist_t* out);
+
+  /*! \brief Quantized histogram of one feature group, as DenseBin::ConstructHistogramIntInner */
+  template <bool USE_INDICES, bool USE_HESSIAN, bool IS_4BIT, typename PACKED_HIST_T, int HIST_BITS>
+  static void ConstructDenseInt(const uint8_t* data, const data_size_t* data_indices, data_size_t start,
+                                data_size_t end, const score_t* ordered_gradients, hist_t* out);
+
+  /*!
+  * \brief Histogram of the rows of num_feature bins, as MultiValDenseBin::ConstructHistogramInner
+  * \param offsets Offsets of the bins of the features in the histogram
+  */
+  template <bool USE_INDICES, bool ORDERED>
+  static void ConstructMultiValDense(const uint8_t* data, int num_feature, const uint32_t* offsets,
+                                     const data_size_t* data_indices, data_size_t start, data_size_t end,
+                                     const score_t* gradients, const score_t* hessians, hist_t* out);
+
+  /*! \brief Quantized histogram of the rows of num_feature bins, as MultiValDenseBin::ConstructHistogramIntInner */
+  template <bool USE_INDICES, typename PACKED_HIST_T, int HIST_BITS>
+  static void ConstructMultiValDenseInt(const uint8_t* data, int num_feature, const uint32_t* offsets,
+                                        const data_size_t* data_indices, data_size_t start, data_size_t end,
+                                        const score_t* gradients_and_hessians, hist_t* out);
+};
+
+#endif  // LGBM_HISTOGRAM_KERNELS
+
+}  // namespace LightGBM
+#endif   // LIGHTGBM_IO_HISTOGRAM_KERNELS_HPP_
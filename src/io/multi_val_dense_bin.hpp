@@ -14,6 +14,8 @@
 #include <cstring>
 #include <vector>
 
+#include "histogram_kernels.hpp"
+
 namespace LightGBM {
 
 template <typename VAL_T>
@@ -58,6 +60,14 @@ class MultiValDenseBin : public MultiValBin {
   template<bool USE_INDICES, bool USE_PREFETCH, bool ORDERED>
   void ConstructHistogramInner(const data_size_t* data_indices, data_size_t start, data_size_t end,
     const score_t* gradients, const score_t* hessians, hist_t* out) const {
+#ifdef LGBM_HISTOGRAM_KERNELS
+    if (sizeof(VAL_T) == 1 && HistogramKernels::IsSupported()) {
+      HistogramKernels::ConstructMultiValDense<USE_INDICES, ORDERED>(
+          reinterpret_cast<const uint8_t*>(data_.data()), num_feature_, offsets_.data(), data_indices,
+          start, end, gradients, hessians, out);
+      return;
+    }
+#endif
     data_size_t i = start;
     hist_t* grad = out;
     hist_t* hess = out + 1;
@@ -124,9 +134,37 @@ class MultiValDenseBin : public MultiValBin {
                                               gradients, hessians, out);
   }
 
+  void ConstructHistogramMultiOutput(const data_size_t* data_indices,
+                                     data_size_t start, data_size_t end,
+                                     int num_outputs,
+                                     const score_t* ordered_gradients_and_hessians,
+                                     hist_t* out) const override {
+    const int num_values = num_outputs * 2;
+    for (data_size_t i = start; i < end; ++i) {
+      const auto idx = data_indices != nullptr ? data_indices[i] : i;
+      const VAL_T* data_ptr = data_.data() + RowPtr(idx);
+      const score_t* gh = ordered_gradients_and_hessians + static_cast<size_t>(i - start) * num_values;
+      for (int j = 0; j < num_feature_; ++j) {
+        const uint32_t bin = static_cast<uint32_t>(data_ptr[j]) + offsets_[j];
+        hist_t* bin_hist = out + static_cast<size_t>(bin) * num_values;
+        for (int k = 0; k < num_values; ++k) {
+          bin_hist[k] += gh[k];
+        }
+      }
+    }
+  }
+
   template<bool USE_INDICES, bool USE_PREFETCH, bool ORDERED, typename PACKED_HIST_T, int HIST_BITS>
   void ConstructHistogramIntInner(const data_size_t* data_indices, data_size_t start, data_size_t end,
     const score_t* gradients_and_hessians, hist_t* out) const {
+#ifdef LGBM_HISTOGRAM_KERNELS
+    if (sizeof(VAL_T) == 1 && HistogramKernels::IsSupported()) {
+      HistogramKernels::ConstructMultiValDenseInt<USE_INDICES, PACKED_HIST_T, HIST_BITS>(
+          reinterpret_cast<const uint8_t*>(data_.data()), num_feature_, offsets_.data(), data_indices,
+          start, end, gradients_and_hessians, out);
+      return;
+    }
+#endif
     data_size_t i = start;
     const VAL_T* data_ptr_base = data_.data();
     const int16_t* gradients_and_hessians_ptr = reinterpret_cast<const int16_t*>(gradients_and_hessians);
@@ -322,6 +360,44 @@ class MultiValDenseBin : public MultiValBin {
                           used_feature_index);
   }
 
+  size_t SizesInByte() const override {
+    return sizeof(VAL_T) * static_cast<size_t>(num_data_) * num_feature_;
+  }
+
+  void CopyPartitionedRows(const MultiValBin* other_bin, data_size_t start, data_size_t num_data,
+                           const uint8_t* is_left) override {
+    const auto other = reinterpret_cast<const MultiValDenseBin<VAL_T>*>(other_bin);
+    int n_block = 1;
+    data_size_t block_size = num_data;
+    Threading::BlockInfo<data_size_t>(num_data, 1024, &n_block, &block_size);
+    std::vector<data_size_t> left_offsets(n_block + 1, 0);
+#pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static, 1)
+    for (int tid = 0; tid < n_block; ++tid) {
+      const data_size_t block_start = tid * block_size;
+      const data_size_t block_end = std::min(num_data, block_start + block_size);
+      data_size_t left_cnt = 0;
+      for (data_size_t i = block_start; i < block_end; ++i) {
+        left_cnt += is_left[i];
+      }
+      left_offsets[tid + 1] = left_cnt;
+    }
+    for (int tid = 0; tid < n_block; ++tid) {
+      left_offsets[tid + 1] += left_offsets[tid];
+    }
+#pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static, 1)
+    for (int tid = 0; tid < n_block; ++tid) {
+      const data_size_t block_start = tid * block_size;
+      const data_size_t block_end = std::min(num_data, block_start + block_size);
+      data_size_t left_pos = start + left_offsets[tid];
+      data_size_t right_pos = start + left_offsets[n_block] + block_start - left_offsets[tid];
+      for (data_size_t i = block_start; i < block_end; ++i) {
+        const data_size_t pos = is_left[i] ? left_pos++ : right_pos++;
+        std::memcpy(data_.data() + RowPtr(pos), other->data_.data() + RowPtr(start + i),
+                    sizeof(VAL_T) * num_feature_);
+      }
+    }
+  }
+
   inline size_t RowPtr(data_size_t idx) const {
     return static_cast<size_t>(idx) * num_feature_;
   }
@@ -180,6 +180,27 @@ class MultiValSparseBin : public MultiValBin {
                                               gradients, hessians, out);
   }
 
+  void ConstructHistogramMultiOutput(const data_size_t* data_indices,
+                                     data_size_t start, data_size_t end,
+                                     int num_outputs,
+                                     const score_t* ordered_gradients_and_hessians,
+                                     hist_t* out) const override {
+    const int num_values = num_outputs * 2;
+    const VAL_T* data_ptr = data_.data();
+    for (data_size_t i = start; i < end; ++i) {
+      const auto idx = data_indices != nullptr ? data_indices[i] : i;
+      const auto j_start = RowPtr(idx);
+      const auto j_end = RowPtr(idx + 1);
+      const score_t* gh = ordered_gradients_and_hessians + static_cast<size_t>(i - start) * num_values;
+      for (auto j = j_start; j < j_end; ++j) {
+        hist_t* bin_hist = out + static_cast<size_t>(data_ptr[j]) * num_values;
+        for (int k = 0; k < num_values; ++k) {
+          bin_hist[k] += gh[k];
+        }
+      }
+    }
+  }
+
   template <bool USE_INDICES, bool USE_PREFETCH, bool ORDERED, typename PACKED_HIST_T, int HIST_BITS>
   void ConstructHistogramIntInner(const data_size_t* data_indices,
                                data_size_t start, data_size_t end,
@@ -405,6 +426,68 @@ class MultiValSparseBin : public MultiValBin {
                           upper, delta);
   }
 
+  size_t SizesInByte() const override {
+    return sizeof(VAL_T) * static_cast<size_t>(row_ptr_[num_data_]) +
+           sizeof(INDEX_T) * (static_cast<size_t>(num_data_) + 1);
+  }
+
+  void CopyPartitionedRows(const MultiValBin* other_bin, data_size_t start, data_size_t num_data,
+                           const uint8_t* is_left) override {
+    const auto other = reinterpret_cast<const MultiValSparseBin<INDEX_T, VAL_T>*>(other_bin);
+    if (data_.size() < other->data_.size()) {
+      data_.resize(other->data_.size());
+    }
+    if (row_ptr_.size() < other->row_ptr_.size()) {
+      row_ptr_.resize(other->row_ptr_.size());
+    }
+    int n_block = 1;
+    data_size_t block_size = num_data;
+    Threading::BlockInfo<data_size_t>(num_data, 1024, &n_block, &block_size);
+    std::vector<data_size_t> left_offsets(n_block + 1, 0);
+    std::vector<INDEX_T> left_element_offsets(n_block + 1, 0);
+#pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static, 1)
+    for (int tid = 0; tid < n_block; ++tid) {
+      const data_size_t block_start = tid * block_size;
+      const data_size_t block_end = std::min(num_data, block_start + block_size);
+      data_size_t left_cnt = 0;
+      INDEX_T left_element_cnt = 0;
+      for (data_size_t i = block_start; i < block_end; ++i) {
+        if (is_left[i]) {
+          ++left_cnt;
+          left_element_cnt += other->RowPtr(start + i + 1) - other->RowPtr(start + i);
+        }
+      }
+      left_offsets[tid + 1] = left_cnt;
+      left_element_offsets[tid + 1] = left_element_cnt;
+    }
+    for (int tid = 0; tid < n_block; ++tid) {
+      left_offsets[tid + 1] += left_offsets[tid];
+      left_element_offsets[tid + 1] += left_element_offsets[tid];
+    }
+    // the rows keep the same range of elements
+    const INDEX_T element_start = other->RowPtr(start);
+    row_ptr_[start + num_data] = other->RowPtr(start + num_data);
+#pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static, 1)
+    for (int tid = 0; tid < n_block; ++tid) {
+      const data_size_t block_start = tid * block_size;
+      const data_size_t block_end = std::min(num_data, block_start + block_size);
+      data_size_t left_pos = start + left_offsets[tid];
+      data_size_t right_pos = start + left_offsets[n_block] + block_start - left_offsets[tid];
+      INDEX_T left_element_pos = element_start + left_element_offsets[tid];
+      INDEX_T right_element_pos = element_start + left_element_offsets[n_block] +
+                                  (other->RowPtr(start + block_start) - element_start) - left_element_offsets[tid];
+      for (data_size_t i = block_start; i < block_end; ++i) {
+        const INDEX_T j_start = other->RowPtr(start + i);
+        const INDEX_T row_size = other->RowPtr(start + i + 1) - j_start;
+        data_size_t* pos = is_left[i] ? &left_pos : &right_pos;
+        INDEX_T* element_pos = is_left[i] ? &left_element_pos : &right_element_pos;
+        row_ptr_[(*pos)++] = *element_pos;
+        std::copy_n(other->data_.data() + j_start, row_size, data_.data() + *element_pos);
+        *element_pos += row_size;
+      }
+    }
+  }
+
   inline INDEX_T RowPtr(data_size_t idx) const { return row_ptr_[idx]; }
 
   MultiValSparseBin<INDEX_T, VAL_T>* Clone() override;
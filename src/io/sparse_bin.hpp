@@ -201,6 +201,93 @@ class SparseBin : public Bin {
       cur_pos += deltas_[++i_delta];
     }
   }
+
+  void ConstructHistogramMultiLeaf(const data_size_t* data_indices, data_size_t start,
+                                   data_size_t end, const int* leaf_slots,
+                                   const score_t* ordered_gradients,
+                                   const score_t* ordered_hessians,
+                                   hist_t* const* out) const override {
+    data_size_t i_delta, cur_pos;
+    InitIndex(data_indices[start], &i_delta, &cur_pos);
+    data_size_t i = start;
+    for (;;) {
+      if (cur_pos < data_indices[i]) {
+        cur_pos += deltas_[++i_delta];
+        if (i_delta >= num_vals_) {
+          break;
+        }
+      } else if (cur_pos > data_indices[i]) {
+        if (++i >= end) {
+          break;
+        }
+      } else {
+        hist_t* grad = out[leaf_slots[i]];
+        const uint32_t ti = static_cast<uint32_t>(vals_[i_delta]) << 1;
+        grad[ti] += ordered_gradients[i];
+        if (ordered_hessians != nullptr) {
+          grad[ti + 1] += ordered_hessians[i];
+        } else {
+          ++reinterpret_cast<hist_cnt_t*>(grad + 1)[ti];
+        }
+        if (++i >= end) {
+          break;
+        }
+        cur_pos += deltas_[++i_delta];
+        if (i_delta >= num_vals_) {
+          break;
+        }
+      }
+    }
+  }
+
+  void ConstructHistogramMultiOutput(const data_size_t* data_indices, data_size_t start,
+                                     data_size_t end, int num_outputs,
+                                     const score_t* ordered_gradients_and_hessians,
+                                     hist_t* out) const override {
+    const int num_values = num_outputs * 2;
+    auto acc_gh = [=] (VAL_T bin, data_size_t i) {
+      hist_t* bin_hist = out + static_cast<size_t>(bin) * num_values;
+      const score_t* gh = ordered_gradients_and_hessians + static_cast<size_t>(i - start) * num_values;
+      for (int j = 0; j < num_values; ++j) {
+        bin_hist[j] += gh[j];
+      }
+    };
+    data_size_t i_delta, cur_pos;
+    if (data_indices == nullptr) {
+      InitIndex(start, &i_delta, &cur_pos);
+      while (cur_pos < start && i_delta < num_vals_) {
+        cur_pos += deltas_[++i_delta];
+      }
+      while (cur_pos < end && i_delta < num_vals_) {
+        acc_gh(vals_[i_delta], cur_pos);
+        cur_pos += deltas_[++i_delta];
+      }
+      return;
+    }
+    InitIndex(data_indices[start], &i_delta, &cur_pos);
+    data_size_t i = start;
+    for (;;) {
+      if (cur_pos < data_indices[i]) {
+        cur_pos += deltas_[++i_delta];
+        if (i_delta >= num_vals_) {
+          break;
+        }
+      } else if (cur_pos > data_indices[i]) {
+        if (++i >= end) {
+          break;
+        }
+      } else {
+        acc_gh(vals_[i_delta], i);
+        if (++i >= end) {
+          break;
+        }
+        cur_pos += deltas_[++i_delta];
+        if (i_delta >= num_vals_) {
+          break;
+        }
+      }
+    }
+  }
 #undef ACC_GH
 
   template <bool USE_HESSIAN, typename PACKED_HIST_T, typename GRAD_HIST_T, typename HESS_HIST_T, int HIST_BITS>
@@ -46,6 +46,136 @@ void MultiValBinWrapper::InitTrain(const std::vector<int>& group_feature_start,
   }
 }
 
+bool MultiValBinWrapper::EnableLeafOrdered(double max_memory_mb) {
+  is_leaf_ordered_ = false;
+  if (multi_val_bin_ == nullptr) {
+    return false;
+  }
+  // the two copies, and the data indices, sides and slots of the rows
+  const double memory_mb = (2.0 * multi_val_bin_->SizesInByte() +
+                            (sizeof(data_size_t) + 2 * sizeof(uint8_t)) * static_cast<double>(num_data_)) / 1024 / 1024;
+  if (max_memory_mb >= 0 && memory_mb > max_memory_mb) {
+    Log::Warning("leaf_ordered_bins needs %.1f MB, more than leaf_ordered_bins_max_memory, it is not used", memory_mb);
+    return false;
+  }
+  is_leaf_ordered_ = true;
+  return true;
+}
+
+void MultiValBinWrapper::InitLeafOrdered(const data_size_t* partition_indices, data_size_t num_data) {
+  if (!is_leaf_ordered_) {
+    return;
+  }
+  Common::FunctionTimer fun_timer("MultiValBinWrapper::InitLeafOrdered", global_timer);
+  const auto cur_multi_val_bin = (is_use_subcol_ || is_use_subrow_)
+        ? multi_val_bin_subset_.get()
+        : multi_val_bin_.get();
+  // the number of features is only used by dense bins, which have one element per feature in each row
+  const int num_feature = static_cast<int>(cur_multi_val_bin->num_element_per_row());
+  for (auto& bin : leaf_ordered_bins_) {
+    if (bin == nullptr) {
+      bin.reset(cur_multi_val_bin->CreateLike(
+          num_data, cur_multi_val_bin->num_bin(), num_feature,
+          cur_multi_val_bin->num_element_per_row(), cur_multi_val_bin->offsets()));
+    } else {
+      bin->ReSize(num_data, cur_multi_val_bin->num_bin(), num_feature,
+                  cur_multi_val_bin->num_element_per_row(), cur_multi_val_bin->offsets());
+    }
+  }
+  leaf_ordered_bins_[0]->CopySubrow(cur_multi_val_bin, partition_indices, num_data);
+  leaf_ordered_slots_.assign(num_data, 0);
+  partition_indices_ = partition_indices;
+  leaf_ordered_indices_.assign(partition_indices, partition_indices + num_data);
+}
+
+void MultiValBinWrapper::SplitLeafOrdered(data_size_t begin, data_size_t left_cnt, data_size_t right_cnt) {
+  if (!is_leaf_ordered_ || left_cnt == 0 || right_cnt == 0) {
+    return;
+  }
+  Common::FunctionTimer fun_timer("MultiValBinWrapper::SplitLeafOrdered", global_timer);
+  const data_size_t cnt = left_cnt + right_cnt;
+  const data_size_t* new_indices = partition_indices_ + begin;
+  data_size_t* old_indices = leaf_ordered_indices_.data() + begin;
+  leaf_ordered_is_left_.resize(cnt);
+  // the data partition is stable, the data of the left child are in the same order before the split
+  data_size_t left_pos = 0;
+  for (data_size_t i = 0; i < cnt; ++i) {
+    const bool is_left = left_pos < left_cnt && old_indices[i] == new_indices[left_pos];
+    leaf_ordered_is_left_[i] = is_left;
+    left_pos += is_left;
+  }
+  CHECK_EQ(left_pos, left_cnt);
+  const uint8_t slot = leaf_ordered_slots_[begin];
+  leaf_ordered_bins_[1 - slot]->CopyPartitionedRows(leaf_ordered_bins_[slot].get(), begin, cnt,
+                                                    leaf_ordered_is_left_.data());
+  leaf_ordered_slots_[begin] = leaf_ordered_slots_[begin + left_cnt] = 1 - slot;
+  std::copy_n(new_indices, cnt, old_indices);
+}
+
+void MultiValBinWrapper::ConstructMultiOutputHistograms(const data_size_t* data_indices,
+  data_size_t num_data,
+  const std::vector<const score_t*>& gradients,
+  const std::vector<const score_t*>& hessians,
+  hist_t* out) {
+  const auto cur_multi_val_bin = (is_use_subcol_ || is_use_subrow_)
+        ? multi_val_bin_subset_.get()
+        : multi_val_bin_.get();
+  if (cur_multi_val_bin == nullptr) {
+    return;
+  }
+  // HistMove, which puts the bins of a column subset at their place, is not done on interleaved histograms
+  CHECK(!is_use_subcol_);
+  Common::FunctionTimer fun_timer("MultiValBinWrapper::ConstructMultiOutputHistograms", global_timer);
+  const int num_outputs = static_cast<int>(gradients.size());
+  const int num_values = num_outputs * 2;
+  const int num_bin = cur_multi_val_bin->num_bin();
+  const size_t block_hist_size = static_cast<size_t>(num_bin) * num_values;
+  int n_data_block = 1;
+  data_size_t data_block_size = num_data;
+  Threading::BlockInfo<data_size_t>(num_threads_, num_data, min_block_size_,
+                                    &n_data_block, &data_block_size);
+  if (multi_output_hist_buf_.size() < block_hist_size * (n_data_block - 1)) {
+    multi_output_hist_buf_.resize(block_hist_size * (n_data_block - 1));
+  }
+  // the gradients of a block are interleaved by tiles small enough to stay in cache
+  const data_size_t tile_size = std::max<data_size_t>(16, 8192 / num_values);
+  OMP_INIT_EX();
+  #pragma omp parallel for schedule(static) num_threads(num_threads_)
+  for (int block_id = 0; block_id < n_data_block; ++block_id) {
+    OMP_LOOP_EX_BEGIN();
+    const data_size_t start = block_id * data_block_size;
+    const data_size_t end = std::min<data_size_t>(start + data_block_size, num_data);
+    hist_t* data_ptr = block_id == 0 ? out : multi_output_hist_buf_.data() + block_hist_size * (block_id - 1);
+    std::memset(reinterpret_cast<void*>(data_ptr), 0, block_hist_size * sizeof(hist_t));
+    std::vector<score_t> tile_gradients_and_hessians(static_cast<size_t>(tile_size) * num_values);
+    for (data_size_t tile_start = start; tile_start < end; tile_start += tile_size) {
+      const data_size_t tile_end = std::min<data_size_t>(tile_start + tile_size, end);
+      InterleaveGradientsAndHessians(data_indices, tile_start, tile_end, gradients, hessians,
+                                     tile_gradients_and_hessians.data());
+      cur_multi_val_bin->ConstructHistogramMultiOutput(data_indices, tile_start, tile_end, num_outputs,
+                                                       tile_gradients_and_hessians.data(), data_ptr);
+    }
+    OMP_LOOP_EX_END();
+  }
+  OMP_THROW_EX();
+  // sum up the blocks in the same order as HistMerge
+  int n_bin_block = 1;
+  int bin_block_size = num_bin;
+  Threading::BlockInfo<data_size_t>(num_threads_, num_bin, 512, &n_bin_block,
+                                    &bin_block_size);
+  #pragma omp parallel for schedule(static, 1) num_threads(num_threads_)
+  for (int t = 0; t < n_bin_block; ++t) {
+    const size_t start = static_cast<size_t>(t) * bin_block_size * num_values;
+    const size_t end = static_cast<size_t>(std::min(t * bin_block_size + bin_block_size, num_bin)) * num_values;
+    for (int block_id = 1; block_id < n_data_block; ++block_id) {
+      const hist_t* src_ptr = multi_output_hist_buf_.data() + block_hist_size * (block_id - 1);
+      for (size_t i = start; i < end; ++i) {
+        out[i] += src_ptr[i];
+      }
+    }
+  }
+}
+
 template <bool USE_QUANT_GRAD, int HIST_BITS, int INNER_HIST_BITS>
 void MultiValBinWrapper::HistMove(const std::vector<hist_t,
   Common::AlignmentAllocator<hist_t, kAlignedSize>>& hist_buf) {
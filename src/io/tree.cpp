@@ -8,6 +8,8 @@
 #include <LightGBM/utils/common.h>
 #include <LightGBM/utils/threading.h>
 
+#include <algorithm>
+#include <cstring>
 #include <functional>
 #include <iomanip>
 #include <sstream>
@@ -47,6 +49,7 @@ Tree::Tree(int max_leaves, bool track_branch_features, bool is_linear)
   cat_boundaries_inner_.push_back(0);
   max_depth_ = -1;
   is_linear_ = is_linear;
+  is_oblivious_ = false;
   if (is_linear_) {
     leaf_coeff_.resize(max_leaves_);
     leaf_const_ = std::vector<double>(max_leaves_, 0);
@@ -316,6 +319,74 @@ void Tree::AddPredictionToScore(const Dataset* data,
 #undef PredictionFun
 #undef PredictionFunLinear
 
+void Tree::BindToDataset(const Dataset* data) {
+  if (is_linear_) {
+    Log::Fatal("Cannot predict linear trees on the bins of a Dataset");
+  }
+  split_feature_inner_.resize(num_leaves_ > 1 ? num_leaves_ - 1 : 0);
+  threshold_in_bin_.resize(split_feature_inner_.size());
+  cat_boundaries_inner_.assign(1, 0);
+  cat_threshold_inner_.clear();
+  for (int node = 0; node < num_leaves_ - 1; ++node) {
+    const int feature = split_feature_[node];
+    const int inner_feature = data->InnerFeatureIndex(feature);
+    if (inner_feature < 0) {
+      Log::Fatal("Feature %d is used by the model but has no bins in the Dataset", feature);
+    }
+    const BinMapper* bin_mapper = data->FeatureBinMapper(inner_feature);
+    split_feature_inner_[node] = inner_feature;
+    if (GetDecisionType(decision_type_[node], kCategoricalMask)) {
+      if (bin_mapper->bin_type() != BinType::CategoricalBin) {
+        Log::Fatal("Feature %d is categorical in the model but not in the Dataset", feature);
+      }
+      // bin 0 holds NaN, negative and unseen categories, which always go right
+      const int cat_idx = static_cast<int>(threshold_[node]);
+      const uint32_t* cat_bitset = cat_threshold_.data() + cat_boundaries_[cat_idx];
+      const int cat_bitset_len = cat_boundaries_[cat_idx + 1] - cat_boundaries_[cat_idx];
+      // a category going left without a bin would be sent right with the unseen ones
+      for (int category = 0; category < cat_bitset_len * 32; ++category) {
+        if (Common::FindInBitset(cat_bitset, cat_bitset_len, category) && bin_mapper->ValueToBin(category) == 0) {
+          Log::Fatal("Category %d of feature %d is used by the model but has no bin in the Dataset", category, feature);
+        }
+      }
+      std::vector<uint32_t> left_bins;
+      for (int bin = 1; bin < bin_mapper->num_bin(); ++bin) {
+        const int category = static_cast<int>(bin_mapper->BinToValue(bin));
+        if (category >= 0 && Common::FindInBitset(cat_bitset, cat_bitset_len, category)) {
+          left_bins.push_back(static_cast<uint32_t>(bin));
+        }
+      }
+      const auto bitset = Common::ConstructBitset(left_bins.data(), static_cast<int>(left_bins.size()));
+      threshold_in_bin_[node] = static_cast<uint32_t>(cat_boundaries_inner_.size() - 1);
+      cat_threshold_inner_.insert(cat_threshold_inner_.end(), bitset.begin(), bitset.end());
+      cat_boundaries_inner_.push_back(static_cast<int>(cat_threshold_inner_.size()));
+    } else {
+      if (bin_mapper->bin_type() != BinType::NumericalBin) {
+        Log::Fatal("Feature %d is numerical in the model but not in the Dataset", feature);
+      }
+      if (GetMissingType(decision_type_[node]) != static_cast<int8_t>(bin_mapper->missing_type())) {
+        Log::Fatal("Feature %d handles missing values differently in the model and in the Dataset", feature);
+      }
+      // the NaN bin has no upper bound
+      const int num_value_bin = bin_mapper->num_bin() - (bin_mapper->missing_type() == MissingType::NaN ? 1 : 0);
+      int low = 0;
+      int high = num_value_bin;
+      while (low < high) {
+        const int mid = (low + high) / 2;
+        if (bin_mapper->BinToValue(mid) < threshold_[node]) {
+          low = mid + 1;
+        } else {
+          high = mid;
+        }
+      }
+      if (low == num_value_bin || bin_mapper->BinToValue(low) != threshold_[node]) {
+        Log::Fatal("Threshold %g of feature %d is not a bin boundary of the Dataset", threshold_[node], feature);
+      }
+      threshold_in_bin_[node] = static_cast<uint32_t>(low);
+    }
+  }
+}
+
 double Tree::GetUpperBoundValue() const {
   double upper_bound = leaf_value_[0];
   for (int i = 1; i < num_leaves_; ++i) {
@@ -402,12 +473,210 @@ std::string Tree::ToString() const {
     }
     str_buf << '\n';
   }
+  if (is_oblivious_) {
+    std::vector<int> level_feature;
+    std::vector<double> level_threshold;
+    for (const auto& level : oblivious_levels_) {
+      level_feature.push_back(level.split_feature);
+      level_threshold.push_back(level.threshold);
+    }
+    str_buf << "oblivious_split_feature="
+      << ArrayToString(level_feature, level_feature.size()) << '\n';
+    str_buf << "oblivious_threshold="
+      << ArrayToString<true>(level_threshold, level_threshold.size()) << '\n';
+  }
   str_buf << "shrinkage=" << shrinkage_ << '\n';
   str_buf << '\n';
 
   return str_buf.str();
 }
 
+namespace {
+
+/*! \brief Writer which only counts the bytes, used to size binary forms */
+struct ByteCounter : BinaryWriter {
+  size_t Write(const void*, size_t bytes) override {
+    size += bytes;
+    return bytes;
+  }
+  size_t size = 0;
+};
+
+/*! \brief Write the first num elements of vec, the missing ones (e.g. counts of a single-leaf tree loaded from text) as zeros */
+template <typename T>
+void WriteBinaryArray(BinaryWriter* writer, const std::vector<T>& vec, int num) {
+  if (num <= 0) {
+    return;
+  }
+  if (vec.size() >= static_cast<size_t>(num)) {
+    writer->AlignedWrite(vec.data(), sizeof(T) * num);
+  } else {
+    std::vector<T> padded(vec);
+    padded.resize(num);
+    writer->AlignedWrite(padded.data(), sizeof(T) * num);
+  }
+}
+
+/*! \brief Read num elements written by WriteBinaryArray, which must fit before end */
+template <typename T>
+const char* ReadBinaryArray(const char* p, const char* end, int num, std::vector<T>* out) {
+  if (num < 0) {
+    Log::Fatal("Tree model binary format error, negative array size");
+  }
+  const size_t bytes = BinaryWriter::AlignedSize(sizeof(T) * num);
+  if (static_cast<size_t>(end - p) < bytes) {
+    Log::Fatal("Tree model binary format error, the tree is truncated");
+  }
+  out->resize(num);
+  if (num > 0) {
+    std::memcpy(out->data(), p, sizeof(T) * num);
+  }
+  return p + bytes;
+}
+
+}  // namespace
+
+size_t Tree::SizesInByte() const {
+  ByteCounter counter;
+  SaveBinaryToFile(&counter);
+  return counter.size;
+}
+
+void Tree::SaveBinaryToFile(BinaryWriter* writer) const {
+  const int32_t header[4] = {num_leaves_, num_cat_, is_linear_ ? 1 : 0, is_oblivious_ ? 1 : 0};
+  writer->Write(header, sizeof(header));
+  writer->Write(&shrinkage_, sizeof(shrinkage_));
+  const int num_nodes = num_leaves_ - 1;
+  WriteBinaryArray(writer, split_feature_, num_nodes);
+  WriteBinaryArray(writer, split_gain_, num_nodes);
+  WriteBinaryArray(writer, threshold_, num_nodes);
+  WriteBinaryArray(writer, decision_type_, num_nodes);
+  WriteBinaryArray(writer, left_child_, num_nodes);
+  WriteBinaryArray(writer, right_child_, num_nodes);
+  WriteBinaryArray(writer, leaf_value_, num_leaves_);
+  WriteBinaryArray(writer, leaf_weight_, num_leaves_);
+  WriteBinaryArray(writer, leaf_count_, num_leaves_);
+  WriteBinaryArray(writer, internal_value_, num_nodes);
+  WriteBinaryArray(writer, internal_weight_, num_nodes);
+  WriteBinaryArray(writer, internal_count_, num_nodes);
+  if (num_cat_ > 0) {
+    WriteBinaryArray(writer, cat_boundaries_, num_cat_ + 1);
+    WriteBinaryArray(writer, cat_threshold_, cat_boundaries_[num_cat_]);
+  }
+  if (is_linear_) {
+    WriteBinaryArray(writer, leaf_const_, num_leaves_);
+    std::vector<int> num_feat(num_leaves_);
+    std::vector<int> all_leaf_features;
+    std::vector<double> all_leaf_coeff;
+    for (int i = 0; i < num_leaves_; ++i) {
+      num_feat[i] = static_cast<int>(leaf_coeff_[i].size());
+      all_leaf_features.insert(all_leaf_features.end(), leaf_features_[i].begin(), leaf_features_[i].end());
+      all_leaf_coeff.insert(all_leaf_coeff.end(), leaf_coeff_[i].begin(), leaf_coeff_[i].end());
+    }
+    const int32_t total_num_feat = static_cast<int32_t>(all_leaf_coeff.size());
+    writer->AlignedWrite(&total_num_feat, sizeof(total_num_feat));
+    WriteBinaryArray(writer, num_feat, num_leaves_);
+    WriteBinaryArray(writer, all_leaf_features, total_num_feat);
+    WriteBinaryArray(writer, all_leaf_coeff, total_num_feat);
+  }
+}
+
+Tree* Tree::CreateFromBinary(const char* memory, size_t len, int num_features, size_t* used_len) {
+  std::unique_ptr<Tree> tree(new Tree());
+  auto p = memory;
+  const char* end = memory + len;
+  int32_t header[4];
+  if (len < sizeof(header) + sizeof(tree->shrinkage_)) {
+    Log::Fatal("Tree model binary format error, the tree is truncated");
+  }
+  std::memcpy(header, p, sizeof(header));
+  p += sizeof(header);
+  std::memcpy(&tree->shrinkage_, p, sizeof(tree->shrinkage_));
+  p += sizeof(tree->shrinkage_);
+  tree->num_leaves_ = header[0];
+  tree->num_cat_ = header[1];
+  tree->is_linear_ = header[2] != 0;
+  if (tree->num_leaves_ <= 0 || tree->num_cat_ < 0 || tree->num_cat_ >= tree->num_leaves_) {
+    Log::Fatal("Tree model binary format error, wrong number of leaves or of categorical splits");
+  }
+  #ifdef USE_CUDA
+  tree->is_cuda_tree_ = false;
+  #endif  // USE_CUDA
+  const int num_nodes = tree->num_leaves_ - 1;
+  p = ReadBinaryArray(p, end, num_nodes, &tree->split_feature_);
+  p = ReadBinaryArray(p, end, num_nodes, &tree->split_gain_);
+  p = ReadBinaryArray(p, end, num_nodes, &tree->threshold_);
+  p = ReadBinaryArray(p, end, num_nodes, &tree->decision_type_);
+  p = ReadBinaryArray(p, end, num_nodes, &tree->left_child_);
+  p = ReadBinaryArray(p, end, num_nodes, &tree->right_child_);
+  p = ReadBinaryArray(p, end, tree->num_leaves_, &tree->leaf_value_);
+  p = ReadBinaryArray(p, end, tree->num_leaves_, &tree->leaf_weight_);
+  p = ReadBinaryArray(p, end, tree->num_leaves_, &tree->leaf_count_);
+  p = ReadBinaryArray(p, end, num_nodes, &tree->internal_value_);
+  p = ReadBinaryArray(p, end, num_nodes, &tree->internal_weight_);
+  p = ReadBinaryArray(p, end, num_nodes, &tree->internal_count_);
+  if (tree->num_cat_ > 0) {
+    p = ReadBinaryArray(p, end, tree->num_cat_ + 1, &tree->cat_boundaries_);
+    if (tree->cat_boundaries_[0] != 0 ||
+        !std::is_sorted(tree->cat_boundaries_.begin(), tree->cat_boundaries_.end())) {
+      Log::Fatal("Tree model binary format error, wrong boundaries of the categorical bitsets");
+    }
+    p = ReadBinaryArray(p, end, tree->cat_boundaries_.back(), &tree->cat_threshold_);
+  }
+  // the nodes are walked without checks, a child is always created after its parent
+  for (int i = 0; i < num_nodes; ++i) {
+    if (tree->split_feature_[i] < 0 || tree->split_feature_[i] >= num_features) {
+      Log::Fatal("Tree model binary format error, wrong split feature of node %d", i);
+    }
+    for (int child : {tree->left_child_[i], tree->right_child_[i]}) {
+      if (child >= num_nodes || (child >= 0 && child <= i) || (child < 0 && ~child >= tree->num_leaves_)) {
+        Log::Fatal("Tree model binary format error, wrong child of node %d", i);
+      }
+    }
+    if (GetDecisionType(tree->decision_type_[i], kCategoricalMask)) {
+      const int cat_idx = static_cast<int>(tree->threshold_[i]);
+      if (cat_idx < 0 || cat_idx >= tree->num_cat_) {
+        Log::Fatal("Tree model binary format error, wrong categorical split of node %d", i);
+      }
+    }
+  }
+  if (tree->is_linear_) {
+    p = ReadBinaryArray(p, end, tree->num_leaves_, &tree->leaf_const_);
+    std::vector<int32_t> total_num_feat;
+    p = ReadBinaryArray(p, end, 1, &total_num_feat);
+    std::vector<int> num_feat;
+    std::vector<int> all_leaf_features;
+    std::vector<double> all_leaf_coeff;
+    p = ReadBinaryArray(p, end, tree->num_leaves_, &num_feat);
+    p = ReadBinaryArray(p, end, total_num_feat[0], &all_leaf_features);
+    p = ReadBinaryArray(p, end, total_num_feat[0], &all_leaf_coeff);
+    tree->leaf_coeff_.resize(tree->num_leaves_);
+    tree->leaf_features_.resize(tree->num_leaves_);
+    tree->leaf_features_inner_.resize(tree->num_leaves_);
+    for (int feature : all_leaf_features) {
+      if (feature < 0 || feature >= num_features) {
+        Log::Fatal("Tree model binary format error, wrong feature of a linear leaf");
+      }
+    }
+    int sum_num_feat = 0;
+    for (int i = 0; i < tree->num_leaves_; ++i) {
+      if (num_feat[i] < 0 || num_feat[i] > total_num_feat[0] - sum_num_feat) {
+        Log::Fatal("Tree model binary format error, wrong number of features of leaf %d", i);
+      }
+      tree->leaf_features_[i].assign(all_leaf_features.begin() + sum_num_feat, all_leaf_features.begin() + sum_num_feat + num_feat[i]);
+      tree->leaf_coeff_[i].assign(all_leaf_coeff.begin() + sum_num_feat, all_leaf_coeff.begin() + sum_num_feat + num_feat[i]);
+      sum_num_feat += num_feat[i];
+    }
+  }
+  tree->max_depth_ = -1;
+  tree->is_oblivious_ = false;
+  if (header[3] != 0 && !tree->MarkOblivious()) {
+    Log::Fatal("Tree model binary format error, the oblivious tree is not symmetric");
+  }
+  *used_len = p - memory;
+  return tree.release();
+}
+
 std::string Tree::ToJSON() const {
   std::stringstream str_buf;
   Common::C_stringstream(str_buf);
@@ -584,14 +853,14 @@ std::string Tree::ToIfElse(int index, bool predict_leaf_index) const {
   }
   str_buf << " }" << '\n';
 
-  // Predict func by Map to ifelse
+  // Predict func on a sparse row to ifelse
   str_buf << "double PredictTree" << index;
   if (predict_leaf_index) {
-    str_buf << "LeafByMap";
+    str_buf << "LeafSparse";
   } else {
-    str_buf << "ByMap";
+    str_buf << "Sparse";
   }
-  str_buf << "(const std::unordered_map<int, double>& arr) { ";
+  str_buf << "(const SparseRow& arr) { ";
   if (num_leaves_ <= 1) {
     str_buf << "return " << leaf_value_[0] << ";";
   } else {
@@ -608,7 +877,7 @@ std::string Tree::ToIfElse(int index, bool predict_leaf_index) const {
     if (num_cat_ > 0) {
       str_buf << "int int_fval = 0; ";
     }
-    str_buf << NodeToIfElseByMap(0, predict_leaf_index);
+    str_buf << NodeToIfElseSparse(0, predict_leaf_index);
   }
   str_buf << " }" << '\n';
 
@@ -647,23 +916,23 @@ std::string Tree::NodeToIfElse(int index, bool predict_leaf_index) const {
   return str_buf.str();
 }
 
-std::string Tree::NodeToIfElseByMap(int index, bool predict_leaf_index) const {
+std::string Tree::NodeToIfElseSparse(int index, bool predict_leaf_index) const {
   std::stringstream str_buf;
   Common::C_stringstream(str_buf);
   str_buf << std::setprecision(std::numeric_limits<double>::digits10 + 2);
   if (index >= 0) {
     // non-leaf
-    str_buf << "fval = arr.count(" << split_feature_[index] << ") > 0 ? arr.at(" << split_feature_[index] << ") : 0.0f;";
+    str_buf << "fval = arr.Get(" << split_feature_[index] << ");";
     if (GetDecisionType(decision_type_[index], kCategoricalMask) == 0) {
       str_buf << NumericalDecisionIfElse(index);
     } else {
       str_buf << CategoricalDecisionIfElse(index);
     }
     // left subtree
-    str_buf << NodeToIfElseByMap(left_child_[index], predict_leaf_index);
+    str_buf << NodeToIfElseSparse(left_child_[index], predict_leaf_index);
     str_buf << " } else { ";
     // right subtree
-    str_buf << NodeToIfElseByMap(right_child_[index], predict_leaf_index);
+    str_buf << NodeToIfElseSparse(right_child_[index], predict_leaf_index);
     str_buf << " }";
   } else {
     // leaf
@@ -682,7 +951,7 @@ std::string Tree::NodeToIfElseByMap(int index, bool predict_leaf_index) const {
 Tree::Tree(const char* str, size_t* used_len) {
   auto p = str;
   std::unordered_map<std::string, std::string> key_vals;
-  const int max_num_line = 22;
+  const int max_num_line = 24;
   int read_line = 0;
   while (read_line < max_num_line) {
     if (*p == '\r' || *p == '\n') break;
@@ -735,7 +1004,11 @@ Tree::Tree(const char* str, size_t* used_len) {
   is_cuda_tree_ = false;
   #endif  // USE_CUDA
 
+  is_oblivious_ = false;
   if ((num_leaves_ <= 1) && !is_linear_) {
+    if (key_vals.count("oblivious_split_feature")) {
+      MarkOblivious();
+    }
     return;
   }
 
@@ -859,6 +1132,25 @@ Tree::Tree(const char* str, size_t* used_len) {
       Log::Fatal("Tree model should contain cat_threshold field");
     }
   }
+
+  if (key_vals.count("oblivious_split_feature")) {
+    // the nodes still describe the tree, the level splits must be the ones they share
+    bool is_valid = MarkOblivious() && key_vals.count("oblivious_threshold");
+    if (is_valid) {
+      const size_t num_levels = oblivious_levels_.size();
+      const auto level_feature = CommonC::StringToArrayFast<int>(key_vals["oblivious_split_feature"],
+                                                                 static_cast<int>(num_levels));
+      const auto level_threshold = CommonC::StringToArray<double>(key_vals["oblivious_threshold"],
+                                                                  static_cast<int>(num_levels));
+      for (size_t i = 0; i < num_levels; ++i) {
+        is_valid = is_valid && level_feature[i] == oblivious_levels_[i].split_feature
+                   && level_threshold[i] == oblivious_levels_[i].threshold;
+      }
+    }
+    if (!is_valid) {
+      Log::Fatal("Tree model string format error, the oblivious levels do not match the nodes");
+    }
+  }
   max_depth_ = -1;
 }
 
@@ -888,9 +1180,12 @@ void Tree::UnwindPath(PathElement *unique_path, int unique_depth, int path_index
         / static_cast<double>((i + 1)*one_fraction);
       next_one_portion = tmp - unique_path[i].pweight*zero_fraction*(unique_depth - i)
         / static_cast<double>(unique_depth + 1);
-    } else {
+    } else if (zero_fraction != 0) {
       unique_path[i].pweight = (unique_path[i].pweight*(unique_depth + 1))
         / static_cast<double>(zero_fraction*(unique_depth - i));
+    } else {
+      // a path through an empty node of an oblivious tree has no weight
+      unique_path[i].pweight = 0;
     }
   }
 
@@ -913,7 +1208,7 @@ double Tree::UnwoundPathSum(const PathElement *unique_path, int unique_depth, in
       total += tmp;
       next_one_portion = unique_path[i].pweight - tmp*zero_fraction*((unique_depth - i)
                                                                      / static_cast<double>(unique_depth + 1));
-    } else {
+    } else if (zero_fraction != 0) {
       total += (unique_path[i].pweight / zero_fraction) / ((unique_depth - i)
                                                            / static_cast<double>(unique_depth + 1));
     }
@@ -946,9 +1241,10 @@ void Tree::TreeSHAP(const double *feature_values, double *phi,
   } else {
     const int hot_index = Decision(feature_values[split_feature_[node]], node);
     const int cold_index = (hot_index == left_child_[node] ? right_child_[node] : left_child_[node]);
+    // the empty nodes of oblivious trees split their (null) weight evenly
     const double w = data_count(node);
-    const double hot_zero_fraction = data_count(hot_index) / w;
-    const double cold_zero_fraction = data_count(cold_index) / w;
+    const double hot_zero_fraction = w > 0 ? data_count(hot_index) / w : 0.5;
+    const double cold_zero_fraction = w > 0 ? data_count(cold_index) / w : 0.5;
     double incoming_zero_fraction = 1;
     double incoming_one_fraction = 1;
 
@@ -974,10 +1270,10 @@ void Tree::TreeSHAP(const double *feature_values, double *phi,
 }
 
 // recursive sparse computation of SHAP values for a decision tree
-void Tree::TreeSHAPByMap(const std::unordered_map<int, double>& feature_values, std::unordered_map<int, double>* phi,
-                         int node, int unique_depth,
-                         PathElement *parent_unique_path, double parent_zero_fraction,
-                         double parent_one_fraction, int parent_feature_index) const {
+void Tree::TreeSHAPSparse(const SparseRow& feature_values, double *phi,
+                          int node, int unique_depth,
+                          PathElement *parent_unique_path, double parent_zero_fraction,
+                          double parent_one_fraction, int parent_feature_index) const {
   // extend the unique path
   PathElement* unique_path = parent_unique_path + unique_depth;
   if (unique_depth > 0) {
@@ -991,16 +1287,17 @@ void Tree::TreeSHAPByMap(const std::unordered_map<int, double>& feature_values,
     for (int i = 1; i <= unique_depth; ++i) {
       const double w = UnwoundPathSum(unique_path, unique_depth, i);
       const PathElement &el = unique_path[i];
-      (*phi)[el.feature_index] += w*(el.one_fraction - el.zero_fraction)*leaf_value_[~node];
+      phi[el.feature_index] += w*(el.one_fraction - el.zero_fraction)*leaf_value_[~node];
     }
 
   // internal node
   } else {
-    const int hot_index = Decision(feature_values.count(split_feature_[node]) > 0 ? feature_values.at(split_feature_[node]) : 0.0f, node);
+    const int hot_index = Decision(feature_values.Get(split_feature_[node]), node);
     const int cold_index = (hot_index == left_child_[node] ? right_child_[node] : left_child_[node]);
+    // the empty nodes of oblivious trees split their (null) weight evenly
     const double w = data_count(node);
-    const double hot_zero_fraction = data_count(hot_index) / w;
-    const double cold_zero_fraction = data_count(cold_index) / w;
+    const double hot_zero_fraction = w > 0 ? data_count(hot_index) / w : 0.5;
+    const double cold_zero_fraction = w > 0 ? data_count(cold_index) / w : 0.5;
     double incoming_zero_fraction = 1;
     double incoming_one_fraction = 1;
 
@@ -1017,11 +1314,235 @@ void Tree::TreeSHAPByMap(const std::unordered_map<int, double>& feature_values,
       unique_depth -= 1;
     }
 
-    TreeSHAPByMap(feature_values, phi, hot_index, unique_depth + 1, unique_path,
-                  hot_zero_fraction*incoming_zero_fraction, incoming_one_fraction, split_feature_[node]);
+    TreeSHAPSparse(feature_values, phi, hot_index, unique_depth + 1, unique_path,
+                   hot_zero_fraction*incoming_zero_fraction, incoming_one_fraction, split_feature_[node]);
+
+    TreeSHAPSparse(feature_values, phi, cold_index, unique_depth + 1, unique_path,
+                   cold_zero_fraction*incoming_zero_fraction, 0, split_feature_[node]);
+  }
+}
+
+// ExtendPath, UnwindPath and UnwoundPathSum with the arithmetic of the single record versions, record by record
+void Tree::ExtendPathBlock(ContribBlockBuffer* buffer, int num_rows, int path, int unique_depth,
+                           double zero_fraction, const double* one_fraction, int feature_index) {
+  buffer->path_feature[path + unique_depth] = feature_index;
+  buffer->path_zero_fraction[path + unique_depth] = zero_fraction;
+  double* one = buffer->path_one_fraction.data() + static_cast<size_t>(path + unique_depth) * num_rows;
+  double* pweight = buffer->path_pweight.data() + static_cast<size_t>(path) * num_rows;
+  for (int r = 0; r < num_rows; ++r) {
+    one[r] = one_fraction[r];
+    pweight[static_cast<size_t>(unique_depth) * num_rows + r] = (unique_depth == 0 ? 1 : 0);
+  }
+  for (int i = unique_depth - 1; i >= 0; i--) {
+    double* pweight_i = pweight + static_cast<size_t>(i) * num_rows;
+    double* pweight_next = pweight_i + num_rows;
+    for (int r = 0; r < num_rows; ++r) {
+      pweight_next[r] += one_fraction[r]*pweight_i[r]*(i + 1)
+        / static_cast<double>(unique_depth + 1);
+      pweight_i[r] = zero_fraction*pweight_i[r]*(unique_depth - i)
+        / static_cast<double>(unique_depth + 1);
+    }
+  }
+}
+
+void Tree::UnwindPathBlock(ContribBlockBuffer* buffer, int num_rows, int path, int unique_depth, int path_index) {
+  const double* one = buffer->path_one_fraction.data() + static_cast<size_t>(path + path_index) * num_rows;
+  const double zero_fraction = buffer->path_zero_fraction[path + path_index];
+  double* pweight = buffer->path_pweight.data() + static_cast<size_t>(path) * num_rows;
+  double* next_one_portion = buffer->next_one_portion.data();
+  for (int r = 0; r < num_rows; ++r) {
+    next_one_portion[r] = pweight[static_cast<size_t>(unique_depth) * num_rows + r];
+  }
+  for (int i = unique_depth - 1; i >= 0; --i) {
+    double* pweight_i = pweight + static_cast<size_t>(i) * num_rows;
+    for (int r = 0; r < num_rows; ++r) {
+      if (one[r] != 0) {
+        const double tmp = pweight_i[r];
+        pweight_i[r] = next_one_portion[r]*(unique_depth + 1)
+          / static_cast<double>((i + 1)*one[r]);
+        next_one_portion[r] = tmp - pweight_i[r]*zero_fraction*(unique_depth - i)
+          / static_cast<double>(unique_depth + 1);
+      } else if (zero_fraction != 0) {
+        pweight_i[r] = (pweight_i[r]*(unique_depth + 1))
+          / static_cast<double>(zero_fraction*(unique_depth - i));
+      } else {
+        pweight_i[r] = 0;
+      }
+    }
+  }
+
+  for (int i = path + path_index; i < path + unique_depth; ++i) {
+    buffer->path_feature[i] = buffer->path_feature[i + 1];
+    buffer->path_zero_fraction[i] = buffer->path_zero_fraction[i + 1];
+    std::copy(buffer->path_one_fraction.begin() + static_cast<size_t>(i + 1) * num_rows,
+              buffer->path_one_fraction.begin() + static_cast<size_t>(i + 2) * num_rows,
+              buffer->path_one_fraction.begin() + static_cast<size_t>(i) * num_rows);
+  }
+}
+
+void Tree::UnwoundPathSumBlock(ContribBlockBuffer* buffer, int num_rows, int path, int unique_depth, int path_index) {
+  const double* one = buffer->path_one_fraction.data() + static_cast<size_t>(path + path_index) * num_rows;
+  const double zero_fraction = buffer->path_zero_fraction[path + path_index];
+  const double* pweight = buffer->path_pweight.data() + static_cast<size_t>(path) * num_rows;
+  double* next_one_portion = buffer->next_one_portion.data();
+  double* total = buffer->total.data();
+  for (int r = 0; r < num_rows; ++r) {
+    next_one_portion[r] = pweight[static_cast<size_t>(unique_depth) * num_rows + r];
+    total[r] = 0;
+  }
+  for (int i = unique_depth - 1; i >= 0; --i) {
+    const double* pweight_i = pweight + static_cast<size_t>(i) * num_rows;
+    for (int r = 0; r < num_rows; ++r) {
+      if (one[r] != 0) {
+        const double tmp = next_one_portion[r]*(unique_depth + 1)
+          / static_cast<double>((i + 1)*one[r]);
+        total[r] += tmp;
+        next_one_portion[r] = pweight_i[r] - tmp*zero_fraction*((unique_depth - i)
+                                                                / static_cast<double>(unique_depth + 1));
+      } else if (zero_fraction != 0) {
+        total[r] += (pweight_i[r] / zero_fraction) / ((unique_depth - i)
+                                                     / static_cast<double>(unique_depth + 1));
+      }
+    }
+  }
+}
+
+// TreeSHAP on a block of records, the decisions of the records only change the one fractions
+void Tree::TreeSHAPBlock(int num_rows, int node, int node_depth, int unique_depth, int parent_path,
+                         double parent_zero_fraction, const double* parent_one_fraction,
+                         int parent_feature_index, ContribBlockBuffer* buffer) const {
+  // extend the unique path
+  const int path = parent_path + unique_depth;
+  if (unique_depth > 0) {
+    std::copy(buffer->path_feature.begin() + parent_path, buffer->path_feature.begin() + path,
+              buffer->path_feature.begin() + path);
+    std::copy(buffer->path_zero_fraction.begin() + parent_path, buffer->path_zero_fraction.begin() + path,
+              buffer->path_zero_fraction.begin() + path);
+    std::copy(buffer->path_one_fraction.begin() + static_cast<size_t>(parent_path) * num_rows,
+              buffer->path_one_fraction.begin() + static_cast<size_t>(path) * num_rows,
+              buffer->path_one_fraction.begin() + static_cast<size_t>(path) * num_rows);
+    std::copy(buffer->path_pweight.begin() + static_cast<size_t>(parent_path) * num_rows,
+              buffer->path_pweight.begin() + static_cast<size_t>(path) * num_rows,
+              buffer->path_pweight.begin() + static_cast<size_t>(path) * num_rows);
+  }
+  ExtendPathBlock(buffer, num_rows, path, unique_depth, parent_zero_fraction,
+                  parent_one_fraction, parent_feature_index);
+
+  // leaf node
+  if (node < 0) {
+    const int leaf = ~node;
+    buffer->leaf_begin[leaf] = static_cast<int>(buffer->leaf_feature.size());
+    for (int i = 1; i <= unique_depth; ++i) {
+      UnwoundPathSumBlock(buffer, num_rows, path, unique_depth, i);
+      const double zero_fraction = buffer->path_zero_fraction[path + i];
+      const double* one = buffer->path_one_fraction.data() + static_cast<size_t>(path + i) * num_rows;
+      buffer->leaf_feature.push_back(buffer->path_feature[path + i]);
+      const size_t contrib_offset = buffer->leaf_contrib.size();
+      buffer->leaf_contrib.resize(contrib_offset + num_rows);
+      double* contrib = buffer->leaf_contrib.data() + contrib_offset;
+      for (int r = 0; r < num_rows; ++r) {
+        contrib[r] = buffer->total[r]*(one[r] - zero_fraction)*leaf_value_[leaf];
+      }
+    }
+    buffer->leaf_end[leaf] = static_cast<int>(buffer->leaf_feature.size());
+
+    // internal node
+  } else {
+    const int left_index = left_child_[node];
+    const int right_index = right_child_[node];
+    // the empty nodes of oblivious trees split their (null) weight evenly
+    const double w = data_count(node);
+    const double left_zero_fraction = w > 0 ? data_count(left_index) / w : 0.5;
+    const double right_zero_fraction = w > 0 ? data_count(right_index) / w : 0.5;
+    double incoming_zero_fraction = 1;
+    const double* incoming_one_fraction = nullptr;
+
+    // see if we have already split on this feature,
+    // if so we undo that split so we can redo it for this node
+    int path_index = 0;
+    for (; path_index <= unique_depth; ++path_index) {
+      if (buffer->path_feature[path + path_index] == split_feature_[node]) break;
+    }
+    if (path_index != unique_depth + 1) {
+      incoming_zero_fraction = buffer->path_zero_fraction[path + path_index];
+      incoming_one_fraction = buffer->path_one_fraction.data() + static_cast<size_t>(path + path_index) * num_rows;
+    }
+    // the hot child of a record gets its incoming one fraction, the cold one gets 0
+    double* left_one_fraction = buffer->child_one_fraction.data() + static_cast<size_t>(2 * node_depth) * num_rows;
+    double* right_one_fraction = left_one_fraction + num_rows;
+    const uint8_t* go_left = buffer->go_left.data() + static_cast<size_t>(node) * num_rows;
+    for (int r = 0; r < num_rows; ++r) {
+      const double one_fraction = incoming_one_fraction != nullptr ? incoming_one_fraction[r] : 1;
+      left_one_fraction[r] = go_left[r] ? one_fraction : 0;
+      right_one_fraction[r] = go_left[r] ? 0 : one_fraction;
+    }
+    if (path_index != unique_depth + 1) {
+      UnwindPathBlock(buffer, num_rows, path, unique_depth, path_index);
+      unique_depth -= 1;
+    }
+
+    TreeSHAPBlock(num_rows, left_index, node_depth + 1, unique_depth + 1, path,
+                  left_zero_fraction*incoming_zero_fraction, left_one_fraction, split_feature_[node], buffer);
+
+    TreeSHAPBlock(num_rows, right_index, node_depth + 1, unique_depth + 1, path,
+                  right_zero_fraction*incoming_zero_fraction, right_one_fraction, split_feature_[node], buffer);
+  }
+}
 
-    TreeSHAPByMap(feature_values, phi, cold_index, unique_depth + 1, unique_path,
-                  cold_zero_fraction*incoming_zero_fraction, 0, split_feature_[node]);
+void Tree::PredictContribBlock(const double* features, int num_rows, int num_features,
+                               double* output, int output_stride, ContribBlockBuffer* buffer) const {
+  const double expected_value = ExpectedValue();
+  for (int r = 0; r < num_rows; ++r) {
+    output[static_cast<size_t>(r) * output_stride + num_features] += expected_value;
+  }
+  if (num_leaves_ <= 1) {
+    return;
+  }
+  CHECK_GE(max_depth_, 0);
+  const int max_path_len = max_depth_ + 1;
+  const size_t num_path_elements = static_cast<size_t>(max_path_len) * (max_path_len + 1) / 2;
+  buffer->path_feature.resize(num_path_elements);
+  buffer->path_zero_fraction.resize(num_path_elements);
+  buffer->path_one_fraction.resize(num_path_elements * num_rows);
+  buffer->path_pweight.resize(num_path_elements * num_rows);
+  // two per depth for the children of the nodes on the current branch, plus one for the root
+  buffer->child_one_fraction.resize(static_cast<size_t>(2 * max_path_len + 1) * num_rows);
+  buffer->next_one_portion.resize(num_rows);
+  buffer->total.resize(num_rows);
+  buffer->go_left.resize(static_cast<size_t>(num_leaves_ - 1) * num_rows);
+  buffer->leaf_begin.resize(num_leaves_);
+  buffer->leaf_end.resize(num_leaves_);
+  buffer->leaf_feature.clear();
+  buffer->leaf_contrib.clear();
+  for (int node = 0; node < num_leaves_ - 1; ++node) {
+    uint8_t* go_left = buffer->go_left.data() + static_cast<size_t>(node) * num_rows;
+    for (int r = 0; r < num_rows; ++r) {
+      go_left[r] = Decision(features[static_cast<size_t>(r) * num_features + split_feature_[node]], node) == left_child_[node];
+    }
+  }
+  double* root_one_fraction = buffer->child_one_fraction.data() + static_cast<size_t>(2 * max_path_len) * num_rows;
+  std::fill(root_one_fraction, root_one_fraction + num_rows, 1.0);
+  TreeSHAPBlock(num_rows, 0, 0, 0, 0, 1, root_one_fraction, -1, buffer);
+
+  // each record adds the leaf contributions in the order of TreeSHAP, hot child first
+  for (int r = 0; r < num_rows; ++r) {
+    double* phi = output + static_cast<size_t>(r) * output_stride;
+    buffer->stack.assign(1, 0);
+    while (!buffer->stack.empty()) {
+      const int node = buffer->stack.back();
+      buffer->stack.pop_back();
+      if (node < 0) {
+        for (int j = buffer->leaf_begin[~node]; j < buffer->leaf_end[~node]; ++j) {
+          phi[buffer->leaf_feature[j]] += buffer->leaf_contrib[static_cast<size_t>(j) * num_rows + r];
+        }
+      } else if (buffer->go_left[static_cast<size_t>(node) * num_rows + r]) {
+        buffer->stack.push_back(right_child_[node]);
+        buffer->stack.push_back(left_child_[node]);
+      } else {
+        buffer->stack.push_back(left_child_[node]);
+        buffer->stack.push_back(right_child_[node]);
+      }
+    }
   }
 }
 
@@ -1035,6 +1556,71 @@ double Tree::ExpectedValue() const {
   return exp_value;
 }
 
+bool Tree::MarkOblivious() {
+  is_oblivious_ = false;
+  oblivious_levels_.clear();
+  oblivious_leaf_.clear();
+  if (is_linear_) {
+    return false;
+  }
+  // walk the tree level by level, node_masks[i] is the mask of the decisions leading to nodes[i]
+  std::vector<int> nodes;
+  std::vector<int> node_masks;
+  if (num_leaves_ > 1) {
+    nodes.push_back(0);
+    node_masks.push_back(0);
+  }
+  std::vector<int> leaf_masks(num_leaves_, 0);
+  while (!nodes.empty()) {
+    const int first = nodes[0];
+    const int level = static_cast<int>(oblivious_levels_.size());
+    if (GetDecisionType(decision_type_[first], kCategoricalMask) || level >= 30) {
+      return false;
+    }
+    std::vector<int> next_nodes;
+    std::vector<int> next_masks;
+    int num_leaf_children = 0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      const int node = nodes[i];
+      if (split_feature_[node] != split_feature_[first] || threshold_[node] != threshold_[first]
+          || decision_type_[node] != decision_type_[first]) {
+        return false;
+      }
+      const int children[2] = {left_child_[node], right_child_[node]};
+      for (int right = 0; right < 2; ++right) {
+        const int mask = node_masks[i] | (right << level);
+        if (children[right] < 0) {
+          leaf_masks[~children[right]] = mask;
+          ++num_leaf_children;
+        } else {
+          next_nodes.push_back(children[right]);
+          next_masks.push_back(mask);
+        }
+      }
+    }
+    // all the leaves are on the last level
+    if (num_leaf_children > 0 && !next_nodes.empty()) {
+      return false;
+    }
+    const int8_t missing_type = GetMissingType(decision_type_[first]);
+    ObliviousLevel split;
+    split.threshold = threshold_[first];
+    split.split_feature = split_feature_[first];
+    split.nan_is_missing = missing_type == MissingType::NaN;
+    split.zero_is_missing = missing_type == MissingType::Zero;
+    split.default_right = !GetDecisionType(decision_type_[first], kDefaultLeftMask);
+    oblivious_levels_.push_back(split);
+    nodes.swap(next_nodes);
+    node_masks.swap(next_masks);
+  }
+  oblivious_leaf_.resize(num_leaves_);
+  for (int leaf = 0; leaf < num_leaves_; ++leaf) {
+    oblivious_leaf_[leaf_masks[leaf]] = leaf;
+  }
+  is_oblivious_ = true;
+  return true;
+}
+
 void Tree::RecomputeMaxDepth() {
   if (num_leaves_ == 1) {
     max_depth_ = 0;
@@ -665,6 +665,73 @@ class FeatureHistogram {
     output->cat_threshold = std::vector<uint32_t>(1, threshold);
   }
 
+  /*!
+   * \brief Add to gains[t] the gain of splitting this leaf between the bins <= t and the bins > t,
+   *        for every threshold t in [0, num_bin - 2] (the NaN bin always goes right). Thresholds leaving
+   *        too few data or hessian in a child add nothing. Used by oblivious trees, whose leaves of a
+   *        level share their split
+   * \param sum_gradient Sum of the gradients of the leaf
+   * \param sum_hessian Sum of the hessians of the leaf
+   * \param num_data Number of data in the leaf
+   * \param parent_output Output of the leaf, see SerialTreeLearner::GetParentOutput
+   * \param gains Gain of each threshold, updated
+   */
+  void AccumulateLevelGains(double sum_gradient, double sum_hessian, data_size_t num_data,
+                            double parent_output, double* gains) const {
+    if (meta_->config->path_smooth > kEpsilon) {
+      AccumulateLevelGainsInner<true>(sum_gradient, sum_hessian, num_data, parent_output, gains);
+    } else {
+      AccumulateLevelGainsInner<false>(sum_gradient, sum_hessian, num_data, parent_output, gains);
+    }
+  }
+
+  template <bool USE_SMOOTHING>
+  void AccumulateLevelGainsInner(double sum_gradient, double sum_hessian, data_size_t num_data,
+                                 double parent_output, double* gains) const {
+    const Config* config = meta_->config;
+    const int8_t offset = meta_->offset;
+    const int num_threshold = meta_->num_bin - 1 - (meta_->missing_type == MissingType::NaN ? 1 : 0);
+    const double gain_shift = GetLeafGainGivenOutput<true>(
+        sum_gradient, sum_hessian, config->lambda_l1, config->lambda_l2, parent_output);
+    const double cnt_factor = num_data / sum_hessian;
+    double sum_left_gradient = 0.0;
+    double sum_left_hessian = 0.0;
+    if (offset > 0) {
+      // the bin 0 is not stored, it holds what the other bins do not
+      sum_left_gradient = sum_gradient;
+      sum_left_hessian = sum_hessian;
+      for (int i = 0; i < meta_->num_bin - offset; ++i) {
+        sum_left_gradient -= GET_GRAD(data_, i);
+        sum_left_hessian -= GET_HESS(data_, i);
+      }
+    }
+    for (int t = 0; t < num_threshold; ++t) {
+      if (t >= offset) {
+        sum_left_gradient += GET_GRAD(data_, t - offset);
+        sum_left_hessian += GET_HESS(data_, t - offset);
+      }
+      const double sum_right_gradient = sum_gradient - sum_left_gradient;
+      const double sum_right_hessian = sum_hessian - sum_left_hessian;
+      const data_size_t left_count = static_cast<data_size_t>(Common::RoundInt(sum_left_hessian * cnt_factor));
+      const data_size_t right_count = num_data - left_count;
+      if (left_count < config->min_data_in_leaf || right_count < config->min_data_in_leaf
+          || sum_left_hessian < config->min_sum_hessian_in_leaf
+          || sum_right_hessian < config->min_sum_hessian_in_leaf) {
+        continue;
+      }
+      const double current_gain =
+          GetLeafGain<true, true, USE_SMOOTHING>(
+              sum_left_gradient, sum_left_hessian + kEpsilon, config->lambda_l1, config->lambda_l2,
+              config->max_delta_step, config->path_smooth, left_count, parent_output) +
+          GetLeafGain<true, true, USE_SMOOTHING>(
+              sum_right_gradient, sum_right_hessian + kEpsilon, config->lambda_l1, config->lambda_l2,
+              config->max_delta_step, config->path_smooth, right_count, parent_output);
+      if (!std::isnan(current_gain)) {
+        gains[t] += current_gain - gain_shift;
+      }
+    }
+  }
+
   /*!
    * \brief Binary size of this histogram
    */
@@ -1522,6 +1589,9 @@ class HistogramPool {
     }
   }
 
+  /*! \brief True if the histograms of all the leaves are cached at the same time */
+  bool is_enough() const { return is_enough_; }
+
   /*!
    * \brief Get data for the specific index
    * \param idx which index want to get
@@ -87,24 +87,28 @@ Tree* LinearTreeLearner::Train(const score_t* gradients, const score_t *hessians
 
   int init_splits = ForceSplits(tree_ptr, &left_leaf, &right_leaf, &cur_depth);
 
-  for (int split = init_splits; split < config_->num_leaves - 1; ++split) {
-    // some initial works before finding best split
-    if (BeforeFindBestSplit(tree_ptr, left_leaf, right_leaf)) {
-      // find best threshold for every feature
-      FindBestSplits(tree_ptr);
-    }
-    // Get a leaf with max split gain
-    int best_leaf = static_cast<int>(ArrayArgs<SplitInfo>::ArgMax(best_split_per_leaf_));
-    // Get split information for best leaf
-    const SplitInfo& best_leaf_SplitInfo = best_split_per_leaf_[best_leaf];
-    // cannot split, quit
-    if (best_leaf_SplitInfo.gain <= 0.0) {
-      Log::Warning("No further splits with positive gain, best gain: %f", best_leaf_SplitInfo.gain);
-      break;
+  if (config_->grow_policy == std::string("depthwise")) {
+    GrowDepthWise(tree_ptr, &cur_depth);
+  } else {
+    for (int split = init_splits; split < config_->num_leaves - 1; ++split) {
+      // some initial works before finding best split
+      if (BeforeFindBestSplit(tree_ptr, left_leaf, right_leaf)) {
+        // find best threshold for every feature
+        FindBestSplits(tree_ptr);
+      }
+      // Get a leaf with max split gain
+      int best_leaf = static_cast<int>(ArrayArgs<SplitInfo>::ArgMax(best_split_per_leaf_));
+      // Get split information for best leaf
+      const SplitInfo& best_leaf_SplitInfo = best_split_per_leaf_[best_leaf];
+      // cannot split, quit
+      if (best_leaf_SplitInfo.gain <= 0.0) {
+        Log::Warning("No further splits with positive gain, best gain: %f", best_leaf_SplitInfo.gain);
+        break;
+      }
+      // split tree with best leaf
+      Split(tree_ptr, best_leaf, &left_leaf, &right_leaf);
+      cur_depth = std::max(cur_depth, tree->leaf_depth(left_leaf));
     }
-    // split tree with best leaf
-    Split(tree_ptr, best_leaf, &left_leaf, &right_leaf);
-    cur_depth = std::max(cur_depth, tree->leaf_depth(left_leaf));
   }
 
   bool has_nan = false;
@@ -0,0 +1,189 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#include "oblivious_tree_learner.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace LightGBM {
+
+Tree* ObliviousTreeLearner::Train(const score_t* gradients, const score_t *hessians, bool /*is_first_tree*/) {
+  Common::FunctionTimer fun_timer("ObliviousTreeLearner::Train", global_timer);
+  gradients_ = gradients;
+  hessians_ = hessians;
+  share_state_->num_threads = OMP_NUM_THREADS();
+
+  BeforeTrain();
+
+  auto tree = std::unique_ptr<Tree>(new Tree(config_->num_leaves, false, false));
+  constraints_->ShareTreePointer(tree.get());
+  // as many levels as both num_leaves and max_depth allow
+  int num_levels = 0;
+  while (num_levels < 30 && (2 << num_levels) <= config_->num_leaves
+         && (config_->max_depth <= 0 || num_levels < config_->max_depth)) {
+    ++num_levels;
+  }
+  std::vector<LeafSplits> level_leaves(1, *smaller_leaf_splits_);
+  if (num_levels > 0 && BeforeFindBestSplit(tree.get(), 0, -1)) {
+    FindBestSplits(tree.get());
+  }
+  int depth = 0;
+  for (; depth < num_levels; ++depth) {
+    int inner_feature;
+    uint32_t threshold;
+    std::vector<double> leaf_gains;
+    if (!FindBestLevelSplit(tree.get(), level_leaves, &inner_feature, &threshold, &leaf_gains)) {
+      break;
+    }
+    std::vector<std::pair<LeafSplits, LeafSplits>> children;
+    SplitLevel(tree.get(), inner_feature, threshold, leaf_gains, &level_leaves, &children);
+    if (depth + 1 < num_levels) {
+      FindBestSplitsForLevel(tree.get(), children);
+    }
+  }
+  CHECK(tree->MarkOblivious());
+
+  Log::Debug("Trained an oblivious tree with leaves = %d and depth = %d", tree->num_leaves(), depth);
+  return tree.release();
+}
+
+bool ObliviousTreeLearner::FindBestLevelSplit(const Tree* tree, const std::vector<LeafSplits>& level_leaves,
+                                              int* inner_feature, uint32_t* threshold,
+                                              std::vector<double>* leaf_gains) {
+  Common::FunctionTimer fun_timer("ObliviousTreeLearner::FindBestLevelSplit", global_timer);
+  const int num_leaves = static_cast<int>(level_leaves.size());
+  // the leaves too small to be split have no histograms, they add no gain
+  std::vector<FeatureHistogram*> histograms(num_leaves, nullptr);
+  std::vector<double> parent_outputs(num_leaves, 0.0);
+  for (int i = 0; i < num_leaves; ++i) {
+    if (level_leaves[i].num_data_in_leaf() >= static_cast<data_size_t>(config_->min_data_in_leaf * 2)) {
+      CHECK(histogram_pool_.Get(level_leaves[i].leaf_index(), &histograms[i]));
+      parent_outputs[i] = GetParentOutput(tree, &level_leaves[i]);
+    }
+  }
+  // a feature is not splittable in a leaf without any split of positive gain, nor in its descendants
+  auto accumulate_gains = [&] (int feature_index, int i, double* gains) {
+    if (histograms[i] != nullptr && histograms[i][feature_index].is_splittable()) {
+      histograms[i][feature_index].AccumulateLevelGains(
+          level_leaves[i].sum_gradients(), level_leaves[i].sum_hessians(), level_leaves[i].num_data_in_leaf(),
+          parent_outputs[i], gains);
+    }
+  };
+  std::vector<double> feature_gain(num_features_, kMinScore);
+  std::vector<uint32_t> feature_threshold(num_features_, 0);
+  OMP_INIT_EX();
+#pragma omp parallel for schedule(static) num_threads(share_state_->num_threads)
+  for (int feature_index = 0; feature_index < num_features_; ++feature_index) {
+    OMP_LOOP_EX_BEGIN();
+    if (!col_sampler_.is_feature_used_bytree()[feature_index]
+        || train_data_->FeatureBinMapper(feature_index)->bin_type() != BinType::NumericalBin) {
+      continue;
+    }
+    std::vector<double> gains(train_data_->FeatureNumBin(feature_index) - 1, 0.0);
+    for (int i = 0; i < num_leaves; ++i) {
+      accumulate_gains(feature_index, i, gains.data());
+    }
+    for (size_t t = 0; t < gains.size(); ++t) {
+      if (gains[t] > feature_gain[feature_index]) {
+        feature_gain[feature_index] = gains[t];
+        feature_threshold[feature_index] = static_cast<uint32_t>(t);
+      }
+    }
+    OMP_LOOP_EX_END();
+  }
+  OMP_THROW_EX();
+  // the first feature wins the ties, whatever the number of threads
+  int best_feature = -1;
+  double best_gain = kMinScore;
+  for (int feature_index = 0; feature_index < num_features_; ++feature_index) {
+    if (feature_gain[feature_index] > best_gain) {
+      best_feature = feature_index;
+      best_gain = feature_gain[feature_index];
+    }
+  }
+  if (best_feature < 0 || best_gain <= config_->min_gain_to_split) {
+    Log::Warning("No further splits with positive gain, best gain: %f", best_gain);
+    return false;
+  }
+  *inner_feature = best_feature;
+  *threshold = feature_threshold[best_feature];
+  leaf_gains->assign(num_leaves, 0.0);
+  std::vector<double> gains(train_data_->FeatureNumBin(best_feature) - 1);
+  for (int i = 0; i < num_leaves; ++i) {
+    std::fill(gains.begin(), gains.end(), 0.0);
+    accumulate_gains(best_feature, i, gains.data());
+    (*leaf_gains)[i] = gains[*threshold];
+  }
+  return true;
+}
+
+void ObliviousTreeLearner::SplitLevel(Tree* tree, int inner_feature, uint32_t threshold,
+                                      const std::vector<double>& leaf_gains, std::vector<LeafSplits>* level_leaves,
+                                      std::vector<std::pair<LeafSplits, LeafSplits>>* children) {
+  Common::FunctionTimer fun_timer("ObliviousTreeLearner::SplitLevel", global_timer);
+  const BinMapper* bin_mapper = train_data_->FeatureBinMapper(inner_feature);
+  const int real_feature = train_data_->RealFeatureIndex(inner_feature);
+  const double threshold_double = train_data_->RealThreshold(inner_feature, threshold);
+  // the gains were accumulated with the NaN bin on the right and the zeros in the default bin,
+  // so the missing values go to the same side here
+  const bool default_left = bin_mapper->missing_type() != MissingType::NaN && bin_mapper->GetDefaultBin() <= threshold;
+  std::vector<LeafSplits> next_leaves;
+  LeafSplits smaller_sums(num_data_, config_);
+  for (size_t i = 0; i < level_leaves->size(); ++i) {
+    const LeafSplits& parent = (*level_leaves)[i];
+    const double parent_output = GetParentOutput(tree, &parent);
+    const int left_leaf = parent.leaf_index();
+    const int next_leaf_id = tree->NextLeafId();
+    uint32_t threshold_bin = threshold;
+    data_partition_->Split(left_leaf, train_data_, inner_feature, &threshold_bin, 1, default_left, next_leaf_id);
+    SplitLeafOrderedBins(left_leaf, next_leaf_id);
+    const data_size_t left_count = data_partition_->leaf_count(left_leaf);
+    const data_size_t right_count = data_partition_->leaf_count(next_leaf_id);
+    // sum up the smaller child, the larger one has the rest of its parent
+    const bool is_left_smaller = left_count < right_count;
+    smaller_sums.Init(is_left_smaller ? left_leaf : next_leaf_id, data_partition_.get(), gradients_, hessians_);
+    const double larger_sum_gradient = parent.sum_gradients() - smaller_sums.sum_gradients();
+    const double larger_sum_hessian = parent.sum_hessians() - smaller_sums.sum_hessians();
+    const double left_sum_gradient = is_left_smaller ? smaller_sums.sum_gradients() : larger_sum_gradient;
+    const double left_sum_hessian = is_left_smaller ? smaller_sums.sum_hessians() : larger_sum_hessian;
+    const double right_sum_gradient = is_left_smaller ? larger_sum_gradient : smaller_sums.sum_gradients();
+    const double right_sum_hessian = is_left_smaller ? larger_sum_hessian : smaller_sums.sum_hessians();
+    auto leaf_output = [&] (double sum_gradient, double sum_hessian, data_size_t num_data) {
+      // every leaf of the level is split, an empty child predicts like its parent
+      if (num_data <= 0) {
+        return parent_output;
+      }
+      if (config_->path_smooth > kEpsilon) {
+        return FeatureHistogram::CalculateSplittedLeafOutput<true, true, true>(
+            sum_gradient, sum_hessian + kEpsilon, config_->lambda_l1, config_->lambda_l2,
+            config_->max_delta_step, config_->path_smooth, num_data, parent_output);
+      } else {
+        return FeatureHistogram::CalculateSplittedLeafOutput<true, true, false>(
+            sum_gradient, sum_hessian + kEpsilon, config_->lambda_l1, config_->lambda_l2,
+            config_->max_delta_step, config_->path_smooth, num_data, parent_output);
+      }
+    };
+    const double left_output = leaf_output(left_sum_gradient, left_sum_hessian, left_count);
+    const double right_output = leaf_output(right_sum_gradient, right_sum_hessian, right_count);
+    const int right_leaf = tree->Split(left_leaf, inner_feature, real_feature, threshold, threshold_double,
+                                       left_output, right_output, left_count, right_count,
+                                       left_sum_hessian, right_sum_hessian, static_cast<float>(leaf_gains[i]),
+                                       bin_mapper->missing_type(), default_left);
+    LeafSplits left(num_data_, config_);
+    LeafSplits right(num_data_, config_);
+    left.Init(left_leaf, data_partition_.get(), left_sum_gradient, left_sum_hessian, left_output);
+    right.Init(right_leaf, data_partition_.get(), right_sum_gradient, right_sum_hessian, right_output);
+    if (is_left_smaller) {
+      children->emplace_back(left, right);
+    } else {
+      children->emplace_back(right, left);
+    }
+    next_leaves.push_back(left);
+    next_leaves.push_back(right);
+  }
+  level_leaves->swap(next_leaves);
+}
+
+}  // namespace LightGBM
@@ -0,0 +1,53 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#ifndef LIGHTGBM_TREELEARNER_OBLIVIOUS_TREE_LEARNER_H_
+#define LIGHTGBM_TREELEARNER_OBLIVIOUS_TREE_LEARNER_H_
+
+#include <utility>
+#include <vector>
+
+#include "serial_tree_learner.h"
+
+namespace LightGBM {
+
+/*!
+* \brief Learns oblivious (symmetric) trees: all the leaves of a level are split on the same feature and
+*        threshold, the one maximizing the sum of the split gains of the leaves. The histograms of the
+*        leaves of a level are constructed together, as for depth-wise growth
+*/
+class ObliviousTreeLearner: public SerialTreeLearner {
+ public:
+  explicit ObliviousTreeLearner(const Config* config) : SerialTreeLearner(config) {}
+
+  Tree* Train(const score_t* gradients, const score_t *hessians, bool is_first_tree) override;
+
+ private:
+  /*!
+  * \brief Find the split shared by the leaves of a level
+  * \param tree Current tree
+  * \param level_leaves Leaves of the level, with their histograms in the pool
+  * \param inner_feature Feature of the split, inner index
+  * \param threshold Threshold of the split, in bin
+  * \param leaf_gains Gain of the split on each leaf of the level
+  * \return Whether a split improves the sum of the gains by more than min_gain_to_split
+  */
+  bool FindBestLevelSplit(const Tree* tree, const std::vector<LeafSplits>& level_leaves, int* inner_feature,
+                          uint32_t* threshold, std::vector<double>* leaf_gains);
+
+  /*!
+  * \brief Split all the leaves of a level on the same feature and threshold
+  * \param tree Current tree, split
+  * \param inner_feature Feature of the split, inner index
+  * \param threshold Threshold of the split, in bin
+  * \param leaf_gains Gain of the split on each leaf of the level
+  * \param level_leaves Leaves of the level, replaced by the leaves of the next one
+  * \param children Smaller and larger leaf of each split
+  */
+  void SplitLevel(Tree* tree, int inner_feature, uint32_t threshold, const std::vector<double>& leaf_gains,
+                  std::vector<LeafSplits>* level_leaves, std::vector<std::pair<LeafSplits, LeafSplits>>* children);
+};
+
+}  // namespace LightGBM
+#endif   // LIGHTGBM_TREELEARNER_OBLIVIOUS_TREE_LEARNER_H_
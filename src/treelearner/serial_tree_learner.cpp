@@ -109,6 +109,9 @@ void SerialTreeLearner::GetShareStates(const Dataset* dataset,
     }
   }
   CHECK_NOTNULL(share_state_);
+  if (config_->leaf_ordered_bins) {
+    share_state_->EnableLeafOrderedBins(config_->leaf_ordered_bins_max_memory);
+  }
 }
 
 void SerialTreeLearner::ResetTrainingDataInner(const Dataset* train_data,
@@ -176,6 +179,30 @@ void SerialTreeLearner::ResetConfig(const Config* config) {
   constraints_.reset(LeafConstraintsBase::Create(config_, config_->num_leaves, train_data_->num_features()));
 }
 
+void SerialTreeLearner::BeforeTrainIteration(const std::vector<const score_t*>& gradients,
+                                             const std::vector<const score_t*>& hessians) {
+  iteration_root_gradients_.clear();
+  iteration_root_hessians_.clear();
+  if (!config_->multiclass_root_histograms || gradients.size() < 2 || share_state_->is_constant_hessian) {
+    return;
+  }
+  Common::FunctionTimer fun_timer("SerialTreeLearner::BeforeTrainIteration", global_timer);
+  // feature_fraction is 1, so all the trees use the same features and the same data
+  train_data_->InitTrain(col_sampler_.is_feature_used_bytree(), share_state_.get());
+  data_partition_->Init();
+  const data_size_t num_data_in_root = data_partition_->leaf_count(0);
+  const size_t hist_size = static_cast<size_t>(share_state_->num_hist_total_bin()) * 2 * gradients.size();
+  if (iteration_root_hist_.size() < hist_size) {
+    iteration_root_hist_.resize(hist_size);
+  }
+  train_data_->ConstructHistogramsMultiOutput(
+      col_sampler_.is_feature_used_bytree(),
+      num_data_in_root < num_data_ ? data_partition_->indices() : nullptr, num_data_in_root,
+      gradients, hessians, share_state_.get(), iteration_root_hist_.data());
+  iteration_root_gradients_ = gradients;
+  iteration_root_hessians_ = hessians;
+}
+
 Tree* SerialTreeLearner::Train(const score_t* gradients, const score_t *hessians, bool /*is_first_tree*/) {
   Common::FunctionTimer fun_timer("SerialTreeLearner::Train", global_timer);
   gradients_ = gradients;
@@ -209,24 +236,28 @@ Tree* SerialTreeLearner::Train(const score_t* gradients, const score_t *hessians
 
   int init_splits = ForceSplits(tree_ptr, &left_leaf, &right_leaf, &cur_depth);
 
-  for (int split = init_splits; split < config_->num_leaves - 1; ++split) {
-    // some initial works before finding best split
-    if (BeforeFindBestSplit(tree_ptr, left_leaf, right_leaf)) {
-      // find best threshold for every feature
-      FindBestSplits(tree_ptr);
-    }
-    // Get a leaf with max split gain
-    int best_leaf = static_cast<int>(ArrayArgs<SplitInfo>::ArgMax(best_split_per_leaf_));
-    // Get split information for best leaf
-    const SplitInfo& best_leaf_SplitInfo = best_split_per_leaf_[best_leaf];
-    // cannot split, quit
-    if (best_leaf_SplitInfo.gain <= 0.0) {
-      Log::Warning("No further splits with positive gain, best gain: %f", best_leaf_SplitInfo.gain);
-      break;
+  if (config_->grow_policy == std::string("depthwise")) {
+    GrowDepthWise(tree_ptr, &cur_depth);
+  } else {
+    for (int split = init_splits; split < config_->num_leaves - 1; ++split) {
+      // some initial works before finding best split
+      if (BeforeFindBestSplit(tree_ptr, left_leaf, right_leaf)) {
+        // find best threshold for every feature
+        FindBestSplits(tree_ptr);
+      }
+      // Get a leaf with max split gain
+      int best_leaf = static_cast<int>(ArrayArgs<SplitInfo>::ArgMax(best_split_per_leaf_));
+      // Get split information for best leaf
+      const SplitInfo& best_leaf_SplitInfo = best_split_per_leaf_[best_leaf];
+      // cannot split, quit
+      if (best_leaf_SplitInfo.gain <= 0.0) {
+        Log::Warning("No further splits with positive gain, best gain: %f", best_leaf_SplitInfo.gain);
+        break;
+      }
+      // split tree with best leaf
+      Split(tree_ptr, best_leaf, &left_leaf, &right_leaf);
+      cur_depth = std::max(cur_depth, tree->leaf_depth(left_leaf));
     }
-    // split tree with best leaf
-    Split(tree_ptr, best_leaf, &left_leaf, &right_leaf);
-    cur_depth = std::max(cur_depth, tree->leaf_depth(left_leaf));
   }
 
   if (config_->use_quantized_grad && config_->quant_train_renew_leaf) {
@@ -288,6 +319,7 @@ void SerialTreeLearner::BeforeTrain() {
   train_data_->InitTrain(col_sampler_.is_feature_used_bytree(), share_state_.get());
   // initialize data partition
   data_partition_->Init();
+  share_state_->InitLeafOrderedBins(data_partition_->indices(), data_partition_->leaf_count(0));
 
   constraints_->Reset();
 
@@ -446,11 +478,13 @@ void SerialTreeLearner::ConstructHistograms(
   } else {
     hist_t* ptr_smaller_leaf_hist_data =
         smaller_leaf_histogram_array_[0].RawData() - kHistOffset;
-    train_data_->ConstructHistograms<false, 0>(
-        is_feature_used, smaller_leaf_splits_->data_indices(),
-        smaller_leaf_splits_->num_data_in_leaf(), gradients_, hessians_,
-        ordered_gradients_.data(), ordered_hessians_.data(), share_state_.get(),
-        ptr_smaller_leaf_hist_data);
+    if (!GetIterationRootHistograms(ptr_smaller_leaf_hist_data)) {
+      train_data_->ConstructHistograms<false, 0>(
+          is_feature_used, smaller_leaf_splits_->data_indices(),
+          smaller_leaf_splits_->num_data_in_leaf(), gradients_, hessians_,
+          ordered_gradients_.data(), ordered_hessians_.data(), share_state_.get(),
+          ptr_smaller_leaf_hist_data);
+    }
     if (larger_leaf_histogram_array_ != nullptr && !use_subtract) {
       // construct larger leaf
       hist_t* ptr_larger_leaf_hist_data =
@@ -464,6 +498,195 @@ void SerialTreeLearner::ConstructHistograms(
   }
 }
 
+bool SerialTreeLearner::GetIterationRootHistograms(hist_t* hist_data) {
+  // only the root is alone, without a larger leaf
+  if (iteration_root_gradients_.empty() || larger_leaf_histogram_array_ != nullptr ||
+      smaller_leaf_splits_->leaf_index() != 0 ||
+      smaller_leaf_splits_->num_data_in_leaf() != data_partition_->leaf_count(0)) {
+    return false;
+  }
+  const int num_outputs = static_cast<int>(iteration_root_gradients_.size());
+  int output = 0;
+  while (output < num_outputs && (iteration_root_gradients_[output] != gradients_ ||
+                                  iteration_root_hessians_[output] != hessians_)) {
+    ++output;
+  }
+  if (output == num_outputs) {
+    return false;
+  }
+  iteration_root_gradients_[output] = nullptr;
+  const int num_bin = share_state_->num_hist_total_bin();
+  const hist_t* src = iteration_root_hist_.data() + output * 2;
+  const size_t stride = static_cast<size_t>(num_outputs) * 2;
+  #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static, 512) if (num_bin >= 1024)
+  for (int i = 0; i < num_bin; ++i) {
+    hist_data[i * 2] = src[i * stride];
+    hist_data[i * 2 + 1] = src[i * stride + 1];
+  }
+  return true;
+}
+
+void SerialTreeLearner::GrowDepthWise(Tree* tree, int* cur_depth) {
+  Common::FunctionTimer fun_timer("SerialTreeLearner::GrowDepthWise", global_timer);
+  if (BeforeFindBestSplit(tree, 0, -1)) {
+    FindBestSplits(tree);
+  }
+  std::vector<int> level_leaves(1, 0);
+  while (tree->num_leaves() < config_->num_leaves) {
+    std::vector<int> split_leaves;
+    for (int leaf : level_leaves) {
+      if (best_split_per_leaf_[leaf].gain > 0.0) {
+        split_leaves.push_back(leaf);
+      }
+    }
+    if (split_leaves.empty()) {
+      const int best_leaf = static_cast<int>(ArrayArgs<SplitInfo>::ArgMax(best_split_per_leaf_));
+      Log::Warning("No further splits with positive gain, best gain: %f", best_split_per_leaf_[best_leaf].gain);
+      break;
+    }
+    // when the level cannot be completed, keep the best splits
+    std::stable_sort(split_leaves.begin(), split_leaves.end(), [this] (int a, int b) {
+      return best_split_per_leaf_[a] > best_split_per_leaf_[b];
+    });
+    std::vector<std::pair<LeafSplits, LeafSplits>> children;
+    level_leaves.clear();
+    for (int leaf : split_leaves) {
+      // cost effective gradient boosting may lower the gains of the leaves not split yet
+      if (tree->num_leaves() >= config_->num_leaves || best_split_per_leaf_[leaf].gain <= 0.0) {
+        continue;
+      }
+      int left_leaf, right_leaf;
+      Split(tree, leaf, &left_leaf, &right_leaf);
+      *cur_depth = std::max(*cur_depth, tree->leaf_depth(left_leaf));
+      children.emplace_back(*smaller_leaf_splits_, *larger_leaf_splits_);
+      level_leaves.push_back(left_leaf);
+      level_leaves.push_back(right_leaf);
+    }
+    if (tree->num_leaves() >= config_->num_leaves) {
+      break;
+    }
+    FindBestSplitsForLevel(tree, children);
+  }
+}
+
+void SerialTreeLearner::FindBestSplitsForLevel(
+    const Tree* tree, const std::vector<std::pair<LeafSplits, LeafSplits>>& children) {
+  Common::FunctionTimer fun_timer("SerialTreeLearner::FindBestSplitsForLevel", global_timer);
+  if (!histogram_pool_.is_enough() || config_->use_quantized_grad) {
+    // the histograms of a level may not be cached at the same time, find the splits one after the other
+    for (const auto& leaves : children) {
+      *smaller_leaf_splits_ = leaves.first;
+      *larger_leaf_splits_ = leaves.second;
+      const int left_leaf = std::min(leaves.first.leaf_index(), leaves.second.leaf_index());
+      const int right_leaf = std::max(leaves.first.leaf_index(), leaves.second.leaf_index());
+      if (BeforeFindBestSplit(tree, left_leaf, right_leaf)) {
+        FindBestSplits(tree);
+      }
+    }
+    return;
+  }
+  const int num_children = static_cast<int>(children.size());
+  std::vector<bool> is_split_needed(num_children, false);
+  std::vector<FeatureHistogram*> smaller_histograms(num_children, nullptr);
+  std::vector<FeatureHistogram*> larger_histograms(num_children, nullptr);
+  std::vector<FeatureHistogram*> parent_histograms(num_children, nullptr);
+  std::vector<std::vector<int8_t>> is_feature_used(num_children);
+  std::vector<int8_t> is_feature_used_in_level(num_features_, 0);
+  std::vector<const data_size_t*> slot_data_indices;
+  std::vector<data_size_t> slot_num_data;
+  std::vector<hist_t*> slot_hist_data;
+  auto add_slot = [&] (const LeafSplits& leaf_splits, FeatureHistogram* histogram_array) {
+    slot_data_indices.push_back(leaf_splits.data_indices());
+    slot_num_data.push_back(leaf_splits.num_data_in_leaf());
+    slot_hist_data.push_back(histogram_array[0].RawData() - kHistOffset);
+  };
+  for (int i = 0; i < num_children; ++i) {
+    const int left_leaf = std::min(children[i].first.leaf_index(), children[i].second.leaf_index());
+    const int right_leaf = std::max(children[i].first.leaf_index(), children[i].second.leaf_index());
+    // the pool holds all the leaves, so the histograms of the other children are kept
+    if (!BeforeFindBestSplit(tree, left_leaf, right_leaf)) {
+      continue;
+    }
+    is_split_needed[i] = true;
+    smaller_histograms[i] = smaller_leaf_histogram_array_;
+    larger_histograms[i] = larger_leaf_histogram_array_;
+    parent_histograms[i] = parent_leaf_histogram_array_;
+    is_feature_used[i].resize(num_features_, 0);
+    for (int feature_index = 0; feature_index < num_features_; ++feature_index) {
+      if (!col_sampler_.is_feature_used_bytree()[feature_index]) continue;
+      if (parent_histograms[i] != nullptr && !parent_histograms[i][feature_index].is_splittable()) {
+        smaller_histograms[i][feature_index].set_is_splittable(false);
+        continue;
+      }
+      is_feature_used[i][feature_index] = 1;
+      is_feature_used_in_level[feature_index] = 1;
+    }
+    add_slot(children[i].first, smaller_histograms[i]);
+    if (parent_histograms[i] == nullptr) {
+      add_slot(children[i].second, larger_histograms[i]);
+    }
+  }
+  const int num_slots = static_cast<int>(slot_hist_data.size());
+  if (num_slots > 0) {
+    // gather the data of all the slots by increasing index, so that the bins are read in a single forward pass
+    row_leaf_slots_.resize(num_data_, -1);
+    level_data_indices_.resize(num_data_);
+    level_leaf_slots_.resize(num_data_);
+    for (int slot = 0; slot < num_slots; ++slot) {
+      const data_size_t* indices = slot_data_indices[slot];
+#pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static, 512) if (slot_num_data[slot] >= 1024)
+      for (data_size_t i = 0; i < slot_num_data[slot]; ++i) {
+        row_leaf_slots_[indices[i]] = slot;
+      }
+    }
+    int n_block = 1;
+    data_size_t block_size = num_data_;
+    Threading::BlockInfo<data_size_t>(num_data_, 1024, &n_block, &block_size);
+    std::vector<data_size_t> block_start(n_block + 1, 0);
+#pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static, 1)
+    for (int block = 0; block < n_block; ++block) {
+      const data_size_t end = std::min(num_data_, (block + 1) * block_size);
+      data_size_t cnt = 0;
+      for (data_size_t i = block * block_size; i < end; ++i) {
+        cnt += row_leaf_slots_[i] >= 0;
+      }
+      block_start[block + 1] = cnt;
+    }
+    for (int block = 0; block < n_block; ++block) {
+      block_start[block + 1] += block_start[block];
+    }
+#pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static, 1)
+    for (int block = 0; block < n_block; ++block) {
+      const data_size_t end = std::min(num_data_, (block + 1) * block_size);
+      data_size_t pos = block_start[block];
+      for (data_size_t i = block * block_size; i < end; ++i) {
+        const int slot = row_leaf_slots_[i];
+        if (slot >= 0) {
+          level_data_indices_[pos] = i;
+          level_leaf_slots_[pos] = slot;
+          row_leaf_slots_[i] = -1;
+          ++pos;
+        }
+      }
+    }
+    train_data_->ConstructHistogramsMultiLeaf(
+        is_feature_used_in_level, level_data_indices_.data(), level_leaf_slots_.data(),
+        block_start[n_block], slot_data_indices, slot_num_data, gradients_, hessians_,
+        ordered_gradients_.data(), ordered_hessians_.data(), share_state_.get(), slot_hist_data);
+  }
+  for (int i = 0; i < num_children; ++i) {
+    if (!is_split_needed[i]) {
+      continue;
+    }
+    *smaller_leaf_splits_ = children[i].first;
+    *larger_leaf_splits_ = children[i].second;
+    smaller_leaf_histogram_array_ = smaller_histograms[i];
+    larger_leaf_histogram_array_ = larger_histograms[i];
+    parent_leaf_histogram_array_ = parent_histograms[i];
+    FindBestSplitsFromHistograms(is_feature_used[i], parent_histograms[i] != nullptr, tree);
+  }
+}
+
 void SerialTreeLearner::FindBestSplitsFromHistograms(
     const std::vector<int8_t>& is_feature_used, bool use_subtract, const Tree* tree) {
   Common::FunctionTimer fun_timer(
@@ -779,6 +1002,7 @@ void SerialTreeLearner::SplitInner(Tree* tree, int best_leaf, int* left_leaf,
     data_partition_->Split(best_leaf, train_data_, inner_feature_index,
                            &best_split_info.threshold, 1,
                            best_split_info.default_left, next_leaf_id);
+    SplitLeafOrderedBins(best_leaf, next_leaf_id);
     if (update_cnt) {
       // don't need to update this in data-based parallel model
       best_split_info.left_count = data_partition_->leaf_count(*left_leaf);
@@ -814,6 +1038,7 @@ void SerialTreeLearner::SplitInner(Tree* tree, int best_leaf, int* left_leaf,
                            cat_bitset_inner.data(),
                            static_cast<int>(cat_bitset_inner.size()),
                            best_split_info.default_left, next_leaf_id);
+    SplitLeafOrderedBins(best_leaf, next_leaf_id);
 
     if (update_cnt) {
       // don't need to update this in data-based parallel model
@@ -20,6 +20,7 @@
 #include <random>
 #include <vector>
 #include <set>
+#include <utility>
 
 #include "col_sampler.hpp"
 #include "data_partition.hpp"
@@ -77,6 +78,13 @@ class SerialTreeLearner: public TreeLearner {
     }
   }
 
+  /*!
+  * \brief Construct the root histograms of all the trees of the iteration with one pass over the data,
+  *        when multiclass_root_histograms is set
+  */
+  void BeforeTrainIteration(const std::vector<const score_t*>& gradients,
+                            const std::vector<const score_t*>& hessians) override;
+
   Tree* Train(const score_t* gradients, const score_t *hessians, bool is_first_tree) override;
 
   Tree* FitByExistingTree(const Tree* old_tree, const score_t* gradients, const score_t* hessians) const override;
@@ -150,6 +158,21 @@ class SerialTreeLearner: public TreeLearner {
 
   virtual void FindBestSplitsFromHistograms(const std::vector<int8_t>& is_feature_used, bool use_subtract, const Tree*);
 
+  /*!
+  * \brief Grow the tree level by level, splitting the leaves of a level by decreasing gain
+  * \param tree Current tree, only has the root leaf
+  * \param cur_depth Depth of the tree, updated
+  */
+  void GrowDepthWise(Tree* tree, int* cur_depth);
+
+  /*!
+  * \brief Find the best splits of the children of the splits of a level,
+  *        the histograms of their smaller leaves are constructed in a single pass
+  * \param tree Current tree
+  * \param children Smaller and larger leaf of each split of the level
+  */
+  void FindBestSplitsForLevel(const Tree* tree, const std::vector<std::pair<LeafSplits, LeafSplits>>& children);
+
   /*!
   * \brief Partition tree and data according best split.
   * \param tree Current tree, will be splitted on this function.
@@ -182,6 +205,23 @@ class SerialTreeLearner: public TreeLearner {
   */
   inline virtual data_size_t GetGlobalDataCountInLeaf(int leaf_idx) const;
 
+  /*!
+  * \brief Get the root histograms of the current tree from the ones constructed by BeforeTrainIteration
+  * \param hist_data Histograms of the root
+  * \return Whether the histograms were constructed by BeforeTrainIteration, each tree gets them only once
+  */
+  bool GetIterationRootHistograms(hist_t* hist_data);
+
+  /*!
+  * \brief Partition the leaf-ordered bins of the share states like the data partition, after it split a leaf
+  * \param left_leaf Index of the split leaf, now its left child
+  * \param right_leaf Index of the right child
+  */
+  void SplitLeafOrderedBins(int left_leaf, int right_leaf) {
+    share_state_->SplitLeafOrderedBins(data_partition_->leaf_begin(left_leaf), data_partition_->leaf_count(left_leaf),
+                                       data_partition_->leaf_count(right_leaf));
+  }
+
   /*! \brief number of data */
   data_size_t num_data_;
   /*! \brief number of features */
@@ -236,6 +276,18 @@ class SerialTreeLearner: public TreeLearner {
   std::unique_ptr<TrainingShareStates> share_state_;
   std::unique_ptr<CostEfficientGradientBoosting> cegb_;
   std::unique_ptr<GradientDiscretizer> gradient_discretizer_;
+  /*! \brief histogram slot of the leaf of each data during depth-wise growth, -1 when unused */
+  std::vector<int> row_leaf_slots_;
+  /*! \brief data indices of the leaves whose histograms are constructed together, in increasing order */
+  std::vector<data_size_t> level_data_indices_;
+  /*! \brief histogram slot of each data of level_data_indices_ */
+  std::vector<int> level_leaf_slots_;
+  /*! \brief interleaved root histograms of the trees of the current iteration, see BeforeTrainIteration */
+  std::vector<hist_t, Common::AlignmentAllocator<hist_t, kAlignedSize>> iteration_root_hist_;
+  /*! \brief gradients of the trees with root histograms in iteration_root_hist_, nullptr once they are used */
+  std::vector<const score_t*> iteration_root_gradients_;
+  /*! \brief hessians of the trees with root histograms in iteration_root_hist_ */
+  std::vector<const score_t*> iteration_root_hessians_;
 };
 
 inline data_size_t SerialTreeLearner::GetGlobalDataCountInLeaf(int leaf_idx) const {
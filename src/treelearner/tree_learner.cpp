@@ -6,6 +6,7 @@
 
 #include "gpu_tree_learner.h"
 #include "linear_tree_learner.h"
+#include "oblivious_tree_learner.h"
 #include "parallel_tree_learner.h"
 #include "serial_tree_learner.h"
 #include "cuda/cuda_single_gpu_tree_learner.hpp"
@@ -18,6 +19,8 @@ TreeLearner* TreeLearner::CreateTreeLearner(const std::string& learner_type, con
     if (learner_type == std::string("serial")) {
       if (config->linear_tree) {
         return new LinearTreeLearner(config);
+      } else if (config->oblivious_tree) {
+        return new ObliviousTreeLearner(config);
       } else {
         return new SerialTreeLearner(config);
       }
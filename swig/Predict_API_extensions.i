@@ -0,0 +1,252 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+/**
+ * This SWIG interface extension provides prediction wrappers which
+ * read the features and write the scores directly in Java memory,
+ * instead of going through the doubleArray/floatArray helpers of
+ * pointer_manipulation.i which require one JNI call per element.
+ *
+ * Two kinds of Java memory are supported:
+ *  - direct java.nio.ByteBuffer (ByteBuffer.allocateDirect), whose address
+ *    is stable and can be used without blocking the garbage collector.
+ *    The buffers must use the native byte order (ByteOrder.nativeOrder()).
+ *    Their content is read/written from the position 0, regardless of the
+ *    current position of the buffer.
+ *  - Java primitive arrays, pinned with GetPrimitiveArrayCritical
+ *    for the duration of the call. The garbage collector may be
+ *    blocked meanwhile, so prefer direct buffers for large batches.
+ *
+ * The wrappers names end with "SWIG" and return the C API code
+ * (0 on success, -1 on failure, see LGBM_GetLastError()).
+ */
+
+%typemap(jni) jobject DIRECT_BUFFER "jobject"
+%typemap(jtype) jobject DIRECT_BUFFER "java.nio.ByteBuffer"
+%typemap(jstype) jobject DIRECT_BUFFER "java.nio.ByteBuffer"
+%typemap(in) jobject DIRECT_BUFFER %{
+  $1 = $input;
+%}
+%typemap(javain) jobject DIRECT_BUFFER "$javainput"
+
+%apply jobject DIRECT_BUFFER { jobject data_buffer, jobject out_buffer }
+
+%{
+    #include <string>
+
+    /**
+     * @brief Returns the address of a direct buffer holding at least required_bytes bytes.
+     *
+     * @return the address, or nullptr (with the last error set) if the buffer is not direct or too small.
+     */
+    void* LGBM_GetDirectBufferAddressSWIG(JNIEnv *jenv, jobject buffer, int64_t required_bytes, const char* name)
+    {
+        void* address = buffer == nullptr ? nullptr : jenv->GetDirectBufferAddress(buffer);
+        if (address == nullptr) {
+            std::string msg = std::string(name) + " must be a direct java.nio.ByteBuffer.";
+            LGBM_SetLastError(msg.c_str());
+            return nullptr;
+        }
+        if (jenv->GetDirectBufferCapacity(buffer) < required_bytes) {
+            std::string msg = std::string(name) + " is too small, it needs " + std::to_string(required_bytes) + " bytes.";
+            LGBM_SetLastError(msg.c_str());
+            return nullptr;
+        }
+        return address;
+    }
+
+    /**
+     * @brief Pins data and out_result with GetPrimitiveArrayCritical.
+     *
+     * @return true on success, false (with the last error set and nothing pinned) if the JVM could not pin them.
+     */
+    bool LGBM_PinArraysSWIG(JNIEnv *jenv, jdoubleArray data, double** data0,
+                            jdoubleArray out_result, double** out_result0)
+    {
+        *data0 = static_cast<double*>(jenv->GetPrimitiveArrayCritical(data, 0));
+        if (*data0 == nullptr) {
+            LGBM_SetLastError("Could not pin data.");
+            return false;
+        }
+        *out_result0 = static_cast<double*>(jenv->GetPrimitiveArrayCritical(out_result, 0));
+        if (*out_result0 == nullptr) {
+            jenv->ReleasePrimitiveArrayCritical(data, *data0, JNI_ABORT);
+            LGBM_SetLastError("Could not pin out_result.");
+            return false;
+        }
+        return true;
+    }
+%}
+
+%inline %{
+
+    /**
+     * @brief Wraps LGBM_BoosterPredictForMat with direct buffers.
+     *
+     * @param data_buffer Direct buffer with the nrow * ncol features, of type data_type
+     * @param out_buffer Direct buffer receiving the doubles of the predictions,
+     *                   its size can be computed with LGBM_BoosterCalcNumPredict
+     * @return 0 on success, -1 on failure
+     */
+    int LGBM_BoosterPredictForMatDirectSWIG(JNIEnv *jenv,
+                                            jobject data_buffer,
+                                            BoosterHandle handle,
+                                            int data_type,
+                                            int32_t nrow,
+                                            int32_t ncol,
+                                            int is_row_major,
+                                            int predict_type,
+                                            int start_iteration,
+                                            int num_iteration,
+                                            const char* parameter,
+                                            int64_t* out_len,
+                                            jobject out_buffer)
+    {
+        int64_t value_size = data_type == C_API_DTYPE_FLOAT32 ? sizeof(float) : sizeof(double);
+        void* data = LGBM_GetDirectBufferAddressSWIG(jenv, data_buffer,
+                                                     static_cast<int64_t>(nrow) * ncol * value_size,
+                                                     "data_buffer");
+        if (data == nullptr) {
+            return -1;
+        }
+        int64_t num_predict;
+        API_OK_OR_VALUE(LGBM_BoosterCalcNumPredict(handle, nrow, predict_type, start_iteration,
+                                                   num_iteration, &num_predict), -1);
+        void* out_result = LGBM_GetDirectBufferAddressSWIG(jenv, out_buffer,
+                                                           num_predict * static_cast<int64_t>(sizeof(double)),
+                                                           "out_buffer");
+        if (out_result == nullptr) {
+            return -1;
+        }
+        return LGBM_BoosterPredictForMat(handle, data, data_type, nrow, ncol, is_row_major, predict_type,
+                                         start_iteration, num_iteration, parameter, out_len,
+                                         static_cast<double*>(out_result));
+    }
+
+    /**
+     * @brief Wraps LGBM_BoosterPredictForMat with Java arrays pinned by GetPrimitiveArrayCritical.
+     *
+     * The garbage collector may be blocked while the batch is predicted,
+     * LGBM_BoosterPredictForMatDirectSWIG has no such drawback.
+     *
+     * @param data Row-major (or column-major) doubles of the nrow * ncol features
+     * @param out_result Array receiving the predictions,
+     *                   its size can be computed with LGBM_BoosterCalcNumPredict
+     * @return 0 on success, -1 on failure
+     */
+    int LGBM_BoosterPredictForMatCriticalSWIG(JNIEnv *jenv,
+                                              jdoubleArray data,
+                                              BoosterHandle handle,
+                                              int32_t nrow,
+                                              int32_t ncol,
+                                              int is_row_major,
+                                              int predict_type,
+                                              int start_iteration,
+                                              int num_iteration,
+                                              const char* parameter,
+                                              int64_t* out_len,
+                                              jdoubleArray out_result)
+    {
+        int64_t num_predict;
+        API_OK_OR_VALUE(LGBM_BoosterCalcNumPredict(handle, nrow, predict_type, start_iteration,
+                                                   num_iteration, &num_predict), -1);
+        if (jenv->GetArrayLength(data) < static_cast<int64_t>(nrow) * ncol
+            || jenv->GetArrayLength(out_result) < num_predict) {
+            LGBM_SetLastError("data or out_result is too small.");
+            return -1;
+        }
+
+        double* data0;
+        double* out_result0;
+        if (!LGBM_PinArraysSWIG(jenv, data, &data0, out_result, &out_result0)) {
+            return -1;
+        }
+
+        int ret = LGBM_BoosterPredictForMat(handle, data0, C_API_DTYPE_FLOAT64, nrow, ncol, is_row_major, predict_type,
+                                            start_iteration, num_iteration, parameter, out_len, out_result0);
+
+        // the predictions are copied back (mode 0) in case the JVM pinned copies
+        jenv->ReleasePrimitiveArrayCritical(out_result, out_result0, 0);
+        jenv->ReleasePrimitiveArrayCritical(data, data0, JNI_ABORT);
+
+        return ret;
+    }
+
+    /**
+     * @brief Wraps LGBM_BoosterPredictForMatSingleRowFast with direct buffers.
+     *
+     * Nothing is allocated and no array is pinned, which makes it
+     * the cheapest way to score rows one at a time from Java:
+     * the same buffers can be refilled and reused for every row.
+     *
+     * @param data_buffer Direct buffer with the features of the row,
+     *                    of the type and number given to LGBM_BoosterPredictForMatSingleRowFastInit
+     * @param out_buffer Direct buffer receiving the doubles of the prediction
+     * @return 0 on success, -1 on failure
+     */
+    int LGBM_BoosterPredictForMatSingleRowFastDirectSWIG(JNIEnv *jenv,
+                                                         jobject data_buffer,
+                                                         FastConfigHandle handle,
+                                                         int64_t* out_len,
+                                                         jobject out_buffer)
+    {
+        int data_type;
+        int32_t ncol;
+        int64_t num_predict;
+        API_OK_OR_VALUE(LGBM_FastConfigGetShape(handle, &data_type, &ncol, &num_predict), -1);
+        int64_t value_size = data_type == C_API_DTYPE_FLOAT32 ? sizeof(float) : sizeof(double);
+        void* data = LGBM_GetDirectBufferAddressSWIG(jenv, data_buffer, ncol * value_size, "data_buffer");
+        if (data == nullptr) {
+            return -1;
+        }
+        void* out_result = LGBM_GetDirectBufferAddressSWIG(jenv, out_buffer,
+                                                           num_predict * static_cast<int64_t>(sizeof(double)),
+                                                           "out_buffer");
+        if (out_result == nullptr) {
+            return -1;
+        }
+        return LGBM_BoosterPredictForMatSingleRowFast(handle, data, out_len, static_cast<double*>(out_result));
+    }
+
+    /**
+     * @brief Variant of LGBM_BoosterPredictForMatSingleRowFastCriticalSWIG
+     *        which also writes the prediction in a pinned Java array.
+     *
+     * @param data Doubles of the features of the row, the FastConfig must be initialized with C_API_DTYPE_FLOAT64
+     * @param out_result Array receiving the prediction
+     * @return 0 on success, -1 on failure
+     */
+    int LGBM_BoosterPredictForMatSingleRowFastCriticalOutSWIG(JNIEnv *jenv,
+                                                              jdoubleArray data,
+                                                              FastConfigHandle handle,
+                                                              int64_t* out_len,
+                                                              jdoubleArray out_result)
+    {
+        int data_type;
+        int32_t ncol;
+        int64_t num_predict;
+        API_OK_OR_VALUE(LGBM_FastConfigGetShape(handle, &data_type, &ncol, &num_predict), -1);
+        if (data_type != C_API_DTYPE_FLOAT64) {
+            LGBM_SetLastError("The FastConfig must be initialized with C_API_DTYPE_FLOAT64 for a double array.");
+            return -1;
+        }
+        if (jenv->GetArrayLength(data) < ncol || jenv->GetArrayLength(out_result) < num_predict) {
+            LGBM_SetLastError("data or out_result is too small.");
+            return -1;
+        }
+
+        double* data0;
+        double* out_result0;
+        if (!LGBM_PinArraysSWIG(jenv, data, &data0, out_result, &out_result0)) {
+            return -1;
+        }
+
+        int ret = LGBM_BoosterPredictForMatSingleRowFast(handle, data0, out_len, out_result0);
+
+        jenv->ReleasePrimitiveArrayCritical(out_result, out_result0, 0);
+        jenv->ReleasePrimitiveArrayCritical(data, data0, JNI_ABORT);
+
+        return ret;
+    }
+%}
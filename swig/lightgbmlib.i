@@ -282,4 +282,5 @@
 
 %include "pointer_manipulation.i"
 %include "StringArray_API_extensions.i"
+%include "Predict_API_extensions.i"
 %include "ChunkedArray_API_extensions.i"
@@ -0,0 +1,195 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+import com.microsoft.ml.lightgbm.SWIGTYPE_p_double;
+import com.microsoft.ml.lightgbm.SWIGTYPE_p_float;
+import com.microsoft.ml.lightgbm.SWIGTYPE_p_int;
+import com.microsoft.ml.lightgbm.SWIGTYPE_p_long_long;
+import com.microsoft.ml.lightgbm.SWIGTYPE_p_p_void;
+import com.microsoft.ml.lightgbm.SWIGTYPE_p_void;
+import com.microsoft.ml.lightgbm.lightgbmlib;
+import com.microsoft.ml.lightgbm.lightgbmlibConstants;
+
+import java.io.File;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.Random;
+
+/**
+ * Checks the prediction wrappers of Predict_API_extensions.i against LGBM_BoosterPredictForMat,
+ * and that they reject buffers and arrays which are too small.
+ *
+ * Run with the directory of lib_lightgbm and lib_lightgbm_swig in the lightgbm.lib.dir property:
+ *   javac -cp lightgbmlib.jar -d . swig/tests/PredictDirectTest.java
+ *   java -cp lightgbmlib.jar:. -Dlightgbm.lib.dir=. PredictDirectTest
+ */
+public final class PredictDirectTest {
+    private static final int NUM_ROWS = 500;
+    private static final int NUM_COLS = 5;
+    private static final int NUM_ITERATIONS = 5;
+
+    private PredictDirectTest() {
+    }
+
+    private static void check(boolean condition, String message) {
+        if (!condition) {
+            throw new AssertionError(message);
+        }
+    }
+
+    private static void checkOk(int ret) {
+        check(ret == 0, lightgbmlib.LGBM_GetLastError());
+    }
+
+    private static ByteBuffer directDoubles(double[] values, int from, int count) {
+        ByteBuffer buffer = ByteBuffer.allocateDirect(count * 8).order(ByteOrder.nativeOrder());
+        for (int i = 0; i < count; ++i) {
+            buffer.putDouble(i * 8, values[from + i]);
+        }
+        return buffer;
+    }
+
+    public static void main(String[] args) {
+        String libDir = System.getProperty("lightgbm.lib.dir", ".");
+        System.load(new File(libDir, System.mapLibraryName("_lightgbm")).getAbsolutePath());
+        System.load(new File(libDir, System.mapLibraryName("_lightgbm_swig")).getAbsolutePath());
+
+        Random rand = new Random(42);
+        double[] features = new double[NUM_ROWS * NUM_COLS];
+        SWIGTYPE_p_double nativeFeatures = lightgbmlib.new_doubleArray(features.length);
+        SWIGTYPE_p_float nativeLabels = lightgbmlib.new_floatArray(NUM_ROWS);
+        for (int i = 0; i < NUM_ROWS; ++i) {
+            for (int j = 0; j < NUM_COLS; ++j) {
+                features[i * NUM_COLS + j] = rand.nextDouble();
+                lightgbmlib.doubleArray_setitem(nativeFeatures, i * NUM_COLS + j, features[i * NUM_COLS + j]);
+            }
+            lightgbmlib.floatArray_setitem(nativeLabels, i,
+                                           (float) (features[i * NUM_COLS] + 2 * features[i * NUM_COLS + 1]));
+        }
+
+        SWIGTYPE_p_p_void datasetOut = lightgbmlib.voidpp_handle();
+        checkOk(lightgbmlib.LGBM_DatasetCreateFromMat(lightgbmlib.double_to_voidp_ptr(nativeFeatures),
+                                                      lightgbmlibConstants.C_API_DTYPE_FLOAT64, NUM_ROWS, NUM_COLS, 1,
+                                                      "min_data_in_leaf=5 verbose=-1", null, datasetOut));
+        SWIGTYPE_p_void dataset = lightgbmlib.voidpp_value(datasetOut);
+        checkOk(lightgbmlib.LGBM_DatasetSetField(dataset, "label", lightgbmlib.float_to_voidp_ptr(nativeLabels),
+                                                 NUM_ROWS, lightgbmlibConstants.C_API_DTYPE_FLOAT32));
+        SWIGTYPE_p_p_void boosterOut = lightgbmlib.voidpp_handle();
+        checkOk(lightgbmlib.LGBM_BoosterCreate(dataset, "objective=regression num_leaves=7 verbose=-1", boosterOut));
+        SWIGTYPE_p_void booster = lightgbmlib.voidpp_value(boosterOut);
+        SWIGTYPE_p_int isFinished = lightgbmlib.new_intp();
+        for (int i = 0; i < NUM_ITERATIONS; ++i) {
+            checkOk(lightgbmlib.LGBM_BoosterUpdateOneIter(booster, isFinished));
+        }
+
+        // reference predictions, element by element
+        SWIGTYPE_p_long_long outLen = lightgbmlib.new_int64_tp();
+        SWIGTYPE_p_double nativeOut = lightgbmlib.new_doubleArray(NUM_ROWS);
+        checkOk(lightgbmlib.LGBM_BoosterPredictForMat(booster, lightgbmlib.double_to_voidp_ptr(nativeFeatures),
+                                                      lightgbmlibConstants.C_API_DTYPE_FLOAT64, NUM_ROWS, NUM_COLS, 1,
+                                                      lightgbmlibConstants.C_API_PREDICT_NORMAL, 0, -1, "",
+                                                      outLen, nativeOut));
+        double[] expected = new double[NUM_ROWS];
+        for (int i = 0; i < NUM_ROWS; ++i) {
+            expected[i] = lightgbmlib.doubleArray_getitem(nativeOut, i);
+        }
+
+        // batch wrappers
+        ByteBuffer dataBuffer = directDoubles(features, 0, features.length);
+        ByteBuffer outBuffer = ByteBuffer.allocateDirect(NUM_ROWS * 8).order(ByteOrder.nativeOrder());
+        checkOk(lightgbmlib.LGBM_BoosterPredictForMatDirectSWIG(dataBuffer, booster,
+                                                                lightgbmlibConstants.C_API_DTYPE_FLOAT64,
+                                                                NUM_ROWS, NUM_COLS, 1,
+                                                                lightgbmlibConstants.C_API_PREDICT_NORMAL, 0, -1, "",
+                                                                outLen, outBuffer));
+        double[] out = new double[NUM_ROWS];
+        checkOk(lightgbmlib.LGBM_BoosterPredictForMatCriticalSWIG(features, booster, NUM_ROWS, NUM_COLS, 1,
+                                                                  lightgbmlibConstants.C_API_PREDICT_NORMAL, 0, -1, "",
+                                                                  outLen, out));
+        for (int i = 0; i < NUM_ROWS; ++i) {
+            check(outBuffer.getDouble(i * 8) == expected[i], "direct batch mismatch at row " + i);
+            check(out[i] == expected[i], "critical batch mismatch at row " + i);
+        }
+        check(lightgbmlib.LGBM_BoosterPredictForMatDirectSWIG(dataBuffer, booster,
+                                                              lightgbmlibConstants.C_API_DTYPE_FLOAT64,
+                                                              NUM_ROWS + 1, NUM_COLS, 1,
+                                                              lightgbmlibConstants.C_API_PREDICT_NORMAL, 0, -1, "",
+                                                              outLen, outBuffer) == -1,
+              "direct batch accepted a short data buffer");
+        check(lightgbmlib.LGBM_BoosterPredictForMatCriticalSWIG(features, booster, NUM_ROWS, NUM_COLS, 1,
+                                                                lightgbmlibConstants.C_API_PREDICT_NORMAL, 0, -1, "",
+                                                                outLen, new double[NUM_ROWS - 1]) == -1,
+              "critical batch accepted a short output array");
+
+        // single row wrappers
+        SWIGTYPE_p_p_void fastConfigOut = lightgbmlib.voidpp_handle();
+        checkOk(lightgbmlib.LGBM_BoosterPredictForMatSingleRowFastInit(booster,
+                                                                       lightgbmlibConstants.C_API_PREDICT_NORMAL,
+                                                                       0, -1, lightgbmlibConstants.C_API_DTYPE_FLOAT64,
+                                                                       NUM_COLS, "", fastConfigOut));
+        SWIGTYPE_p_void fastConfig = lightgbmlib.voidpp_value(fastConfigOut);
+        ByteBuffer rowBuffer = ByteBuffer.allocateDirect(NUM_COLS * 8).order(ByteOrder.nativeOrder());
+        ByteBuffer rowOutBuffer = ByteBuffer.allocateDirect(8).order(ByteOrder.nativeOrder());
+        double[] row = new double[NUM_COLS];
+        double[] rowOut = new double[1];
+        for (int i = 0; i < NUM_ROWS; ++i) {
+            for (int j = 0; j < NUM_COLS; ++j) {
+                row[j] = features[i * NUM_COLS + j];
+                rowBuffer.putDouble(j * 8, row[j]);
+            }
+            checkOk(lightgbmlib.LGBM_BoosterPredictForMatSingleRowFastDirectSWIG(rowBuffer, fastConfig, outLen,
+                                                                                 rowOutBuffer));
+            checkOk(lightgbmlib.LGBM_BoosterPredictForMatSingleRowFastCriticalOutSWIG(row, fastConfig, outLen,
+                                                                                      rowOut));
+            check(rowOutBuffer.getDouble(0) == expected[i], "direct single row mismatch at row " + i);
+            check(rowOut[0] == expected[i], "critical single row mismatch at row " + i);
+        }
+        check(lightgbmlib.LGBM_BoosterPredictForMatSingleRowFastDirectSWIG(directDoubles(row, 0, NUM_COLS - 1),
+                                                                           fastConfig, outLen, rowOutBuffer) == -1,
+              "direct single row accepted a short data buffer");
+        check(lightgbmlib.LGBM_BoosterPredictForMatSingleRowFastDirectSWIG(ByteBuffer.allocate(NUM_COLS * 8),
+                                                                           fastConfig, outLen, rowOutBuffer) == -1,
+              "direct single row accepted a heap buffer");
+        check(lightgbmlib.LGBM_BoosterPredictForMatSingleRowFastCriticalOutSWIG(new double[NUM_COLS - 1],
+                                                                                fastConfig, outLen, rowOut) == -1,
+              "critical single row accepted a short data array");
+        checkOk(lightgbmlib.LGBM_FastConfigFree(fastConfig));
+
+        // the contributions of a row need one output per feature, plus the expected value
+        checkOk(lightgbmlib.LGBM_BoosterPredictForMatSingleRowFastInit(booster,
+                                                                       lightgbmlibConstants.C_API_PREDICT_CONTRIB,
+                                                                       0, -1, lightgbmlibConstants.C_API_DTYPE_FLOAT64,
+                                                                       NUM_COLS, "", fastConfigOut));
+        fastConfig = lightgbmlib.voidpp_value(fastConfigOut);
+        check(lightgbmlib.LGBM_BoosterPredictForMatSingleRowFastDirectSWIG(rowBuffer, fastConfig, outLen,
+                                                                           rowOutBuffer) == -1,
+              "direct single row accepted a short output buffer");
+        check(lightgbmlib.LGBM_BoosterPredictForMatSingleRowFastCriticalOutSWIG(row, fastConfig, outLen,
+                                                                                rowOut) == -1,
+              "critical single row accepted a short output array");
+        ByteBuffer contribBuffer = ByteBuffer.allocateDirect((NUM_COLS + 1) * 8).order(ByteOrder.nativeOrder());
+        checkOk(lightgbmlib.LGBM_BoosterPredictForMatSingleRowFastDirectSWIG(rowBuffer, fastConfig, outLen,
+                                                                             contribBuffer));
+        check(lightgbmlib.int64_tp_value(outLen) == NUM_COLS + 1, "wrong number of contributions");
+        checkOk(lightgbmlib.LGBM_FastConfigFree(fastConfig));
+
+        // a double array cannot be read as float32 features
+        checkOk(lightgbmlib.LGBM_BoosterPredictForMatSingleRowFastInit(booster,
+                                                                       lightgbmlibConstants.C_API_PREDICT_NORMAL,
+                                                                       0, -1, lightgbmlibConstants.C_API_DTYPE_FLOAT32,
+                                                                       NUM_COLS, "", fastConfigOut));
+        fastConfig = lightgbmlib.voidpp_value(fastConfigOut);
+        check(lightgbmlib.LGBM_BoosterPredictForMatSingleRowFastCriticalOutSWIG(row, fastConfig, outLen,
+                                                                                rowOut) == -1,
+              "critical single row accepted a float32 FastConfig");
+        checkOk(lightgbmlib.LGBM_FastConfigFree(fastConfig));
+
+        checkOk(lightgbmlib.LGBM_BoosterFree(booster));
+        checkOk(lightgbmlib.LGBM_DatasetFree(dataset));
+        lightgbmlib.delete_doubleArray(nativeFeatures);
+        lightgbmlib.delete_floatArray(nativeLabels);
+        lightgbmlib.delete_doubleArray(nativeOut);
+        System.out.println("PredictDirectTest passed");
+    }
+}
@@ -0,0 +1,250 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+
+#include <gtest/gtest.h>
+#include <LightGBM/bin.h>
+#include <LightGBM/utils/random.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+using LightGBM::Bin;
+using LightGBM::data_size_t;
+using LightGBM::hist_cnt_t;
+using LightGBM::hist_t;
+using LightGBM::MultiValBin;
+using LightGBM::Random;
+using LightGBM::score_t;
+
+namespace {
+
+const data_size_t kNumData = 5000;
+
+/*!
+ * Gradients and hessians, as floats and as int8 pairs packed in an int16, for the rows
+ * of the data or gathered in the order of some indices.
+ */
+struct Scores {
+  Scores(Random* rand, const std::vector<data_size_t>& indices) {
+    for (data_size_t i = 0; i < kNumData; ++i) {
+      gradients.push_back(rand->NextFloat() * 2.0f - 1.0f);
+      hessians.push_back(rand->NextFloat());
+      const int gradient = rand->NextShort(0, 120) - 60;
+      const int hessian = rand->NextShort(0, 60);
+      quantized.push_back(static_cast<int16_t>((gradient * 256) | hessian));
+    }
+    for (auto idx : indices) {
+      ordered_gradients.push_back(gradients[idx]);
+      ordered_hessians.push_back(hessians[idx]);
+      ordered_quantized.push_back(quantized[idx]);
+    }
+  }
+
+  /*! \brief The quantized gradients and hessians take the place of the float gradients */
+  const score_t* Quantized(bool ordered) const {
+    return reinterpret_cast<const score_t*>(ordered ? ordered_quantized.data() : quantized.data());
+  }
+
+  std::vector<score_t> gradients;
+  std::vector<score_t> hessians;
+  std::vector<int16_t> quantized;
+  std::vector<score_t> ordered_gradients;
+  std::vector<score_t> ordered_hessians;
+  std::vector<int16_t> ordered_quantized;
+};
+
+/*!
+ * Histograms accumulated row after row, as by the scalar loops of the bins.
+ * Each row has a position in the histogram per feature.
+ */
+class ReferenceHistogram {
+ public:
+  ReferenceHistogram(int num_bin, const std::vector<std::vector<uint32_t>>& bins, const Scores& scores)
+      : num_bin_(num_bin), bins_(bins), scores_(scores) {}
+
+  std::vector<hist_t> Float(const data_size_t* indices, data_size_t start, data_size_t end,
+                            bool ordered, bool use_hessian) const {
+    std::vector<hist_t> hist(num_bin_ * 2, 0.0);
+    hist_cnt_t* cnt = reinterpret_cast<hist_cnt_t*>(hist.data());
+    for (data_size_t i = start; i < end; ++i) {
+      const data_size_t idx = indices != nullptr ? indices[i] : i;
+      const score_t gradient = ordered ? scores_.ordered_gradients[i] : scores_.gradients[idx];
+      const score_t hessian = ordered ? scores_.ordered_hessians[i] : scores_.hessians[idx];
+      for (const auto& feature_bins : bins_) {
+        const uint32_t ti = feature_bins[idx] << 1;
+        hist[ti] += gradient;
+        if (use_hessian) {
+          hist[ti + 1] += hessian;
+        } else {
+          ++cnt[ti + 1];
+        }
+      }
+    }
+    return hist;
+  }
+
+  template <typename PACKED_HIST_T, int HIST_BITS>
+  std::vector<hist_t> Int(const data_size_t* indices, data_size_t start, data_size_t end,
+                          bool ordered, bool use_hessian) const {
+    std::vector<hist_t> hist(num_bin_ * 2, 0.0);
+    PACKED_HIST_T* packed = reinterpret_cast<PACKED_HIST_T*>(hist.data());
+    for (data_size_t i = start; i < end; ++i) {
+      const data_size_t idx = indices != nullptr ? indices[i] : i;
+      const int16_t gradient_and_hessian = ordered ? scores_.ordered_quantized[i] : scores_.quantized[idx];
+      PACKED_HIST_T value = gradient_and_hessian;
+      if (HIST_BITS != 8) {
+        value = (static_cast<PACKED_HIST_T>(static_cast<int8_t>(gradient_and_hessian >> 8)) << HIST_BITS) |
+                (use_hessian ? static_cast<PACKED_HIST_T>(gradient_and_hessian & 0xff) : 1);
+      }
+      for (const auto& feature_bins : bins_) {
+        packed[feature_bins[idx]] += value;
+      }
+    }
+    return hist;
+  }
+
+ private:
+  int num_bin_;
+  const std::vector<std::vector<uint32_t>>& bins_;
+  const Scores& scores_;
+};
+
+/*! \brief Histograms of the same bits, the quantized ones are not doubles */
+::testing::AssertionResult SameBits(const std::vector<hist_t>& expected, const std::vector<hist_t>& actual) {
+  for (size_t k = 0; k < expected.size(); ++k) {
+    if (std::memcmp(&expected[k], &actual[k], sizeof(hist_t)) != 0) {
+      return ::testing::AssertionFailure() << "the histograms differ at " << k;
+    }
+  }
+  return ::testing::AssertionSuccess();
+}
+
+/*! \brief About two thirds of the rows, as the indices of a leaf */
+std::vector<data_size_t> CreateIndices(Random* rand) {
+  std::vector<data_size_t> indices;
+  for (data_size_t i = 0; i < kNumData; ++i) {
+    if (rand->NextShort(0, 3) != 0) {
+      indices.push_back(i);
+    }
+  }
+  return indices;
+}
+
+/*! \brief Ranges of rows, large and small, starting and ending anywhere */
+std::vector<std::pair<data_size_t, data_size_t>> CreateRanges(data_size_t num_indices) {
+  return {{0, num_indices}, {3, num_indices - 2}, {7, 110}, {5, 6}, {9, 9}};
+}
+
+}  // namespace
+
+// the SIMD kernels used when the CPU supports them accumulate the same histograms, to the bit
+TEST(Histogram, DenseBinsMatchTheScalarLoops) {
+  Random rand(17);
+  const std::vector<data_size_t> indices = CreateIndices(&rand);
+  const Scores scores(&rand, indices);
+  const data_size_t* idx = indices.data();
+
+  // 4-bit, 8-bit and 16-bit bins
+  for (int num_bin : {3, 16, 200, 256, 1000}) {
+    std::unique_ptr<Bin> bin(Bin::CreateDenseBin(kNumData, num_bin));
+    std::vector<std::vector<uint32_t>> bins(1, std::vector<uint32_t>(kNumData));
+    for (data_size_t i = 0; i < kNumData; ++i) {
+      // mostly the first bins, so that consecutive rows often share their bin
+      bins[0][i] = rand.NextShort(0, rand.NextShort(0, 4) == 0 ? num_bin : std::min(num_bin, 3));
+      bin->Push(0, i, bins[0][i]);
+    }
+    bin->FinishLoad();
+    const ReferenceHistogram reference(num_bin, bins, scores);
+    std::vector<hist_t> hist(num_bin * 2);
+    auto reset = [&hist] () {
+      std::fill(hist.begin(), hist.end(), 0.0);
+      return hist.data();
+    };
+    for (const auto& range : CreateRanges(static_cast<data_size_t>(indices.size()))) {
+      const data_size_t start = range.first;
+      const data_size_t end = range.second;
+      bin->ConstructHistogram(idx, start, end, scores.ordered_gradients.data(), scores.ordered_hessians.data(),
+                              reset());
+      EXPECT_TRUE(SameBits(reference.Float(idx, start, end, true, true), hist)) << num_bin;
+      bin->ConstructHistogram(start, end, scores.gradients.data(), scores.hessians.data(), reset());
+      EXPECT_TRUE(SameBits(reference.Float(nullptr, start, end, false, true), hist)) << num_bin;
+      bin->ConstructHistogram(idx, start, end, scores.ordered_gradients.data(), reset());
+      EXPECT_TRUE(SameBits(reference.Float(idx, start, end, true, false), hist)) << num_bin;
+      bin->ConstructHistogram(start, end, scores.gradients.data(), reset());
+      EXPECT_TRUE(SameBits(reference.Float(nullptr, start, end, false, false), hist)) << num_bin;
+
+      bin->ConstructHistogramInt8(idx, start, end, scores.Quantized(true), nullptr, reset());
+      EXPECT_TRUE(SameBits(reference.Int<int16_t, 8>(idx, start, end, true, true), hist)) << num_bin;
+      bin->ConstructHistogramInt8(start, end, scores.Quantized(false), reset());
+      EXPECT_TRUE(SameBits(reference.Int<int16_t, 8>(nullptr, start, end, false, false), hist)) << num_bin;
+      bin->ConstructHistogramInt16(idx, start, end, scores.Quantized(true), nullptr, reset());
+      EXPECT_TRUE(SameBits(reference.Int<int32_t, 16>(idx, start, end, true, true), hist)) << num_bin;
+      bin->ConstructHistogramInt16(idx, start, end, scores.Quantized(true), reset());
+      EXPECT_TRUE(SameBits(reference.Int<int32_t, 16>(idx, start, end, true, false), hist)) << num_bin;
+      bin->ConstructHistogramInt32(start, end, scores.Quantized(false), nullptr, reset());
+      EXPECT_TRUE(SameBits(reference.Int<int64_t, 32>(nullptr, start, end, false, true), hist)) << num_bin;
+      bin->ConstructHistogramInt32(start, end, scores.Quantized(false), reset());
+      EXPECT_TRUE(SameBits(reference.Int<int64_t, 32>(nullptr, start, end, false, false), hist)) << num_bin;
+    }
+  }
+}
+
+TEST(Histogram, MultiValDenseBinsMatchTheScalarLoops) {
+  Random rand(29);
+  const std::vector<data_size_t> indices = CreateIndices(&rand);
+  const Scores scores(&rand, indices);
+  const data_size_t* idx = indices.data();
+
+  // full and partial blocks of eight features, with 8-bit and 16-bit bins
+  for (int num_feature : {3, 8, 21}) {
+    for (int first_feature_num_bin : {40, 256, 300}) {
+      std::vector<uint32_t> offsets(1, 0);
+      for (int j = 0; j < num_feature; ++j) {
+        offsets.push_back(offsets.back() + (j == 0 ? first_feature_num_bin : rand.NextShort(2, 41)));
+      }
+      const int num_bin = static_cast<int>(offsets.back());
+      std::unique_ptr<MultiValBin> bin(MultiValBin::CreateMultiValDenseBin(kNumData, num_bin, num_feature,
+                                                                           offsets));
+      // the positions of the bins of the features in the histogram
+      std::vector<std::vector<uint32_t>> bins(num_feature, std::vector<uint32_t>(kNumData));
+      std::vector<uint32_t> values(num_feature);
+      for (data_size_t i = 0; i < kNumData; ++i) {
+        for (int j = 0; j < num_feature; ++j) {
+          values[j] = rand.NextShort(0, static_cast<int>(offsets[j + 1] - offsets[j]));
+          bins[j][i] = offsets[j] + values[j];
+        }
+        bin->PushOneRow(0, i, values);
+      }
+      bin->FinishLoad();
+      const ReferenceHistogram reference(num_bin, bins, scores);
+      std::vector<hist_t> hist(num_bin * 2);
+      auto reset = [&hist] () {
+        std::fill(hist.begin(), hist.end(), 0.0);
+        return hist.data();
+      };
+      for (const auto& range : CreateRanges(static_cast<data_size_t>(indices.size()))) {
+        const data_size_t start = range.first;
+        const data_size_t end = range.second;
+        bin->ConstructHistogram(idx, start, end, scores.gradients.data(), scores.hessians.data(), reset());
+        EXPECT_TRUE(SameBits(reference.Float(idx, start, end, false, true), hist)) << num_feature << " " << num_bin;
+        bin->ConstructHistogram(start, end, scores.gradients.data(), scores.hessians.data(), reset());
+        EXPECT_TRUE(SameBits(reference.Float(nullptr, start, end, false, true), hist)) << num_feature << " " << num_bin;
+        bin->ConstructHistogramOrdered(idx, start, end, scores.ordered_gradients.data(),
+                                       scores.ordered_hessians.data(), reset());
+        EXPECT_TRUE(SameBits(reference.Float(idx, start, end, true, true), hist)) << num_feature << " " << num_bin;
+
+        bin->ConstructHistogramInt8(idx, start, end, scores.Quantized(false), nullptr, reset());
+        EXPECT_TRUE(SameBits(reference.Int<int16_t, 8>(idx, start, end, false, true), hist)) << num_feature;
+        bin->ConstructHistogramInt16(start, end, scores.Quantized(false), nullptr, reset());
+        EXPECT_TRUE(SameBits(reference.Int<int32_t, 16>(nullptr, start, end, false, true), hist)) << num_feature;
+        bin->ConstructHistogramInt32(idx, start, end, scores.Quantized(false), nullptr, reset());
+        EXPECT_TRUE(SameBits(reference.Int<int64_t, 32>(idx, start, end, false, true), hist)) << num_feature;
+      }
+    }
+  }
+}
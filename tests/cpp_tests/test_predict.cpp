@@ -0,0 +1,1641 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+
+#include <gtest/gtest.h>
+#include <testutils.h>
+#include <LightGBM/c_api.h>
+#include <LightGBM/tree.h>
+#include <LightGBM/utils/random.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using LightGBM::Random;
+
+namespace {
+
+const int kNumRows = 2000;
+const int kNumCols = 8;
+const char* kDatasetParams = "categorical_feature=0 min_data_per_group=5 cat_smooth=1 verbose=-1";
+
+/*!
+ * Dense row-major data with one categorical column (column 0), missing values and exact zeros,
+ * so that every decision type of the trees is exercised.
+ */
+void CreatePredictData(std::vector<double>* features, std::vector<float>* labels) {
+  Random rand(17);
+  features->resize(static_cast<size_t>(kNumRows) * kNumCols);
+  labels->resize(kNumRows);
+  for (int i = 0; i < kNumRows; ++i) {
+    double* row = features->data() + static_cast<size_t>(i) * kNumCols;
+    row[0] = static_cast<double>(rand.NextShort(0, 12));
+    for (int j = 1; j < kNumCols; ++j) {
+      const int r = rand.NextShort(0, 20);
+      if (r == 0) {
+        row[j] = std::numeric_limits<double>::quiet_NaN();
+      } else if (r == 1) {
+        row[j] = 0.0;
+      } else {
+        row[j] = rand.NextFloat() * 2.0 - 1.0;
+      }
+    }
+    const double x1 = std::isnan(row[1]) ? 0.5 : row[1];
+    const double x2 = std::isnan(row[2]) ? -0.5 : row[2];
+    (*labels)[i] = static_cast<float>((static_cast<int>(row[0]) % 3) + x1 * x2 + (x1 > 0.2 ? 1.0 : 0.0));
+  }
+}
+
+BoosterHandle TrainPredictBooster(const std::vector<double>& features, const std::vector<float>& labels,
+                                  const char* params, int num_iterations,
+                                  const char* dataset_params = kDatasetParams) {
+  DatasetHandle dataset;
+  int result = LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, kNumRows, kNumCols, 1,
+                                         dataset_params, nullptr, &dataset);
+  EXPECT_EQ(0, result) << "LGBM_DatasetCreateFromMat result code: " << result;
+  result = LGBM_DatasetSetField(dataset, "label", labels.data(), kNumRows, C_API_DTYPE_FLOAT32);
+  EXPECT_EQ(0, result) << "LGBM_DatasetSetField result code: " << result;
+  BoosterHandle booster;
+  result = LGBM_BoosterCreate(dataset, params, &booster);
+  EXPECT_EQ(0, result) << "LGBM_BoosterCreate result code: " << result;
+  for (int i = 0; i < num_iterations; ++i) {
+    int is_finished;
+    result = LGBM_BoosterUpdateOneIter(booster, &is_finished);
+    EXPECT_EQ(0, result) << "LGBM_BoosterUpdateOneIter result code: " << result;
+  }
+  // detach the booster from its training data, like a model served in production
+  std::vector<char> model_str(1);
+  int64_t model_len = 0;
+  result = LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, 0, &model_len, model_str.data());
+  EXPECT_EQ(0, result) << "LGBM_BoosterSaveModelToString result code: " << result;
+  model_str.resize(model_len);
+  result = LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, model_len, &model_len, model_str.data());
+  EXPECT_EQ(0, result) << "LGBM_BoosterSaveModelToString result code: " << result;
+  LGBM_BoosterFree(booster);
+  LGBM_DatasetFree(dataset);
+  int num_loaded_iterations;
+  result = LGBM_BoosterLoadModelFromString(model_str.data(), &num_loaded_iterations, &booster);
+  EXPECT_EQ(0, result) << "LGBM_BoosterLoadModelFromString result code: " << result;
+  EXPECT_EQ(num_iterations, num_loaded_iterations);
+  return booster;
+}
+
+std::vector<double> PredictMat(BoosterHandle booster, const std::vector<double>& features, int predict_type,
+                               int start_iteration, int num_iteration, const char* params) {
+  int64_t out_len;
+  int result = LGBM_BoosterCalcNumPredict(booster, kNumRows, predict_type, start_iteration, num_iteration, &out_len);
+  EXPECT_EQ(0, result) << "LGBM_BoosterCalcNumPredict result code: " << result;
+  std::vector<double> out(out_len);
+  result = LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64, kNumRows, kNumCols, 1,
+                                     predict_type, start_iteration, num_iteration, params, &out_len, out.data());
+  EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMat result code: " << result;
+  EXPECT_EQ(out.size(), static_cast<size_t>(out_len));
+  return out;
+}
+
+}  // namespace
+
+TEST(Predict, RawScoreMatchesLeafValues) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  BoosterHandle booster = TrainPredictBooster(features, labels, "objective=regression num_leaves=15 verbose=-1", 20);
+
+  const int start_iteration = 3;
+  const int num_iteration = 12;
+  auto raw = PredictMat(booster, features, C_API_PREDICT_RAW_SCORE, start_iteration, num_iteration, "");
+  auto leaves = PredictMat(booster, features, C_API_PREDICT_LEAF_INDEX, start_iteration, num_iteration, "");
+  ASSERT_EQ(leaves.size(), raw.size() * num_iteration);
+  for (int i = 0; i < kNumRows; ++i) {
+    double expected = 0.0;
+    for (int t = 0; t < num_iteration; ++t) {
+      double leaf_value;
+      int result = LGBM_BoosterGetLeafValue(booster, start_iteration + t,
+                                            static_cast<int>(leaves[static_cast<size_t>(i) * num_iteration + t]), &leaf_value);
+      EXPECT_EQ(0, result) << "LGBM_BoosterGetLeafValue result code: " << result;
+      expected += leaf_value;
+    }
+    EXPECT_EQ(expected, raw[i]) << "raw score mismatch at row " << i;
+  }
+
+  // the leaves and scores also match the trees of the text model, walked node by node without the compiled forest
+  std::vector<char> model_str(1 << 22);
+  int64_t model_len;
+  int result = LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT,
+                                             static_cast<int64_t>(model_str.size()), &model_len, model_str.data());
+  ASSERT_EQ(0, result) << "LGBM_BoosterSaveModelToString result code: " << result;
+  std::vector<std::unique_ptr<LightGBM::Tree>> trees;
+  for (const char* p = std::strstr(model_str.data(), "\nTree="); p != nullptr; p = std::strstr(p + 1, "\nTree=")) {
+    size_t used_len = 0;
+    trees.emplace_back(new LightGBM::Tree(std::strchr(p + 1, '\n') + 1, &used_len));
+  }
+  ASSERT_EQ(20u, trees.size());
+  // the walked trees go through categorical splits and numerical splits with missing values
+  bool has_categorical = false;
+  bool has_missing = false;
+  for (int t = start_iteration; t < start_iteration + num_iteration; ++t) {
+    for (int node = 0; node < trees[t]->num_leaves() - 1; ++node) {
+      const int8_t decision_type = trees[t]->decision_type(node);
+      has_categorical |= LightGBM::Tree::GetDecisionType(decision_type, kCategoricalMask);
+      has_missing |= LightGBM::Tree::GetMissingType(decision_type) != LightGBM::MissingType::None;
+    }
+  }
+  EXPECT_TRUE(has_categorical);
+  EXPECT_TRUE(has_missing);
+  for (int i = 0; i < kNumRows; ++i) {
+    const double* row = features.data() + static_cast<size_t>(i) * kNumCols;
+    double expected = 0.0;
+    for (int t = 0; t < num_iteration; ++t) {
+      const LightGBM::Tree& tree = *trees[start_iteration + t];
+      EXPECT_EQ(tree.PredictLeafIndex(row), static_cast<int>(leaves[static_cast<size_t>(i) * num_iteration + t]))
+        << "leaf mismatch at row " << i << ", tree " << start_iteration + t;
+      expected += tree.Predict(row);
+    }
+    EXPECT_EQ(expected, raw[i]) << "raw score mismatch with the trees at row " << i;
+  }
+
+  // modifying the model must be reflected by later predictions
+  const int leaf_idx = static_cast<int>(leaves[0]);
+  double old_value;
+  LGBM_BoosterGetLeafValue(booster, start_iteration, leaf_idx, &old_value);
+  result = LGBM_BoosterSetLeafValue(booster, start_iteration, leaf_idx, old_value + 1.0);
+  EXPECT_EQ(0, result) << "LGBM_BoosterSetLeafValue result code: " << result;
+  auto raw_after = PredictMat(booster, features, C_API_PREDICT_RAW_SCORE, start_iteration, num_iteration, "");
+  EXPECT_NEAR(raw[0] + 1.0, raw_after[0], 1e-9);
+
+  LGBM_BoosterFree(booster);
+}
+
+TEST(Predict, BlockMatchesRowByRow) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  for (auto& label : labels) {
+    label = static_cast<float>(std::abs(static_cast<int>(label)) % 3);
+  }
+  BoosterHandle booster = TrainPredictBooster(features, labels,
+                                              "objective=multiclass num_class=3 num_leaves=15 verbose=-1", 10);
+  for (int predict_type : {C_API_PREDICT_NORMAL, C_API_PREDICT_RAW_SCORE}) {
+    auto expected = PredictMat(booster, features, predict_type, 0, -1, "");
+    for (const char* params : {"predict_block_size=1", "predict_block_size=7", "predict_block_size=256"}) {
+      auto blocked = PredictMat(booster, features, predict_type, 0, -1, params);
+      EXPECT_EQ(expected, blocked) << "block prediction mismatch with " << params;
+    }
+  }
+  LGBM_BoosterFree(booster);
+}
+
+TEST(Predict, QuickScorerMatchesDefault) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  // trees with categorical splits or more than 64 leaves are not scored by the bitvector algorithm
+  const std::vector<std::pair<const char*, const char*>> configs = {
+    {"objective=regression num_leaves=63 min_data_in_leaf=5 verbose=-1", "verbose=-1"},
+    {"objective=regression num_leaves=15 verbose=-1", kDatasetParams},
+    {"objective=regression num_leaves=100 min_data_in_leaf=5 verbose=-1", "verbose=-1"}};
+  for (const auto& config : configs) {
+    const char* params = config.first;
+    BoosterHandle booster = TrainPredictBooster(features, labels, params, 20, config.second);
+    for (int predict_type : {C_API_PREDICT_NORMAL, C_API_PREDICT_RAW_SCORE}) {
+      auto expected = PredictMat(booster, features, predict_type, 2, 15, "");
+      auto scored = PredictMat(booster, features, predict_type, 2, 15, "predict_quick_scorer=true");
+      EXPECT_EQ(expected, scored) << "quick scorer mismatch with " << params;
+      auto blocked = PredictMat(booster, features, predict_type, 2, 15, "predict_quick_scorer=true predict_block_size=64");
+      EXPECT_EQ(expected, blocked) << "blocked quick scorer mismatch with " << params;
+    }
+    LGBM_BoosterFree(booster);
+  }
+}
+
+TEST(Predict, DenseMatchesSparse) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  BoosterHandle booster = TrainPredictBooster(features, labels, "objective=regression num_leaves=15 verbose=-1", 10);
+
+  std::vector<float> features32(features.begin(), features.end());
+  std::vector<double> features_col_major(features.size());
+  for (int i = 0; i < kNumRows; ++i) {
+    for (int j = 0; j < kNumCols; ++j) {
+      features_col_major[static_cast<size_t>(j) * kNumRows + i] = features[static_cast<size_t>(i) * kNumCols + j];
+    }
+  }
+  // the same data as CSR, which goes through the (index, value) pairs of each row
+  std::vector<int32_t> indptr(1, 0);
+  std::vector<int32_t> indices;
+  std::vector<double> values;
+  for (int i = 0; i < kNumRows; ++i) {
+    for (int j = 0; j < kNumCols; ++j) {
+      const double value = features[static_cast<size_t>(i) * kNumCols + j];
+      if (value != 0.0) {
+        indices.push_back(j);
+        values.push_back(value);
+      }
+    }
+    indptr.push_back(static_cast<int32_t>(indices.size()));
+  }
+  std::vector<float> values32(values.begin(), values.end());
+
+  for (int predict_type : {C_API_PREDICT_NORMAL, C_API_PREDICT_RAW_SCORE, C_API_PREDICT_LEAF_INDEX, C_API_PREDICT_CONTRIB}) {
+    int64_t out_len;
+    int result = LGBM_BoosterCalcNumPredict(booster, kNumRows, predict_type, 0, -1, &out_len);
+    EXPECT_EQ(0, result) << "LGBM_BoosterCalcNumPredict result code: " << result;
+    const int64_t num_pred_one_row = out_len / kNumRows;
+    std::vector<double> expected(out_len), expected32(out_len), out(out_len);
+    result = LGBM_BoosterPredictForCSR(booster, indptr.data(), C_API_DTYPE_INT32, indices.data(), values.data(),
+                                       C_API_DTYPE_FLOAT64, indptr.size(), values.size(), kNumCols, predict_type,
+                                       0, -1, "", &out_len, expected.data());
+    EXPECT_EQ(0, result) << "LGBM_BoosterPredictForCSR result code: " << result;
+    result = LGBM_BoosterPredictForCSR(booster, indptr.data(), C_API_DTYPE_INT32, indices.data(), values32.data(),
+                                       C_API_DTYPE_FLOAT32, indptr.size(), values32.size(), kNumCols, predict_type,
+                                       0, -1, "", &out_len, expected32.data());
+    EXPECT_EQ(0, result) << "LGBM_BoosterPredictForCSR result code: " << result;
+
+    EXPECT_EQ(expected, PredictMat(booster, features, predict_type, 0, -1, ""));
+    result = LGBM_BoosterPredictForMat(booster, features_col_major.data(), C_API_DTYPE_FLOAT64, kNumRows, kNumCols, 0,
+                                       predict_type, 0, -1, "", &out_len, out.data());
+    EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMat result code: " << result;
+    EXPECT_EQ(expected, out);
+    result = LGBM_BoosterPredictForMat(booster, features32.data(), C_API_DTYPE_FLOAT32, kNumRows, kNumCols, 1,
+                                       predict_type, 0, -1, "", &out_len, out.data());
+    EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMat result code: " << result;
+    EXPECT_EQ(expected32, out);
+
+    FastConfigHandle fast_config;
+    result = LGBM_BoosterPredictForMatSingleRowFastInit(booster, predict_type, 0, -1, C_API_DTYPE_FLOAT64, kNumCols,
+                                                        "", &fast_config);
+    EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMatSingleRowFastInit result code: " << result;
+    for (int i = 0; i < kNumRows; i += 97) {
+      int64_t row_len;
+      result = LGBM_BoosterPredictForMatSingleRowFast(fast_config, features.data() + static_cast<size_t>(i) * kNumCols,
+                                                      &row_len, out.data());
+      EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMatSingleRowFast result code: " << result;
+      EXPECT_EQ(num_pred_one_row, row_len);
+      for (int64_t k = 0; k < num_pred_one_row; ++k) {
+        EXPECT_EQ(expected[i * num_pred_one_row + k], out[k]) << "single row mismatch at row " << i;
+      }
+    }
+    LGBM_FastConfigFree(fast_config);
+  }
+  LGBM_BoosterFree(booster);
+}
+
+TEST(Predict, DenseTinyValuesAreZeros) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  BoosterHandle trained = TrainPredictBooster(features, labels, "objective=regression num_leaves=15 verbose=-1", 10);
+  std::vector<char> model_str(1 << 20);
+  int64_t model_len;
+  LGBM_BoosterSaveModelToString(trained, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, static_cast<int64_t>(model_str.size()),
+                                &model_len, model_str.data());
+  LGBM_BoosterFree(trained);
+
+  // trained thresholds are never closer to zero than kZeroThreshold, move the numerical ones just above zero
+  std::istringstream lines(model_str.data());
+  std::string line;
+  std::string model;
+  std::vector<int> split_features;
+  while (std::getline(lines, line)) {
+    if (line.compare(0, 14, "split_feature=") == 0) {
+      std::istringstream values(line.substr(14));
+      split_features.clear();
+      int feature;
+      while (values >> feature) {
+        split_features.push_back(feature);
+      }
+    } else if (line.compare(0, 10, "threshold=") == 0) {
+      std::istringstream values(line.substr(10));
+      line = "threshold=";
+      for (size_t node = 0; node < split_features.size(); ++node) {
+        std::string value;
+        values >> value;
+        line += (node > 0 ? " " : "") + (split_features[node] == 0 ? value : std::string("1e-37"));
+      }
+    }
+    // without the tree sizes, which change with the thresholds, the trees are parsed one after the other
+    if (line.compare(0, 11, "tree_sizes=") != 0) {
+      model += line + "\n";
+    }
+  }
+  BoosterHandle booster;
+  int num_iterations;
+  int result = LGBM_BoosterLoadModelFromString(model.c_str(), &num_iterations, &booster);
+  ASSERT_EQ(0, result) << "LGBM_BoosterLoadModelFromString result code: " << result;
+
+  // values within kZeroThreshold of zero are dropped from the (index, value) pairs, dense rows must agree
+  std::vector<double> tiny_features(features);
+  std::vector<double> zero_features(features);
+  for (int i = 0; i < kNumRows; ++i) {
+    for (int j = 1; j < kNumCols; ++j) {
+      tiny_features[static_cast<size_t>(i) * kNumCols + j] = 1e-36;
+      zero_features[static_cast<size_t>(i) * kNumCols + j] = 0.0;
+    }
+  }
+  const std::vector<float> tiny_features32(tiny_features.begin(), tiny_features.end());
+  const std::vector<float> zero_features32(zero_features.begin(), zero_features.end());
+  for (int predict_type : {C_API_PREDICT_RAW_SCORE, C_API_PREDICT_LEAF_INDEX, C_API_PREDICT_CONTRIB}) {
+    const auto expected = PredictMat(booster, zero_features, predict_type, 0, -1, "");
+    EXPECT_EQ(expected, PredictMat(booster, tiny_features, predict_type, 0, -1, ""))
+      << "dense mismatch for predict type " << predict_type;
+
+    std::vector<double> out(expected.size());
+    int64_t out_len;
+    FastConfigHandle fast_config;
+    result = LGBM_BoosterPredictForMatSingleRowFastInit(booster, predict_type, 0, -1, C_API_DTYPE_FLOAT64,
+                                                        kNumCols, "", &fast_config);
+    EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMatSingleRowFastInit result code: " << result;
+    const size_t num_pred_one_row = expected.size() / kNumRows;
+    for (int i = 0; i < kNumRows; i += 97) {
+      result = LGBM_BoosterPredictForMatSingleRowFast(fast_config,
+                                                      tiny_features.data() + static_cast<size_t>(i) * kNumCols,
+                                                      &out_len, out.data());
+      EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMatSingleRowFast result code: " << result;
+      for (size_t k = 0; k < num_pred_one_row; ++k) {
+        EXPECT_EQ(expected[i * num_pred_one_row + k], out[k]) << "single row mismatch at row " << i;
+      }
+    }
+    LGBM_FastConfigFree(fast_config);
+  }
+
+  std::vector<double> expected32(kNumRows), out32(kNumRows);
+  int64_t out_len;
+  for (const char* params : {"", "predict_float32=true"}) {
+    result = LGBM_BoosterPredictForMat(booster, zero_features32.data(), C_API_DTYPE_FLOAT32, kNumRows, kNumCols, 1,
+                                       C_API_PREDICT_RAW_SCORE, 0, -1, params, &out_len, expected32.data());
+    EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMat result code: " << result;
+    result = LGBM_BoosterPredictForMat(booster, tiny_features32.data(), C_API_DTYPE_FLOAT32, kNumRows, kNumCols, 1,
+                                       C_API_PREDICT_RAW_SCORE, 0, -1, params, &out_len, out32.data());
+    EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMat result code: " << result;
+    EXPECT_EQ(expected32, out32) << "float32 dense mismatch with " << params;
+  }
+  LGBM_BoosterFree(booster);
+}
+
+TEST(Predict, SingleRowFastConcurrent) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  BoosterHandle booster = TrainPredictBooster(features, labels, "objective=regression num_leaves=15 verbose=-1", 10);
+  const std::vector<float> features32(features.begin(), features.end());
+  auto expected = PredictMat(booster, features, C_API_PREDICT_NORMAL, 0, -1, "");
+  auto expected32 = expected;
+  int64_t out_len;
+  int result = LGBM_BoosterPredictForMat(booster, features32.data(), C_API_DTYPE_FLOAT32, kNumRows, kNumCols, 1,
+                                         C_API_PREDICT_NORMAL, 0, -1, "", &out_len, expected32.data());
+  EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMat result code: " << result;
+
+  FastConfigHandle mat_config, mat32_config, csr_config;
+  result = LGBM_BoosterPredictForMatSingleRowFastInit(booster, C_API_PREDICT_NORMAL, 0, -1, C_API_DTYPE_FLOAT64,
+                                                      kNumCols, "num_threads=1", &mat_config);
+  EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMatSingleRowFastInit result code: " << result;
+  result = LGBM_BoosterPredictForMatSingleRowFastInit(booster, C_API_PREDICT_NORMAL, 0, -1, C_API_DTYPE_FLOAT32,
+                                                      kNumCols, "num_threads=1", &mat32_config);
+  EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMatSingleRowFastInit result code: " << result;
+  result = LGBM_BoosterPredictForCSRSingleRowFastInit(booster, C_API_PREDICT_NORMAL, 0, -1, C_API_DTYPE_FLOAT64,
+                                                      kNumCols, "num_threads=1", &csr_config);
+  EXPECT_EQ(0, result) << "LGBM_BoosterPredictForCSRSingleRowFastInit result code: " << result;
+
+  // many more threads than buffers in the pool, all sharing the same handles
+  const int num_threads = 64;
+  std::vector<int> num_errors(num_threads, 0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      std::vector<int32_t> indices(kNumCols);
+      for (int j = 0; j < kNumCols; ++j) {
+        indices[j] = j;
+      }
+      const int32_t indptr[2] = {0, kNumCols};
+      for (int i = t; i < kNumRows; i += 3) {
+        const double* row = features.data() + static_cast<size_t>(i) * kNumCols;
+        double out = 0.0;
+        int64_t len;
+        LGBM_BoosterPredictForMatSingleRowFast(mat_config, row, &len, &out);
+        num_errors[t] += out != expected[i];
+        LGBM_BoosterPredictForMatSingleRowFast(mat32_config, features32.data() + static_cast<size_t>(i) * kNumCols,
+                                               &len, &out);
+        num_errors[t] += out != expected32[i];
+        LGBM_BoosterPredictForCSRSingleRowFast(csr_config, indptr, C_API_DTYPE_INT32, indices.data(), row,
+                                               2, kNumCols, &len, &out);
+        num_errors[t] += out != expected[i];
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < num_threads; ++t) {
+    EXPECT_EQ(0, num_errors[t]) << "wrong predictions in thread " << t;
+  }
+  LGBM_FastConfigFree(mat_config);
+  LGBM_FastConfigFree(mat32_config);
+  LGBM_FastConfigFree(csr_config);
+  LGBM_BoosterFree(booster);
+}
+
+TEST(Predict, ModelBinaryRoundTrip) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  std::vector<float> class_labels(labels.size());
+  for (size_t i = 0; i < labels.size(); ++i) {
+    class_labels[i] = static_cast<float>(std::abs(static_cast<int>(labels[i])) % 3);
+  }
+  const char* filename = "test_predict_model_binary.bin";
+  struct BinaryModelCase {
+    const char* params;
+    const char* dataset_params;
+    const std::vector<float>* labels;
+    std::vector<int> predict_types;
+  };
+  const std::vector<int> all_predict_types = {C_API_PREDICT_NORMAL, C_API_PREDICT_RAW_SCORE,
+                                              C_API_PREDICT_LEAF_INDEX, C_API_PREDICT_CONTRIB};
+  // categorical splits, multiclass, oblivious trees, and linear trees which are saved without a compiled forest
+  const std::vector<BinaryModelCase> cases = {
+    {"objective=regression num_leaves=15 verbose=-1", kDatasetParams, &labels, all_predict_types},
+    {"objective=multiclass num_class=3 num_leaves=7 verbose=-1", kDatasetParams, &class_labels, all_predict_types},
+    {"objective=regression num_leaves=16 oblivious_tree=true verbose=-1", kDatasetParams, &labels, all_predict_types},
+    {"objective=regression num_leaves=7 linear_tree=true verbose=-1", "linear_tree=true verbose=-1", &labels,
+     {C_API_PREDICT_NORMAL, C_API_PREDICT_RAW_SCORE, C_API_PREDICT_LEAF_INDEX}}};
+  for (const auto& test_case : cases) {
+    BoosterHandle booster = TrainPredictBooster(features, *test_case.labels, test_case.params, 12,
+                                                test_case.dataset_params);
+    for (int num_iteration : {-1, 5}) {
+      int result = LGBM_BoosterSaveModelBinary(booster, 2, num_iteration, C_API_FEATURE_IMPORTANCE_SPLIT, filename);
+      ASSERT_EQ(0, result) << "LGBM_BoosterSaveModelBinary result code: " << result;
+      const int expected_iterations = num_iteration > 0 ? num_iteration : 10;
+
+      BoosterHandle from_file;
+      int num_loaded_iterations = 0;
+      result = LGBM_BoosterCreateFromModelBinary(filename, nullptr, 0, &num_loaded_iterations, &from_file);
+      ASSERT_EQ(0, result) << "LGBM_BoosterCreateFromModelBinary result code: " << result;
+      EXPECT_EQ(expected_iterations, num_loaded_iterations);
+
+      // load from an unaligned copy of the file
+      std::vector<char> content;
+      FILE* file = fopen(filename, "rb");
+      ASSERT_NE(nullptr, file);
+      char chunk[4096];
+      size_t read_len;
+      content.push_back(0);
+      while ((read_len = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        content.insert(content.end(), chunk, chunk + read_len);
+      }
+      fclose(file);
+      BoosterHandle from_buffer;
+      result = LGBM_BoosterCreateFromModelBinary(nullptr, content.data() + 1, static_cast<int64_t>(content.size() - 1),
+                                                 &num_loaded_iterations, &from_buffer);
+      ASSERT_EQ(0, result) << "LGBM_BoosterCreateFromModelBinary result code: " << result;
+      EXPECT_EQ(expected_iterations, num_loaded_iterations);
+
+      for (int predict_type : test_case.predict_types) {
+        auto expected = PredictMat(booster, features, predict_type, 2, expected_iterations, "");
+        EXPECT_EQ(expected, PredictMat(from_file, features, predict_type, 0, -1, ""))
+          << "binary model file mismatch with " << test_case.params;
+        EXPECT_EQ(expected, PredictMat(from_buffer, features, predict_type, 0, -1, ""))
+          << "binary model buffer mismatch with " << test_case.params;
+      }
+
+      // the binary model holds the same fields as the text model of the saved iterations
+      std::vector<char> model_str(1 << 22);
+      int64_t out_len;
+      LGBM_BoosterSaveModelToString(booster, 2, num_iteration, C_API_FEATURE_IMPORTANCE_SPLIT,
+                                    static_cast<int64_t>(model_str.size()), &out_len, model_str.data());
+      BoosterHandle from_text;
+      LGBM_BoosterLoadModelFromString(model_str.data(), &num_loaded_iterations, &from_text);
+      std::vector<char> expected_str(model_str.size());
+      std::vector<char> loaded_str(model_str.size());
+      LGBM_BoosterSaveModelToString(from_text, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT,
+                                    static_cast<int64_t>(expected_str.size()), &out_len, expected_str.data());
+      LGBM_BoosterSaveModelToString(from_file, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT,
+                                    static_cast<int64_t>(loaded_str.size()), &out_len, loaded_str.data());
+      EXPECT_STREQ(expected_str.data(), loaded_str.data());
+      LGBM_BoosterFree(from_text);
+
+      LGBM_BoosterFree(from_file);
+      LGBM_BoosterFree(from_buffer);
+    }
+    LGBM_BoosterFree(booster);
+  }
+
+  // a text model is rejected
+  const char* text = "tree\nversion=v4\n";
+  BoosterHandle invalid;
+  int num_loaded_iterations;
+  EXPECT_NE(0, LGBM_BoosterCreateFromModelBinary(nullptr, text, static_cast<int64_t>(std::strlen(text)),
+                                                 &num_loaded_iterations, &invalid));
+  std::remove(filename);
+}
+
+TEST(Predict, ModelBinaryRejectsCorruption) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  BoosterHandle booster = TrainPredictBooster(features, labels, "objective=regression num_leaves=15 verbose=-1", 5);
+  const char* filename = "test_predict_model_corrupted.bin";
+  int result = LGBM_BoosterSaveModelBinary(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, filename);
+  ASSERT_EQ(0, result) << "LGBM_BoosterSaveModelBinary result code: " << result;
+  LGBM_BoosterFree(booster);
+  std::vector<char> model;
+  FILE* file = fopen(filename, "rb");
+  ASSERT_NE(nullptr, file);
+  char chunk[4096];
+  size_t read_len;
+  while ((read_len = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    model.insert(model.end(), chunk, chunk + read_len);
+  }
+  fclose(file);
+  std::remove(filename);
+
+  auto aligned = [] (size_t bytes) { return (bytes + 7) / 8 * 8; };
+  auto read_size = [&model] (size_t pos) {
+    size_t value;
+    std::memcpy(&value, model.data() + pos, sizeof(value));
+    return value;
+  };
+  // token, version and byte order mark, header, then the tree sizes, the trees and the compiled forest
+  const size_t header_pos = std::strlen("______LightGBM_Binary_Model_Token______\n") + 8;
+  const size_t num_trees_pos = header_pos + sizeof(size_t) + aligned(read_size(header_pos));
+  const size_t num_trees = read_size(num_trees_pos);
+  ASSERT_EQ(5u, num_trees);
+  const size_t tree_sizes_pos = num_trees_pos + sizeof(size_t);
+  std::vector<size_t> tree_pos(1, tree_sizes_pos + sizeof(size_t) * num_trees);
+  for (size_t i = 0; i < num_trees; ++i) {
+    tree_pos.push_back(tree_pos.back() + read_size(tree_sizes_pos + sizeof(size_t) * i));
+  }
+  const size_t forest_nodes_pos = tree_pos.back() + sizeof(size_t) + 8 * sizeof(int32_t);
+  int32_t num_nodes;
+  std::memcpy(&num_nodes, model.data() + tree_pos[0], sizeof(num_nodes));
+  --num_nodes;
+  // the tree arrays before left_child_: split_feature_, split_gain_, threshold_ and decision_type_
+  const size_t left_child_pos = tree_pos[0] + 24 + aligned(4 * num_nodes) * 2 + 8 * num_nodes + aligned(num_nodes);
+
+  auto load = [] (const std::vector<char>& buffer) {
+    BoosterHandle loaded;
+    int num_iterations;
+    const int ret = LGBM_BoosterCreateFromModelBinary(nullptr, buffer.data(), static_cast<int64_t>(buffer.size()),
+                                                      &num_iterations, &loaded);
+    if (ret == 0) {
+      LGBM_BoosterFree(loaded);
+    }
+    return ret;
+  };
+  auto corrupt = [&model] (size_t pos, const auto& value) {
+    std::vector<char> corrupted(model);
+    std::memcpy(corrupted.data() + pos, &value, sizeof(value));
+    return corrupted;
+  };
+  ASSERT_EQ(0, load(model));
+  const size_t huge_size = std::numeric_limits<size_t>::max() - 3;
+  EXPECT_NE(0, load(corrupt(tree_sizes_pos, huge_size))) << "tree size wrapping around";
+  // the first tree keeps its size for the reader, but the tree must fit in the size it was given
+  std::vector<char> short_tree = corrupt(tree_sizes_pos, static_cast<size_t>(24));
+  const size_t second_size = tree_pos[2] - tree_pos[0] - 24;
+  std::memcpy(short_tree.data() + tree_sizes_pos + sizeof(size_t), &second_size, sizeof(second_size));
+  EXPECT_NE(0, load(short_tree)) << "tree larger than its size";
+  EXPECT_NE(0, load(corrupt(tree_pos[0], static_cast<int32_t>(1 << 30)))) << "number of leaves";
+  EXPECT_NE(0, load(corrupt(tree_pos[0] + 4, static_cast<int32_t>(1 << 30)))) << "number of categorical splits";
+  EXPECT_NE(0, load(corrupt(tree_pos[0] + 24, static_cast<int32_t>(kNumCols)))) << "tree split feature";
+  EXPECT_NE(0, load(corrupt(left_child_pos, static_cast<int32_t>(0)))) << "tree node cycle";
+  EXPECT_NE(0, load(corrupt(left_child_pos, static_cast<int32_t>(-100)))) << "tree leaf";
+  EXPECT_NE(0, load(corrupt(forest_nodes_pos + 8, static_cast<int32_t>(kNumCols)))) << "forest split feature";
+  EXPECT_NE(0, load(corrupt(forest_nodes_pos + 12, static_cast<int32_t>(0)))) << "forest node cycle";
+  EXPECT_NE(0, load(corrupt(forest_nodes_pos + 16, static_cast<int32_t>(1 << 30)))) << "forest node";
+}
+
+TEST(Predict, FromPreviousScore) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  std::vector<float> binary_labels(labels.size());
+  std::vector<float> class_labels(labels.size());
+  for (size_t i = 0; i < labels.size(); ++i) {
+    binary_labels[i] = static_cast<float>(std::abs(static_cast<int>(labels[i])) % 2);
+    class_labels[i] = static_cast<float>(std::abs(static_cast<int>(labels[i])) % 3);
+  }
+  std::vector<int32_t> indptr(1, 0);
+  std::vector<int32_t> indices;
+  std::vector<double> values;
+  for (int i = 0; i < kNumRows; ++i) {
+    for (int j = 0; j < kNumCols; ++j) {
+      const double value = features[static_cast<size_t>(i) * kNumCols + j];
+      if (value != 0.0) {
+        indices.push_back(j);
+        values.push_back(value);
+      }
+    }
+    indptr.push_back(static_cast<int32_t>(indices.size()));
+  }
+  const char* data_filename = "test_predict_from_score.tsv";
+  const std::string init_filename = std::string(data_filename) + ".init";
+  const char* result_filename = "test_predict_from_score.out";
+  FILE* file = fopen(data_filename, "w");
+  ASSERT_NE(nullptr, file);
+  for (int i = 0; i < kNumRows; ++i) {
+    fprintf(file, "0");
+    for (int j = 0; j < kNumCols; ++j) {
+      fprintf(file, "\t%.17g", features[static_cast<size_t>(i) * kNumCols + j]);
+    }
+    fprintf(file, "\n");
+  }
+  fclose(file);
+  auto read_result = [result_filename] () {
+    std::vector<double> out;
+    FILE* result_file = fopen(result_filename, "r");
+    double value;
+    while (result_file != nullptr && fscanf(result_file, "%lf", &value) == 1) {
+      out.push_back(value);
+    }
+    if (result_file != nullptr) {
+      fclose(result_file);
+    }
+    return out;
+  };
+
+  // random forest averages the trees, so the conversion depends on the number of previous iterations
+  const std::vector<std::pair<const char*, const std::vector<float>*>> configs = {
+    {"objective=binary num_leaves=15 verbose=-1", &binary_labels},
+    {"objective=multiclass num_class=3 num_leaves=7 verbose=-1", &class_labels},
+    {"boosting=rf objective=binary bagging_freq=1 bagging_fraction=0.5 num_leaves=15 verbose=-1", &binary_labels}};
+  const int num_previous_iterations = 5;
+  for (const auto& config : configs) {
+    BoosterHandle booster = TrainPredictBooster(features, *config.second, config.first, 12);
+    auto previous = PredictMat(booster, features, C_API_PREDICT_RAW_SCORE, 0, num_previous_iterations, "");
+    int result = LGBM_BoosterPredictForFile(booster, data_filename, 0, C_API_PREDICT_RAW_SCORE, 0,
+                                            num_previous_iterations, "", init_filename.c_str());
+    ASSERT_EQ(0, result) << "LGBM_BoosterPredictForFile result code: " << result;
+    for (int predict_type : {C_API_PREDICT_NORMAL, C_API_PREDICT_RAW_SCORE}) {
+      auto expected = PredictMat(booster, features, predict_type, 0, -1, "");
+      std::vector<double> out(expected.size());
+      int64_t out_len;
+      result = LGBM_BoosterPredictForMatFromScore(booster, features.data(), C_API_DTYPE_FLOAT64, kNumRows, kNumCols, 1,
+                                                  predict_type, previous.data(), num_previous_iterations, -1, "",
+                                                  &out_len, out.data());
+      ASSERT_EQ(0, result) << "LGBM_BoosterPredictForMatFromScore result code: " << result;
+      ASSERT_EQ(expected.size(), static_cast<size_t>(out_len));
+      for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_NEAR(expected[i], out[i], 1e-12) << "dense mismatch with " << config.first;
+      }
+      result = LGBM_BoosterPredictForCSRFromScore(booster, indptr.data(), C_API_DTYPE_INT32, indices.data(),
+                                                  values.data(), C_API_DTYPE_FLOAT64, indptr.size(), values.size(),
+                                                  kNumCols, predict_type, previous.data(), num_previous_iterations,
+                                                  -1, "", &out_len, out.data());
+      ASSERT_EQ(0, result) << "LGBM_BoosterPredictForCSRFromScore result code: " << result;
+      for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_NEAR(expected[i], out[i], 1e-12) << "CSR mismatch with " << config.first;
+      }
+
+      // the previous scores are read from the sidecar file of the data
+      result = LGBM_BoosterPredictForFile(booster, data_filename, 0, predict_type, 0, -1, "", result_filename);
+      ASSERT_EQ(0, result) << "LGBM_BoosterPredictForFile result code: " << result;
+      auto expected_file = read_result();
+      ASSERT_EQ(expected.size(), expected_file.size());
+      result = LGBM_BoosterPredictForFileFromScore(booster, data_filename, 0, predict_type, nullptr,
+                                                   num_previous_iterations, -1, "", result_filename);
+      ASSERT_EQ(0, result) << "LGBM_BoosterPredictForFileFromScore result code: " << result;
+      auto out_file = read_result();
+      ASSERT_EQ(expected_file.size(), out_file.size());
+      for (size_t i = 0; i < expected_file.size(); ++i) {
+        EXPECT_NEAR(expected_file[i], out_file[i], 1e-12) << "file mismatch with " << config.first;
+      }
+    }
+
+    // only scores can be completed
+    std::vector<double> out(previous.size() * 16);
+    int64_t out_len;
+    EXPECT_NE(0, LGBM_BoosterPredictForMatFromScore(booster, features.data(), C_API_DTYPE_FLOAT64, kNumRows, kNumCols,
+                                                    1, C_API_PREDICT_LEAF_INDEX, previous.data(),
+                                                    num_previous_iterations, -1, "", &out_len, out.data()));
+    LGBM_BoosterFree(booster);
+  }
+
+  // the sidecar file must have one line per record
+  BoosterHandle booster = TrainPredictBooster(features, binary_labels, "objective=binary verbose=-1", 3);
+  file = fopen(init_filename.c_str(), "w");
+  fprintf(file, "0.5\n");
+  fclose(file);
+  std::remove(result_filename);
+  EXPECT_NE(0, LGBM_BoosterPredictForFileFromScore(booster, data_filename, 0, C_API_PREDICT_NORMAL, nullptr, 1, -1,
+                                                   "", result_filename));
+  // no truncated result is written
+  file = fopen(result_filename, "r");
+  EXPECT_EQ(nullptr, file);
+  if (file != nullptr) {
+    fclose(file);
+  }
+  file = fopen(init_filename.c_str(), "w");
+  for (int i = 0; i < kNumRows; ++i) {
+    fprintf(file, "0.5\t0.5\n");
+  }
+  fclose(file);
+  EXPECT_NE(0, LGBM_BoosterPredictForFileFromScore(booster, data_filename, 0, C_API_PREDICT_NORMAL, nullptr, 1, -1,
+                                                   "", result_filename));
+  LGBM_BoosterFree(booster);
+  std::remove(data_filename);
+  std::remove(init_filename.c_str());
+  std::remove(result_filename);
+}
+
+TEST(Predict, Float32MatchesDouble) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  const std::vector<float> features32(features.begin(), features.end());
+  std::vector<int32_t> indptr(1, 0);
+  std::vector<int32_t> indices;
+  std::vector<float> values32;
+  for (int i = 0; i < kNumRows; ++i) {
+    for (int j = 0; j < kNumCols; ++j) {
+      if (features32[static_cast<size_t>(i) * kNumCols + j] != 0.0f) {
+        indices.push_back(j);
+        values32.push_back(features32[static_cast<size_t>(i) * kNumCols + j]);
+      }
+    }
+    indptr.push_back(static_cast<int32_t>(indices.size()));
+  }
+  auto predict_mat32 = [&features32] (BoosterHandle booster, int predict_type, const char* params) {
+    std::vector<double> out(kNumRows);
+    int64_t out_len;
+    int result = LGBM_BoosterPredictForMat(booster, features32.data(), C_API_DTYPE_FLOAT32, kNumRows, kNumCols, 1,
+                                           predict_type, 0, -1, params, &out_len, out.data());
+    EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMat result code: " << result;
+    return out;
+  };
+
+  BoosterHandle booster = TrainPredictBooster(features, labels, "objective=regression num_leaves=15 verbose=-1", 20);
+  int num_inexact_thresholds;
+  double max_deviation;
+  int result = LGBM_BoosterGetFloat32Deviation(booster, 0, -1, &num_inexact_thresholds, &max_deviation);
+  EXPECT_EQ(0, result) << "LGBM_BoosterGetFloat32Deviation result code: " << result;
+  EXPECT_GT(num_inexact_thresholds, 0);
+  EXPECT_GT(max_deviation, 0.0);
+  auto expected = predict_mat32(booster, C_API_PREDICT_RAW_SCORE, "");
+  auto out = predict_mat32(booster, C_API_PREDICT_RAW_SCORE, "predict_float32=true");
+  for (int i = 0; i < kNumRows; ++i) {
+    EXPECT_LE(std::fabs(expected[i] - out[i]), max_deviation * (1.0 + 1e-9)) << "deviation above bound at row " << i;
+  }
+
+  // with leaf values representable as float, float32 inputs get exactly the same predictions
+  std::vector<char> model_str(1 << 20);
+  int64_t model_len;
+  LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, static_cast<int64_t>(model_str.size()),
+                                &model_len, model_str.data());
+  const std::string model(model_str.data());
+  int tree_idx = 0;
+  for (size_t pos = model.find("\nnum_leaves="); pos != std::string::npos; pos = model.find("\nnum_leaves=", pos + 1)) {
+    const int num_leaves = std::stoi(model.substr(pos + std::strlen("\nnum_leaves=")));
+    for (int leaf = 0; leaf < num_leaves; ++leaf) {
+      double value;
+      LGBM_BoosterGetLeafValue(booster, tree_idx, leaf, &value);
+      LGBM_BoosterSetLeafValue(booster, tree_idx, leaf, static_cast<float>(value));
+    }
+    ++tree_idx;
+  }
+  EXPECT_EQ(20, tree_idx);
+  result = LGBM_BoosterGetFloat32Deviation(booster, 0, -1, &num_inexact_thresholds, &max_deviation);
+  EXPECT_EQ(0, result) << "LGBM_BoosterGetFloat32Deviation result code: " << result;
+  EXPECT_EQ(0.0, max_deviation);
+  for (int predict_type : {C_API_PREDICT_NORMAL, C_API_PREDICT_RAW_SCORE}) {
+    expected = predict_mat32(booster, predict_type, "");
+    EXPECT_EQ(expected, predict_mat32(booster, predict_type, "predict_float32=true"));
+    int64_t out_len;
+    result = LGBM_BoosterPredictForCSR(booster, indptr.data(), C_API_DTYPE_INT32, indices.data(), values32.data(),
+                                       C_API_DTYPE_FLOAT32, indptr.size(), values32.size(), kNumCols, predict_type,
+                                       0, -1, "predict_float32=true", &out_len, out.data());
+    EXPECT_EQ(0, result) << "LGBM_BoosterPredictForCSR result code: " << result;
+    EXPECT_EQ(expected, out);
+
+    FastConfigHandle fast_config;
+    result = LGBM_BoosterPredictForMatSingleRowFastInit(booster, predict_type, 0, -1, C_API_DTYPE_FLOAT32, kNumCols,
+                                                        "predict_float32=true", &fast_config);
+    EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMatSingleRowFastInit result code: " << result;
+    for (int i = 0; i < kNumRows; i += 97) {
+      double row_out;
+      int64_t row_len;
+      result = LGBM_BoosterPredictForMatSingleRowFast(fast_config, features32.data() + static_cast<size_t>(i) * kNumCols,
+                                                      &row_len, &row_out);
+      EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMatSingleRowFast result code: " << result;
+      EXPECT_EQ(expected[i], row_out) << "single row mismatch at row " << i;
+    }
+    LGBM_FastConfigFree(fast_config);
+  }
+  LGBM_BoosterFree(booster);
+}
+
+TEST(Predict, Float32RoutesFloat64InputsDifferently) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  const int kIntegerCol = 3;
+  Random rand(3);
+  for (int i = 0; i < kNumRows; ++i) {
+    const int value = rand.NextShort(0, 10);
+    features[static_cast<size_t>(i) * kNumCols + kIntegerCol] = value;
+    labels[i] += value > 4 ? 3.0f : 0.0f;
+  }
+  BoosterHandle trained = TrainPredictBooster(features, labels, "objective=regression num_leaves=15 verbose=-1", 10);
+  std::vector<char> model_str(1 << 20);
+  int64_t model_len;
+  LGBM_BoosterSaveModelToString(trained, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, static_cast<int64_t>(model_str.size()),
+                                &model_len, model_str.data());
+  LGBM_BoosterFree(trained);
+
+  // the trained thresholds are just above the middle of two values, one of them is set to a float
+  const double threshold = 4.5;
+  std::istringstream lines(model_str.data());
+  std::string line;
+  std::string model;
+  std::vector<int> split_features;
+  bool is_replaced = false;
+  while (std::getline(lines, line)) {
+    if (line.compare(0, 14, "split_feature=") == 0) {
+      std::istringstream values(line.substr(14));
+      split_features.clear();
+      int feature;
+      while (values >> feature) {
+        split_features.push_back(feature);
+      }
+    } else if (line.compare(0, 10, "threshold=") == 0 && !is_replaced) {
+      std::istringstream values(line.substr(10));
+      line = "threshold=";
+      for (size_t node = 0; node < split_features.size(); ++node) {
+        std::string value;
+        values >> value;
+        if (split_features[node] == kIntegerCol && !is_replaced) {
+          value = "4.5";
+          is_replaced = true;
+        }
+        line += (node > 0 ? " " : "") + value;
+      }
+    }
+    // without the tree sizes, which change with the threshold, the trees are parsed one after the other
+    if (line.compare(0, 11, "tree_sizes=") != 0) {
+      model += line + "\n";
+    }
+  }
+  ASSERT_TRUE(is_replaced);
+  BoosterHandle booster;
+  int num_iterations;
+  int result = LGBM_BoosterLoadModelFromString(model.c_str(), &num_iterations, &booster);
+  ASSERT_EQ(0, result) << "LGBM_BoosterLoadModelFromString result code: " << result;
+  int num_inexact_thresholds;
+  double max_deviation;
+  result = LGBM_BoosterGetFloat32Deviation(booster, 0, -1, &num_inexact_thresholds, &max_deviation);
+  EXPECT_EQ(0, result) << "LGBM_BoosterGetFloat32Deviation result code: " << result;
+
+  // at the threshold the bound holds, just above it the float64 input is rounded onto the threshold and goes left
+  for (double offset : {0.0, 1e-10}) {
+    std::vector<double> shifted(features);
+    for (int i = 0; i < kNumRows; ++i) {
+      shifted[static_cast<size_t>(i) * kNumCols + kIntegerCol] = threshold + offset;
+    }
+    auto expected = PredictMat(booster, shifted, C_API_PREDICT_RAW_SCORE, 0, -1, "");
+    auto out = PredictMat(booster, shifted, C_API_PREDICT_RAW_SCORE, 0, -1, "predict_float32=true");
+    double max_diff = 0.0;
+    for (int i = 0; i < kNumRows; ++i) {
+      max_diff = std::max(max_diff, std::fabs(expected[i] - out[i]));
+    }
+    if (offset == 0.0) {
+      EXPECT_LE(max_diff, max_deviation * (1.0 + 1e-9));
+    } else {
+      EXPECT_GT(max_diff, max_deviation * 10);
+    }
+  }
+  LGBM_BoosterFree(booster);
+}
+
+TEST(Predict, BinnedMatchesDefault) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  std::vector<float> class_labels(labels.size());
+  for (size_t i = 0; i < labels.size(); ++i) {
+    class_labels[i] = static_cast<float>(std::abs(static_cast<int>(labels[i])) % 3);
+  }
+  struct BinnedCase {
+    const char* params;
+    const char* dataset_params;
+    const std::vector<float>* labels;
+    int num_iterations;
+  };
+  // every missing type, categorical splits, and enough thresholds per feature to need uint16_t codes
+  const std::vector<BinnedCase> cases = {
+    {"objective=regression num_leaves=15 verbose=-1", kDatasetParams, &labels, 20},
+    {"objective=regression num_leaves=15 zero_as_missing=true verbose=-1", "zero_as_missing=true verbose=-1",
+     &labels, 20},
+    {"objective=regression num_leaves=15 use_missing=false verbose=-1", "use_missing=false verbose=-1", &labels, 20},
+    {"objective=multiclass num_class=3 num_leaves=7 verbose=-1", kDatasetParams, &class_labels, 10},
+    {"objective=regression num_leaves=63 min_data_in_leaf=5 verbose=-1", "max_bin=1023 verbose=-1", &labels, 60}};
+  for (const auto& test_case : cases) {
+    BoosterHandle booster = TrainPredictBooster(features, *test_case.labels, test_case.params,
+                                                test_case.num_iterations, test_case.dataset_params);
+    for (int predict_type : {C_API_PREDICT_NORMAL, C_API_PREDICT_RAW_SCORE}) {
+      auto expected = PredictMat(booster, features, predict_type, 2, 8, "");
+      EXPECT_EQ(expected, PredictMat(booster, features, predict_type, 2, 8, "predict_binned=true"))
+        << "binned prediction mismatch with " << test_case.params;
+      EXPECT_EQ(expected, PredictMat(booster, features, predict_type, 2, 8, "predict_binned=true predict_block_size=64"))
+        << "blocked binned prediction mismatch with " << test_case.params;
+    }
+    LGBM_BoosterFree(booster);
+  }
+}
+
+TEST(Predict, ForDatasetMatchesMat) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  std::vector<float> class_labels(labels.size());
+  for (size_t i = 0; i < labels.size(); ++i) {
+    class_labels[i] = static_cast<float>(std::abs(static_cast<int>(labels[i])) % 3);
+  }
+  struct DatasetCase {
+    const char* params;
+    const char* dataset_params;
+    const std::vector<float>* labels;
+  };
+  // every missing type and categorical splits, the dataset is rebuilt with the bins of the training data
+  const std::vector<DatasetCase> cases = {
+    {"objective=regression num_leaves=15 verbose=-1", kDatasetParams, &labels},
+    {"objective=regression num_leaves=15 zero_as_missing=true verbose=-1", "zero_as_missing=true verbose=-1", &labels},
+    {"objective=regression num_leaves=15 use_missing=false verbose=-1", "use_missing=false verbose=-1", &labels},
+    {"objective=multiclass num_class=3 num_leaves=7 verbose=-1", kDatasetParams, &class_labels}};
+  for (const auto& test_case : cases) {
+    BoosterHandle booster = TrainPredictBooster(features, *test_case.labels, test_case.params, 10,
+                                                test_case.dataset_params);
+    DatasetHandle dataset;
+    int result = LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, kNumRows, kNumCols, 1,
+                                           test_case.dataset_params, nullptr, &dataset);
+    EXPECT_EQ(0, result) << "LGBM_DatasetCreateFromMat result code: " << result;
+    for (int predict_type : {C_API_PREDICT_NORMAL, C_API_PREDICT_RAW_SCORE}) {
+      auto expected = PredictMat(booster, features, predict_type, 2, 6, "");
+      std::vector<double> out(expected.size());
+      int64_t out_len = 0;
+      result = LGBM_BoosterPredictForDataset(booster, dataset, predict_type, 2, 6, "", &out_len, out.data());
+      EXPECT_EQ(0, result) << "LGBM_BoosterPredictForDataset result code: " << result;
+      EXPECT_EQ(expected.size(), static_cast<size_t>(out_len));
+      EXPECT_EQ(expected, out) << "dataset prediction mismatch with " << test_case.params;
+    }
+    LGBM_DatasetFree(dataset);
+    LGBM_BoosterFree(booster);
+  }
+
+  // coarser bins do not contain the thresholds of the trees
+  BoosterHandle booster = TrainPredictBooster(features, labels, "objective=regression num_leaves=15 verbose=-1", 10);
+  DatasetHandle dataset;
+  int result = LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, kNumRows, kNumCols, 1,
+                                         "categorical_feature=0 max_bin=7 verbose=-1", nullptr, &dataset);
+  EXPECT_EQ(0, result) << "LGBM_DatasetCreateFromMat result code: " << result;
+  std::vector<double> out(kNumRows);
+  int64_t out_len = 0;
+  EXPECT_EQ(-1, LGBM_BoosterPredictForDataset(booster, dataset, C_API_PREDICT_NORMAL, 0, -1, "", &out_len, out.data()));
+  EXPECT_EQ(-1, LGBM_BoosterPredictForDataset(booster, dataset, C_API_PREDICT_LEAF_INDEX, 0, -1, "", &out_len, out.data()));
+  LGBM_DatasetFree(dataset);
+  LGBM_BoosterFree(booster);
+
+  // the categories of the trees have no bin when the Dataset only has other ones
+  booster = TrainPredictBooster(features, labels, "objective=regression num_leaves=15 verbose=-1", 10);
+  std::vector<double> shifted_features(features);
+  for (int i = 0; i < kNumRows; ++i) {
+    shifted_features[static_cast<size_t>(i) * kNumCols] += 100.0;
+  }
+  result = LGBM_DatasetCreateFromMat(shifted_features.data(), C_API_DTYPE_FLOAT64, kNumRows, kNumCols, 1,
+                                     kDatasetParams, nullptr, &dataset);
+  EXPECT_EQ(0, result) << "LGBM_DatasetCreateFromMat result code: " << result;
+  EXPECT_EQ(-1, LGBM_BoosterPredictForDataset(booster, dataset, C_API_PREDICT_NORMAL, 0, -1, "", &out_len, out.data()));
+  EXPECT_NE(nullptr, std::strstr(LGBM_GetLastError(), "has no bin in the Dataset")) << LGBM_GetLastError();
+  LGBM_DatasetFree(dataset);
+  LGBM_BoosterFree(booster);
+}
+
+TEST(Predict, ContribBlockMatchesRowByRow) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  std::vector<float> class_labels(labels.size());
+  for (size_t i = 0; i < labels.size(); ++i) {
+    class_labels[i] = static_cast<float>(std::abs(static_cast<int>(labels[i])) % 3);
+  }
+  const std::vector<std::pair<const char*, const std::vector<float>*>> cases = {
+    {"objective=regression num_leaves=31 min_data_in_leaf=5 verbose=-1", &labels},
+    {"objective=multiclass num_class=3 num_leaves=7 verbose=-1", &class_labels}};
+  for (const auto& test_case : cases) {
+    BoosterHandle booster = TrainPredictBooster(features, *test_case.second, test_case.first, 10);
+    int64_t num_pred_one_row = 0;
+    int result = LGBM_BoosterCalcNumPredict(booster, 1, C_API_PREDICT_CONTRIB, 1, 8, &num_pred_one_row);
+    EXPECT_EQ(0, result) << "LGBM_BoosterCalcNumPredict result code: " << result;
+    // row by row, TreeSHAP on each record
+    std::vector<double> expected(static_cast<size_t>(num_pred_one_row) * kNumRows);
+    for (int i = 0; i < kNumRows; ++i) {
+      int64_t out_len;
+      result = LGBM_BoosterPredictForMatSingleRow(booster, features.data() + static_cast<size_t>(i) * kNumCols,
+                                                  C_API_DTYPE_FLOAT64, kNumCols, 1, C_API_PREDICT_CONTRIB, 1, 8, "",
+                                                  &out_len, expected.data() + static_cast<size_t>(num_pred_one_row) * i);
+      EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMatSingleRow result code: " << result;
+    }
+    EXPECT_EQ(expected, PredictMat(booster, features, C_API_PREDICT_CONTRIB, 1, 8, ""))
+      << "default block contributions mismatch with " << test_case.first;
+    EXPECT_EQ(expected, PredictMat(booster, features, C_API_PREDICT_CONTRIB, 1, 8, "predict_block_size=7"))
+      << "contributions by blocks of 7 mismatch with " << test_case.first;
+    EXPECT_EQ(expected, PredictMat(booster, features, C_API_PREDICT_CONTRIB, 1, 8, "predict_block_size=1"))
+      << "contributions by blocks of 1 mismatch with " << test_case.first;
+    LGBM_BoosterFree(booster);
+  }
+}
+
+TEST(Predict, WideSparseMatchesDense) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  // the columns are spread over a wide model, whose sparse rows are predicted on the features used by the trees
+  const int kWideStride = 20011;
+  const int kNumWideCols = kNumCols * kWideStride;
+  std::vector<int32_t> indptr(1, 0);
+  std::vector<int32_t> indices;
+  std::vector<double> values;
+  for (int i = 0; i < kNumRows; ++i) {
+    for (int j = 0; j < kNumCols; ++j) {
+      const double value = features[static_cast<size_t>(i) * kNumCols + j];
+      if (value != 0.0) {
+        indices.push_back(j * kWideStride);
+        values.push_back(value);
+      }
+    }
+    indptr.push_back(static_cast<int32_t>(indices.size()));
+  }
+  // linear trees cannot be compacted, their rows are looked up in the sorted (index, value) pairs
+  for (const std::string dataset_params : {"verbose=-1", "linear_tree=true verbose=-1"}) {
+    DatasetHandle dataset;
+    int result = LGBM_DatasetCreateFromCSR(indptr.data(), C_API_DTYPE_INT32, indices.data(), values.data(),
+                                           C_API_DTYPE_FLOAT64, indptr.size(), values.size(), kNumWideCols,
+                                           dataset_params.c_str(), nullptr, &dataset);
+    EXPECT_EQ(0, result) << "LGBM_DatasetCreateFromCSR result code: " << result;
+    result = LGBM_DatasetSetField(dataset, "label", labels.data(), kNumRows, C_API_DTYPE_FLOAT32);
+    EXPECT_EQ(0, result) << "LGBM_DatasetSetField result code: " << result;
+    BoosterHandle booster;
+    result = LGBM_BoosterCreate(dataset, ("objective=regression num_leaves=15 " + dataset_params).c_str(), &booster);
+    EXPECT_EQ(0, result) << "LGBM_BoosterCreate result code: " << result;
+    for (int i = 0; i < 10; ++i) {
+      int is_finished;
+      result = LGBM_BoosterUpdateOneIter(booster, &is_finished);
+      EXPECT_EQ(0, result) << "LGBM_BoosterUpdateOneIter result code: " << result;
+    }
+
+    // a few full-width dense rows, predicted on all the features
+    const int kRowStep = 97;
+    std::vector<double> wide_row(kNumWideCols, 0.0);
+    for (int predict_type : {C_API_PREDICT_NORMAL, C_API_PREDICT_RAW_SCORE, C_API_PREDICT_LEAF_INDEX}) {
+      int64_t out_len;
+      result = LGBM_BoosterCalcNumPredict(booster, kNumRows, predict_type, 2, 6, &out_len);
+      EXPECT_EQ(0, result) << "LGBM_BoosterCalcNumPredict result code: " << result;
+      const int64_t num_pred_one_row = out_len / kNumRows;
+      std::vector<double> out(out_len), expected(num_pred_one_row), row_out(num_pred_one_row);
+      result = LGBM_BoosterPredictForCSR(booster, indptr.data(), C_API_DTYPE_INT32, indices.data(), values.data(),
+                                         C_API_DTYPE_FLOAT64, indptr.size(), values.size(), kNumWideCols, predict_type,
+                                         2, 6, "", &out_len, out.data());
+      EXPECT_EQ(0, result) << "LGBM_BoosterPredictForCSR result code: " << result;
+      for (int i = 0; i < kNumRows; i += kRowStep) {
+        for (int j = 0; j < kNumCols; ++j) {
+          wide_row[j * kWideStride] = features[static_cast<size_t>(i) * kNumCols + j];
+        }
+        int64_t row_len;
+        result = LGBM_BoosterPredictForMat(booster, wide_row.data(), C_API_DTYPE_FLOAT64, 1, kNumWideCols, 1,
+                                           predict_type, 2, 6, "", &row_len, expected.data());
+        EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMat result code: " << result;
+        for (int64_t k = 0; k < num_pred_one_row; ++k) {
+          EXPECT_EQ(expected[k], out[i * num_pred_one_row + k]) << "wide sparse mismatch at row " << i;
+        }
+        // single-row CSR predictions go through the same compact rows
+        const int row_begin = indptr[i];
+        const int32_t row_indptr[2] = {0, indptr[i + 1] - row_begin};
+        result = LGBM_BoosterPredictForCSRSingleRow(booster, row_indptr, C_API_DTYPE_INT32, indices.data() + row_begin,
+                                                    values.data() + row_begin, C_API_DTYPE_FLOAT64, 2, row_indptr[1],
+                                                    kNumWideCols, predict_type, 2, 6, "", &row_len, row_out.data());
+        EXPECT_EQ(0, result) << "LGBM_BoosterPredictForCSRSingleRow result code: " << result;
+        EXPECT_EQ(expected, row_out) << "wide single row mismatch at row " << i;
+      }
+    }
+    LGBM_BoosterFree(booster);
+    LGBM_DatasetFree(dataset);
+  }
+}
+
+TEST(Predict, SparseContribMatchesDense) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  std::vector<float> class_labels(labels.size());
+  for (size_t i = 0; i < labels.size(); ++i) {
+    class_labels[i] = static_cast<float>(std::abs(static_cast<int>(labels[i])) % 3);
+  }
+  BoosterHandle booster = TrainPredictBooster(features, class_labels,
+                                              "objective=multiclass num_class=3 num_leaves=7 verbose=-1", 10);
+  const int kNumClass = 3;
+  // CSR rows with decreasing column indices and a duplicated column, whose last value wins
+  std::vector<int32_t> indptr(1, 0);
+  std::vector<int32_t> indices;
+  std::vector<double> values;
+  for (int i = 0; i < kNumRows; ++i) {
+    indices.push_back(1);
+    values.push_back(123.0);
+    for (int j = kNumCols - 1; j >= 0; --j) {
+      const double value = features[static_cast<size_t>(i) * kNumCols + j];
+      if (value != 0.0 || j == 1) {
+        indices.push_back(j);
+        values.push_back(value);
+      }
+    }
+    indptr.push_back(static_cast<int32_t>(indices.size()));
+  }
+  std::vector<double> expected = PredictMat(booster, features, C_API_PREDICT_CONTRIB, 1, 8, "");
+
+  int64_t out_len[2];
+  void* out_indptr;
+  int32_t* out_indices;
+  void* out_data;
+  int result = LGBM_BoosterPredictSparseOutput(booster, indptr.data(), C_API_DTYPE_INT32, indices.data(),
+                                               values.data(), C_API_DTYPE_FLOAT64, indptr.size(), values.size(),
+                                               kNumCols, C_API_PREDICT_CONTRIB, 1, 8, "", C_API_MATRIX_TYPE_CSR,
+                                               out_len, &out_indptr, &out_indices, &out_data);
+  EXPECT_EQ(0, result) << "LGBM_BoosterPredictSparseOutput result code: " << result;
+  const int32_t* sparse_indptr = reinterpret_cast<const int32_t*>(out_indptr);
+  const double* sparse_data = reinterpret_cast<const double*>(out_data);
+  EXPECT_EQ((kNumRows + 1) * kNumClass, out_len[1]);
+  // one matrix per class, each one with its own row headers
+  int64_t class_offset = 0;
+  for (int k = 0; k < kNumClass; ++k) {
+    const int32_t* class_indptr = sparse_indptr + k * (kNumRows + 1);
+    for (int i = 0; i < kNumRows; ++i) {
+      std::vector<double> dense_row(kNumCols + 1, 0.0);
+      for (int32_t e = class_indptr[i]; e < class_indptr[i + 1]; ++e) {
+        if (e > class_indptr[i]) {
+          EXPECT_LT(out_indices[class_offset + e - 1], out_indices[class_offset + e]) << "unsorted row " << i;
+        }
+        dense_row[out_indices[class_offset + e]] = sparse_data[class_offset + e];
+      }
+      for (int j = 0; j <= kNumCols; ++j) {
+        EXPECT_EQ(expected[(static_cast<size_t>(i) * kNumClass + k) * (kNumCols + 1) + j], dense_row[j])
+          << "contribution mismatch at row " << i << ", class " << k << ", feature " << j;
+      }
+    }
+    class_offset += class_indptr[kNumRows];
+  }
+  EXPECT_EQ(out_len[0], class_offset);
+  LGBM_BoosterFreePredictSparse(out_indptr, out_indices, out_data, C_API_DTYPE_INT32, C_API_DTYPE_FLOAT64);
+  LGBM_BoosterFree(booster);
+}
+
+TEST(Predict, CompiledMatchesInterpreted) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  std::vector<float> class_labels(labels.size());
+  for (size_t i = 0; i < labels.size(); ++i) {
+    class_labels[i] = static_cast<float>(std::abs(static_cast<int>(labels[i])) % 3);
+  }
+  const std::vector<float> features32(features.begin(), features.end());
+  auto predict_mat32 = [&features32] (BoosterHandle booster, int predict_type, const char* params) {
+    std::vector<double> out(kNumRows);
+    int64_t out_len;
+    int result = LGBM_BoosterPredictForMat(booster, features32.data(), C_API_DTYPE_FLOAT32, kNumRows, kNumCols, 1,
+                                           predict_type, 0, -1, params, &out_len, out.data());
+    EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMat result code: " << result;
+    return out;
+  };
+  struct CompiledCase {
+    const char* params;
+    const char* dataset_params;
+    const std::vector<float>* labels;
+  };
+  // categorical splits and every missing type
+  const std::vector<CompiledCase> cases = {
+    {"objective=regression num_leaves=15 verbose=-1", kDatasetParams, &labels},
+    {"objective=regression num_leaves=15 zero_as_missing=true verbose=-1", "zero_as_missing=true verbose=-1", &labels},
+    {"objective=regression num_leaves=15 use_missing=false verbose=-1", "use_missing=false verbose=-1", &labels},
+    {"objective=multiclass num_class=3 num_leaves=7 verbose=-1", kDatasetParams, &class_labels}};
+  for (size_t i = 0; i < cases.size(); ++i) {
+    const auto& test_case = cases[i];
+    // one file per case, a library is not reloaded from a path which is still loaded
+    const std::string filename = "test_predict_compiled_" + std::to_string(i) + ".so";
+    BoosterHandle booster = TrainPredictBooster(features, *test_case.labels, test_case.params, 12,
+                                                test_case.dataset_params);
+    int result = LGBM_BoosterSaveModelCompiled(booster, -1, 1, nullptr, nullptr, filename.c_str());
+    if (result != 0) {
+      LGBM_BoosterFree(booster);
+      GTEST_SKIP() << "no C compiler: " << LGBM_GetLastError();
+    }
+    BoosterHandle compiled;
+    int num_iterations;
+    result = LGBM_BoosterLoadCompiled(filename.c_str(), &num_iterations, &compiled);
+    ASSERT_EQ(0, result) << "LGBM_BoosterLoadCompiled result code: " << result;
+    EXPECT_EQ(12, num_iterations);
+    for (int predict_type : {C_API_PREDICT_NORMAL, C_API_PREDICT_RAW_SCORE}) {
+      for (const char* params : {"", "predict_block_size=64"}) {
+        EXPECT_EQ(PredictMat(booster, features, predict_type, 0, -1, params),
+                  PredictMat(compiled, features, predict_type, 0, -1, params))
+          << "compiled prediction mismatch with " << test_case.params << " " << params;
+        EXPECT_EQ(PredictMat(booster, features, predict_type, 2, 7, params),
+                  PredictMat(compiled, features, predict_type, 2, 7, params))
+          << "compiled prediction mismatch on iterations [2, 9) with " << test_case.params << " " << params;
+      }
+      if (test_case.labels == &labels) {
+        EXPECT_EQ(predict_mat32(booster, predict_type, "predict_float32=true"),
+                  predict_mat32(compiled, predict_type, "predict_float32=true"))
+          << "compiled float32 prediction mismatch with " << test_case.params;
+      }
+    }
+    // the other prediction types go through the embedded model
+    EXPECT_EQ(PredictMat(booster, features, C_API_PREDICT_CONTRIB, 0, -1, ""),
+              PredictMat(compiled, features, C_API_PREDICT_CONTRIB, 0, -1, ""));
+    LGBM_BoosterFree(compiled);
+    LGBM_BoosterFree(booster);
+    std::remove(filename.c_str());
+    std::remove((filename + ".c").c_str());
+  }
+}
+
+TEST(Predict, CompiledModelFilenameIsNotParsedByShell) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  BoosterHandle booster = TrainPredictBooster(features, labels, "objective=regression num_leaves=7 verbose=-1", 3);
+  const std::string filename = "test predict \"compiled\" $(false) 'x'.so";
+  int result = LGBM_BoosterSaveModelCompiled(booster, -1, 0, nullptr, nullptr, filename.c_str());
+  if (result != 0) {
+    const std::string error = LGBM_GetLastError();
+    const std::string plain_filename = "test_predict_compiled_plain.so";
+    result = LGBM_BoosterSaveModelCompiled(booster, -1, 0, nullptr, nullptr, plain_filename.c_str());
+    std::remove(plain_filename.c_str());
+    std::remove((plain_filename + ".c").c_str());
+    std::remove((filename + ".c").c_str());
+    LGBM_BoosterFree(booster);
+    if (result != 0) {
+      GTEST_SKIP() << "no C compiler: " << LGBM_GetLastError();
+    }
+    FAIL() << "compiling to a filename with shell characters failed: " << error;
+  }
+  BoosterHandle compiled;
+  int num_iterations;
+  result = LGBM_BoosterLoadCompiled(filename.c_str(), &num_iterations, &compiled);
+  ASSERT_EQ(0, result) << "LGBM_BoosterLoadCompiled result code: " << result;
+  EXPECT_EQ(PredictMat(booster, features, C_API_PREDICT_NORMAL, 0, -1, ""),
+            PredictMat(compiled, features, C_API_PREDICT_NORMAL, 0, -1, ""));
+  LGBM_BoosterFree(compiled);
+  LGBM_BoosterFree(booster);
+  std::remove(filename.c_str());
+  std::remove((filename + ".c").c_str());
+}
+
+TEST(Predict, ViewSharesTrees) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  for (auto& label : labels) {
+    label = static_cast<float>(std::abs(static_cast<int>(label)) % 3);
+  }
+  BoosterHandle booster = TrainPredictBooster(features, labels,
+                                              "objective=multiclass num_class=3 num_leaves=15 verbose=-1", 12);
+  const int start_iteration = 3;
+  const int num_iteration = 6;
+  BoosterHandle view;
+  int num_view_iterations;
+  int result = LGBM_BoosterCreateView(booster, start_iteration, num_iteration, &num_view_iterations, &view);
+  EXPECT_EQ(0, result) << "LGBM_BoosterCreateView result code: " << result;
+  EXPECT_EQ(num_iteration, num_view_iterations);
+
+  const int predict_types[] = {C_API_PREDICT_NORMAL, C_API_PREDICT_RAW_SCORE, C_API_PREDICT_LEAF_INDEX,
+                               C_API_PREDICT_CONTRIB};
+  std::vector<std::vector<double>> expected;
+  for (int predict_type : predict_types) {
+    expected.push_back(PredictMat(booster, features, predict_type, start_iteration, num_iteration, ""));
+    EXPECT_EQ(expected.back(), PredictMat(view, features, predict_type, 0, -1, ""))
+      << "view mismatch for predict type " << predict_type;
+  }
+  EXPECT_EQ(PredictMat(booster, features, C_API_PREDICT_RAW_SCORE, start_iteration + 1, 2, ""),
+            PredictMat(view, features, C_API_PREDICT_RAW_SCORE, 1, 2, ""));
+
+  // the view only references trees and a flattened forest of the booster
+  int64_t own_bytes, shared_bytes;
+  result = LGBM_BoosterGetMemoryUsage(view, &own_bytes, &shared_bytes);
+  EXPECT_EQ(0, result) << "LGBM_BoosterGetMemoryUsage result code: " << result;
+  EXPECT_EQ(0, own_bytes);
+  EXPECT_GT(shared_bytes, 0);
+  int64_t booster_own_bytes, booster_shared_bytes;
+  LGBM_BoosterGetMemoryUsage(booster, &booster_own_bytes, &booster_shared_bytes);
+  EXPECT_GT(booster_own_bytes, 0);
+  EXPECT_GT(booster_shared_bytes, 0);
+
+  // modifying a shared tree copies it, the view keeps predicting with the original one
+  const int tree_idx = start_iteration * 3 + 1;
+  double old_value;
+  LGBM_BoosterGetLeafValue(booster, tree_idx, 0, &old_value);
+  result = LGBM_BoosterSetLeafValue(booster, tree_idx, 0, old_value + 1.0);
+  EXPECT_EQ(0, result) << "LGBM_BoosterSetLeafValue result code: " << result;
+  EXPECT_NE(expected[1], PredictMat(booster, features, C_API_PREDICT_RAW_SCORE, start_iteration, num_iteration, ""));
+  EXPECT_EQ(expected[1], PredictMat(view, features, C_API_PREDICT_RAW_SCORE, 0, -1, ""));
+  LGBM_BoosterGetMemoryUsage(view, &own_bytes, &shared_bytes);
+  EXPECT_GT(own_bytes, 0);
+
+  // the view outlives the booster it was created from
+  LGBM_BoosterFree(booster);
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i], PredictMat(view, features, predict_types[i], 0, -1, ""));
+  }
+  LGBM_BoosterGetMemoryUsage(view, &own_bytes, &shared_bytes);
+  EXPECT_EQ(0, shared_bytes);
+  LGBM_BoosterFree(view);
+}
+
+TEST(Predict, ConcurrentPlansWithDifferentRanges) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  BoosterHandle booster = TrainPredictBooster(features, labels, "objective=regression num_leaves=15 verbose=-1", 12);
+  const int ranges[][2] = {{0, -1}, {2, 4}, {5, 3}};
+  const int predict_types[] = {C_API_PREDICT_RAW_SCORE, C_API_PREDICT_LEAF_INDEX, C_API_PREDICT_CONTRIB};
+  const char* params[] = {"", "predict_quick_scorer=true", "predict_binned=true"};
+  std::vector<std::vector<double>> expected;
+  for (const auto& range : ranges) {
+    for (int predict_type : predict_types) {
+      expected.push_back(PredictMat(booster, features, predict_type, range[0], range[1], ""));
+    }
+  }
+
+  // each prediction resolves its own plan, none of them changes what the others predict
+  const int num_threads = 9;
+  std::vector<int> num_errors(num_threads, 0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int repeat = 0; repeat < 3; ++repeat) {
+        const int range_idx = (t + repeat) % 3;
+        const int type_idx = t / 3;
+        const auto& range = ranges[range_idx];
+        const char* param = predict_types[type_idx] == C_API_PREDICT_RAW_SCORE ? params[t % 3] : "";
+        num_errors[t] += PredictMat(booster, features, predict_types[type_idx], range[0], range[1], param)
+                         != expected[range_idx * 3 + type_idx];
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int t = 0; t < num_threads; ++t) {
+    EXPECT_EQ(0, num_errors[t]) << "wrong predictions in thread " << t;
+  }
+
+  // a fast config keeps predicting the trees it was created with
+  FastConfigHandle fast_config;
+  int result = LGBM_BoosterPredictForMatSingleRowFastInit(booster, C_API_PREDICT_RAW_SCORE, 2, 4, C_API_DTYPE_FLOAT64,
+                                                          kNumCols, "", &fast_config);
+  EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMatSingleRowFastInit result code: " << result;
+  // while the predictor cached by the booster for single rows follows the modifications
+  int64_t out_len;
+  double out = 0.0;
+  LGBM_BoosterPredictForMatSingleRow(booster, features.data(), C_API_DTYPE_FLOAT64, kNumCols, 1,
+                                     C_API_PREDICT_RAW_SCORE, 2, 4, "", &out_len, &out);
+  EXPECT_EQ(expected[3][0], out);
+  double old_value;
+  LGBM_BoosterGetLeafValue(booster, 3, 0, &old_value);
+  result = LGBM_BoosterSetLeafValue(booster, 3, 0, old_value + 1.0);
+  EXPECT_EQ(0, result) << "LGBM_BoosterSetLeafValue result code: " << result;
+  const auto modified = PredictMat(booster, features, C_API_PREDICT_RAW_SCORE, 2, 4, "");
+  EXPECT_NE(expected[3], modified);
+  for (int i = 0; i < kNumRows; ++i) {
+    LGBM_BoosterPredictForMatSingleRowFast(fast_config, features.data() + static_cast<size_t>(i) * kNumCols,
+                                           &out_len, &out);
+    EXPECT_EQ(expected[3][i], out) << "fast config changed at row " << i;
+    LGBM_BoosterPredictForMatSingleRow(booster, features.data() + static_cast<size_t>(i) * kNumCols,
+                                       C_API_DTYPE_FLOAT64, kNumCols, 1, C_API_PREDICT_RAW_SCORE, 2, 4, "",
+                                       &out_len, &out);
+    EXPECT_EQ(modified[i], out) << "single row prediction not updated at row " << i;
+  }
+  LGBM_FastConfigFree(fast_config);
+  LGBM_BoosterFree(booster);
+}
+
+TEST(Predict, FileOutputFormats) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  for (auto& label : labels) {
+    label = static_cast<float>(std::abs(static_cast<int>(label)) % 3);
+  }
+  const char* data_filename = "test_predict_output_formats.tsv";
+  const char* result_filename = "test_predict_output_formats.out";
+  FILE* file = fopen(data_filename, "w");
+  ASSERT_NE(nullptr, file);
+  for (int i = 0; i < kNumRows; ++i) {
+    fprintf(file, "0");
+    for (int j = 0; j < kNumCols; ++j) {
+      fprintf(file, "\t%.17g", features[static_cast<size_t>(i) * kNumCols + j]);
+    }
+    fprintf(file, "\n");
+  }
+  fclose(file);
+  auto read_binary = [result_filename] (size_t value_size) {
+    std::vector<char> bytes;
+    FILE* result_file = fopen(result_filename, "rb");
+    char buffer[4096];
+    size_t read_cnt;
+    while (result_file != nullptr && (read_cnt = fread(buffer, 1, sizeof(buffer), result_file)) > 0) {
+      bytes.insert(bytes.end(), buffer, buffer + read_cnt);
+    }
+    if (result_file != nullptr) {
+      fclose(result_file);
+    }
+    std::vector<double> out(bytes.size() / value_size);
+    for (size_t i = 0; i < out.size(); ++i) {
+      if (value_size == sizeof(float)) {
+        float value;
+        std::memcpy(&value, bytes.data() + i * value_size, sizeof(value));
+        out[i] = value;
+      } else {
+        std::memcpy(&out[i], bytes.data() + i * value_size, sizeof(out[i]));
+      }
+    }
+    EXPECT_EQ(out.size() * value_size, bytes.size());
+    return out;
+  };
+
+  BoosterHandle booster = TrainPredictBooster(features, labels, "objective=multiclass num_class=3 num_leaves=7 verbose=-1", 6);
+  for (int predict_type : {C_API_PREDICT_NORMAL, C_API_PREDICT_RAW_SCORE, C_API_PREDICT_LEAF_INDEX}) {
+    const auto expected = PredictMat(booster, features, predict_type, 0, -1, "");
+    // several threads format their part of the block of lines
+    int result = LGBM_BoosterPredictForFile(booster, data_filename, 0, predict_type, 0, -1, "num_threads=3",
+                                            result_filename);
+    ASSERT_EQ(0, result) << "LGBM_BoosterPredictForFile result code: " << result;
+    std::vector<double> text;
+    file = fopen(result_filename, "r");
+    ASSERT_NE(nullptr, file);
+    int num_lines = 0;
+    char line[1024];
+    while (fgets(line, sizeof(line), file) != nullptr) {
+      ++num_lines;
+      for (char* token = strtok(line, "\t\n"); token != nullptr; token = strtok(nullptr, "\t\n")) {
+        text.push_back(strtod(token, nullptr));
+      }
+    }
+    fclose(file);
+    EXPECT_EQ(kNumRows, num_lines);
+    ASSERT_EQ(expected.size(), text.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_NEAR(expected[i], text[i], 1e-12) << "text mismatch for predict type " << predict_type;
+    }
+
+    // binary values are the ones formatted in the text output
+    result = LGBM_BoosterPredictForFile(booster, data_filename, 0, predict_type, 0, -1,
+                                        "num_threads=3 predict_output_format=float64", result_filename);
+    ASSERT_EQ(0, result) << "LGBM_BoosterPredictForFile result code: " << result;
+    EXPECT_EQ(text, read_binary(sizeof(double)));
+    // the lines of each thread are predicted by blocks, the last one shorter
+    result = LGBM_BoosterPredictForFile(booster, data_filename, 0, predict_type, 0, -1,
+                                        "num_threads=3 predict_block_size=7 predict_output_format=float64",
+                                        result_filename);
+    ASSERT_EQ(0, result) << "LGBM_BoosterPredictForFile result code: " << result;
+    EXPECT_EQ(text, read_binary(sizeof(double))) << "blocked file prediction mismatch for predict type " << predict_type;
+    result = LGBM_BoosterPredictForFile(booster, data_filename, 0, predict_type, 0, -1,
+                                        "predict_output_format=float32", result_filename);
+    ASSERT_EQ(0, result) << "LGBM_BoosterPredictForFile result code: " << result;
+    const auto out_f32 = read_binary(sizeof(float));
+    ASSERT_EQ(text.size(), out_f32.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+      EXPECT_EQ(static_cast<float>(text[i]), out_f32[i]) << "float32 mismatch for predict type " << predict_type;
+    }
+  }
+  EXPECT_NE(0, LGBM_BoosterPredictForFile(booster, data_filename, 0, C_API_PREDICT_NORMAL, 0, -1,
+                                          "predict_output_format=csv", result_filename));
+  LGBM_BoosterFree(booster);
+  std::remove(data_filename);
+  std::remove(result_filename);
+}
+
+TEST(Predict, CompactLeafIndexAndRefitFromFeatures) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  for (auto& label : labels) {
+    label = static_cast<float>(std::abs(static_cast<int>(label)) % 3);
+  }
+  const char* params = "objective=multiclass num_class=3 num_leaves=15 verbose=-1";
+  const int num_iterations = 5;
+  BoosterHandle model = TrainPredictBooster(features, labels, params, num_iterations);
+
+  // leaf indices as int32 and int16 are the double ones
+  const auto expected = PredictMat(model, features, C_API_PREDICT_LEAF_INDEX, 0, -1, "");
+  std::vector<int32_t> leaves32(expected.size());
+  std::vector<int16_t> leaves16(expected.size());
+  int64_t out_len = 0;
+  int result = LGBM_BoosterPredictLeafIndexForMat(model, features.data(), C_API_DTYPE_FLOAT64, kNumRows, kNumCols, 1,
+                                                  0, -1, "", C_API_DTYPE_INT32, &out_len, leaves32.data());
+  ASSERT_EQ(0, result) << "LGBM_BoosterPredictLeafIndexForMat result code: " << result;
+  ASSERT_EQ(expected.size(), static_cast<size_t>(out_len));
+  result = LGBM_BoosterPredictLeafIndexForMat(model, features.data(), C_API_DTYPE_FLOAT64, kNumRows, kNumCols, 1,
+                                              0, -1, "", C_API_DTYPE_INT16, &out_len, leaves16.data());
+  ASSERT_EQ(0, result) << "LGBM_BoosterPredictLeafIndexForMat result code: " << result;
+  ASSERT_EQ(expected.size(), static_cast<size_t>(out_len));
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i], leaves32[i]) << "int32 mismatch at " << i;
+    EXPECT_EQ(expected[i], leaves16[i]) << "int16 mismatch at " << i;
+  }
+  EXPECT_NE(0, LGBM_BoosterPredictLeafIndexForMat(model, features.data(), C_API_DTYPE_FLOAT64, kNumRows, kNumCols, 1,
+                                                  0, -1, "", C_API_DTYPE_INT64, &out_len, leaves32.data()));
+
+  // refitting from the features gives the same trees as from the leaf indices,
+  // with the leaves of 2 iterations computed at a time, then the last one alone
+  std::vector<double> col_major(features.size());
+  for (int i = 0; i < kNumRows; ++i) {
+    for (int j = 0; j < kNumCols; ++j) {
+      col_major[static_cast<size_t>(j) * kNumRows + i] = features[static_cast<size_t>(i) * kNumCols + j];
+    }
+  }
+  DatasetHandle dataset;
+  result = LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, kNumRows, kNumCols, 1, kDatasetParams,
+                                     nullptr, &dataset);
+  ASSERT_EQ(0, result) << "LGBM_DatasetCreateFromMat result code: " << result;
+  result = LGBM_DatasetSetField(dataset, "label", labels.data(), kNumRows, C_API_DTYPE_FLOAT32);
+  ASSERT_EQ(0, result) << "LGBM_DatasetSetField result code: " << result;
+  const std::string refit_params = std::string(params) + " refit_leaf_buffer_size=" + std::to_string(2 * 3 * kNumRows);
+  std::vector<std::vector<double>> refitted;
+  for (int mode = 0; mode < 3; ++mode) {
+    BoosterHandle booster;
+    result = LGBM_BoosterCreate(dataset, refit_params.c_str(), &booster);
+    ASSERT_EQ(0, result) << "LGBM_BoosterCreate result code: " << result;
+    result = LGBM_BoosterMerge(booster, model);
+    ASSERT_EQ(0, result) << "LGBM_BoosterMerge result code: " << result;
+    if (mode == 0) {
+      result = LGBM_BoosterRefit(booster, leaves32.data(), kNumRows, static_cast<int32_t>(leaves32.size() / kNumRows));
+    } else if (mode == 1) {
+      result = LGBM_BoosterRefitForMat(booster, features.data(), C_API_DTYPE_FLOAT64, kNumRows, kNumCols, 1);
+    } else {
+      result = LGBM_BoosterRefitForMat(booster, col_major.data(), C_API_DTYPE_FLOAT64, kNumRows, kNumCols, 0);
+    }
+    ASSERT_EQ(0, result) << "refit result code: " << result << " in mode " << mode;
+    refitted.push_back(PredictMat(booster, features, C_API_PREDICT_RAW_SCORE, 0, -1, ""));
+    LGBM_BoosterFree(booster);
+  }
+  EXPECT_NE(PredictMat(model, features, C_API_PREDICT_RAW_SCORE, 0, -1, ""), refitted[0]);
+  EXPECT_EQ(refitted[0], refitted[1]);
+  EXPECT_EQ(refitted[0], refitted[2]);
+  LGBM_DatasetFree(dataset);
+  LGBM_BoosterFree(model);
+}
+
+TEST(Predict, ExactEarlyStopKeepsDecisions) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreatePredictData(&features, &labels);
+  std::vector<float> binary_labels(labels.size());
+  std::vector<float> class_labels(labels.size());
+  for (size_t i = 0; i < labels.size(); ++i) {
+    binary_labels[i] = static_cast<float>(std::abs(static_cast<int>(labels[i])) % 2);
+    class_labels[i] = static_cast<float>(std::abs(static_cast<int>(labels[i])) % 3);
+  }
+  const double threshold = 0.3;
+  const std::vector<std::pair<const char*, const std::vector<float>*>> configs = {
+    {"objective=binary num_leaves=15 verbose=-1", &binary_labels},
+    {"objective=multiclass num_class=3 num_leaves=7 verbose=-1", &class_labels}};
+  for (const auto& config : configs) {
+    BoosterHandle booster = TrainPredictBooster(features, *config.second, config.first, 40);
+    const auto expected = PredictMat(booster, features, C_API_PREDICT_RAW_SCORE, 0, -1, "");
+    const int num_class = static_cast<int>(expected.size() / kNumRows);
+    auto decision = [num_class, threshold] (const double* raw) {
+      if (num_class == 1) {
+        return raw[0] > threshold ? 1 : 0;
+      }
+      return static_cast<int>(std::max_element(raw, raw + num_class) - raw);
+    };
+    for (const char* freq : {"1", "3"}) {
+      const std::string params = std::string("pred_early_stop=true pred_early_stop_exact=true pred_early_stop_threshold=")
+                                 + std::to_string(threshold) + " pred_early_stop_freq=" + freq;
+      const auto out = PredictMat(booster, features, C_API_PREDICT_RAW_SCORE, 0, -1, params.c_str());
+      ASSERT_EQ(expected.size(), out.size());
+      int num_stopped = 0;
+      for (int i = 0; i < kNumRows; ++i) {
+        const double* expected_row = expected.data() + static_cast<size_t>(i) * num_class;
+        const double* row = out.data() + static_cast<size_t>(i) * num_class;
+        EXPECT_EQ(decision(expected_row), decision(row)) << "decision changed at row " << i << " with " << config.first;
+        num_stopped += std::equal(row, row + num_class, expected_row) ? 0 : 1;
+      }
+      EXPECT_GT(num_stopped, kNumRows / 4) << config.first;
+      // blocks of rows and other scorers stop at the same iteration as single rows
+      for (const char* other : {" predict_block_size=16", " predict_block_size=16 predict_binned=true",
+                                " predict_quick_scorer=true", " predict_binned=true"}) {
+        EXPECT_EQ(out, PredictMat(booster, features, C_API_PREDICT_RAW_SCORE, 0, -1, (params + other).c_str()))
+            << other << " with " << config.first;
+      }
+    }
+    LGBM_BoosterFree(booster);
+  }
+}
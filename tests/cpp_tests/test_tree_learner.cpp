@@ -0,0 +1,343 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+
+#include <gtest/gtest.h>
+#include <LightGBM/c_api.h>
+#include <LightGBM/utils/random.h>
+
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using LightGBM::Random;
+
+namespace {
+
+const int kNumRows = 3000;
+const int kNumCols = 10;
+
+/*!
+ * Dense row-major data with a mostly zero column (stored in a sparse bin)
+ * and a binary label, usable for regression and classification.
+ */
+void CreateTrainData(std::vector<double>* features, std::vector<float>* labels) {
+  Random rand(23);
+  features->resize(static_cast<size_t>(kNumRows) * kNumCols);
+  labels->resize(kNumRows);
+  for (int i = 0; i < kNumRows; ++i) {
+    double* row = features->data() + static_cast<size_t>(i) * kNumCols;
+    for (int j = 0; j < kNumCols; ++j) {
+      row[j] = rand.NextFloat() * 2.0 - 1.0;
+    }
+    row[kNumCols - 1] = rand.NextShort(0, 10) == 0 ? rand.NextFloat() : 0.0;
+    const double score = row[0] * row[1] + (row[2] > 0.3 ? 1.0 : 0.0) + row[kNumCols - 1] + 0.3 * row[3];
+    (*labels)[i] = score + 0.2 * rand.NextFloat() > 0.6 ? 1.0f : 0.0f;
+  }
+}
+
+/*! Train a booster, the caller frees it and the dataset */
+BoosterHandle Train(const std::vector<double>& features, const std::vector<float>& labels,
+                    const std::string& params, int num_iterations, DatasetHandle* dataset) {
+  int result = LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, kNumRows, kNumCols, 1,
+                                         "verbose=-1", nullptr, dataset);
+  EXPECT_EQ(0, result) << "LGBM_DatasetCreateFromMat result code: " << result;
+  result = LGBM_DatasetSetField(*dataset, "label", labels.data(), kNumRows, C_API_DTYPE_FLOAT32);
+  EXPECT_EQ(0, result) << "LGBM_DatasetSetField result code: " << result;
+  BoosterHandle booster;
+  result = LGBM_BoosterCreate(*dataset, params.c_str(), &booster);
+  EXPECT_EQ(0, result) << "LGBM_BoosterCreate result code: " << result;
+  for (int i = 0; i < num_iterations; ++i) {
+    int is_finished;
+    result = LGBM_BoosterUpdateOneIter(booster, &is_finished);
+    EXPECT_EQ(0, result) << "LGBM_BoosterUpdateOneIter result code: " << result;
+  }
+  return booster;
+}
+
+std::vector<double> PredictRaw(BoosterHandle booster, const std::vector<double>& features) {
+  int64_t out_len = 0;
+  std::vector<double> out(kNumRows);
+  int result = LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64, kNumRows, kNumCols, 1,
+                                         C_API_PREDICT_RAW_SCORE, 0, -1, "", &out_len, out.data());
+  EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMat result code: " << result;
+  EXPECT_EQ(kNumRows, out_len);
+  return out;
+}
+
+std::vector<double> TrainAndPredict(const std::vector<double>& features, const std::vector<float>& labels,
+                                    const std::string& params, int num_iterations) {
+  DatasetHandle dataset;
+  BoosterHandle booster = Train(features, labels, params, num_iterations, &dataset);
+  auto out = PredictRaw(booster, features);
+  LGBM_BoosterFree(booster);
+  LGBM_DatasetFree(dataset);
+  return out;
+}
+
+std::string SaveModelToString(BoosterHandle booster) {
+  int64_t out_len = 0;
+  int result = LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, 0, &out_len, nullptr);
+  EXPECT_EQ(0, result) << "LGBM_BoosterSaveModelToString result code: " << result;
+  std::string model(static_cast<size_t>(out_len), '\0');
+  result = LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, out_len, &out_len, &model[0]);
+  EXPECT_EQ(0, result) << "LGBM_BoosterSaveModelToString result code: " << result;
+  model.resize(std::strlen(model.c_str()));
+  return model;
+}
+
+std::vector<double> LoadAndPredict(const std::string& model, const std::vector<double>& features) {
+  BoosterHandle booster;
+  int num_iterations;
+  int result = LGBM_BoosterLoadModelFromString(model.c_str(), &num_iterations, &booster);
+  EXPECT_EQ(0, result) << "LGBM_BoosterLoadModelFromString result code: " << result;
+  auto out = PredictRaw(booster, features);
+  LGBM_BoosterFree(booster);
+  return out;
+}
+
+}  // namespace
+
+TEST(TreeLearner, DepthWiseMatchesLeafWiseOnFullTrees) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreateTrainData(&features, &labels);
+
+  // when every leaf down to max_depth is split, both policies find the same splits
+  const std::vector<std::string> variants = {
+    "objective=regression force_col_wise=true",
+    "objective=binary force_col_wise=true",
+    "objective=binary force_row_wise=true",
+    "objective=binary force_col_wise=true bagging_fraction=0.7 bagging_freq=1",
+  };
+  for (const auto& variant : variants) {
+    const std::string params = variant + " num_leaves=16 max_depth=4 min_data_in_leaf=5 verbose=-1 num_threads=2";
+    auto leaf_wise = TrainAndPredict(features, labels, params, 10);
+    auto depth_wise = TrainAndPredict(features, labels, params + " grow_policy=depthwise", 10);
+    for (int i = 0; i < kNumRows; ++i) {
+      ASSERT_EQ(leaf_wise[i], depth_wise[i]) << variant << ", row " << i;
+    }
+  }
+}
+
+TEST(TreeLearner, DepthWiseBatchedMatchesLeafByLeaf) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreateTrainData(&features, &labels);
+
+  // a small histogram pool cannot hold a level, its histograms are then constructed one leaf after the other,
+  // and the evicted parents are rebuilt instead of subtracted, which only changes the rounding
+  const std::string params = "objective=binary grow_policy=depthwise num_leaves=23 min_data_in_leaf=5 "
+                             "force_col_wise=true verbose=-1 num_threads=2";
+  auto batched = TrainAndPredict(features, labels, params, 10);
+  auto leaf_by_leaf = TrainAndPredict(features, labels, params + " histogram_pool_size=0.001", 10);
+  for (int i = 0; i < kNumRows; ++i) {
+    ASSERT_NEAR(batched[i], leaf_by_leaf[i], 1e-9) << "row " << i;
+  }
+}
+
+TEST(TreeLearner, ObliviousTreesShareTheSplitOfEachLevel) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreateTrainData(&features, &labels);
+  // a few missing values, which go right
+  for (int i = 0; i < kNumRows; i += 7) {
+    features[static_cast<size_t>(i) * kNumCols + 4] = NAN;
+  }
+
+  const std::vector<std::string> variants = {
+    "objective=binary num_leaves=16",
+    "objective=regression num_leaves=31 max_depth=3 lambda_l1=0.5 path_smooth=1",
+    "objective=binary num_leaves=8 bagging_fraction=0.7 bagging_freq=1 feature_fraction=0.8",
+  };
+  for (const auto& variant : variants) {
+    DatasetHandle dataset;
+    BoosterHandle booster = Train(features, labels, variant + " oblivious_tree=true min_data_in_leaf=5 "
+                                  "verbose=-1 num_threads=2", 10, &dataset);
+    auto predictions = PredictRaw(booster, features);
+    const std::string model = SaveModelToString(booster);
+    LGBM_BoosterFree(booster);
+    LGBM_DatasetFree(dataset);
+
+    // every tree is complete, with one split per level
+    std::istringstream lines(model);
+    std::string line;
+    std::string model_without_levels;
+    int num_trees = 0;
+    int num_leaves = 0;
+    while (std::getline(lines, line)) {
+      if (line.compare(0, 11, "num_leaves=") == 0) {
+        num_leaves = std::stoi(line.substr(11));
+      } else if (line.compare(0, 24, "oblivious_split_feature=") == 0) {
+        std::istringstream level_features(line.substr(24));
+        int num_levels = 0;
+        int feature;
+        while (level_features >> feature) {
+          ++num_levels;
+        }
+        EXPECT_EQ(1 << num_levels, num_leaves) << variant;
+        ++num_trees;
+      }
+      // without the tree sizes, which change with the lines removed, the trees are parsed one after the other
+      if (line.compare(0, 10, "oblivious_") != 0 && line.compare(0, 11, "tree_sizes=") != 0) {
+        model_without_levels += line + "\n";
+      }
+    }
+    EXPECT_EQ(10, num_trees) << variant;
+
+    // the level splits give the leaves found by walking the nodes, also after a round trip
+    auto reloaded = LoadAndPredict(model, features);
+    auto walked = LoadAndPredict(model_without_levels, features);
+    for (int i = 0; i < kNumRows; ++i) {
+      ASSERT_EQ(predictions[i], reloaded[i]) << variant << ", row " << i;
+      ASSERT_EQ(predictions[i], walked[i]) << variant << ", row " << i;
+    }
+  }
+}
+
+TEST(TreeLearner, ObliviousTreesSplitTheMissingValuesAsScored) {
+  // one feature, missing in a fifth of the rows whose labels are far from the others,
+  // and a best threshold above the default bin
+  std::vector<double> features(static_cast<size_t>(kNumRows) * kNumCols, 0.0);
+  std::vector<float> labels(kNumRows);
+  Random rand(5);
+  for (int i = 0; i < kNumRows; ++i) {
+    const double value = rand.NextFloat() * 2.0 - 1.0;
+    if (i % 5 == 0) {
+      features[static_cast<size_t>(i) * kNumCols] = NAN;
+      labels[i] = 5.0f;
+    } else {
+      features[static_cast<size_t>(i) * kNumCols] = value;
+      labels[i] = value > 0.5 ? 1.0f : 0.0f;
+    }
+  }
+
+  DatasetHandle dataset;
+  BoosterHandle booster = Train(features, labels, "objective=regression oblivious_tree=true num_leaves=2 "
+                                "learning_rate=1 boost_from_average=false min_data_in_leaf=5 verbose=-1 "
+                                "num_threads=2", 1, &dataset);
+  const std::string model = SaveModelToString(booster);
+  LGBM_BoosterFree(booster);
+  LGBM_DatasetFree(dataset);
+
+  std::istringstream lines(model);
+  std::string line;
+  double split_gain = 0.0;
+  std::vector<double> leaf_values;
+  std::vector<double> leaf_counts;
+  auto parse = [] (const std::string& values) {
+    std::istringstream stream(values);
+    std::vector<double> out;
+    double value;
+    while (stream >> value) {
+      out.push_back(value);
+    }
+    return out;
+  };
+  while (std::getline(lines, line)) {
+    if (line.compare(0, 11, "split_gain=") == 0) {
+      split_gain = std::stod(line.substr(11));
+    } else if (line.compare(0, 11, "leaf_value=") == 0) {
+      leaf_values = parse(line.substr(11));
+    } else if (line.compare(0, 11, "leaf_count=") == 0) {
+      leaf_counts = parse(line.substr(11));
+    }
+  }
+  ASSERT_EQ(2u, leaf_values.size());
+  ASSERT_EQ(2u, leaf_counts.size());
+
+  // from a zero score, the gradients are minus the labels and the hessians are one, so each leaf value is the
+  // mean label of the rows the split sent there, and the gain of that partition follows from the leaf values
+  double sum_label = 0.0;
+  for (int i = 0; i < kNumRows; ++i) {
+    sum_label += labels[i];
+  }
+  double partition_gain = -sum_label * sum_label / kNumRows;
+  for (int i = 0; i < 2; ++i) {
+    partition_gain += leaf_values[i] * leaf_values[i] * leaf_counts[i];
+  }
+  EXPECT_NEAR(partition_gain, split_gain, 1e-3 * partition_gain);
+}
+
+TEST(TreeLearner, LeafOrderedBinsGiveTheSameModels) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreateTrainData(&features, &labels);
+  // the same data with mostly zero columns, whose row-wise bins are sparse
+  std::vector<double> sparse_features(features);
+  Random rand(7);
+  for (int i = 0; i < kNumRows; ++i) {
+    for (int j = 4; j < kNumCols - 1; ++j) {
+      if (rand.NextShort(0, 10) < 8) {
+        sparse_features[static_cast<size_t>(i) * kNumCols + j] = 0.0;
+      }
+    }
+  }
+
+  // the rows of a leaf are accumulated in the same order from the leaf-ordered copy, so the histograms are the same
+  const std::vector<std::string> variants = {
+    "objective=binary",
+    "objective=regression",
+    "objective=binary bagging_fraction=0.6 bagging_freq=1 feature_fraction=0.5",
+    "objective=binary use_quantized_grad=true",
+    "objective=binary num_leaves=23 max_depth=6 grow_policy=depthwise",
+    "objective=binary oblivious_tree=true",
+  };
+  for (const auto* data : {&features, &sparse_features}) {
+    for (const auto& variant : variants) {
+      const std::string params = variant + " force_row_wise=true min_data_in_leaf=5 verbose=-1 num_threads=2";
+      auto indexed = TrainAndPredict(*data, labels, params, 10);
+      auto leaf_ordered = TrainAndPredict(*data, labels, params + " leaf_ordered_bins=true", 10);
+      for (int i = 0; i < kNumRows; ++i) {
+        ASSERT_EQ(indexed[i], leaf_ordered[i]) << variant << ", row " << i;
+      }
+    }
+  }
+}
+
+TEST(TreeLearner, MulticlassRootHistogramsGiveTheSameModels) {
+  std::vector<double> features;
+  std::vector<float> labels;
+  CreateTrainData(&features, &labels);
+  std::vector<double> sparse_features(features);
+  Random rand(11);
+  for (int i = 0; i < kNumRows; ++i) {
+    const double* row = features.data() + static_cast<size_t>(i) * kNumCols;
+    labels[i] = static_cast<float>((row[0] + 0.1 * rand.NextFloat() > 0.0 ? 1 : 0) + (row[2] > 0.3 ? 2 : 0));
+    for (int j = 4; j < kNumCols - 1; ++j) {
+      if (rand.NextShort(0, 10) < 8) {
+        sparse_features[static_cast<size_t>(i) * kNumCols + j] = 0.0;
+      }
+    }
+  }
+
+  // each class gets the same root histograms as when it is constructed alone, so the trees are the same
+  const std::vector<std::string> variants = {
+    "objective=multiclass force_col_wise=true",
+    "objective=multiclass force_row_wise=true",
+    "objective=multiclassova force_col_wise=true",
+    "objective=multiclass force_col_wise=true bagging_fraction=0.6 bagging_freq=1",
+    "objective=multiclass force_row_wise=true bagging_fraction=0.6 bagging_freq=1",
+    "objective=multiclass force_row_wise=true grow_policy=depthwise num_leaves=8 max_depth=3",
+  };
+  for (const auto* data : {&features, &sparse_features}) {
+    for (const auto& variant : variants) {
+      const std::string params = variant + " num_class=4 min_data_in_leaf=5 verbose=-1 num_threads=2";
+      DatasetHandle dataset;
+      BoosterHandle booster = Train(*data, labels, params, 5, &dataset);
+      const std::string model = SaveModelToString(booster);
+      LGBM_BoosterFree(booster);
+      LGBM_DatasetFree(dataset);
+      booster = Train(*data, labels, params + " multiclass_root_histograms=true", 5, &dataset);
+      const std::string shared_model = SaveModelToString(booster);
+      LGBM_BoosterFree(booster);
+      LGBM_DatasetFree(dataset);
+      // the parameters at the end of the models differ
+      const size_t end_of_trees = model.find("end of trees");
+      ASSERT_NE(std::string::npos, end_of_trees);
+      ASSERT_EQ(model.substr(0, end_of_trees), shared_model.substr(0, end_of_trees)) << variant;
+    }
+  }
+}